@@ -29,18 +29,10 @@
 #include "ITKToolsBase.h"
 
 #include "itkImageFileReader.h"
-#include "itkBinaryThresholdImageFilter.h"
-#include "itkImageRegionIteratorWithIndex.h"
-#include "itkDisplacementFieldJacobianDeterminantFilter.h"
-#include "itkDeformationFieldBendingEnergyFilter.h"
-#include "itkLabelStatisticsImageFilter.h"
-#include "itkStatisticsImageFilter.h"
-#include "itkUnaryFunctorImageFilter.h"
-#include "itkCropImageFilter.h"
-#include "itkRegionOfInterestImageFilter.h"
-#include "itkIntensityWindowingImageFilter.h"
-#include "itkLogImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkBrainDistanceEvaluator.h"
 #include "vnl/vnl_math.h"
+#include <algorithm>
 #include <fstream>
 
 
@@ -56,11 +48,17 @@ std::string GetHelpString( void )
     << "a label mask image of one of the brains and a deformation field.\n"
     << "Usage:\n"
     << "pxbraindistance\n"
-    << "  -in      inputFilename: 3D deformation field\n"
-    << "  -out     outputFilenames: two output filenames. The first\n"
+    << "  -in      inputFilenames: one or more 3D deformation fields\n"
+    << "  -out     outputFilenames: two output filenames per deformation field. The first\n"
     << "           one contains mu_tot and sigma_tot. the second one contains mu_i, sigma_i, and sigma_itot.\n"
-    << "  -mask    maskFileName: the name of the label image (deformed HAMMER atlas)\n"
+    << "  -mask    maskFileNames: the name of the label image (deformed HAMMER atlas), either\n"
+    << "           one for all deformation fields, which is then read once, or one per field\n"
     << "  [-m]     method: 0 (jacobian), 1 (bending energy), or 2 (log(jacobian)); default: 0\n"
+    << "  [-s]     number of streams per deformation field, default 1\n"
+    << "  [-jobs]  number of deformation fields processed concurrently, default 1\n"
+    << "  [-threads] maximum number of threads, default all; they are shared by the jobs\n"
+    << "The Jacobian (or bending energy) is evaluated and accumulated per label in a single\n"
+    << "pass, without computing a Jacobian image.\n"
     << "Supported: -in: 3D vector of floats, 3 elements per vector\n"
     << "-mask: 3D unsigned char or anything that is valid after casting to unsigned char";
   return ss.str();
@@ -72,10 +70,12 @@ std::string GetHelpString( void )
 
 /* Declare ComputeBrainDistance function. */
 void ComputeBrainDistance(
-  const std::string & inputFileName,
-  const std::string & maskFileName,
+  const std::vector<std::string> & inputFileNames,
+  const std::vector<std::string> & maskFileNames,
   const std::vector<std::string> & outputFileNames,
-  unsigned int method );
+  unsigned int method,
+  unsigned int numberOfStreams,
+  unsigned int numberOfJobs );
 
 //-------------------------------------------------------------------------------------
 
@@ -104,13 +104,19 @@ int main( int argc, char ** argv )
     return EXIT_SUCCESS;
   }
 
-  /** Get arguments (mandatory): input deformation field */
-  std::string inputFileName = "";
-  parser->GetCommandLineArgument( "-in", inputFileName );
+  /** Get arguments (mandatory): input deformation fields */
+  std::vector< std::string > inputFileNames;
+  parser->GetCommandLineArgument( "-in", inputFileNames );
 
-  /** Get arguments (mandatory): input deformation field */
-  std::string maskFileName = "";
-  parser->GetCommandLineArgument( "-mask", maskFileName );
+  /** Get arguments (mandatory): label images */
+  std::vector< std::string > maskFileNames;
+  parser->GetCommandLineArgument( "-mask", maskFileNames );
+  if( maskFileNames.size() != 1 && maskFileNames.size() != inputFileNames.size() )
+  {
+    std::cerr << "ERROR: You should specify \"-mask\", followed by 1 filename, "
+      << "or by 1 filename per input." << std::endl;
+    return EXIT_FAILURE;
+  }
 
   /** Get arguments (optional): method */
   unsigned int method = 0;
@@ -119,41 +125,58 @@ int main( int argc, char ** argv )
   /** Get arguments (mandatory): Output filenames */
   std::vector< std::string > outputFileNames;
   parser->GetCommandLineArgument( "-out", outputFileNames );
-  if( outputFileNames.size() != 2 )
+  if( outputFileNames.size() != 2 * inputFileNames.size() )
   {
-    std::cerr << "ERROR: You should specify \"-out\", followed by 2 filenames." << std::endl;
+    std::cerr << "ERROR: You should specify \"-out\", followed by 2 filenames per input." << std::endl;
+    return EXIT_FAILURE;
   }
 
+  /** Get arguments (optional): streaming and concurrency */
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  unsigned int numberOfJobs = 1;
+  parser->GetCommandLineArgument( "-jobs", numberOfJobs );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
   /** Determine image properties. */
-  itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
-  itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
-  unsigned int dim = 0;
-  unsigned int numberOfComponents = 0;
-  std::vector<unsigned int> imageSize;
-  bool retgip = itktools::GetImageProperties(
-    inputFileName, pixelType, componentType, dim, numberOfComponents, imageSize );
-  if( !retgip ) return EXIT_FAILURE;
-
-  if( (dim != 3) || (numberOfComponents != dim) )
+  for( unsigned int k = 0; k < inputFileNames.size(); ++k )
   {
-    std::cerr << "ERROR: the input image is not of the right format: 3D, "
-      << "vectors of length 3 it should be!" << std::endl;
-    return EXIT_FAILURE;
-  }
-  for( unsigned int i = 0; i < dim; ++i )
-  {
-    if( imageSize[ i ] < 3 )
+    itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+    itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+    unsigned int dim = 0;
+    unsigned int numberOfComponents = 0;
+    std::vector<unsigned int> imageSize;
+    bool retgip = itktools::GetImageProperties(
+      inputFileNames[ k ], pixelType, componentType, dim, numberOfComponents, imageSize );
+    if( !retgip ) return EXIT_FAILURE;
+
+    if( (dim != 3) || (numberOfComponents != dim) )
     {
-      std::cerr << "ERROR: the image is too small in one of the dimensions. "
-        << "Minimum size is 3 for each dimension." << std::endl;
+      std::cerr << "ERROR: the input image " << inputFileNames[ k ]
+        << " is not of the right format: 3D, vectors of length 3 it should be!" << std::endl;
       return EXIT_FAILURE;
     }
+    for( unsigned int i = 0; i < dim; ++i )
+    {
+      if( imageSize[ i ] < 3 )
+      {
+        std::cerr << "ERROR: the image " << inputFileNames[ k ]
+          << " is too small in one of the dimensions. "
+          << "Minimum size is 3 for each dimension." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
   }
 
   /** Run the program. */
   try
   {
-    ComputeBrainDistance( inputFileName, maskFileName, outputFileNames, method );
+    ComputeBrainDistance( inputFileNames, maskFileNames, outputFileNames,
+      method, numberOfStreams, numberOfJobs );
   }
   catch( itk::ExceptionObject & excp )
   {
@@ -169,59 +192,8 @@ int main( int argc, char ** argv )
 
 //------------------------------------------------------------------
 
-/* Function that does (x-b)^2 */
-namespace itk
-{
-  namespace Function {
-
-  template< class TInput, class TOutput = TInput>
-  class SubtractSquare
-  {
-  public:
-    typedef typename NumericTraits<TInput>::RealType RealType;
-
-    SubtractSquare()
-    {
-      this->m_ScalarToSubtract = itk::NumericTraits<RealType>::Zero;
-    }
-    ~SubtractSquare() {}
-
-    bool operator!=( const SubtractSquare & ) const
-    {
-      return false;
-    }
-
-    bool operator==( const SubtractSquare & other ) const
-    {
-      return !(*this != other);
-    }
-
-    void SetScalarToSubtract( RealType scalar )
-    {
-      this->m_ScalarToSubtract = scalar;
-    }
-    RealType GetScalarToSubtract( void )
-    {
-      return this->m_ScalarToSubtract;
-    }
-
-    inline TOutput operator()( const TInput & A )
-    {
-      const RealType ra = static_cast<RealType>( A ) - this->m_ScalarToSubtract;
-      return static_cast<TOutput>( ra * ra );
-    }
-  protected:
-    RealType m_ScalarToSubtract;
-
-  }; // end class
-
-  } // end Function namespace
-} // end itk namespace
-
-//---------------------------------------------------------------------
-
 /* write a vector of doubles to an ostream */
-std::ostream& operator<<(std::ostream& os, std::vector<double>& vec)
+std::ostream& operator<<(std::ostream& os, const std::vector<double>& vec)
 {
   for( unsigned int i =0; i< (vec.size()-1); ++i )
   {
@@ -233,253 +205,170 @@ std::ostream& operator<<(std::ostream& os, std::vector<double>& vec)
 
 //------------------------------------------------------------------
 
-/* Implement ComputeBrainDistance function. */
-void ComputeBrainDistance(
-  const std::string & inputFileName,
-  const std::string & maskFileName,
-  const std::vector<std::string> & outputFileNames,
-  unsigned int method )
+/** Typedefs. */
+typedef float                                             InputComponentType;
+typedef itk::Vector<InputComponentType, 3>                InputPixelType;
+typedef unsigned char                                     MaskPixelType;
+typedef itk::Image< InputPixelType, 3 >                   InputImageType;
+typedef itk::Image< MaskPixelType, 3 >                    MaskImageType;
+typedef itk::ImageFileReader< InputImageType >            InputReaderType;
+typedef itk::ImageFileReader< MaskImageType >             MaskReaderType;
+typedef itk::BrainDistanceEvaluator<
+  InputImageType, MaskImageType >                         EvaluatorType;
+
+/** The state of the jobs, shared by the threads. */
+struct BrainDistanceJobStruct
 {
-  /** Typedefs. */
-  typedef float                                           InputComponentType;
-  const unsigned int Dimension = 3;
-  typedef itk::Vector<InputComponentType, Dimension>      InputPixelType;
-  typedef unsigned char                                   MaskPixelType;
-  typedef float                                           InternalPixelType;
-
-  typedef itk::Image< InputPixelType, Dimension >         InputImageType;
-  typedef itk::Image< MaskPixelType, Dimension >          MaskImageType;
-  typedef itk::Image< InternalPixelType, Dimension >      InternalImageType;
-
-  typedef itk::ImageFileReader< InputImageType >          InputReaderType;
-  typedef itk::ImageFileReader< MaskImageType >           MaskReaderType;
-
-  typedef itk::ImageRegionIteratorWithIndex<
-    InputImageType >                                      IteratorType;
-  typedef InputImageType::IndexType                       IndexType;
-  typedef InputImageType::PointType                       PointType;
-  typedef InputImageType::RegionType                      RegionType;
-  typedef RegionType::SizeType                            SizeType;
-
-  typedef itk::DisplacementFieldJacobianDeterminantFilter<
-    InputImageType, InternalPixelType, InternalImageType> JacobianFilterType;
-  typedef itk::DeformationFieldBendingEnergyFilter<
-    InputImageType, InternalPixelType, InternalImageType> BendingEnergyFilterType;
-
-  typedef itk::BinaryThresholdImageFilter<
-    MaskImageType, MaskImageType >                        ThresholderType;
-  typedef itk::LabelStatisticsImageFilter<
-    InternalImageType, MaskImageType >                    StatFilterType;
-  typedef itk::StatisticsImageFilter< MaskImageType >     MaximumComputerType;
-
-  typedef itk::RegionOfInterestImageFilter<
-    InternalImageType, InternalImageType >                JacobianCropFilterType;
-  typedef itk::RegionOfInterestImageFilter<
-    MaskImageType, MaskImageType >                        MaskCropFilterType;
-
-  typedef itk::Function::SubtractSquare<
-    InternalPixelType >                                   SubtractSquareFunctionType;
-  typedef itk::UnaryFunctorImageFilter<
-    InternalImageType, InternalImageType,
-     SubtractSquareFunctionType >                         SubtractSquareFilterType;
-
-  typedef itk::IntensityWindowingImageFilter<
-    InternalImageType, InternalImageType >                WindowFilterType;
-  typedef itk::LogImageFilter<
-    InternalImageType, InternalImageType >                LogFilterType;
-
-  /** Instantiate main variables */
+  const std::vector<std::string> *  InputFileNames;
+  const std::vector<std::string> *  MaskFileNames;
+  const std::vector<std::string> *  OutputFileNames;
+  MaskImageType::Pointer            SharedMask;
+  unsigned int                      Method;
+  unsigned int                      NumberOfStreams;
+  unsigned int                      NumberOfThreadsPerJob;
+  unsigned int                      BatchBegin;
+  unsigned int                      BatchEnd;
+  std::vector<std::string>          Errors;
+};
+
+//------------------------------------------------------------------
+
+/* Evaluate one deformation field and write its results. */
+void EvaluateBrainDistance( const BrainDistanceJobStruct & jobs, unsigned int k )
+{
+  /** Setup the readers; only the meta data is read here. */
   InputReaderType::Pointer inputReader = InputReaderType::New();
-  InputImageType::Pointer inputImage = 0;
+  inputReader->SetFileName( ( *jobs.InputFileNames )[ k ] );
+
+  MaskImageType::Pointer labelMask = jobs.SharedMask;
   MaskReaderType::Pointer maskReader = MaskReaderType::New();
-  MaskCropFilterType::Pointer maskCropFilter = MaskCropFilterType::New();
-  MaskImageType::Pointer labelMask = 0;
-  MaskImageType::Pointer brainMask = 0;
-  InternalImageType::Pointer jacobian = 0;
-  JacobianCropFilterType::Pointer jacobianCropFilter = JacobianCropFilterType::New();
-  ThresholderType::Pointer thresholder = ThresholderType::New();
-  StatFilterType::Pointer statFilterBrainMask = StatFilterType::New();
-  StatFilterType::Pointer statFilterLabels = StatFilterType::New();
-  StatFilterType::Pointer statFilterLabelsSpecial = StatFilterType::New();
-  MaximumComputerType::Pointer maximumComputer  = MaximumComputerType::New();
-  SubtractSquareFilterType::Pointer subsqFilter = SubtractSquareFilterType::New();
-  WindowFilterType::Pointer windowFilter = WindowFilterType::New();
-  LogFilterType::Pointer logFilter = LogFilterType::New();
-
-  /** method 0 or 1 */
-  JacobianFilterType::Pointer jacobianFilter = 0;
-  if( method==0 || method ==2 )
+  if( labelMask.IsNull() )
   {
-    jacobianFilter = JacobianFilterType::New();
-  }
-  else
-  {
-    jacobianFilter = BendingEnergyFilterType::New();
+    maskReader->SetFileName( ( *jobs.MaskFileNames )[ k ] );
+    labelMask = maskReader->GetOutput();
   }
 
-  /** Read image. */
-  std::cout << "Reading input image..." << std::endl;
-  inputReader->SetFileName( inputFileName );
-  inputImage = inputReader->GetOutput();
-  inputImage->Update();
-
-  /** Compute the 'jacobian' (or bending energy) and crop */
-  std::cout << "Computing jacobian image..." << std::endl;
-  jacobianFilter->SetUseImageSpacingOn();
-  jacobianFilter->SetInput( inputImage );
-  jacobianFilter->UpdateLargestPossibleRegion();
-  RegionType oldregion = jacobianFilter->GetOutput()->GetLargestPossibleRegion();
-  SizeType oldsize = oldregion.GetSize();
-  IndexType oldindex = oldregion.GetIndex();
-  RegionType newregion;
-  SizeType newsize;
-  IndexType newindex;
-  for( unsigned int d = 0; d < Dimension; ++d)
-  {
-    newsize[d] = oldsize[d] - 2;
-    newindex[d] = oldindex[d] + 1;
-  }
-  newregion.SetIndex( newindex);
-  newregion.SetSize( newsize );
-  jacobianCropFilter->SetRegionOfInterest( newregion );
-  jacobianCropFilter->SetInput( jacobianFilter->GetOutput() );
-  jacobianCropFilter->Update();
-
-  const double maxJac = 3.0;
-  if( method ==2 )
-  {
-    /** Clamp and take log */
-    windowFilter->SetInput( jacobianCropFilter->GetOutput() );
-    windowFilter->SetOutputMinimum( 1.0 / maxJac );
-    windowFilter->SetWindowMinimum( 1.0 / maxJac );
-    windowFilter->SetOutputMaximum( maxJac );
-    windowFilter->SetWindowMaximum( maxJac );
-    logFilter->SetInput( windowFilter->GetOutput() );
-    logFilter->Update();
-    jacobian = logFilter->GetOutput();
-  }
-  else
-  {
-    /** Do nothing */
-    jacobian = jacobianCropFilter->GetOutput();
-  }
+  /** The single pass. */
+  EvaluatorType::Pointer evaluator = EvaluatorType::New();
+  evaluator->SetInput( inputReader->GetOutput() );
+  evaluator->SetLabelImage( labelMask );
+  evaluator->SetMethod( jobs.Method );
+  evaluator->SetNumberOfStreamDivisions( jobs.NumberOfStreams );
+  evaluator->SetNumberOfThreads( jobs.NumberOfThreadsPerJob );
+  evaluator->Compute();
 
-  /** Read the label mask and crop */
-  std::cout << "Reading label mask image..." << std::endl;
-  maskReader->SetFileName( maskFileName );
-  maskReader->Update();
-  maskCropFilter->SetRegionOfInterest( newregion );
-  maskCropFilter->SetInput( maskReader->GetOutput() );
-  labelMask = maskCropFilter->GetOutput();
-  labelMask->Update();
-
-  /** Generate brain mask by thresholding at 0 (assumes Hammer atlas) */
-  std::cout << "Thresholding label image..." << std::endl;
-  thresholder->SetLowerThreshold( itk::NumericTraits<MaskPixelType>::Zero );
-  thresholder->SetUpperThreshold( itk::NumericTraits<MaskPixelType>::Zero );
-  thresholder->SetInsideValue( itk::NumericTraits<MaskPixelType>::Zero );
-  thresholder->SetOutsideValue( itk::NumericTraits<MaskPixelType>::One );
-  thresholder->SetInput( labelMask );
-  brainMask = thresholder->GetOutput();
-  brainMask->Update();
-
-  /** Compute mu_tot and sigma_tot over brain mask */
-  std::cout << "Compute mu_tot and sigma_tot over entire brain..."  << std::endl;
-  statFilterBrainMask->SetInput( jacobian );
-  statFilterBrainMask->SetLabelInput( brainMask );
-  statFilterBrainMask->UseHistogramsOff();
-  statFilterBrainMask->Update();
-  double mu_tot = 0.0;
-  double sigma_tot = 0.0;
-  if( statFilterBrainMask->HasLabel( 1 ) )
+  /** Write results to files */
+  const std::string & outputFileName0 = ( *jobs.OutputFileNames )[ 2 * k ];
+  const std::string & outputFileName1 = ( *jobs.OutputFileNames )[ 2 * k + 1 ];
+  std::ofstream mutotsigmatot( outputFileName0.c_str() );
+  if( ! mutotsigmatot.is_open() )
   {
-    mu_tot = statFilterBrainMask->GetMean(1);
-    sigma_tot = statFilterBrainMask->GetSigma(1);
+    itkGenericExceptionMacro( << "The output file " << outputFileName0
+    << " cannot be opened!" )
   }
-  else
+  mutotsigmatot << evaluator->GetMeanTotal() << "\t" << evaluator->GetSigmaTotal() << std::endl;
+  mutotsigmatot.close();
+  std::ofstream musigmaperlabel( outputFileName1.c_str() );
+  if( ! musigmaperlabel.is_open() )
   {
-    itkGenericExceptionMacro( << "ERROR: the thresholded label mask image "
-      << "does not contain any 1's" );
+    itkGenericExceptionMacro( << "The output file " << outputFileName1
+    << " cannot be opened!" )
   }
+  musigmaperlabel << evaluator->GetLabelMeans() << std::endl;
+  musigmaperlabel << evaluator->GetLabelSigmas() << std::endl;
+  musigmaperlabel << evaluator->GetLabelSigmasTotal() << std::endl;
+  musigmaperlabel.close();
+
+} // end EvaluateBrainDistance()
 
-  /** Compute maximum label nr */
-  std::cout << "Compute maximum label nr..." << std::endl;
-  maximumComputer->SetInput( labelMask );
-  maximumComputer->Update();
-  MaskPixelType maxLabelNr = maximumComputer->GetMaximum();
-
-  /** Compute mean_i and sigma_i for each segment_i */
-  std::cout << "Compute mu_i and sigma_i for each brain segment_i in the "
-    << "label image..."  << std::endl;
-  statFilterLabels->SetInput( jacobian );
-  statFilterLabels->SetLabelInput( labelMask );
-  statFilterLabels->UseHistogramsOff();
-  statFilterLabels->Update();
-  std::vector<double> mu_i( maxLabelNr + 1, 0.0);
-  std::vector<double> sigma_i( maxLabelNr + 1, 0.0);
-  for ( MaskPixelType i = 0; i <= maxLabelNr; ++i )
+//------------------------------------------------------------------
+
+/* Thread callback that evaluates one deformation field of the batch. */
+ITK_THREAD_RETURN_TYPE BrainDistanceThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info
+    = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  const itk::ThreadIdType threadId = info->ThreadID;
+  BrainDistanceJobStruct * jobs = static_cast<BrainDistanceJobStruct *>( info->UserData );
+
+  const unsigned int k = jobs->BatchBegin + threadId;
+  if( k < jobs->BatchEnd )
   {
-    if( statFilterLabels->HasLabel( i ) )
+    /** Exceptions can not cross the thread boundary; report them afterwards. */
+    try
     {
-      mu_i[ i ] = statFilterLabels->GetMean( i );
-      sigma_i[ i ] = statFilterLabels->GetSigma( i );
+      EvaluateBrainDistance( *jobs, k );
     }
-    else
+    catch( itk::ExceptionObject & excp )
     {
-      /** Some bogus value which will never occur */
-      mu_i[ i ] = -1000.0;
-      sigma_i[ i ] = -1000.0;
+      jobs->Errors[ threadId ] = excp.GetDescription();
     }
   }
 
-  /** Compute (Jac - mu_tot)^2 image */
-  std::cout << "Compute ( jacobian - mu_tot )^2... " << std::endl;
-  subsqFilter->GetFunctor().SetScalarToSubtract( mu_tot );
-  subsqFilter->SetInput( jacobian );
-  subsqFilter->Update();
-
-  /** Compute sigma_i,tot for each segment_i */
-  std::cout << "Compute sigma_i,tot = sqrt[ mean[ ( jacobian - mu_tot )^2 ] ] "
-    << "per segment_i... " << std::endl;
-  statFilterLabelsSpecial->SetInput( subsqFilter->GetOutput() );
-  statFilterLabelsSpecial->SetLabelInput( labelMask );
-  statFilterLabelsSpecial->UseHistogramsOff();
-  statFilterLabelsSpecial->Update();
-  std::vector<double> sigma_itot( maxLabelNr + 1, 0.0);
-  for ( MaskPixelType i = 0; i <= maxLabelNr; ++i )
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end BrainDistanceThreaderCallback()
+
+//------------------------------------------------------------------
+
+/* Implement ComputeBrainDistance function. */
+void ComputeBrainDistance(
+  const std::vector<std::string> & inputFileNames,
+  const std::vector<std::string> & maskFileNames,
+  const std::vector<std::string> & outputFileNames,
+  unsigned int method,
+  unsigned int numberOfStreams,
+  unsigned int numberOfJobs )
+{
+  const unsigned int numberOfInputs = static_cast<unsigned int>( inputFileNames.size() );
+  const unsigned int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  const unsigned int batchSize = vnl_math_max( 1u,
+    vnl_math_min( vnl_math_min( numberOfJobs, numberOfInputs ), numberOfThreads ) );
+
+  BrainDistanceJobStruct jobs;
+  jobs.InputFileNames = &inputFileNames;
+  jobs.MaskFileNames = &maskFileNames;
+  jobs.OutputFileNames = &outputFileNames;
+  jobs.Method = method;
+  jobs.NumberOfStreams = numberOfStreams;
+  jobs.NumberOfThreadsPerJob = vnl_math_max( 1u, numberOfThreads / batchSize );
+  jobs.Errors.resize( batchSize );
+
+  /** A single label image is read once, and shared by all jobs. */
+  if( maskFileNames.size() == 1 )
+  {
+    std::cout << "Reading label mask image..." << std::endl;
+    MaskReaderType::Pointer maskReader = MaskReaderType::New();
+    maskReader->SetFileName( maskFileNames[ 0 ] );
+    maskReader->Update();
+    jobs.SharedMask = maskReader->GetOutput();
+    jobs.SharedMask->DisconnectPipeline();
+  }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  for( unsigned int batch = 0; batch < numberOfInputs; batch += batchSize )
   {
-    if( statFilterLabelsSpecial->HasLabel( i ) )
+    jobs.BatchBegin = batch;
+    jobs.BatchEnd = vnl_math_min( batch + batchSize, numberOfInputs );
+    for( unsigned int k = jobs.BatchBegin; k < jobs.BatchEnd; ++k )
     {
-      sigma_itot[ i ] = vcl_sqrt( statFilterLabelsSpecial->GetMean( i ) );
+      std::cout << "Computing the brain distance of " << inputFileNames[ k ] << "..." << std::endl;
     }
-    else
+
+    std::fill( jobs.Errors.begin(), jobs.Errors.end(), std::string() );
+    threader->SetNumberOfThreads( jobs.BatchEnd - jobs.BatchBegin );
+    threader->SetSingleMethod( BrainDistanceThreaderCallback, &jobs );
+    threader->SingleMethodExecute();
+    for( unsigned int k = 0; k < jobs.BatchEnd - jobs.BatchBegin; ++k )
     {
-      /** Some bogus value which will never occur */
-      sigma_itot[ i ] = -1000.0;
+      if( !jobs.Errors[ k ].empty() )
+      {
+        itkGenericExceptionMacro( << "ERROR: processing "
+          << inputFileNames[ batch + k ] << " failed:\n" << jobs.Errors[ k ] );
+      }
     }
   }
 
-  /** Write results to files */
-  std::cout << "Write results to files" << std::endl;
-  std::ofstream mutotsigmatot( outputFileNames[0].c_str() );
-  if( ! mutotsigmatot.is_open() )
-  {
-    itkGenericExceptionMacro( << "The output file " << outputFileNames[0]
-    << " cannot be opened!" )
-  }
-  mutotsigmatot << mu_tot << "\t" << sigma_tot << std::endl;
-  mutotsigmatot.close();
-  std::ofstream musigmaperlabel( outputFileNames[1].c_str() );
-  if( ! musigmaperlabel.is_open() )
-  {
-    itkGenericExceptionMacro( << "The output file " << outputFileNames[1]
-    << " cannot be opened!" )
-  }
-  musigmaperlabel << mu_i << std::endl;
-  musigmaperlabel << sigma_i << std::endl;
-  musigmaperlabel << sigma_itot << std::endl;
-  musigmaperlabel.close();
-
   std::cout << "Ready!" << std::endl;
 
 } // end ComputeBrainDistance()
@@ -0,0 +1,180 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkBrainDistanceEvaluator_h_
+#define __itkBrainDistanceEvaluator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+#include <vector>
+
+
+namespace itk {
+
+/** \class BrainDistanceEvaluator
+ * \brief Computes the label statistics of the Jacobian determinant, the
+ * log of the Jacobian determinant, or the bending energy of a deformation
+ * field in a single streamed pass.
+ *
+ * The evaluator computes the same numbers as the original pxbraindistance
+ * pipeline. That pipeline computed the Jacobian image with
+ * DisplacementFieldJacobianDeterminantFilter (or the bending energy with
+ * DeformationFieldBendingEnergyFilter), cropped the border, and ran
+ * LabelStatisticsImageFilter three times.
+ *
+ * Here the field is requested piece by piece, each piece padded by one
+ * voxel for the central differences. Every piece is split over the
+ * threads. Each thread evaluates the Jacobian (or bending energy) voxel by
+ * voxel, and adds it to per-label sums, sums of squares and counts. No
+ * Jacobian image is made. The statistics of the brain (label > 0), and
+ * mean[ (J - mu_tot)^2 ] per label, follow from the per-label sums, so a
+ * single pass suffices.
+ *
+ * As in the original pipeline, the border voxels of the image are
+ * skipped. For method 2 the Jacobian is clamped to [1/3, 3] before the log.
+ * The value is computed in double precision and rounded to float before
+ * it is accumulated, like the float Jacobian image was.
+ *
+ * The label image may be shared by several evaluators running
+ * concurrently. If its buffered region already contains the image, it is
+ * only read.
+ */
+
+template< class TDeformationField, class TLabelImage >
+class BrainDistanceEvaluator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef BrainDistanceEvaluator      Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BrainDistanceEvaluator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TDeformationField::ImageDimension );
+
+  /** Typedefs. */
+  typedef TDeformationField                         DeformationFieldType;
+  typedef typename DeformationFieldType::Pointer    DeformationFieldPointer;
+  typedef typename DeformationFieldType::PixelType  VectorType;
+  typedef typename DeformationFieldType::RegionType RegionType;
+  typedef TLabelImage                               LabelImageType;
+  typedef typename LabelImageType::Pointer          LabelImagePointer;
+  typedef typename LabelImageType::PixelType        LabelType;
+
+  /** The methods of pxbraindistance. */
+  enum MethodType { Jacobian = 0, BendingEnergy = 1, LogJacobian = 2 };
+
+  /** Connect the deformation field. It is not const, since requested regions
+   * are set on it to drive the upstream pipeline.
+   */
+  void SetInput( DeformationFieldType * field );
+
+  /** Connect the label image; label 0 is outside the brain. */
+  void SetLabelImage( LabelImageType * labels );
+
+  /** Select the method. */
+  itkSetMacro( Method, unsigned int );
+  itkGetConstMacro( Method, unsigned int );
+
+  /** Set the number of pieces in which the field is processed. */
+  itkSetMacro( NumberOfStreamDivisions, unsigned int );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
+  /** Set the number of threads. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Triggers the computation; this is the only pass over the field. */
+  void Compute( void );
+
+  /** Mean and sigma over the brain. The sigma of a single voxel is 0.
+   * Valid after Compute().
+   */
+  itkGetConstMacro( MeanTotal, double );
+  itkGetConstMacro( SigmaTotal, double );
+
+  /** Per label, from 0 to the largest label in the image: the mean, the
+   * sigma, and the root mean squared difference with MeanTotal. Labels
+   * that do not occur get -1000, labels of a single voxel a sigma of 0.
+   * Valid after Compute().
+   */
+  const std::vector<double> & GetLabelMeans( void ) const
+  { return this->m_LabelMeans; }
+  const std::vector<double> & GetLabelSigmas( void ) const
+  { return this->m_LabelSigmas; }
+  const std::vector<double> & GetLabelSigmasTotal( void ) const
+  { return this->m_LabelSigmasTotal; }
+
+protected:
+  BrainDistanceEvaluator();
+  virtual ~BrainDistanceEvaluator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Per label sums. */
+  struct LabelAccumulator
+  {
+    std::vector<double>         Sum;
+    std::vector<double>         SumOfSquares;
+    std::vector<SizeValueType>  Count;
+  };
+
+  /** Accumulate the values of a part of the current piece. */
+  void ThreadedAccumulate( const RegionType & region, ThreadIdType threadId );
+
+private:
+  BrainDistanceEvaluator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  /** Callback for the multithreader. */
+  static ITK_THREAD_RETURN_TYPE AccumulateThreaderCallback( void * arg );
+
+  DeformationFieldPointer   m_Input;
+  LabelImagePointer         m_LabelImage;
+  unsigned int              m_Method;
+  unsigned int              m_NumberOfStreamDivisions;
+  unsigned int              m_NumberOfThreads;
+
+  /** State shared with the threads. */
+  RegionType                      m_Piece;
+  double                          m_HalfDerivativeWeights[ ImageDimension ];
+  std::vector<LabelAccumulator>   m_ThreadAccumulators;
+
+  /** Results. */
+  double                    m_MeanTotal;
+  double                    m_SigmaTotal;
+  std::vector<double>       m_LabelMeans;
+  std::vector<double>       m_LabelSigmas;
+  std::vector<double>       m_LabelSigmasTotal;
+
+}; // end class BrainDistanceEvaluator
+
+
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBrainDistanceEvaluator.txx"
+#endif
+
+#endif // end #ifndef __itkBrainDistanceEvaluator_h_
@@ -0,0 +1,378 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkBrainDistanceEvaluator_txx_
+#define __itkBrainDistanceEvaluator_txx_
+
+#include "itkBrainDistanceEvaluator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionSplitter.h"
+#include "vnl/vnl_matrix_fixed.h"
+#include "vnl/vnl_det.h"
+#include "vnl/vnl_math.h"
+
+
+namespace itk {
+
+/**
+ * ************************* Constructor ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::BrainDistanceEvaluator()
+{
+  this->m_Method = Jacobian;
+  this->m_NumberOfStreamDivisions = 1;
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->m_MeanTotal = 0.0;
+  this->m_SigmaTotal = 0.0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_HalfDerivativeWeights[ d ] = 0.5;
+  }
+
+} // end Constructor()
+
+
+/**
+ * ************************* SetInput ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+void
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::SetInput( DeformationFieldType * field )
+{
+  if( this->m_Input != field )
+  {
+    this->m_Input = field;
+    this->Modified();
+  }
+
+} // end SetInput()
+
+
+/**
+ * ************************* SetLabelImage ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+void
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::SetLabelImage( LabelImageType * labels )
+{
+  if( this->m_LabelImage != labels )
+  {
+    this->m_LabelImage = labels;
+    this->Modified();
+  }
+
+} // end SetLabelImage()
+
+
+/**
+ * ************************* Compute ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+void
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::Compute( void )
+{
+  if( this->m_Input.IsNull() || this->m_LabelImage.IsNull() )
+  {
+    itkExceptionMacro( << "ERROR: the deformation field and the label image should be set." );
+  }
+  if( this->m_Method > LogJacobian )
+  {
+    itkExceptionMacro( << "ERROR: unknown method " << this->m_Method << "." );
+  }
+
+  /** Only the meta data is read here. A shared label image has no source. */
+  this->m_Input->UpdateOutputInformation();
+  if( this->m_LabelImage->GetSource() )
+  {
+    this->m_LabelImage->UpdateOutputInformation();
+  }
+  const RegionType largestRegion = this->m_Input->GetLargestPossibleRegion();
+  if( this->m_LabelImage->GetLargestPossibleRegion() != largestRegion )
+  {
+    itkExceptionMacro( << "ERROR: the label image does not have the same size as the deformation field." );
+  }
+
+  /** The border is skipped, as the central differences are not defined there. */
+  RegionType interior = largestRegion;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    if( largestRegion.GetSize()[ d ] < 3 )
+    {
+      itkExceptionMacro( << "ERROR: the deformation field should have at least 3 voxels in each dimension." );
+    }
+    interior.SetIndex( d, largestRegion.GetIndex()[ d ] + 1 );
+    interior.SetSize( d, largestRegion.GetSize()[ d ] - 2 );
+  }
+
+  const typename DeformationFieldType::SpacingType spacing = this->m_Input->GetSpacing();
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    this->m_HalfDerivativeWeights[ d ] = 0.5 / spacing[ d ];
+  }
+
+  /** Reset the per-thread accumulators. */
+  const std::size_t numberOfLabels
+    = static_cast<std::size_t>( NumericTraits<LabelType>::max() ) + 1;
+  this->m_ThreadAccumulators.resize( this->m_NumberOfThreads );
+  for( unsigned int t = 0; t < this->m_NumberOfThreads; ++t )
+  {
+    this->m_ThreadAccumulators[ t ].Sum.assign( numberOfLabels, 0.0 );
+    this->m_ThreadAccumulators[ t ].SumOfSquares.assign( numberOfLabels, 0.0 );
+    this->m_ThreadAccumulators[ t ].Count.assign( numberOfLabels, 0 );
+  }
+
+  /** The single pass over the field. */
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(
+    interior, vnl_math_max( 1u, this->m_NumberOfStreamDivisions ) );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( this->m_NumberOfThreads );
+  for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+  {
+    this->m_Piece = splitter->GetSplit( piece, numberOfPieces, interior );
+
+    RegionType fieldRegion = this->m_Piece;
+    fieldRegion.PadByRadius( 1 );
+    fieldRegion.Crop( largestRegion );
+    this->m_Input->SetRequestedRegion( fieldRegion );
+    this->m_Input->Update();
+    if( !this->m_LabelImage->GetBufferedRegion().IsInside( this->m_Piece ) )
+    {
+      this->m_LabelImage->SetRequestedRegion( this->m_Piece );
+      this->m_LabelImage->Update();
+    }
+
+    threader->SetSingleMethod( this->AccumulateThreaderCallback, this );
+    threader->SingleMethodExecute();
+  }
+
+  /** Merge the threads. */
+  LabelAccumulator total = this->m_ThreadAccumulators[ 0 ];
+  for( unsigned int t = 1; t < this->m_NumberOfThreads; ++t )
+  {
+    const LabelAccumulator & accumulator = this->m_ThreadAccumulators[ t ];
+    for( std::size_t i = 0; i < numberOfLabels; ++i )
+    {
+      total.Sum[ i ] += accumulator.Sum[ i ];
+      total.SumOfSquares[ i ] += accumulator.SumOfSquares[ i ];
+      total.Count[ i ] += accumulator.Count[ i ];
+    }
+  }
+  this->m_ThreadAccumulators.clear();
+
+  /** The statistics of the brain, as in LabelStatisticsImageFilter. */
+  double brainSum = 0.0;
+  double brainSumOfSquares = 0.0;
+  double brainCount = 0.0;
+  std::size_t maximumLabel = 0;
+  for( std::size_t i = 0; i < numberOfLabels; ++i )
+  {
+    if( total.Count[ i ] == 0 ) continue;
+    maximumLabel = i;
+    if( i == 0 ) continue;
+    brainSum += total.Sum[ i ];
+    brainSumOfSquares += total.SumOfSquares[ i ];
+    brainCount += static_cast<double>( total.Count[ i ] );
+  }
+  if( brainCount == 0.0 )
+  {
+    itkExceptionMacro( << "ERROR: the label image does not contain any nonzero labels." );
+  }
+  this->m_MeanTotal = brainSum / brainCount;
+  this->m_SigmaTotal = 0.0;
+  if( brainCount > 1.0 )
+  {
+    this->m_SigmaTotal = vcl_sqrt( vnl_math_max( 0.0,
+      ( brainSumOfSquares - brainSum * brainSum / brainCount ) / ( brainCount - 1.0 ) ) );
+  }
+
+  /** The statistics per label; mean[ (J - mu_tot)^2 ] follows from the sums. */
+  const double mu = this->m_MeanTotal;
+  this->m_LabelMeans.assign( maximumLabel + 1, -1000.0 );
+  this->m_LabelSigmas.assign( maximumLabel + 1, -1000.0 );
+  this->m_LabelSigmasTotal.assign( maximumLabel + 1, -1000.0 );
+  for( std::size_t i = 0; i <= maximumLabel; ++i )
+  {
+    if( total.Count[ i ] == 0 ) continue;
+    const double n = static_cast<double>( total.Count[ i ] );
+    const double sum = total.Sum[ i ];
+    const double sumOfSquares = total.SumOfSquares[ i ];
+    this->m_LabelMeans[ i ] = sum / n;
+    this->m_LabelSigmas[ i ] = 0.0;
+    if( n > 1.0 )
+    {
+      this->m_LabelSigmas[ i ] = vcl_sqrt( vnl_math_max( 0.0,
+        ( sumOfSquares - sum * sum / n ) / ( n - 1.0 ) ) );
+    }
+    this->m_LabelSigmasTotal[ i ] = vcl_sqrt( vnl_math_max( 0.0,
+      ( sumOfSquares - 2.0 * mu * sum + n * mu * mu ) / n ) );
+  }
+
+} // end Compute()
+
+
+/**
+ * ************************* AccumulateThreaderCallback ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+ITK_THREAD_RETURN_TYPE
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::AccumulateThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int total = splitter->GetNumberOfSplits( self->m_Piece, threadCount );
+  if( threadId < total )
+  {
+    self->ThreadedAccumulate( splitter->GetSplit( threadId, total, self->m_Piece ), threadId );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateThreaderCallback()
+
+
+/**
+ * ************************* ThreadedAccumulate ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+void
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::ThreadedAccumulate( const RegionType & region, ThreadIdType threadId )
+{
+  const DeformationFieldType * field = this->m_Input;
+  const OffsetValueType * offsetTable = field->GetOffsetTable();
+  const double * w = this->m_HalfDerivativeWeights;
+  const double minimumJacobian = 1.0 / 3.0;
+  const double maximumJacobian = 3.0;
+  LabelAccumulator & accumulator = this->m_ThreadAccumulators[ threadId ];
+
+  ImageRegionConstIterator<DeformationFieldType> it( field, region );
+  ImageRegionConstIterator<LabelImageType> labelIt( this->m_LabelImage, region );
+  vnl_matrix_fixed<double, ImageDimension, ImageDimension> jacobian;
+  for( ; !it.IsAtEnd(); ++it, ++labelIt )
+  {
+    /** The neighbours are found with the offset table of the buffer. */
+    const VectorType * center = &it.Value();
+    float value = 0.0f;
+    if( this->m_Method == BendingEnergy )
+    {
+      /** The sum of all squared second order derivatives. */
+      double bending = 0.0;
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        const VectorType & p = center[ offsetTable[ i ] ];
+        const VectorType & q = center[ -offsetTable[ i ] ];
+        double squaredNorm = 0.0;
+        for( unsigned int k = 0; k < ImageDimension; ++k )
+        {
+          const double pqc = static_cast<double>( p[ k ] ) + q[ k ] - 2.0 * ( *center )[ k ];
+          squaredNorm += pqc * pqc;
+        }
+        bending += squaredNorm * vnl_math_sqr( w[ i ] * w[ i ] );
+      }
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        for( unsigned int j = i + 1; j < ImageDimension; ++j )
+        {
+          const VectorType & p = center[ offsetTable[ i ] + offsetTable[ j ] ];
+          const VectorType & q = center[ -offsetTable[ i ] - offsetTable[ j ] ];
+          const VectorType & r = center[ offsetTable[ i ] - offsetTable[ j ] ];
+          const VectorType & s = center[ -offsetTable[ i ] + offsetTable[ j ] ];
+          double squaredNorm = 0.0;
+          for( unsigned int k = 0; k < ImageDimension; ++k )
+          {
+            const double pqrs = static_cast<double>( p[ k ] ) + q[ k ] - r[ k ] - s[ k ];
+            squaredNorm += pqrs * pqrs;
+          }
+          bending += 2.0 * squaredNorm * vnl_math_sqr( w[ i ] * w[ j ] );
+        }
+      }
+      value = static_cast<float>( bending );
+    }
+    else
+    {
+      /** The determinant of the identity plus the gradient of the field. */
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        const VectorType & next = center[ offsetTable[ i ] ];
+        const VectorType & previous = center[ -offsetTable[ i ] ];
+        for( unsigned int j = 0; j < ImageDimension; ++j )
+        {
+          jacobian[ i ][ j ] = w[ i ] * ( static_cast<double>( next[ j ] ) - previous[ j ] );
+        }
+        jacobian[ i ][ i ] += 1.0;
+      }
+      value = static_cast<float>( vnl_det( jacobian ) );
+      if( this->m_Method == LogJacobian )
+      {
+        const double clamped = vnl_math_min( vnl_math_max(
+          static_cast<double>( value ), minimumJacobian ), maximumJacobian );
+        value = static_cast<float>( vcl_log( clamped ) );
+      }
+    }
+
+    const std::size_t label = static_cast<std::size_t>( labelIt.Value() );
+    accumulator.Sum[ label ] += value;
+    accumulator.SumOfSquares[ label ] += static_cast<double>( value ) * value;
+    ++accumulator.Count[ label ];
+  }
+
+} // end ThreadedAccumulate()
+
+
+/**
+ * ************************* PrintSelf ************************
+ */
+
+template< class TDeformationField, class TLabelImage >
+void
+BrainDistanceEvaluator< TDeformationField, TLabelImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Method: " << this->m_Method << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << this->m_NumberOfStreamDivisions << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "MeanTotal: " << this->m_MeanTotal << std::endl;
+  os << indent << "SigmaTotal: " << this->m_SigmaTotal << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace itk
+
+#endif // end #ifndef __itkBrainDistanceEvaluator_txx_
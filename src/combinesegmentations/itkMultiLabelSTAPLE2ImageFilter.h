@@ -110,6 +110,15 @@ namespace itk
   * converged. The algorithm makes no attempt to report its progress since the
   * number of iterations needed cannot be known in advance.
   *
+  * \par MULTITHREADING
+  * The E and M steps of each iteration are performed by multiple threads.
+  * Each thread accumulates a partial update of the confusion matrices over
+  * its part of the image, and these partial updates are summed after each
+  * iteration. The prior probability images, if provided, are copied once to
+  * a single buffer in which the probabilities of all classes of a pixel are
+  * contiguous, so that every pixel reads one block of memory instead of one
+  * value from each of the class images.
+  *
   * This code is largely based on the MultiLabelSTAPLEImageFilter code
   * written by Rohlfing.
   *
@@ -372,6 +381,39 @@ namespace itk
     /** Do the actual work */
     void GenerateData();
 
+    /** Typedefs for multithreading. */
+    typedef std::vector<ConfusionMatrixType>        ConfusionMatrixArrayType;
+    typedef std::vector<ConfusionMatrixArrayType>   ConfusionMatrixArrayArrayType;
+
+    /** Perform the E and M step on a part of the image, for one iteration. */
+    virtual void ThreadedExpectationMaximization(
+      const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+    /** Build the combined output on a part of the image,
+     * based on the estimated confusion matrices. */
+    virtual void ThreadedGenerateCombinedSegmentation(
+      const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+    /** Execute ThreadedExpectationMaximization() or
+     * ThreadedGenerateCombinedSegmentation() using multiple threads. */
+    virtual void ExecuteThreadedPass( bool combine );
+
+    /** Struct and callback for the multithreader. */
+    struct STAPLEThreadStruct
+    {
+      Pointer Filter;
+      bool    Combine;
+    };
+    static ITK_THREAD_RETURN_TYPE STAPLEThreaderCallback( void * arg );
+
+    /** Copy the prior probability images to m_InterleavedPriorProbabilities. */
+    virtual void InterleavePriorProbabilityImages();
+
+    /** Get a pointer to the interleaved prior probabilities of the first pixel
+     * of a region, or 0 if no prior probability images are used. */
+    virtual const WeightsType * GetInterleavedPriorProbabilities(
+      const OutputImageRegionType & region ) const;
+
     /** Print some information, not really implemented */
     void PrintSelf(std::ostream&, Indent) const;
 
@@ -407,10 +449,18 @@ namespace itk
     ProbabilisticSegmentationArrayType m_ProbabilisticSegmentationArray;
     PriorPreferenceType                m_PriorPreference;
 
+    /** For multithreading: the partial confusion matrix updates of each thread,
+     * and the prior probabilities of all classes of each pixel, contiguously. */
+    ConfusionMatrixArrayArrayType      m_ThreadConfusionMatrixArrays;
+    std::vector<WeightsType>           m_InterleavedPriorProbabilities;
+
     /** Variables updated during iterating: */
     WeightsType m_MaximumConfusionMatrixElementUpdate;
     unsigned int m_ElapsedIterations;
 
+    /** The label with the highest priorPreference number */
+    OutputPixelType m_LeastPreferredLabel;
+
   private:
     MultiLabelSTAPLE2ImageFilter(const Self&); //purposely not implemented
     void operator=(const Self&); //purposely not implemented
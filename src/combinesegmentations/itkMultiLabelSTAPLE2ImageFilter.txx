@@ -21,6 +21,7 @@
 #include "itkMultiLabelSTAPLE2ImageFilter.h"
 #include "itkLabelVoting2ImageFilter.h"
 
+#include "itkMultiThreader.h"
 #include "vnl/vnl_math.h"
 
 namespace itk
@@ -246,284 +247,259 @@ namespace itk
   template< typename TInputImage, typename TOutputImage, typename TWeights >
     void
     MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
-    ::GenerateData()
+    ::InterleavePriorProbabilityImages()
   {
-    typedef Array<WeightsType>                  WType;
-    typedef std::vector<InputConstIteratorType> InputConstIteratorArrayType;
-    typedef std::vector<ProbIteratorType>       ProbIteratorArrayType;
-    typedef std::vector<ProbConstIteratorType>  ProbConstIteratorArrayType;
-
-    /** Initialize some variables */
-    this->m_MaximumConfusionMatrixElementUpdate = 0.0;
-    this->m_ElapsedIterations = 0;
-    const bool generateProbSeg =
-      this->GetGenerateProbabilisticSegmentations();
-    const bool useMask = this->m_MaskImage.IsNotNull();
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
-    WType W( this->m_NumberOfClasses );
-    OutputImagePointer output = this->GetOutput();
-    this->AllocateOutputs();
-
-    /** Set some default values if necessary */
-    if( this->m_HasNumberOfClasses == false )
+    this->m_InterleavedPriorProbabilities.clear();
+    if( !this->m_HasPriorProbabilityImageArray ) return;
+
+    /** Copy the prior probabilities of all classes of a pixel
+     * next to each other, in the order of the requested region. */
+    const OutputImageRegionType region = this->GetOutput()->GetRequestedRegion();
+    const unsigned int numberOfClasses = this->m_NumberOfClasses;
+    this->m_InterleavedPriorProbabilities.resize(
+      region.GetNumberOfPixels() * numberOfClasses );
+    for( unsigned int ci = 0; ci < numberOfClasses; ++ci )
     {
-      this->m_NumberOfClasses = this->ComputeMaximumInputValue() + 1;
-    }
-    if( ! this->m_HasPriorPreference )
-    {
-      this->m_PriorPreference.SetSize( this->m_NumberOfClasses );
-      for( unsigned int i = 0; i < this->m_NumberOfClasses; ++i )
+      ProbConstIteratorType pit( this->m_PriorProbabilityImageArray[ ci ], region );
+      typename std::vector<WeightsType>::iterator prior
+        = this->m_InterleavedPriorProbabilities.begin() + ci;
+      for( pit.GoToBegin(); !pit.IsAtEnd(); ++pit, prior += numberOfClasses )
       {
-        this->m_PriorPreference[ i ] = i;
+        *prior = pit.Get();
       }
     }
-    if( !this->m_HasObserverTrust )
-    {
-      this->m_ObserverTrust.SetSize( numberOfInputs );
-      this->m_ObserverTrust.Fill(0.99999);
-    }
 
-    /** Determine the least preferred label */
-    OutputPixelType leastPreferredLabel = 0;
-    for( unsigned int i= 0; i< this->m_NumberOfClasses; ++i )
-    {
-      if( this->m_PriorPreference[ i ] == (this->m_NumberOfClasses-1) )
-      {
-        leastPreferredLabel = i;
-      }
-    }
+  } // end InterleavePriorProbabilityImages
 
-    /** Initialize prior probabilities and confusion matrices */
-    this->InitializePriorProbabilities();
-    this->AllocateConfusionMatrixArray();
-    this->InitializeConfusionMatrixArray();
 
-    /** If probabilistic segmentations are desired, allocate them */
-    if( generateProbSeg )
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    const typename MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >::WeightsType *
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GetInterleavedPriorProbabilities( const OutputImageRegionType & region ) const
+  {
+    if( this->m_InterleavedPriorProbabilities.empty() ) return 0;
+
+    /** The regions of the threads are split along the outermost dimension,
+     * so they are a contiguous part of the requested region. */
+    const OutputImageRegionType requestedRegion = this->GetOutput()->GetRequestedRegion();
+    OffsetValueType offset = 0;
+    OffsetValueType stride = 1;
+    for( unsigned int i = 0; i < ImageDimension; ++i )
     {
-      this->m_ProbabilisticSegmentationArray =
-        ProbabilisticSegmentationArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
-      {
-        this->m_ProbabilisticSegmentationArray[k] =
-          ProbabilityImageType::New();
-        this->m_ProbabilisticSegmentationArray[k]->SetRegions(
-          output->GetRequestedRegion() );
-        this->m_ProbabilisticSegmentationArray[k]->CopyInformation( output );
-        this->m_ProbabilisticSegmentationArray[k]->Allocate();
-      }
+      offset += ( region.GetIndex()[ i ] - requestedRegion.GetIndex()[ i ] ) * stride;
+      stride *= static_cast<OffsetValueType>( requestedRegion.GetSize()[ i ] );
     }
 
-    /** create and initialize all input image iterators */
-    InputConstIteratorArrayType it(numberOfInputs);
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
-    {
-      it[k] = InputConstIteratorType
-        ( this->GetInput( k ), output->GetRequestedRegion() );
-    }
+    return &( this->m_InterleavedPriorProbabilities[ offset * this->m_NumberOfClasses ] );
 
-    /** Create and initialize the prior prob image iterators */
-    ProbConstIteratorArrayType pit;
-    if( this->m_HasPriorProbabilityImageArray )
+  } // end GetInterleavedPriorProbabilities
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    ITK_THREAD_RETURN_TYPE
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::STAPLEThreaderCallback( void * arg )
+  {
+    MultiThreader::ThreadInfoStruct * info
+      = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+    const ThreadIdType threadId = info->ThreadID;
+    const ThreadIdType threadCount = info->NumberOfThreads;
+    STAPLEThreadStruct * str = static_cast<STAPLEThreadStruct *>( info->UserData );
+
+    /** Split the output requested region, and let this thread process its part. */
+    OutputImageRegionType splitRegion;
+    const ThreadIdType total = str->Filter->SplitRequestedRegion(
+      threadId, threadCount, splitRegion );
+    if( threadId < total )
     {
-      pit = ProbConstIteratorArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
+      if( str->Combine )
       {
-        pit[k] = ProbConstIteratorType(
-          this->m_PriorProbabilityImageArray[k], output->GetRequestedRegion() );
+        str->Filter->ThreadedGenerateCombinedSegmentation( splitRegion, threadId );
       }
-    }
-
-    /** Create and initialize the output probabilistic segmentation image iterators */
-    ProbIteratorArrayType psit;
-    if( generateProbSeg )
-    {
-      psit = ProbIteratorArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
+      else
       {
-        psit[k] = ProbIteratorType(
-          this->m_ProbabilisticSegmentationArray[k], output->GetRequestedRegion() );
+        str->Filter->ThreadedExpectationMaximization( splitRegion, threadId );
       }
     }
 
-    /** Create and initialize the mask iterator */
-    MaskConstIteratorType mit;
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end STAPLEThreaderCallback
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::ExecuteThreadedPass( bool combine )
+  {
+    STAPLEThreadStruct str;
+    str.Filter = this;
+    str.Combine = combine;
+
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod( this->STAPLEThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+
+  } // end ExecuteThreadedPass
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::ThreadedExpectationMaximization(
+      const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+  {
+    typedef std::vector<InputConstIteratorType> InputConstIteratorArrayType;
+
+    const bool useMask = this->m_MaskImage.IsNotNull();
+    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfClasses = this->m_NumberOfClasses;
     const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
+    ConfusionMatrixArrayType & updatedConfusionMatrixArray
+      = this->m_ThreadConfusionMatrixArrays[ threadId ];
+    std::vector<WeightsType> W( numberOfClasses );
+
+    /** Create and initialize the input, mask and prior iterators */
+    InputConstIteratorArrayType it( numberOfInputs );
+    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+      it[k] = InputConstIteratorType( this->GetInput( k ), outputRegionForThread );
+    }
+    MaskConstIteratorType mit;
     if( useMask )
     {
-      mit = MaskConstIteratorType(
-        this->m_MaskImage, this->GetOutput()->GetRequestedRegion() );
+      mit = MaskConstIteratorType( this->m_MaskImage, outputRegionForThread );
     }
+    const WeightsType * prior = this->GetInterleavedPriorProbabilities( outputRegionForThread );
+    const WeightsType * constantPrior = this->m_PriorProbabilities.data_block();
 
-    /** Create and initialize the output iterator */
-    OutputIteratorType out = OutputIteratorType( output, output->GetRequestedRegion() );
-
-    /** Start iterating! */
-    while (  ( !this->m_HasMaximumNumberOfIterations ) ||
-             ( this->m_ElapsedIterations < this->m_MaximumNumberOfIterations )   )
+    /** Loop over voxels and do the E and M step
+     * use it[0] as indicator for image pixel count */
+    while ( ! it[0].IsAtEnd() )
     {
-      /** reset updated confusion matrix */
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      bool insideMask = true;
+      if( useMask )
       {
-        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+        insideMask = ( mit.Get() != zeroMaskPixel );
+        ++mit;
       }
 
-      /** Loop over voxels and do the E and M step
-       * use it[0] as indicator for image pixel count */
-      while ( ! it[0].IsAtEnd() )
+      /** the following is the E step for one pixel, only performed when this
+       * pixel is inside the mask */
+      if( insideMask )
       {
-        if(useMask)
+        const WeightsType * p = prior ? prior : constantPrior;
+        for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
         {
-          if( mit.Get() == zeroMaskPixel )
-          {
-            /** Move all iterators to the next pixel and go to the
-             * next cycle of the while loop */
-            ++mit;
-            for( unsigned int k = 0; k < numberOfInputs; ++k )
-            {
-              ++(it[k]);
-            }
-            if( this->m_HasPriorProbabilityImageArray )
-            {
-              for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-              {
-                ++(pit[ci]);
-              }
-            }
-            continue;
-          } // end if mit==zero
-          /** Move the iterator to the next pixel */
-          ++mit;
-        } // end if useMask
-
-        /** the following is the E step for one pixel, only performed when this
-         * pixel is inside the mask */
-        if( this->m_HasPriorProbabilityImageArray )
-        {
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-          {
-            W[ci] = pit[ci].Get();
-            /** move already to next pixel */
-            ++(pit[ci]);
-          }
-        }
-        else
-        {
-          W = this->m_PriorProbabilities;
+          W[ci] = p[ci];
         }
 
         for( unsigned int k = 0; k < numberOfInputs; ++k )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+          const WeightsType * confusion = this->m_ConfusionMatrixArray[k][ it[k].Get() ];
+          for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
           {
-            W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
+            W[ci] *= confusion[ci];
           }
         }
 
         // the following is the M step
         /** normalize: */
-        WeightsType sumW = W.sum();
-        if( sumW )
+        WeightsType sumW = 0.0;
+        for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
         {
-          W /= sumW;
+          sumW += W[ci];
         }
-
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        if( sumW )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+          for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
           {
-            this->m_UpdatedConfusionMatrixArray[k][j][ci] += W[ci];
+            W[ci] /= sumW;
           }
-
-          // we're now done with this input pixel, so update.
-          ++(it[k]);
         }
 
-      } // end loop over voxels
-
-      /** Normalize matrix elements of each of the updated confusion matrices
-       * with sum over all expert decisions. */
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
-      {
-        // compute sum over all output classifications
-        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        for( unsigned int k = 0; k < numberOfInputs; ++k )
         {
-          WeightsType sumW = this->m_UpdatedConfusionMatrixArray[k][0][ci];
-          for ( InputPixelType j = 1; j < this->m_NumberOfClasses; ++j )
-          {
-            sumW += this->m_UpdatedConfusionMatrixArray[k][j][ci];
-          }
-
-          // normalize with sumW for each class ci
-          if( sumW )
+          WeightsType * update = updatedConfusionMatrixArray[k][ it[k].Get() ];
+          for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
           {
-            this->m_UpdatedConfusionMatrixArray[k].scale_column(ci, 1.0/sumW);
+            update[ci] += W[ci];
           }
         }
-      } // end for k: end normalization of updated confusion matrix
-
-      // now we're applying the update to the confusion matrices and compute the
-      // maximum parameter change in the process, to check for convergence.
-      WeightsType maximumUpdate = 0;
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
-      {
-        const WeightsType maximumUpdate_k = static_cast<WeightsType>(
-          (this->m_UpdatedConfusionMatrixArray[k]-this->m_ConfusionMatrixArray[k]).array_inf_norm() );
-        maximumUpdate = vnl_math_max( maximumUpdate, maximumUpdate_k );
-
-        this->m_ConfusionMatrixArray[k] = this->m_UpdatedConfusionMatrixArray[k];
-      }
-      this->m_MaximumConfusionMatrixElementUpdate = maximumUpdate;
-
-      /** We have finished this iteration */
-      ++(this->m_ElapsedIterations);
+      } // end if insideMask
 
-      /** reset all input iterators to start, to be prepared for next iteration
-       * or for generating the final segmentation, if the current iteration
-       * happened to be the last one */
-      if(useMask)
-      {
-        mit.GoToBegin();
-      }
+      /** we're now done with this pixel, so update. */
       for( unsigned int k = 0; k < numberOfInputs; ++k )
       {
-        it[k].GoToBegin();
+        ++(it[k]);
       }
-      if( this->m_HasPriorProbabilityImageArray )
+      if( prior )
       {
-        for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
-        {
-          pit[k].GoToBegin();
-        }
+        prior += numberOfClasses;
       }
 
-      /** Allow user to do something */
-      this->InvokeEvent( IterationEvent() );
-      if( this->GetAbortGenerateData() )
+    } // end loop over voxels
+
+  } // end ThreadedExpectationMaximization
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::ThreadedGenerateCombinedSegmentation(
+      const OutputImageRegionType & outputRegionForThread, ThreadIdType itkNotUsed( threadId ) )
+  {
+    typedef Array<WeightsType>                  WType;
+    typedef std::vector<InputConstIteratorType> InputConstIteratorArrayType;
+    typedef std::vector<ProbIteratorType>       ProbIteratorArrayType;
+
+    const bool generateProbSeg =
+      this->GetGenerateProbabilisticSegmentations();
+    const bool useMask = this->m_MaskImage.IsNotNull();
+    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfClasses = this->m_NumberOfClasses;
+    const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
+    WType W( this->m_NumberOfClasses );
+
+    /** Create and initialize all input image iterators */
+    InputConstIteratorArrayType it( numberOfInputs );
+    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+      it[k] = InputConstIteratorType( this->GetInput( k ), outputRegionForThread );
+    }
+
+    /** Create and initialize the output probabilistic segmentation image iterators */
+    ProbIteratorArrayType psit;
+    if( generateProbSeg )
+    {
+      psit = ProbIteratorArrayType( this->m_NumberOfClasses );
+      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
       {
-        this->ResetPipeline();
-        // fake this to cause termination; we could really just break
-        maximumUpdate = 0;
+        psit[k] = ProbIteratorType(
+          this->m_ProbabilisticSegmentationArray[k], outputRegionForThread );
       }
+    }
 
-      // if all confusion matrix parameters changes by less than the defined
-      // threshold, we're done.
-      if( maximumUpdate < this->m_TerminationUpdateThreshold )
-        break;
-
-    } // end for ( iteration )
+    /** Create and initialize the mask and prior iterators */
+    MaskConstIteratorType mit;
+    if( useMask )
+    {
+      mit = MaskConstIteratorType( this->m_MaskImage, outputRegionForThread );
+    }
+    const WeightsType * prior = this->GetInterleavedPriorProbabilities( outputRegionForThread );
+    const WeightsType * constantPrior = this->m_PriorProbabilities.data_block();
 
+    /** Create and initialize the output iterator */
+    OutputIteratorType out = OutputIteratorType( this->GetOutput(), outputRegionForThread );
 
     /** now we'll build the combined output image based on the estimated
      * confusion matrices */
     for ( out.GoToBegin(); !out.IsAtEnd(); ++out )
     {
-      OutputPixelType winningLabel = leastPreferredLabel;
+      OutputPixelType winningLabel = this->m_LeastPreferredLabel;
 
       bool insideMask = true;
-      if(useMask)
+      if( useMask )
       {
         /** For pixels outside the mask use the decision
          * of th first observer */
@@ -535,18 +511,6 @@ namespace itk
           W[ winningLabel ] = 1.0;
           /** Set the winning label to the output pixel */
           out.Set( winningLabel );
-          /** move the pit and it iterators */
-          if( this->m_HasPriorProbabilityImageArray )
-          {
-            for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-            {
-              ++(pit[ci]);
-            }
-          }
-          for( unsigned int k = 0; k < numberOfInputs; ++k )
-          {
-            ++(it[k]);
-          }
         } // if mit==zero
         ++mit;
       } // end if useMask
@@ -554,27 +518,19 @@ namespace itk
       if( insideMask )
       {
         // basically, we'll repeat the E step from above
-        if( this->m_HasPriorProbabilityImageArray )
-        {
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-          {
-            W[ci] = pit[ci].Get();
-            ++(pit[ci]);
-          }
-        }
-        else
+        const WeightsType * p = prior ? prior : constantPrior;
+        for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
         {
-          W = this->m_PriorProbabilities;
+          W[ci] = p[ci];
         }
 
         for( unsigned int k = 0; k < numberOfInputs; ++k )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+          const WeightsType * confusion = this->m_ConfusionMatrixArray[k][ it[k].Get() ];
+          for ( unsigned int ci = 0; ci < numberOfClasses; ++ci )
           {
-            W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
+            W[ci] *= confusion[ci];
           }
-          ++(it[k]);
         }
 
         /** normalize: */
@@ -609,6 +565,15 @@ namespace itk
         out.Set( winningLabel );
       } // end if insideMask
 
+      /** Move the input iterators and the prior pointer */
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        ++(it[k]);
+      }
+      if( prior )
+      {
+        prior += numberOfClasses;
+      }
 
       /** copy the W values into the probabilistic segmentation images
        * and move the psit iterators */
@@ -623,6 +588,170 @@ namespace itk
 
     } // end loop over output pixels
 
+  } // end ThreadedGenerateCombinedSegmentation
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GenerateData()
+  {
+    /** Initialize some variables */
+    this->m_MaximumConfusionMatrixElementUpdate = 0.0;
+    this->m_ElapsedIterations = 0;
+    const bool generateProbSeg =
+      this->GetGenerateProbabilisticSegmentations();
+    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfThreads = this->GetNumberOfThreads();
+    OutputImagePointer output = this->GetOutput();
+    this->AllocateOutputs();
+
+    /** Set some default values if necessary */
+    if( this->m_HasNumberOfClasses == false )
+    {
+      this->m_NumberOfClasses = this->ComputeMaximumInputValue() + 1;
+    }
+    if( ! this->m_HasPriorPreference )
+    {
+      this->m_PriorPreference.SetSize( this->m_NumberOfClasses );
+      for( unsigned int i = 0; i < this->m_NumberOfClasses; ++i )
+      {
+        this->m_PriorPreference[ i ] = i;
+      }
+    }
+    if( !this->m_HasObserverTrust )
+    {
+      this->m_ObserverTrust.SetSize( numberOfInputs );
+      this->m_ObserverTrust.Fill(0.99999);
+    }
+
+    /** Determine the least preferred label */
+    this->m_LeastPreferredLabel = 0;
+    for( unsigned int i= 0; i< this->m_NumberOfClasses; ++i )
+    {
+      if( this->m_PriorPreference[ i ] == (this->m_NumberOfClasses-1) )
+      {
+        this->m_LeastPreferredLabel = i;
+      }
+    }
+
+    /** Initialize prior probabilities and confusion matrices */
+    this->InitializePriorProbabilities();
+    this->AllocateConfusionMatrixArray();
+    this->InitializeConfusionMatrixArray();
+    this->InterleavePriorProbabilityImages();
+
+    /** Allocate the confusion matrix updates of each thread */
+    this->m_ThreadConfusionMatrixArrays.resize( numberOfThreads );
+    for( unsigned int t = 0; t < numberOfThreads; ++t )
+    {
+      this->m_ThreadConfusionMatrixArrays[t].assign( numberOfInputs,
+        ConfusionMatrixType( this->m_NumberOfClasses, this->m_NumberOfClasses ) );
+    }
+
+    /** If probabilistic segmentations are desired, allocate them */
+    if( generateProbSeg )
+    {
+      this->m_ProbabilisticSegmentationArray =
+        ProbabilisticSegmentationArrayType( this->m_NumberOfClasses );
+      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
+      {
+        this->m_ProbabilisticSegmentationArray[k] =
+          ProbabilityImageType::New();
+        this->m_ProbabilisticSegmentationArray[k]->SetRegions(
+          output->GetRequestedRegion() );
+        this->m_ProbabilisticSegmentationArray[k]->CopyInformation( output );
+        this->m_ProbabilisticSegmentationArray[k]->Allocate();
+      }
+    }
+
+    /** Start iterating! */
+    while (  ( !this->m_HasMaximumNumberOfIterations ) ||
+             ( this->m_ElapsedIterations < this->m_MaximumNumberOfIterations )   )
+    {
+      /** reset the confusion matrix updates of all threads */
+      for( unsigned int t = 0; t < numberOfThreads; ++t )
+      {
+        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        {
+          this->m_ThreadConfusionMatrixArrays[t][k].Fill( 0.0 );
+        }
+      }
+
+      /** Do the E and M step for all voxels, multi-threaded */
+      this->ExecuteThreadedPass( false );
+
+      /** Add the confusion matrix updates of all threads */
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+        for( unsigned int t = 0; t < numberOfThreads; ++t )
+        {
+          this->m_UpdatedConfusionMatrixArray[k] += this->m_ThreadConfusionMatrixArrays[t][k];
+        }
+      }
+
+      /** Normalize matrix elements of each of the updated confusion matrices
+       * with sum over all expert decisions. */
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        // compute sum over all output classifications
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        {
+          WeightsType sumW = this->m_UpdatedConfusionMatrixArray[k][0][ci];
+          for ( InputPixelType j = 1; j < this->m_NumberOfClasses; ++j )
+          {
+            sumW += this->m_UpdatedConfusionMatrixArray[k][j][ci];
+          }
+
+          // normalize with sumW for each class ci
+          if( sumW )
+          {
+            this->m_UpdatedConfusionMatrixArray[k].scale_column(ci, 1.0/sumW);
+          }
+        }
+      } // end for k: end normalization of updated confusion matrix
+
+      // now we're applying the update to the confusion matrices and compute the
+      // maximum parameter change in the process, to check for convergence.
+      WeightsType maximumUpdate = 0;
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        const WeightsType maximumUpdate_k = static_cast<WeightsType>(
+          (this->m_UpdatedConfusionMatrixArray[k]-this->m_ConfusionMatrixArray[k]).array_inf_norm() );
+        maximumUpdate = vnl_math_max( maximumUpdate, maximumUpdate_k );
+
+        this->m_ConfusionMatrixArray[k] = this->m_UpdatedConfusionMatrixArray[k];
+      }
+      this->m_MaximumConfusionMatrixElementUpdate = maximumUpdate;
+
+      /** We have finished this iteration */
+      ++(this->m_ElapsedIterations);
+
+      /** Allow user to do something */
+      this->InvokeEvent( IterationEvent() );
+      if( this->GetAbortGenerateData() )
+      {
+        this->ResetPipeline();
+        // fake this to cause termination; we could really just break
+        maximumUpdate = 0;
+      }
+
+      // if all confusion matrix parameters changes by less than the defined
+      // threshold, we're done.
+      if( maximumUpdate < this->m_TerminationUpdateThreshold )
+        break;
+
+    } // end for ( iteration )
+
+    /** now we'll build the combined output image based on the estimated
+     * confusion matrices, multi-threaded */
+    this->ExecuteThreadedPass( true );
+
+    /** Release the memory used for multithreading */
+    this->m_ThreadConfusionMatrixArrays.clear();
+    std::vector<WeightsType>().swap( this->m_InterleavedPriorProbabilities );
+
   } // end GenerateData
 
 } // end namespace itk
@@ -51,6 +51,7 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_cross.h>
+#include <vnl/vnl_math.h>
 
 #include <itksys/SystemTools.hxx>
 
@@ -75,6 +76,13 @@ MevisDicomTiffImageIO
   m_TileLength(0),
   m_TileDepth(0),
   m_NumberOfTiles(0),
+  m_IsOpenForWriting(false),
+  m_NumberOfTilesWritten(0),
+  m_TileCacheFileModifiedTime(0),
+  m_TileCacheFileLength(0),
+  m_TileCacheSize(64 * 1024 * 1024),
+  m_TileCacheUsed(0),
+  m_NumberOfDecodeThreads(MultiThreader::GetGlobalDefaultNumberOfThreads()),
   m_RescaleSlope(NumericTraits<double>::One),
   m_RescaleIntercept(NumericTraits<double>::Zero),
   m_GantryTilt(NumericTraits<double>::Zero),
@@ -102,10 +110,14 @@ MevisDicomTiffImageIO
 // destructor
 MevisDicomTiffImageIO::~MevisDicomTiffImageIO()
 {
-  if (m_IsOpen)
+  if (m_IsOpen || m_IsOpenForWriting)
   {
     TIFFClose(m_TIFFImage);
   }
+  for (unsigned int i = 0; i < m_WorkerTIFFImages.size(); ++i)
+  {
+    TIFFClose(m_WorkerTIFFImages[i]);
+  }
 }
 
 // printself
@@ -126,6 +138,8 @@ void MevisDicomTiffImageIO::PrintSelf(std::ostream& os, Indent indent) const
   os << indent << "TileLength       : " << m_TileLength << std::endl;
   os << indent << "TileDepth        : " << m_TileDepth << std::endl;
   os << indent << "NumberOfTiles    : " << m_NumberOfTiles << std::endl;
+  os << indent << "TileCacheSize    : " << m_TileCacheSize << std::endl;
+  os << indent << "NumberOfDecodeThreads : " << m_NumberOfDecodeThreads << std::endl;
   os << indent << "RescaleIntercept : " << m_RescaleIntercept << std::endl;
   os << indent << "RescaleSlope     : " << m_RescaleSlope << std::endl;
   os << indent << "GantryTilt       : " << m_GantryTilt << std::endl;
@@ -283,7 +297,26 @@ bool MevisDicomTiffImageIO::CanReadFile( const char* filename )
     return false;
   }
 
+  // decoded tiles and worker handles belong to one version of one file;
+  // a file that was rewritten since has another time stamp or length
+  const long modifiedTime = itksys::SystemTools::ModifiedTime(m_TiffFileName.c_str());
+  const unsigned long fileLength = itksys::SystemTools::FileLength(m_TiffFileName.c_str());
+  if (m_TiffFileName != m_TileCacheFileName
+    || modifiedTime != m_TileCacheFileModifiedTime
+    || fileLength != m_TileCacheFileLength)
+  {
+    this->ClearTileCache();
+    m_TileCacheFileName = m_TiffFileName;
+    m_TileCacheFileModifiedTime = modifiedTime;
+    m_TileCacheFileLength = fileLength;
+  }
+
   // checking if tiff is valid tif
+  if (m_IsOpen)
+  {
+    TIFFClose(m_TIFFImage);
+    m_IsOpen = false;
+  }
   m_TIFFImage = TIFFOpen(m_TiffFileName.c_str(), "rc"); // c is disable strip chopping
   if (m_TIFFImage == NULL)
   {
@@ -803,6 +836,14 @@ void MevisDicomTiffImageIO::ReadImageInformation()
 
 }
 
+// generatestreamablereadregionfromrequestedregion
+ImageIORegion MevisDicomTiffImageIO
+::GenerateStreamableReadRegionFromRequestedRegion( const ImageIORegion & requested ) const
+{
+  // tiles are decoded on demand, so any region can be read
+  return requested;
+}
+
 // read
 void MevisDicomTiffImageIO::Read(void* buffer)
 {
@@ -812,9 +853,10 @@ void MevisDicomTiffImageIO::Read(void* buffer)
   // TIFFTileSize     returns size of one tile in bytes
   // TIFFReadTile     reads one tile, returns number of bytes in decoded tile
   //
-  // note *buffer goes in scanline order!
-  // very inconvenient if the tiff image is tiled, which damned
-  // is the case for mevislab images!
+  // note *buffer goes in scanline order, and only covers the
+  // IORegion, which is the requested region when streaming!
+  // only the tiles that overlap the IORegion are decoded, and
+  // only their overlapping rows are copied.
   // note buffer is already allocated, according to size!
 
   short int p;
@@ -831,356 +873,252 @@ void MevisDicomTiffImageIO::Read(void* buffer)
     }
   }
 
-  if (m_IsTiled)
+  if (!m_IsTiled)
   {
-    // only works for tile depth == 1 (used by mevislab),
-    // therefore in z-direction we do not need to do checking
-    // if the volume is multiple of tile.
-    if (m_TIFFDimension == 3 && m_TileDepth != 1)
-    {
-      itkExceptionMacro( << "mevisIO:read(): unsupported tiledepth (should be one)! " );
-      return;
-    }
+    // if not tiled then img is stripped
+    itkExceptionMacro( << "mevisIO:read(): non-tiled dcm/tiff reading not (yet) implemented" );
+    return;
+  }
 
-    // buffer pointer is scanline based (one dimensional array)
-    // tile is positioned on x,y,z; we read each tile, and fill
-    // the corresponding positions in the onedimensional array
-    unsigned char *vol = reinterpret_cast<unsigned char*>(buffer);
+  // only works for tile depth == 1 (used by mevislab),
+  // therefore in z-direction we do not need to do checking
+  // if the volume is multiple of tile.
+  if (m_TIFFDimension == 3 && m_TileDepth != 1)
+  {
+    itkExceptionMacro( << "mevisIO:read(): unsupported tiledepth (should be one)! " );
+    return;
+  }
 
-    const unsigned int tilesize = TIFFTileSize(m_TIFFImage);
-    const unsigned int tilerowbytes = TIFFTileRowSize(m_TIFFImage);
-    const unsigned int bytespersample = m_BitsPerSample/8;
+  // region to read, in x,y and the slices; for 4D images the
+  // tiff slice is z + t * sizez
+  ReadJobType job;
+  job.IO = this;
+  for (unsigned int d = 0; d < 4; ++d)
+  {
+    job.Start[d] = 0;
+    job.Size[d] = 1;
+  }
+  const ImageIORegion & region = this->GetIORegion();
+  for (unsigned int d = 0; d < 4 && d < region.GetImageDimension(); ++d)
+  {
+    job.Start[d] = static_cast<unsigned int>(region.GetIndex(d));
+    job.Size[d] = static_cast<unsigned int>(region.GetSize(d));
+  }
+  const unsigned int sizez = (m_NumberOfDimensions == 4 ? m_Dimensions[2] : 1);
 
-    unsigned char *tilebuf = static_cast<unsigned char*>(_TIFFmalloc(tilesize));
+  job.TileSize = TIFFTileSize(m_TIFFImage);
+  job.TileRowBytes = TIFFTileRowSize(m_TIFFImage);
+  job.BytesPerSample = m_BitsPerSample/8;
+  job.RegionRowBytes = static_cast<std::size_t>(job.Size[0]) * job.BytesPerSample;
+  job.Buffer = reinterpret_cast<unsigned char*>(buffer);
 
-    //
-    // special cases, if the tilexy is larger than or equal to the image
-    // size itself, treat as three separate cases, both are larger/equal,
-    // or only direction
-    //
-    bool tileoversized(false);
+  // first tile row/column overlapping the region
+  const unsigned int tx0 = (job.Start[0] / m_TileWidth) * m_TileWidth;
+  const unsigned int ty0 = (job.Start[1] / m_TileLength) * m_TileLength;
+  const unsigned int xend = job.Start[0] + job.Size[0];
+  const unsigned int yend = job.Start[1] + job.Size[1];
 
-    if (m_TileLength >= m_Length || m_TileWidth >= m_Width)
+  // tiles found in the cache are copied right away, the others
+  // are collected for decoding
+  std::size_t slice = 0;
+  for (unsigned int t = job.Start[3]; t < job.Start[3] + job.Size[3]; ++t)
+  {
+    for (unsigned int z = job.Start[2]; z < job.Start[2] + job.Size[2]; ++z, ++slice)
     {
-      tileoversized = true;
-
-      // case one both x,y is larger
-      if (m_TileLength >= m_Length && m_TileWidth >= m_Width)
+      const unsigned int z0 = (m_TIFFDimension == 3 ? z + t * sizez : 0);
+      for (unsigned int y0 = ty0; y0 < yend; y0 += m_TileLength)
       {
-        for (unsigned int z0 = 0; z0< (m_TIFFDimension == 3 ? m_Depth :1); z0++)
+        for (unsigned int x0 = tx0; x0 < xend; x0 += m_TileWidth)
         {
-          if (TIFFReadTile(m_TIFFImage, tilebuf, 0, 0, z0, 0) < 0)
+          TileRequestType request;
+          request.Tile = TIFFComputeTile(m_TIFFImage, x0, y0, z0, 0);
+          request.X = x0;
+          request.Y = y0;
+          request.Z = z0;
+          request.Slice = slice;
+
+          const unsigned char * cached = this->LookUpTile(request.Tile);
+          if (cached)
           {
-            _TIFFfree(tilebuf);
-            itkExceptionMacro( << "mevisIO:read(): error reading tile (topleft)" );
-            return;
+            this->CopyTileToBuffer(job, request, cached);
           }
           else
           {
-            // do row based copy of tile into volume
-            const unsigned lenx = m_Width;
-            const unsigned leny = m_Length;
-            const unsigned int tilexbytes = lenx * bytespersample;
-
-            unsigned char * pv = vol;
-            const unsigned int p = z0 * m_Length * m_Width;
-            pv += p * bytespersample;
-
-            unsigned char * pb = tilebuf;
-            for (unsigned int r = 0; r<leny; ++r)
-            {
-              memcpy(pv,pb,tilexbytes);
-              pv += tilexbytes;
-              pb += tilerowbytes;
-            }
-          }
-        }
-      } // end case one
-
-      // case two, larger x, smaller y
-      if (m_TileWidth >= m_Width && m_TileLength < m_Length)
-      {
-
-        const unsigned lenx = m_Width;
-        const unsigned int tilexbytes = lenx * bytespersample;
-
-        const bool my = ( m_Length%m_TileLength == 0) ? true : false;
-        for (unsigned int z0 = 0; z0 < (m_TIFFDimension == 3 ? m_Depth : 1); z0++)
-        {
-          for (unsigned int y0 = 0; y0 < (my ? m_Length : m_Length-m_TileLength); y0 += m_TileLength)
-          {
-            if (TIFFReadTile(m_TIFFImage, tilebuf, 0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (top image)" );
-              return;
-            }
-            else
-            {
-
-              unsigned char * pb = tilebuf;
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width;
-              pv += p * bytespersample;
-
-              for (unsigned int r = 0; r<m_TileLength; ++r)
-              {
-                memcpy(pv,pb,tilerowbytes);
-                pv += tilexbytes;
-                pb += tilerowbytes;
-              }
-            }
-          }
-
-          if (!my)
-          {
-            const unsigned leny = m_Length%m_TileLength;
-            const unsigned int y0 = m_Length - leny;
-
-            if (TIFFReadTile(m_TIFFImage, tilebuf, 0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (strip bottom)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width;
-              pv += p * bytespersample;
-
-              for (unsigned int r = 0; r<leny; ++r)
-              {
-                memcpy(pv,pb,tilexbytes);
-                pv += tilexbytes;
-                pb += tilerowbytes;
-              }
-            }
+            job.Requests.push_back(request);
           }
         }
+      }
+    }
+  }
+  if (job.Requests.empty())
+  {
+    return;
+  }
 
-      } // end case two
-
-      // case three, smaller x, larger y
-      if (m_TileWidth < m_Width && m_TileLength >= m_Length)
+  // decode the remaining tiles, every worker has its own tiff handle,
+  // since a handle can not be shared between threads
+  const unsigned int numberOfThreads = static_cast<unsigned int>(
+    vnl_math_min(static_cast<std::size_t>(vnl_math_max(1u, m_NumberOfDecodeThreads)),
+    job.Requests.size()));
+  job.Failed.assign(numberOfThreads, 0);
+  if (numberOfThreads == 1)
+  {
+    job.Handles.assign(1, m_TIFFImage);
+    this->DecodeTiles(job, 0, 1);
+  }
+  else
+  {
+    while (m_WorkerTIFFImages.size() < numberOfThreads)
+    {
+      TIFF * handle = TIFFOpen(m_TiffFileName.c_str(), "rc");
+      if (handle == NULL)
       {
+        itkExceptionMacro( << "mevisIO:read(): error opening tif file " << m_TiffFileName );
+      }
+      m_WorkerTIFFImages.push_back(handle);
+    }
+    job.Handles.assign(m_WorkerTIFFImages.begin(), m_WorkerTIFFImages.begin() + numberOfThreads);
 
-        const unsigned leny = m_Length;
-        const bool mx = ( m_Width%m_TileWidth == 0) ? true: false;
-
-        for (unsigned int z0 = 0; z0 < (m_TIFFDimension == 3 ? m_Depth : 1); z0++)
-        {
-          for (unsigned int x0 = 0; x0 < (mx ? m_Width : m_Width-m_TileWidth); x0 += m_TileWidth)
-          {
-            // read tile
-            if (TIFFReadTile(m_TIFFImage, tilebuf, x0, 0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (top image)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + x0;
-              pv += p * bytespersample;
-
-              for (unsigned int r = 0; r<leny; ++r)
-              {
-                memcpy(pv,pb,tilerowbytes);
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-          // fill strip right
-          if (!mx)
-          {
-            const unsigned lenx = m_Width%m_TileWidth;
-            const unsigned int x0 = m_Width - lenx;
-            const unsigned int tilexbytes = lenx * bytespersample;
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(DecodeThreaderCallback, &job);
+    threader->SingleMethodExecute();
+  }
 
-            if (TIFFReadTile(m_TIFFImage, tilebuf, x0, 0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (strip right)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + x0;
-              pv += p * bytespersample;
-
-              for (unsigned int r = 0; r<leny; ++r)
-              {
-                memcpy(pv,pb,tilexbytes);
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-        }
+  for (unsigned int i = 0; i < job.Failed.size(); ++i)
+  {
+    if (job.Failed[i])
+    {
+      itkExceptionMacro( << "mevisIO:read(): error reading tile" );
+    }
+  }
 
-      } // end case three
+  return;
+}
 
-    } // end oversized tile
+// decodethreadercallback
+ITK_THREAD_RETURN_TYPE MevisDicomTiffImageIO
+::DecodeThreaderCallback(void * arg)
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>(arg);
+  ReadJobType * job = static_cast<ReadJobType *>(info->UserData);
+  job->IO->DecodeTiles(*job, info->ThreadID, info->NumberOfThreads);
+  return ITK_THREAD_RETURN_VALUE;
+}
 
+// decodetiles
+void MevisDicomTiffImageIO
+::DecodeTiles(ReadJobType & job, unsigned int threadId, unsigned int numberOfThreads)
+{
+  TIFF * handle = job.Handles[threadId];
+  unsigned char *tilebuf = static_cast<unsigned char*>(_TIFFmalloc(job.TileSize));
 
-    //
-    // normal case, tile is smaller than image
-    //
-    if (!tileoversized)
+  for (std::size_t k = threadId; k < job.Requests.size(); k += numberOfThreads)
+  {
+    const TileRequestType & request = job.Requests[k];
+    if (TIFFReadTile(handle, tilebuf, request.X, request.Y, request.Z, 0) < 0)
     {
-      // is volume direction a multiple of tiledirection?
-      const bool mx = ( m_Width%m_TileWidth == 0) ? true: false;
-      const bool my = ( m_Length%m_TileLength == 0) ? true : false;
+      job.Failed[threadId] = 1;
+      break;
+    }
 
-      // fill everything inside ie from topleft
-      for (unsigned int z0 = 0; z0 < (m_TIFFDimension == 3 ? m_Depth : 1); z0++)
-      {
-        for (unsigned int y0 = 0; y0 < (my ? m_Length : m_Length-m_TileLength); y0 += m_TileLength)
-          for (unsigned int x0 = 0; x0 < (mx ? m_Width : m_Width-m_TileWidth); x0 += m_TileWidth)
-          {
-            // x0,y0,z0 is position of tile in volume, top left corner
-            // pointer to volume (at 0,0,0)
-            unsigned char * pv = vol;
+    // tiles of one read do not overlap in the buffer, so
+    // the copy needs no locking, the cache does
+    this->CopyTileToBuffer(job, request, tilebuf);
+    m_TileCacheMutex.Lock();
+    this->InsertTile(request.Tile, tilebuf, job.TileSize);
+    m_TileCacheMutex.Unlock();
+  }
 
-            // set pointer of volume to y0,x0,z0 position
-            const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
+  _TIFFfree(tilebuf);
+}
 
-            // read tile
-            if (TIFFReadTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (topleft image)" );
-              return;
-            }
-            else
-            {
-              // do row based copy of tile into volume
-              unsigned char * pb = tilebuf;
-              for (unsigned int r = 0; r<m_TileLength; ++r)
-              {
-                memcpy(pv,pb,tilerowbytes);
-                // move pointers
-                // x remain same, y is one complete vol line
-                // (ie width of image)
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
+// copytiletobuffer
+void MevisDicomTiffImageIO
+::CopyTileToBuffer(const ReadJobType & job, const TileRequestType & request,
+  const unsigned char * tile) const
+{
+  const unsigned int * start = job.Start;
+  const unsigned int xend = start[0] + job.Size[0];
+  const unsigned int yend = start[1] + job.Size[1];
+
+  // overlap of tile and region
+  const unsigned int xs = vnl_math_max(request.X, start[0]);
+  const unsigned int xe = vnl_math_min(request.X + m_TileWidth, xend);
+  const unsigned int ys = vnl_math_max(request.Y, start[1]);
+  const unsigned int ye = vnl_math_min(request.Y + m_TileLength, yend);
+  const std::size_t tilexbytes = static_cast<std::size_t>(xe - xs) * job.BytesPerSample;
+
+  // do row based copy of tile into volume
+  const unsigned char * pb = tile + (ys - request.Y) * job.TileRowBytes
+    + (xs - request.X) * job.BytesPerSample;
+  unsigned char * pv = job.Buffer
+    + (request.Slice * job.Size[1] + (ys - start[1])) * job.RegionRowBytes
+    + static_cast<std::size_t>(xs - start[0]) * job.BytesPerSample;
+  for (unsigned int r = ys; r < ye; ++r)
+  {
+    memcpy(pv,pb,tilexbytes);
+    pv += job.RegionRowBytes;
+    pb += job.TileRowBytes;
+  }
+}
 
-          }
-          // fill boundaries
-          if (!mx)
-          {
-            // x is fixed
-            const unsigned lenx = m_Width%m_TileWidth;
-            const unsigned int x0 = m_Width - lenx;
-            const unsigned int tilexbytes = lenx * bytespersample;
+// lookuptile
+const unsigned char * MevisDicomTiffImageIO
+::LookUpTile(ttile_t tile)
+{
+  TileCacheType::iterator it = m_TileCache.find(tile);
+  if (it == m_TileCache.end())
+  {
+    return NULL;
+  }
 
-            for (unsigned int y0 = 0; y0 < (my ? m_Length: m_Length - m_TileLength); y0 += m_TileLength)
-            {
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-              pv += p * bytespersample;
-
-              if (TIFFReadTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-              {
-                _TIFFfree(tilebuf);
-                itkExceptionMacro( << "mevisIO:read(): error reading tile (ydirection)" );
-                return;
-              }
-              else
-              {
-                unsigned char * pb = tilebuf;
-                for (unsigned int r = 0; r<m_TileLength; ++r)
-                {
-                  memcpy(pv,pb,tilexbytes);
-                  pv += m_Width * bytespersample;
-                  pb += tilerowbytes;
-                }
-              }
-            }
-          }
-          if (!my)
-          {
-            // y is fixed
-            const unsigned leny = m_Length%m_TileLength;
-            const unsigned int y0 = m_Length - leny;
+  // move to the front of the lru list
+  m_TileCacheOrder.splice(m_TileCacheOrder.begin(), m_TileCacheOrder, it->second.Position);
+  return &it->second.Buffer[0];
+}
 
-            for (unsigned int x0 = 0; x0 < (mx ? m_Width : m_Width-m_TileWidth); x0 += m_TileWidth)
-            {
-              unsigned char * pv = vol;
-              const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-              pv += p * bytespersample;
-
-              if (TIFFReadTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-              {
-                _TIFFfree(tilebuf);
-                itkExceptionMacro( << "mevisIO:read(): error reading tile (x-direction)");
-                return;
-              }
-              else
-              {
-                unsigned char * pb = tilebuf;
-                for (unsigned int r = 0; r<leny; ++r)
-                {
-                  memcpy(pv,pb,tilerowbytes);
-                  pv += m_Width * bytespersample;
-                  pb += tilerowbytes;
-                }
-              }
-            }
-          }
-          // fill corner bottom
-          if (!mx && !my)
-          {
-            // x0,y0 is fixed
-            const unsigned lenx = m_Width%m_TileWidth;
-            const unsigned int x0 = m_Width - lenx;
-            const unsigned int tilexbytes = lenx * bytespersample;
-            const unsigned leny = m_Length%m_TileLength;
-            const unsigned int y0 = m_Length - leny;
-
-            unsigned char * pv = vol;
-            const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
-
-            if (TIFFReadTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              itkExceptionMacro( << "mevisIO:read(): error reading tile (corner bottom)" );
-              return;
-            }
-            else
-            {
-              unsigned char * pb = tilebuf;
-              for (unsigned int r = 0; r<leny; ++r)
-              {
-                memcpy(pv,pb,tilexbytes);
-                pv += m_Width * bytespersample;
-                pb += tilerowbytes;
-              }
-            }
-          }
-      }
-    }
+// inserttile
+void MevisDicomTiffImageIO
+::InsertTile(ttile_t tile, const unsigned char * data, std::size_t size)
+{
+  if (size > m_TileCacheSize || m_TileCache.find(tile) != m_TileCache.end())
+  {
+    return;
+  }
 
-    _TIFFfree(tilebuf);
+  // evict the least recently used tiles
+  while (m_TileCacheUsed + size > m_TileCacheSize && !m_TileCacheOrder.empty())
+  {
+    TileCacheType::iterator last = m_TileCache.find(m_TileCacheOrder.back());
+    m_TileCacheUsed -= last->second.Buffer.size();
+    m_TileCache.erase(last);
+    m_TileCacheOrder.pop_back();
   }
-  else
+
+  m_TileCacheOrder.push_front(tile);
+  CachedTileType & cached = m_TileCache[tile];
+  cached.Buffer.assign(data, data + size);
+  cached.Position = m_TileCacheOrder.begin();
+  m_TileCacheUsed += size;
+}
+
+// cleartilecache; also closes the worker handles, which belong to the file
+void MevisDicomTiffImageIO
+::ClearTileCache(void)
+{
+  m_TileCache.clear();
+  m_TileCacheOrder.clear();
+  m_TileCacheUsed = 0;
+  for (unsigned int i = 0; i < m_WorkerTIFFImages.size(); ++i)
   {
-    // if not tiled then img is stripped
-    itkExceptionMacro( << "mevisIO:read(): non-tiled dcm/tiff reading not (yet) implemented" );
-    return;
+    TIFFClose(m_WorkerTIFFImages[i]);
   }
-  return;
+  m_WorkerTIFFImages.clear();
+  m_TileCacheFileName = "";
+  m_TileCacheFileModifiedTime = 0;
+  m_TileCacheFileLength = 0;
 }
 
 // canwritefile
@@ -1256,6 +1194,53 @@ void MevisDicomTiffImageIO
 // write
 void MevisDicomTiffImageIO
 ::Write( const void* buffer)
+{
+  // When streaming, ImageFileWriter calls Write() once per piece, with
+  // the piece in the IORegion, starting with the piece at the origin.
+  // The first piece writes the dcm header and opens the tiff file,
+  // every piece then writes the tiles it completes. The file is closed
+  // when all tiles have been written.
+  const ImageIORegion & region = this->GetIORegion();
+  bool atorigin(true);
+  for (unsigned int d = 0; d < region.GetImageDimension(); ++d)
+  {
+    atorigin &= (region.GetIndex(d) == 0);
+  }
+
+  if (atorigin)
+  {
+    if (m_IsOpenForWriting)
+    {
+      // previous write was not completed
+      TIFFClose(m_TIFFImage);
+      m_IsOpenForWriting = false;
+    }
+    m_PendingTiles.clear();
+    m_NumberOfTilesWritten = 0;
+    // the file may be one that was read before
+    this->ClearTileCache();
+    this->WriteHeaderAndOpenTiff();
+    m_IsOpenForWriting = true;
+  }
+  else if (!m_IsOpenForWriting)
+  {
+    itkExceptionMacro( << "mevisIO:write(): pasting into an existing dcm/tiff file is not supported" );
+  }
+
+  this->WriteTiles(buffer);
+
+  if (m_NumberOfTilesWritten == TIFFNumberOfTiles(m_TIFFImage))
+  {
+    TIFFClose(m_TIFFImage);
+    m_IsOpenForWriting = false;
+  }
+
+  return;
+}
+
+// writeheaderandopentiff
+void MevisDicomTiffImageIO
+::WriteHeaderAndOpenTiff(void)
 {
   if (this->GetNumberOfDimensions() != 2
     && this->GetNumberOfDimensions() != 3
@@ -1952,12 +1937,9 @@ void MevisDicomTiffImageIO
     itkExceptionMacro( << "mevisIO:write(): error setting TILELENGTH, m_TileLength" );
   }
 
-  // now filling the image with buffer provided
-  // the provided buffer is one dimensional array,
-  // we apply the same routines as for reading the image
-  // except, no boundary checking is required for writing
-  // the tiles. Boundary checking on the input pointer to
-  // prevent assessing memblocks outside the array
+  // the image is filled tile by tile in WriteTiles(), the provided
+  // buffer is a one dimensional array, we apply the same routines as
+  // for reading the image. Boundary tiles are padded with zeros.
 
   if (smallimg)
   {
@@ -1970,148 +1952,100 @@ void MevisDicomTiffImageIO
     itkExceptionMacro( << "mevisIO:write(): image x,y smaller than tilesize (16)! Consider different layout for tif (eg scanline layout)");
     return;
   }
-  else
-  {
-    const unsigned int tilesize = TIFFTileSize(m_TIFFImage);
-    const unsigned int tilerowbytes = TIFFTileRowSize(m_TIFFImage);
-    const unsigned int bytespersample = m_BitsPerSample/8;
-
-    const unsigned char *vol = reinterpret_cast<const unsigned char*>(buffer);
-    unsigned char *tilebuf = static_cast<unsigned char*>(_TIFFmalloc(tilesize));
-
-    // is volume direction a multiple of tiledirection?
-    const bool mx = ( m_Width%m_TileWidth == 0) ? true: false;
-    const bool my = ( m_Length%m_TileLength == 0) ? true : false;
 
-    for (unsigned int z0 = 0; z0 < (m_TIFFDimension == 3 ? m_Depth:1); z0++)
-    {
-      for (unsigned int y0 = 0; y0 < (my ? m_Length : m_Length-m_TileLength); y0 += m_TileLength)
-        for (unsigned int x0 = 0; x0 < (mx ? m_Width : m_Width-m_TileWidth); x0 += m_TileWidth)
-        {
-          // set bufferpointer to begin of tile
-          const unsigned char * pv = vol;
-          const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
+  return;
+}
 
-          // fill tile
-          unsigned char * pb = tilebuf;
-          for (unsigned int r=0; r<m_TileLength; ++r)
-          {
-            memcpy(pb,pv,tilerowbytes);
-            pv += m_Width * bytespersample;
-            pb += tilerowbytes;
-          }
-          // write tile
-          if (TIFFWriteTile(m_TIFFImage, tilebuf,x0,y0,z0,0)< 0)
-          {
+// writetiles
+void MevisDicomTiffImageIO
+::WriteTiles( const void* buffer)
+{
+  // The IORegion need not be aligned with the tiles, e.g. a 2D image
+  // streamed in y. Tiles that are only partly covered are kept in
+  // m_PendingTiles until the following pieces complete them.
+  unsigned int start[4] = {0, 0, 0, 0};
+  unsigned int size[4] = {1, 1, 1, 1};
+  const ImageIORegion & region = this->GetIORegion();
+  for (unsigned int d = 0; d < 4 && d < region.GetImageDimension(); ++d)
+  {
+    start[d] = static_cast<unsigned int>(region.GetIndex(d));
+    size[d] = static_cast<unsigned int>(region.GetSize(d));
+  }
+  const unsigned int sizez = (m_NumberOfDimensions == 4 ? m_Dimensions[2] : 1);
 
-            _TIFFfree(tilebuf);
-            TIFFClose(m_TIFFImage);
-            itkExceptionMacro( << "mevisIO:write(): error writing tile." );
-            return;
-          }
-        }
-        // boundaries
-        if (!mx)
-        {
-          // x is fixed
-          const unsigned lenx = m_Width%m_TileWidth;
-          const unsigned int x0 = m_Width - lenx;
-          const unsigned int tilexbytes = lenx * bytespersample;
+  const unsigned int tilesize = TIFFTileSize(m_TIFFImage);
+  const unsigned int tilerowbytes = TIFFTileRowSize(m_TIFFImage);
+  const unsigned int bytespersample = m_BitsPerSample/8;
+  const std::size_t regionrowbytes = static_cast<std::size_t>(size[0]) * bytespersample;
 
-          for (unsigned int y0 = 0; y0 < (my ? m_Length: m_Length - m_TileLength); y0 += m_TileLength)
-          {
-            const unsigned char * pv = vol;
-            const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
+  const unsigned char *vol = reinterpret_cast<const unsigned char*>(buffer);
 
-            unsigned char * pb = tilebuf;
-            memset (pb,0,tilesize);
+  const unsigned int tx0 = (start[0] / m_TileWidth) * m_TileWidth;
+  const unsigned int ty0 = (start[1] / m_TileLength) * m_TileLength;
+  const unsigned int xend = start[0] + size[0];
+  const unsigned int yend = start[1] + size[1];
 
-            // fill tile
-            for (unsigned int r = 0; r<m_TileLength; ++r)
-            {
-              memcpy(pb,pv,tilexbytes);
-              pv += m_Width * bytespersample;
-              pb += tilerowbytes;
-            }
+  std::size_t slice = 0;
+  for (unsigned int t = start[3]; t < start[3] + size[3]; ++t)
+  {
+    for (unsigned int z = start[2]; z < start[2] + size[2]; ++z, ++slice)
+    {
+      const unsigned int z0 = (m_TIFFDimension == 3 ? z + t * sizez : 0);
+      const unsigned char * pslice = vol + slice * size[1] * regionrowbytes;
 
-            if (TIFFWriteTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              TIFFClose(m_TIFFImage);
-              itkExceptionMacro( << "mevisIO:write(): error writing tile (ydirection)" );
-              return;
-            }
-          }
-        }
-        if (!my)
+      for (unsigned int y0 = ty0; y0 < yend; y0 += m_TileLength)
+      {
+        for (unsigned int x0 = tx0; x0 < xend; x0 += m_TileWidth)
         {
-          const unsigned leny = m_Length%m_TileLength;
-          const unsigned int y0 = m_Length - leny;
-
-          for (unsigned int x0 = 0; x0 < (mx ? m_Width : m_Width-m_TileWidth); x0 += m_TileWidth)
+          const ttile_t tile = TIFFComputeTile(m_TIFFImage, x0, y0, z0, 0);
+          PendingTileType & pending = m_PendingTiles[tile];
+          if (pending.Buffer.empty())
           {
-            const unsigned char * pv = vol;
-            const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-            pv += p * bytespersample;
-
-            unsigned char * pb = tilebuf;
-            memset (pb,0,tilesize);
-
-            for (unsigned int r = 0; r<leny; ++r)
-            {
-              memcpy(pb,pv,tilerowbytes);
-              pv += m_Width * bytespersample;
-              pb += tilerowbytes;
-            }
-
-            if (TIFFWriteTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
-            {
-              _TIFFfree(tilebuf);
-              TIFFClose(m_TIFFImage);
-              itkExceptionMacro( << "mevisIO:write(): error writing tile (x-direction)" );
-              return;
-            }
+            pending.Buffer.assign(tilesize, 0);
+            pending.NumberOfFilledPixels = 0;
           }
-        }
-        if (!mx && !my)
-        {
-          // x0,y0 is fixed
-          const unsigned lenx = m_Width%m_TileWidth;
-          const unsigned int x0 = m_Width - lenx;
-          const unsigned int tilexbytes = lenx * bytespersample;
-          const unsigned leny = m_Length%m_TileLength;
-          const unsigned int y0 = m_Length - leny;
-
-          const unsigned char * pv = vol;
-          const unsigned int p = z0 * m_Length * m_Width + y0 * m_Width + x0;
-          pv += p * bytespersample;
 
-          unsigned char * pb = tilebuf;
-          memset (pb,0,tilesize);
+          // overlap of tile and region
+          const unsigned int xs = vnl_math_max(x0, start[0]);
+          const unsigned int xe = vnl_math_min(x0 + m_TileWidth, xend);
+          const unsigned int ys = vnl_math_max(y0, start[1]);
+          const unsigned int ye = vnl_math_min(y0 + m_TileLength, yend);
+          const std::size_t tilexbytes = static_cast<std::size_t>(xe - xs) * bytespersample;
 
-          for (unsigned int r = 0; r<leny; ++r)
+          // fill tile
+          unsigned char * pb = &pending.Buffer[0] + (ys - y0) * tilerowbytes + (xs - x0) * bytespersample;
+          const unsigned char * pv = pslice + (ys - start[1]) * regionrowbytes
+            + static_cast<std::size_t>(xs - start[0]) * bytespersample;
+          for (unsigned int r = ys; r < ye; ++r)
           {
             memcpy(pb,pv,tilexbytes);
-            pv += m_Width * bytespersample;
+            pv += regionrowbytes;
             pb += tilerowbytes;
           }
+          pending.NumberOfFilledPixels += (xe - xs) * (ye - ys);
 
-          if (TIFFWriteTile(m_TIFFImage, tilebuf, x0, y0, z0, 0) < 0)
+          // write tile if complete; boundary tiles have less pixels
+          const unsigned int tilepixels = vnl_math_min(m_TileWidth, m_Width - x0)
+            * vnl_math_min(m_TileLength, m_Length - y0);
+          if (pending.NumberOfFilledPixels == tilepixels)
           {
-            _TIFFfree(tilebuf);
-            TIFFClose(m_TIFFImage);
-            itkExceptionMacro( << "mevisIO:write(): error writing tile (corner bottom)" );
-            return;
+            if (TIFFWriteTile(m_TIFFImage, &pending.Buffer[0], x0, y0, z0, 0) < 0)
+            {
+              m_PendingTiles.clear();
+              TIFFClose(m_TIFFImage);
+              m_IsOpenForWriting = false;
+              itkExceptionMacro( << "mevisIO:write(): error writing tile at "
+                << x0 << "," << y0 << "," << z0 );
+              return;
+            }
+            m_PendingTiles.erase(tile);
+            ++m_NumberOfTilesWritten;
           }
         }
-    } // end z
-    _TIFFfree(tilebuf);
+      }
+    }
   }
 
-  TIFFClose(m_TIFFImage);
-
   return;
 }
 
@@ -22,12 +22,17 @@
 #endif
 
 #include "itkImageIOBase.h"
+#include "itkMultiThreader.h"
+#include "itkSimpleFastMutexLock.h"
 #include "itk_tiff.h"
 #include "gdcmTag.h"
 #include "gdcmAttribute.h"
 
 #include <fstream>
+#include <list>
+#include <map>
 #include <string>
+#include <vector>
 
 
 namespace itk
@@ -99,6 +104,13 @@ namespace itk
  *  18 apr 2011
  *    added reading dicom tags from sequences of tags, suggestion and
  *    code proposal by Reinhard Hameeteman
+ *  streaming
+ *    reading decodes only the tiles overlapping the requested region;
+ *    writing accepts the image in pieces, starting at the origin, and
+ *    writes each tile as soon as it is complete
+ *  parallel decoding
+ *    tiles are decoded by several threads, each with its own tiff
+ *    handle, and kept in a bounded lru cache of decoded tiles
  *
  *  email: rashindra@gmail.com
  *
@@ -121,6 +133,17 @@ public:
   itkGetMacro(RescaleIntercept, double);
   itkGetMacro(GantryTilt, double);
 
+  /** Size in bytes of the cache of decoded tiles, default 64 MB.
+   * Repeated reads of regions of the same file, e.g. browsing
+   * slices, take their tiles from this cache. */
+  itkSetMacro(TileCacheSize, SizeValueType);
+  itkGetConstMacro(TileCacheSize, SizeValueType);
+
+  /** Number of threads decoding tiles, each with its own tiff handle,
+   * default the global default number of threads. */
+  itkSetMacro(NumberOfDecodeThreads, unsigned int);
+  itkGetConstMacro(NumberOfDecodeThreads, unsigned int);
+
   virtual bool CanReadFile(const char*);
   virtual void ReadImageInformation();
   virtual void Read(void* buffer);
@@ -129,14 +152,19 @@ public:
   virtual void Write(const void* buffer);
   virtual bool CanStreamRead()
     {
-    return false;
+    return true;
     }
 
   virtual bool CanStreamWrite()
     {
-    return false;
+    return true;
     }
 
+  /** Only the tiles overlapping the requested region are decoded,
+   * so the requested region can be read as is. */
+  virtual ImageIORegion GenerateStreamableReadRegionFromRequestedRegion(
+    const ImageIORegion & requested ) const;
+
 protected:
   MevisDicomTiffImageIO();
   ~MevisDicomTiffImageIO();
@@ -149,6 +177,62 @@ private:
   bool FindElement(const gdcm::DataSet ds, const gdcm::Tag tag, gdcm::DataElement &de,
                         const bool breadthfirstsearch);
 
+  /** Write the dcm file and open the tiff file with all its tags set. */
+  void WriteHeaderAndOpenTiff(void);
+
+  /** Write the tiles that are completed by the IORegion in buffer. */
+  void WriteTiles(const void* buffer);
+
+  /** A tile to be copied into the read buffer. */
+  struct TileRequestType
+  {
+    ttile_t       Tile;
+    unsigned int  X, Y, Z;
+    std::size_t   Slice;
+  };
+
+  /** All that the decode threads need for one Read(). */
+  struct ReadJobType
+  {
+    Self *                        IO;
+    unsigned int                  Start[4];
+    unsigned int                  Size[4];
+    unsigned int                  TileSize;
+    unsigned int                  TileRowBytes;
+    unsigned int                  BytesPerSample;
+    std::size_t                   RegionRowBytes;
+    unsigned char *               Buffer;
+    std::vector<TileRequestType>  Requests;
+    std::vector<TIFF *>           Handles;
+    std::vector<int>              Failed;
+  };
+
+  /** Thread callback, decodes every NumberOfThreads-th requested tile. */
+  static ITK_THREAD_RETURN_TYPE DecodeThreaderCallback(void * arg);
+  void DecodeTiles(ReadJobType & job, unsigned int threadId, unsigned int numberOfThreads);
+  void CopyTileToBuffer(const ReadJobType & job, const TileRequestType & request,
+    const unsigned char * tile) const;
+
+  /** Lru cache of decoded tiles; LookUpTile marks the tile as most
+   * recently used, InsertTile evicts the least recently used ones. */
+  struct CachedTileType
+  {
+    std::vector<unsigned char>          Buffer;
+    std::list<ttile_t>::iterator        Position;
+  };
+  typedef std::map<ttile_t, CachedTileType> TileCacheType;
+  const unsigned char * LookUpTile(ttile_t tile);
+  void InsertTile(ttile_t tile, const unsigned char * data, std::size_t size);
+  void ClearTileCache(void);
+
+  /** A tile that is only partly covered by the pieces written so far. */
+  struct PendingTileType
+  {
+    std::vector<unsigned char>  Buffer;
+    unsigned int                NumberOfFilledPixels;
+  };
+  typedef std::map<ttile_t, PendingTileType> PendingTileMapType;
+
   // the following may include the pathname
   std::string                           m_DcmFileName;
   std::string                           m_TiffFileName;
@@ -166,6 +250,20 @@ private:
   unsigned int                          m_TileLength;
   unsigned int                          m_TileDepth;
   unsigned short                        m_NumberOfTiles;
+  bool                                  m_IsOpenForWriting;
+  unsigned int                          m_NumberOfTilesWritten;
+  PendingTileMapType                    m_PendingTiles;
+
+  TileCacheType                         m_TileCache;
+  std::list<ttile_t>                    m_TileCacheOrder;
+  std::string                           m_TileCacheFileName;
+  long                                  m_TileCacheFileModifiedTime;
+  unsigned long                         m_TileCacheFileLength;
+  SizeValueType                         m_TileCacheSize;
+  SizeValueType                         m_TileCacheUsed;
+  SimpleFastMutexLock                   m_TileCacheMutex;
+  unsigned int                          m_NumberOfDecodeThreads;
+  std::vector<TIFF *>                   m_WorkerTIFFImages;
 
   double                                m_RescaleSlope;
   double                                m_RescaleIntercept;
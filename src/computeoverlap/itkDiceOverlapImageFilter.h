@@ -21,6 +21,7 @@
 #include "itkImageToImageFilter.h"
 #include <map>
 #include <set>
+#include <vector>
 
 
 namespace itk
@@ -29,6 +30,14 @@ namespace itk
 /** \class DiceOverlapImageFilter
  * \brief Computes the Dice overlap per label
  *
+ * For integer label images with a limited range of labels, the label sizes
+ * are accumulated in flat per-thread count arrays indexed by label. For 8 and
+ * 16 bit pixel types the full range of the type is used. For other integer
+ * types the label range is determined with a minimum/maximum prepass, and the
+ * count arrays are used when the range contains at most MaximumDenseRange
+ * labels. Otherwise, e.g. for sparse large-range labels or floating point
+ * images, per-thread maps are used.
+ *
  * \ingroup IntensityImageFilters
  * \ingroup Multithreaded
  */
@@ -69,6 +78,7 @@ public:
   typedef std::map<InputPixelType, std::size_t>             OverlapMapType;
   typedef std::map<InputPixelType, ScalarRealType>          OverlapMapRealType;
   typedef std::set<InputPixelType>                          LabelsType;
+  typedef std::vector<std::size_t>                          DenseOverlapType;
 
   /** Set and get the user-requested labels for which the overlaps a. */
   //itkSetMacro( RequestedLabels, LabelsType );
@@ -93,6 +103,10 @@ public:
     return this->m_DiceOverlap;
   }
 
+  /** Set the maximum label range for which dense count arrays are used. Default 2^16. */
+  itkSetMacro( MaximumDenseRange, std::size_t );
+  itkGetConstMacro( MaximumDenseRange, std::size_t );
+
   /** Print the Dice overlaps, only the requested ones. */
   void PrintRequestedDiceOverlaps( void );
 
@@ -122,6 +136,13 @@ private:
   DiceOverlapImageFilter(const Self&); //purposely not implemented
   void operator=(const Self&); //purposely not implemented
 
+  /** Determine whether dense count arrays can be used, and for which labels. */
+  virtual void DetermineDenseLabelRange( void );
+
+  /** Add the dense counts of all threads, and convert them to maps. */
+  virtual void MergeDenseSums( std::vector<DenseOverlapType> & denseSums,
+    OverlapMapType & sum ) const;
+
   /** Member variables. */
   LabelsType                    m_RequestedLabels;
 
@@ -130,6 +151,15 @@ private:
   std::vector<OverlapMapType>   m_SumC;
   OverlapMapRealType            m_DiceOverlap;
 
+  /** Member variables for the dense count arrays. */
+  bool                          m_UseDenseSums;
+  std::size_t                   m_MaximumDenseRange;
+  InputPixelType                m_DenseLabelMinimum;
+  std::size_t                   m_DenseLabelRange;
+  std::vector<DenseOverlapType> m_DenseSumA;
+  std::vector<DenseOverlapType> m_DenseSumB;
+  std::vector<DenseOverlapType> m_DenseSumC;
+
 }; // end class DiceOverlapImageFilter
 
 } // end namespace itk
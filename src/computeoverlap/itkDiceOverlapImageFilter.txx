@@ -22,6 +22,8 @@
 
 #include "itkImageRegionConstIterator.h"
 #include "itkProgressReporter.h"
+#include "itkMinimumMaximumImageCalculator.h"
+#include <algorithm>
 
 
 namespace itk
@@ -37,6 +39,10 @@ DiceOverlapImageFilter<TInputImage>
 {
   /** Initialize variables. */
   //this->m_RequestedLabels = 0;
+  this->m_UseDenseSums = false;
+  this->m_MaximumDenseRange = 65536;
+  this->m_DenseLabelMinimum = 0;
+  this->m_DenseLabelRange = 0;
 
   this->SetNumberOfRequiredInputs( 2 );
 
@@ -55,13 +61,69 @@ DiceOverlapImageFilter<TInputImage>
   const int numberOfThreads = this->GetNumberOfThreads();
 
   // Create the thread temporaries
-  this->m_SumA.resize( numberOfThreads );
-  this->m_SumB.resize( numberOfThreads );
-  this->m_SumC.resize( numberOfThreads );
+  this->m_SumA.assign( numberOfThreads, OverlapMapType() );
+  this->m_SumB.assign( numberOfThreads, OverlapMapType() );
+  this->m_SumC.assign( numberOfThreads, OverlapMapType() );
+
+  /** The dense count arrays are allocated by the threads themselves. */
+  this->m_DenseSumA.assign( numberOfThreads, DenseOverlapType() );
+  this->m_DenseSumB.assign( numberOfThreads, DenseOverlapType() );
+  this->m_DenseSumC.assign( numberOfThreads, DenseOverlapType() );
+  this->DetermineDenseLabelRange();
 
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* DetermineDenseLabelRange *******************
+ */
+
+template<class TInputImage>
+void
+DiceOverlapImageFilter<TInputImage>
+::DetermineDenseLabelRange( void )
+{
+  this->m_UseDenseSums = false;
+
+  /** Floating point labels are always counted in a map. */
+  if( !NumericTraits<InputPixelType>::is_integer ) return;
+
+  /** For 8 and 16 bit types the full range of the type is used,
+   * otherwise the range of the labels in the two inputs.
+   */
+  InputPixelType minimum = NumericTraits<InputPixelType>::NonpositiveMin();
+  InputPixelType maximum = NumericTraits<InputPixelType>::max();
+  if( sizeof( InputPixelType ) > 2 )
+  {
+    typedef MinimumMaximumImageCalculator<InputImageType> CalculatorType;
+    typename CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetImage( this->GetInput( 0 ) );
+    calculator->Compute();
+    minimum = calculator->GetMinimum();
+    maximum = calculator->GetMaximum();
+
+    calculator->SetImage( this->GetInput( 1 ) );
+    calculator->Compute();
+    minimum = std::min( minimum, calculator->GetMinimum() );
+    maximum = std::max( maximum, calculator->GetMaximum() );
+  }
+
+  /** Use the dense count arrays only for a limited label range. Within
+   * that range the offset of a label to the minimum can be computed in
+   * the pixel type itself, which also works for unsigned 32 and 64 bit
+   * labels that do not fit in a long.
+   */
+  const double range = static_cast<double>( maximum ) - static_cast<double>( minimum ) + 1.0;
+  if( range <= static_cast<double>( this->m_MaximumDenseRange ) )
+  {
+    this->m_UseDenseSums = true;
+    this->m_DenseLabelMinimum = minimum;
+    this->m_DenseLabelRange = static_cast<std::size_t>( range );
+  }
+
+} // end DetermineDenseLabelRange()
+
+
 /**
  * ******************* ThreadedGenerateData *******************
  */
@@ -84,6 +146,38 @@ DiceOverlapImageFilter<TInputImage>
   itA.GoToBegin();
   itB.GoToBegin();
 
+  /** Determine size of objects, and size in the overlap,
+   * using flat count arrays indexed by label.
+   */
+  if( this->m_UseDenseSums )
+  {
+    DenseOverlapType & sumA = this->m_DenseSumA[ threadId ];
+    DenseOverlapType & sumB = this->m_DenseSumB[ threadId ];
+    DenseOverlapType & sumC = this->m_DenseSumC[ threadId ];
+    sumA.assign( this->m_DenseLabelRange, 0 );
+    sumB.assign( this->m_DenseLabelRange, 0 );
+    sumC.assign( this->m_DenseLabelRange, 0 );
+
+    const InputPixelType minimum = this->m_DenseLabelMinimum;
+    while ( !itA.IsAtEnd() )
+    {
+      const InputPixelType A = itA.Value();
+      const InputPixelType B = itB.Value();
+      const SizeValueType a = static_cast<SizeValueType>( A - minimum );
+
+      sumA[ a ]++;
+      sumB[ static_cast<SizeValueType>( B - minimum ) ]++;
+      sumC[ a ] += ( A == B );
+
+      /** Increase iterators. */
+      ++itA; ++itB;
+      progress.CompletedPixel(); // potential exception thrown here
+
+    } // end while
+
+    return;
+  }
+
   /** Determine size of objects, and size in the overlap. */
   OverlapMapType sumA, sumB, sumC;
   while ( !itA.IsAtEnd() )
@@ -118,6 +212,14 @@ void
 DiceOverlapImageFilter<TInputImage>
 ::AfterThreadedGenerateData( void )
 {
+  /** Merge the dense sums from all threads, and convert them to maps. */
+  if( this->m_UseDenseSums )
+  {
+    this->MergeDenseSums( this->m_DenseSumA, this->m_SumA[ 0 ] );
+    this->MergeDenseSums( this->m_DenseSumB, this->m_SumB[ 0 ] );
+    this->MergeDenseSums( this->m_DenseSumC, this->m_SumC[ 0 ] );
+  }
+
   /** Merge sums from all threads. */
   OverlapMapType sumA = this->m_SumA[ 0 ];
   OverlapMapType sumB = this->m_SumB[ 0 ];
@@ -186,6 +288,50 @@ DiceOverlapImageFilter<TInputImage>
 } // end AfterThreadedGenerateData()
 
 
+/**
+ * ******************* MergeDenseSums *******************
+ */
+
+template<class TInputImage>
+void
+DiceOverlapImageFilter<TInputImage>
+::MergeDenseSums( std::vector<DenseOverlapType> & denseSums,
+  OverlapMapType & sum ) const
+{
+  /** Add the counts of all threads to a single array. Threads that did not
+   * process a region have an empty array. The loop is a simple contiguous
+   * addition, which the compiler vectorizes.
+   */
+  DenseOverlapType total( this->m_DenseLabelRange, 0 );
+  for( std::size_t threadId = 0; threadId < denseSums.size(); ++threadId )
+  {
+    const DenseOverlapType & threadSum = denseSums[ threadId ];
+    if( threadSum.size() != total.size() ) continue;
+
+    const std::size_t * in = &threadSum[ 0 ];
+    std::size_t * out = &total[ 0 ];
+    for( std::size_t i = 0; i < total.size(); ++i )
+    {
+      out[ i ] += in[ i ];
+    }
+
+    /** Release the memory. */
+    DenseOverlapType().swap( denseSums[ threadId ] );
+  }
+
+  /** Only the labels that occur are stored in the map. */
+  sum.clear();
+  for( std::size_t i = 0; i < total.size(); ++i )
+  {
+    if( total[ i ] == 0 ) continue;
+    const InputPixelType label = static_cast<InputPixelType>(
+      this->m_DenseLabelMinimum + static_cast<InputPixelType>( i ) );
+    sum[ label ] = total[ i ];
+  }
+
+} // end MergeDenseSums()
+
+
 /**
  * ******************* PrintRequestedDiceOverlaps *******************
  */
@@ -64,9 +64,14 @@ std::string GetHelpString( void )
     << "           EBSR: elastic body reciprocal spline\n"
     << "           See ITK documentation and the there cited paper\n"
     << "           for more information on these methods.\n"
+    << "  [-tol]   tolerance: the maximum error in the displacement, in mm.\n"
+    << "           If nonzero, far away landmarks are approximated by a\n"
+    << "           tree based expansion; only for TPS, TPSR2LOGR and VS.\n"
+    << "           0.0 = exact = default.\n"
     << "  -out     outputFilename: the name of the resulting deformation field,\n"
     << "           which is written as a vector<float/double,dim> image.\n"
     << "  [-opct]  output pixel component type, choose one of {float, double}, default float.\n"
+    << "  [-threads] maximum number of threads used, default all.\n"
     << "Supported: 2D, 3D, any scalar input pixeltype.";
 
   return ss.str();
@@ -122,6 +127,13 @@ int main( int argc, char **argv )
   double stiffness = 0.0;
   parser->GetCommandLineArgument( "-s", stiffness );
 
+  double tolerance = 0.0;
+  parser->GetCommandLineArgument( "-tol", tolerance );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
   /** Determine image properties. */
   itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
@@ -165,6 +177,7 @@ int main( int argc, char **argv )
     filter->m_OutputImageFileName = outputImageFileName;
     filter->m_KernelName = kernelName;
     filter->m_Stiffness = stiffness;
+    filter->m_Tolerance = tolerance;
 
     filter->Run();
 
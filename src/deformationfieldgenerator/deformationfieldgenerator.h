@@ -20,17 +20,12 @@
 
 #include "ITKToolsBase.h"
 
-#include "itkImageRegionIteratorWithIndex.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
 #include "itkTransformixInputPointFileReader.h"
 #include "itkVector.h"
 #include "itkImage.h"
-#include "itkThinPlateSplineKernelTransform.h"
-#include "itkThinPlateR2LogRSplineKernelTransform.h"
-#include "itkVolumeSplineKernelTransform.h"
-#include "itkElasticBodySplineKernelTransform.h"
-#include "itkElasticBodyReciprocalSplineKernelTransform.h"
+#include "itkKernelSplineDeformationFieldSource.h"
 #include "vnl/vnl_math.h"
 
 
@@ -53,6 +48,7 @@ public:
     this->m_OutputImageFileName = "";
     this->m_KernelName = "";
     this->m_Stiffness = 0.0f;
+    this->m_Tolerance = 0.0;
   };
   /** Destructor. */
   ~ITKToolsDeformationFieldGeneratorBase(){};
@@ -65,6 +61,7 @@ public:
   std::string m_OutputImageFileName;
   std::string m_KernelName;
   double m_Stiffness;
+  double m_Tolerance;
 
 }; // end class ITKToolsDeformationFieldGeneratorBase
 
@@ -92,15 +89,12 @@ public:
     /** Typedefs. */
     typedef short InputPixelType;
     typedef TComponentType DeformationVectorValueType;
-    typedef double CoordRepType;
 
     typedef itk::Image< InputPixelType, VDimension >        InputImageType;
     typedef itk::ImageFileReader< InputImageType >          InputImageReaderType;
     typedef itk::Vector<
       DeformationVectorValueType, VDimension >              DeformationVectorType;
     typedef itk::Image< DeformationVectorType, VDimension > DeformationFieldType;
-    typedef itk::ImageRegionIteratorWithIndex<
-      DeformationFieldType >                                DeformationFieldIteratorType;
     typedef itk::ImageFileWriter< DeformationFieldType >    DeformationFieldWriterType;
     typedef typename DeformationFieldType::IndexType        IndexType;
     typedef typename DeformationFieldType::PointType        PointType;
@@ -111,20 +105,9 @@ public:
     typedef typename DeformationFieldType::IndexType        IndexType;
     typedef typename IndexType::IndexValueType              IndexValueType;
 
-    typedef itk::KernelTransform<
-      CoordRepType, VDimension>                             KernelTransformType;
-    typedef itk::ThinPlateSplineKernelTransform<
-      CoordRepType, VDimension>                             TPSTransformType;
-    typedef itk::ThinPlateR2LogRSplineKernelTransform<
-      CoordRepType, VDimension>                             TPSR2LOGRTransformType;
-    typedef itk::VolumeSplineKernelTransform<
-      CoordRepType, VDimension>                             VSTransformType;
-    typedef itk::ElasticBodySplineKernelTransform<
-      CoordRepType, VDimension>                             EBSTransformType;
-    typedef itk::ElasticBodyReciprocalSplineKernelTransform<
-      CoordRepType, VDimension>                             EBSRTransformType;
-
-    typedef typename KernelTransformType::PointSetType      PointSetType;
+    typedef itk::KernelSplineDeformationFieldSource<
+      DeformationFieldType >                                FieldSourceType;
+    typedef typename FieldSourceType::PointSetType          PointSetType;
     typedef itk::TransformixInputPointFileReader<
       PointSetType >                                        IPPReaderType;
 
@@ -135,8 +118,7 @@ public:
     typename IPPReaderType::Pointer ipp2Reader = IPPReaderType::New();
     typename PointSetType::Pointer inputPointSet1 = 0;
     typename PointSetType::Pointer inputPointSet2 = 0;
-    typename KernelTransformType::Pointer kernelTransform = 0;
-    typename DeformationFieldType::Pointer deformationField = DeformationFieldType::New();
+    typename FieldSourceType::Pointer fieldSource = FieldSourceType::New();
     typename DeformationFieldWriterType::Pointer writer = DeformationFieldWriterType::New();
 
     ipp1Reader->SetFileName( this->m_InputPoints1FileName.c_str() );
@@ -248,23 +230,23 @@ public:
 
     if( this->m_KernelName == "TPS" )
     {
-      kernelTransform = TPSTransformType::New();
+      fieldSource->SetKernel( FieldSourceType::ThinPlateSpline );
     }
     else if( this->m_KernelName == "TPSR2LOGR" )
     {
-      kernelTransform = TPSR2LOGRTransformType::New();
+      fieldSource->SetKernel( FieldSourceType::ThinPlateR2LogRSpline );
     }
     else if( this->m_KernelName == "VS" )
     {
-      kernelTransform = VSTransformType::New();
+      fieldSource->SetKernel( FieldSourceType::VolumeSpline );
     }
     else if( this->m_KernelName == "EBS" )
     {
-      kernelTransform = EBSTransformType::New();
+      fieldSource->SetKernel( FieldSourceType::ElasticBodySpline );
     }
     else if( this->m_KernelName == "EBSR" )
     {
-      kernelTransform = EBSRTransformType::New();
+      fieldSource->SetKernel( FieldSourceType::ElasticBodyReciprocalSpline );
     }
     else
     {
@@ -272,36 +254,25 @@ public:
       itkGenericExceptionMacro( << "Unknown kernel transform!." );
     }
 
-    kernelTransform->SetStiffness( this->m_Stiffness );
-    kernelTransform->SetSourceLandmarks( inputPointSet1 );
-    kernelTransform->SetTargetLandmarks( inputPointSet2 );
-    kernelTransform->ComputeWMatrix();
+    fieldSource->SetStiffness( this->m_Stiffness );
+    fieldSource->SetTolerance( this->m_Tolerance );
+    fieldSource->SetSourceLandmarks( inputPointSet1 );
+    fieldSource->SetTargetLandmarks( inputPointSet2 );
 
-    /** Define the deformation field and an iterator on it */
-    deformationField->SetSpacing( reader1->GetOutput()->GetSpacing() );
-    deformationField->SetOrigin( reader1->GetOutput()->GetOrigin() );
-    deformationField->SetRegions( reader1->GetOutput()->GetLargestPossibleRegion() );
-    deformationField->Allocate();
-    DeformationFieldIteratorType iterator(
-      deformationField, deformationField->GetLargestPossibleRegion() );
-    iterator.GoToBegin();
+    /** Define the deformation field on the grid of the first image. */
+    fieldSource->SetOutputSpacing( reader1->GetOutput()->GetSpacing() );
+    fieldSource->SetOutputOrigin( reader1->GetOutput()->GetOrigin() );
+    fieldSource->SetOutputRegion( reader1->GetOutput()->GetLargestPossibleRegion() );
 
-    std::cout << "Generating deformation field. " << std::endl;
+    std::cout << "Computing the kernel weights." << std::endl;
+    fieldSource->ComputeWeights();
 
-    while ( !iterator.IsAtEnd() )
-    {
-      PointType pointin;
-      const IndexType & index = iterator.GetIndex();
-      deformationField->TransformIndexToPhysicalPoint( index, pointin);
-      PointType pointout = kernelTransform->TransformPoint( pointin );
-      DeformationVectorType vec = pointout - pointin;
-      iterator.Set( vec );
-      ++iterator;
-    }
+    std::cout << "Generating deformation field. " << std::endl;
+    fieldSource->Update();
 
     std::cout << "Saving deformation field to disk as " << this->m_OutputImageFileName << std::endl;
     writer->SetFileName( this->m_OutputImageFileName.c_str() );
-    writer->SetInput( deformationField );
+    writer->SetInput( fieldSource->GetOutput() );
     writer->Update();
 
   } // end Run()
@@ -0,0 +1,290 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkKernelSplineDeformationFieldSource_h_
+#define __itkKernelSplineDeformationFieldSource_h_
+
+#include "itkImageSource.h"
+#include "itkKernelTransform.h"
+#include "itkTimeStamp.h"
+#include "vnl/vnl_matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+
+/** \class KernelSplineDeformationFieldSource
+ * \brief Generates the deformation field of a kernel spline through
+ * corresponding landmarks, multithreaded.
+ *
+ * The spline is the same as that of the KernelTransform subclasses:
+ * thin plate (r), thin plate R2LogR (r^2 log r), volume (r^3), elastic
+ * body and elastic body reciprocal spline, with the same stiffness and
+ * the same affine part. The output pixel is the displacement
+ * T(x) - x of the voxel position x.
+ *
+ * The weights are computed with ThreadedDenseLinearSolver. For the three
+ * radial kernels, where the kernel matrix is a scalar times the identity,
+ * the system of size N D + D (D + 1) separates into one system of size
+ * N + D + 1 with D right hand sides, which is D^3 times cheaper.
+ *
+ * The field is evaluated per block of NumberOfLanes voxels along the
+ * first image axis: the loops over the voxels of a block are free of
+ * branches, so that the compiler can vectorize them.
+ *
+ * If a Tolerance is set, the sum over the landmarks is approximated
+ * for the radial kernels: the landmarks are stored in a kd-tree, and a
+ * node that is far enough from a block is replaced by a first order
+ * Taylor expansion around its center, i.e. by its total weight and its
+ * dipole moment. The expansion is only used when the bound on the
+ * second order remainder, 0.5 |H| R^2 sum_i |w_i|, with H the Hessian of
+ * the kernel and R the radius of the node, guarantees that the error in
+ * the displacement of any voxel is at most Tolerance. With a tolerance of
+ * zero (the default), the sum is exact.
+ *
+ * \ingroup ImageSource Multithreaded
+ */
+
+template< class TOutputImage >
+class KernelSplineDeformationFieldSource
+  : public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef KernelSplineDeformationFieldSource  Self;
+  typedef ImageSource< TOutputImage >         Superclass;
+  typedef SmartPointer<Self>                  Pointer;
+  typedef SmartPointer<const Self>            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( KernelSplineDeformationFieldSource, ImageSource );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** The number of voxels that are evaluated at once. */
+  itkStaticConstMacro( NumberOfLanes, unsigned int, 64 );
+
+  /** Typedef's. */
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputPixelType::ValueType         OutputValueType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename OutputImageType::SpacingType       SpacingType;
+  typedef typename OutputImageType::PointType         OriginPointType;
+  typedef typename OutputImageType::DirectionType     DirectionType;
+
+  /** The landmarks are given as for KernelTransform. */
+  typedef KernelTransform< double,
+    itkGetStaticConstMacro( ImageDimension ) >        KernelTransformType;
+  typedef typename KernelTransformType::PointSetType  PointSetType;
+  typedef typename PointSetType::Pointer              PointSetPointer;
+  typedef typename PointSetType::PointType            PointType;
+
+  /** The available kernels. */
+  typedef enum {
+    ThinPlateSpline,
+    ThinPlateR2LogRSpline,
+    VolumeSpline,
+    ElasticBodySpline,
+    ElasticBodyReciprocalSpline
+  } KernelType;
+
+  /** Set the kernel, default ThinPlateSpline. */
+  itkSetMacro( Kernel, KernelType );
+  itkGetConstMacro( Kernel, KernelType );
+
+  /** Set the stiffness, as KernelTransform::SetStiffness(). */
+  itkSetMacro( Stiffness, double );
+  itkGetConstMacro( Stiffness, double );
+
+  /** Set the maximum error in the displacement, default 0 (exact). */
+  itkSetMacro( Tolerance, double );
+  itkGetConstMacro( Tolerance, double );
+
+  /** Set the landmarks in the output space, and the corresponding ones. */
+  void SetSourceLandmarks( PointSetType * landmarks );
+  void SetTargetLandmarks( PointSetType * landmarks );
+
+  /** Set the geometry of the output. */
+  itkSetMacro( OutputRegion, OutputImageRegionType );
+  itkGetConstReferenceMacro( OutputRegion, OutputImageRegionType );
+  itkSetMacro( OutputSpacing, SpacingType );
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+  itkSetMacro( OutputOrigin, OriginPointType );
+  itkGetConstReferenceMacro( OutputOrigin, OriginPointType );
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  /** Compute the weights of the spline. Called by the pipeline when
+   * needed, but it can be called beforehand.
+   */
+  void ComputeWeights( void );
+
+protected:
+  KernelSplineDeformationFieldSource();
+  virtual ~KernelSplineDeformationFieldSource() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Sets the geometry of the output. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Computes the weights if needed, and builds the tree. */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Evaluates the field in the region, in blocks along the first axis. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+  /** The radial kernels, with the first derivative, and a bound on the
+   * norm of the Hessian of phi( |x| ) for rMin <= |x| <= rMax.
+   */
+  struct ThinPlateKernel
+  {
+    static double Phi( double r ) { return r; }
+    static double Derivative( double ) { return 1.0; }
+    static double HessianBound( double rMin, double ) { return 1.0 / rMin; }
+  };
+  struct ThinPlateR2LogRKernel
+  {
+    static double Phi( double r )
+    { return r > 1e-8 ? r * r * std::log( r ) : 0.0; }
+    static double Derivative( double r )
+    { return r > 1e-8 ? r * ( 2.0 * std::log( r ) + 1.0 ) : 0.0; }
+    static double HessianBound( double rMin, double rMax )
+    { return std::max( std::abs( 2.0 * std::log( rMin ) ),
+        std::abs( 2.0 * std::log( rMax ) ) ) + 3.0; }
+  };
+  struct VolumeKernel
+  {
+    static double Phi( double r ) { return r * r * r; }
+    static double Derivative( double r ) { return 3.0 * r * r; }
+    static double HessianBound( double, double rMax ) { return 6.0 * rMax; }
+  };
+
+  /** The elastic body kernels: G( x ) = Radial( r ) I + Factor( r ) x x^T,
+   * with the alpha of ITK for a Poisson ratio of 0.25.
+   */
+  struct ElasticBodyKernel
+  {
+    static double Radial( double r ) { return 8.0 * r * r * r; }
+    static double Factor( double r ) { return -3.0 * r; }
+  };
+  struct ElasticBodyReciprocalKernel
+  {
+    static double Radial( double r ) { return 5.0 * r; }
+    static double Factor( double r ) { return r > 1e-8 ? -1.0 / r : 0.0; }
+  };
+
+  /** Whether the kernel is a scalar times the identity. */
+  bool KernelIsRadial( void ) const;
+
+  /** Kernel matrix entry for a radial kernel, or block for the others. */
+  double EvaluatePhi( double r ) const;
+  void EvaluateG( const double * x, double * g ) const;
+
+  /** Add the contribution of landmarks [begin, end) to a block. */
+  template< class TKernel >
+  void AddRadialContribution( const double * const * points, unsigned int lanes,
+    unsigned int begin, unsigned int end, double * const * result ) const;
+  template< class TKernel >
+  void AddElasticContribution( const double * const * points, unsigned int lanes,
+    unsigned int begin, unsigned int end, double * const * result ) const;
+
+  /** Add the contribution of all landmarks to a block, using the tree. */
+  template< class TKernel >
+  void AddTreeContribution( const double * const * points, unsigned int lanes,
+    std::vector<unsigned int> & stack, double * const * result ) const;
+
+  /** Add the contribution of all landmarks to a block. */
+  void AddContribution( const double * const * points, unsigned int lanes,
+    std::vector<unsigned int> & stack, double * const * result ) const;
+
+  /** Build the kd-tree on the landmarks, reordering them. */
+  void BuildTree( void );
+  unsigned int BuildNode( std::vector<unsigned int> & order,
+    unsigned int begin, unsigned int end );
+
+private:
+  KernelSplineDeformationFieldSource( const Self & ); // purposely not implemented
+  void operator=( const Self & );                     // purposely not implemented
+
+  /** A node of the kd-tree: the landmarks [Begin, End), and the
+   * expansion around Center: M0 = sum_i w_i, M1 = sum_i ( p_i - c ) w_i^T.
+   */
+  struct TreeNode
+  {
+    double        Center[ ImageDimension ];
+    double        Radius;
+    double        M0[ ImageDimension ];
+    double        M1[ ImageDimension * ImageDimension ];
+    unsigned int  Begin;
+    unsigned int  End;
+    unsigned int  Children[ 2 ];
+    bool          IsLeaf;
+  };
+
+  /** Orders landmarks on one coordinate, for building the tree. */
+  struct LandmarkComparator
+  {
+    const double *  Landmarks;
+    unsigned int    Axis;
+    bool operator()( unsigned int a, unsigned int b ) const
+    {
+      return this->Landmarks[ a * ImageDimension + this->Axis ]
+        < this->Landmarks[ b * ImageDimension + this->Axis ];
+    }
+  };
+
+  KernelType              m_Kernel;
+  double                  m_Stiffness;
+  double                  m_Tolerance;
+  PointSetPointer         m_SourceLandmarks;
+  PointSetPointer         m_TargetLandmarks;
+
+  OutputImageRegionType   m_OutputRegion;
+  SpacingType             m_OutputSpacing;
+  OriginPointType         m_OutputOrigin;
+  DirectionType           m_OutputDirection;
+
+  /** The solution: landmark positions and weights, interleaved, and the
+   * affine part T(x) = x + sum_i G( x - p_i ) w_i + A x + b.
+   */
+  std::vector<double>     m_Landmarks;
+  std::vector<double>     m_Weights;
+  vnl_matrix<double>      m_AffineMatrix;
+  std::vector<double>     m_Translation;
+  TimeStamp               m_WeightsComputeTime;
+
+  /** The tree, and sum_i |w_i|. */
+  std::vector<TreeNode>   m_Tree;
+  double                  m_TotalWeight;
+
+}; // end class KernelSplineDeformationFieldSource
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkKernelSplineDeformationFieldSource.txx"
+#endif
+
+#endif // end #ifndef __itkKernelSplineDeformationFieldSource_h_
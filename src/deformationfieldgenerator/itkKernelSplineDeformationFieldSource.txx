@@ -0,0 +1,844 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkKernelSplineDeformationFieldSource_txx_
+#define __itkKernelSplineDeformationFieldSource_txx_
+
+#include "itkKernelSplineDeformationFieldSource.h"
+#include "itkThreadedDenseLinearSolver.h"
+#include "itkImageLinearIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TOutputImage >
+KernelSplineDeformationFieldSource< TOutputImage >
+::KernelSplineDeformationFieldSource()
+{
+  this->m_Kernel = ThinPlateSpline;
+  this->m_Stiffness = 0.0;
+  this->m_Tolerance = 0.0;
+  this->m_OutputSpacing.Fill( 1.0 );
+  this->m_OutputOrigin.Fill( 0.0 );
+  this->m_OutputDirection.SetIdentity();
+  this->m_TotalWeight = 0.0;
+
+} // end Constructor()
+
+
+/**
+ * ******************* SetSourceLandmarks *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::SetSourceLandmarks( PointSetType * landmarks )
+{
+  if( this->m_SourceLandmarks != landmarks )
+  {
+    this->m_SourceLandmarks = landmarks;
+    this->Modified();
+  }
+
+} // end SetSourceLandmarks()
+
+
+/**
+ * ******************* SetTargetLandmarks *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::SetTargetLandmarks( PointSetType * landmarks )
+{
+  if( this->m_TargetLandmarks != landmarks )
+  {
+    this->m_TargetLandmarks = landmarks;
+    this->Modified();
+  }
+
+} // end SetTargetLandmarks()
+
+
+/**
+ * ******************* GenerateOutputInformation *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::GenerateOutputInformation( void )
+{
+  OutputImageType * output = this->GetOutput();
+  if( !output ) return;
+
+  output->SetLargestPossibleRegion( this->m_OutputRegion );
+  output->SetSpacing( this->m_OutputSpacing );
+  output->SetOrigin( this->m_OutputOrigin );
+  output->SetDirection( this->m_OutputDirection );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ******************* KernelIsRadial *******************
+ */
+
+template< class TOutputImage >
+bool
+KernelSplineDeformationFieldSource< TOutputImage >
+::KernelIsRadial( void ) const
+{
+  return this->m_Kernel == ThinPlateSpline
+    || this->m_Kernel == ThinPlateR2LogRSpline
+    || this->m_Kernel == VolumeSpline;
+
+} // end KernelIsRadial()
+
+
+/**
+ * ******************* EvaluatePhi *******************
+ */
+
+template< class TOutputImage >
+double
+KernelSplineDeformationFieldSource< TOutputImage >
+::EvaluatePhi( double r ) const
+{
+  switch( this->m_Kernel )
+  {
+    case ThinPlateR2LogRSpline: return ThinPlateR2LogRKernel::Phi( r );
+    case VolumeSpline:          return VolumeKernel::Phi( r );
+    default:                    return ThinPlateKernel::Phi( r );
+  }
+
+} // end EvaluatePhi()
+
+
+/**
+ * ******************* EvaluateG *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::EvaluateG( const double * x, double * g ) const
+{
+  double r = 0.0;
+  for( unsigned int d = 0; d < ImageDimension; ++d ) r += x[ d ] * x[ d ];
+  r = std::sqrt( r );
+
+  double radial = 0.0;
+  double factor = 0.0;
+  if( this->m_Kernel == ElasticBodySpline )
+  {
+    radial = ElasticBodyKernel::Radial( r );
+    factor = ElasticBodyKernel::Factor( r );
+  }
+  else
+  {
+    radial = ElasticBodyReciprocalKernel::Radial( r );
+    factor = ElasticBodyReciprocalKernel::Factor( r );
+  }
+
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+  {
+    for( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+      g[ i * ImageDimension + j ] = factor * x[ i ] * x[ j ] + ( i == j ? radial : 0.0 );
+    }
+  }
+
+} // end EvaluateG()
+
+
+/**
+ * ******************* ComputeWeights *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::ComputeWeights( void )
+{
+  const unsigned int D = ImageDimension;
+  if( this->m_SourceLandmarks.IsNull() || this->m_TargetLandmarks.IsNull() )
+  {
+    itkExceptionMacro( << "ERROR: the source and target landmarks should be set." );
+  }
+  const unsigned int N = this->m_SourceLandmarks->GetNumberOfPoints();
+  if( N == 0 || N != this->m_TargetLandmarks->GetNumberOfPoints() )
+  {
+    itkExceptionMacro( << "ERROR: the number of source landmarks (" << N
+      << ") should be nonzero and equal to the number of target landmarks ("
+      << this->m_TargetLandmarks->GetNumberOfPoints() << ")." );
+  }
+
+  /** Copy the landmarks and the displacements. */
+  this->m_Landmarks.resize( N * D );
+  std::vector<double> displacements( N * D );
+  PointType source, target;
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    this->m_SourceLandmarks->GetPoint( i, &source );
+    this->m_TargetLandmarks->GetPoint( i, &target );
+    for( unsigned int d = 0; d < D; ++d )
+    {
+      this->m_Landmarks[ i * D + d ] = source[ d ];
+      displacements[ i * D + d ] = target[ d ] - source[ d ];
+    }
+  }
+  const double * p = &this->m_Landmarks[ 0 ];
+
+  ThreadedDenseLinearSolver::Pointer solver = ThreadedDenseLinearSolver::New();
+  solver->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  this->m_Weights.assign( N * D, 0.0 );
+  this->m_AffineMatrix.set_size( D, D );
+  this->m_Translation.assign( D, 0.0 );
+
+  if( this->KernelIsRadial() )
+  {
+    /** The kernel matrix is phi( r ) I, so that the system separates into
+     * [ Phi + sI, Q; Q^T, 0 ] W = [ Y; 0 ], with Q = [ p_i^T 1 ], and the
+     * displacements in the columns of Y.
+     */
+    const unsigned int m = N + D + 1;
+    vnl_matrix<double> L( m, m, 0.0 );
+    vnl_matrix<double> Y( m, D, 0.0 );
+    for( unsigned int i = 0; i < N; ++i )
+    {
+      for( unsigned int j = 0; j < i; ++j )
+      {
+        double r = 0.0;
+        for( unsigned int d = 0; d < D; ++d )
+        {
+          const double diff = p[ i * D + d ] - p[ j * D + d ];
+          r += diff * diff;
+        }
+        const double phi = this->EvaluatePhi( std::sqrt( r ) );
+        L( i, j ) = phi;
+        L( j, i ) = phi;
+      }
+      L( i, i ) = this->m_Stiffness;
+      for( unsigned int d = 0; d < D; ++d )
+      {
+        L( i, N + d ) = p[ i * D + d ];
+        L( N + d, i ) = p[ i * D + d ];
+        Y( i, d ) = displacements[ i * D + d ];
+      }
+      L( i, N + D ) = 1.0;
+      L( N + D, i ) = 1.0;
+    }
+
+    solver->Solve( L, Y );
+
+    for( unsigned int i = 0; i < N; ++i )
+    {
+      for( unsigned int d = 0; d < D; ++d )
+      {
+        this->m_Weights[ i * D + d ] = Y( i, d );
+      }
+    }
+    for( unsigned int k = 0; k < D; ++k )
+    {
+      for( unsigned int j = 0; j < D; ++j )
+      {
+        this->m_AffineMatrix( k, j ) = Y( N + j, k );
+      }
+      this->m_Translation[ k ] = Y( N + D, k );
+    }
+  }
+  else
+  {
+    /** The full system of KernelTransform: [ K, P; P^T, 0 ] W = [ Y; 0 ]. */
+    const unsigned int m = N * D + D * ( D + 1 );
+    vnl_matrix<double> L( m, m, 0.0 );
+    vnl_matrix<double> Y( m, 1, 0.0 );
+    double x[ ImageDimension ];
+    double g[ ImageDimension * ImageDimension ];
+    for( unsigned int i = 0; i < N; ++i )
+    {
+      for( unsigned int j = 0; j < i; ++j )
+      {
+        for( unsigned int d = 0; d < D; ++d )
+        {
+          x[ d ] = p[ i * D + d ] - p[ j * D + d ];
+        }
+        this->EvaluateG( x, g );
+        for( unsigned int r = 0; r < D; ++r )
+        {
+          for( unsigned int c = 0; c < D; ++c )
+          {
+            L( i * D + r, j * D + c ) = g[ r * D + c ];
+            L( j * D + c, i * D + r ) = g[ r * D + c ];
+          }
+        }
+      }
+      for( unsigned int k = 0; k < D; ++k )
+      {
+        L( i * D + k, i * D + k ) = this->m_Stiffness;
+        for( unsigned int j = 0; j < D; ++j )
+        {
+          L( i * D + k, N * D + j * D + k ) = p[ i * D + j ];
+          L( N * D + j * D + k, i * D + k ) = p[ i * D + j ];
+        }
+        L( i * D + k, N * D + D * D + k ) = 1.0;
+        L( N * D + D * D + k, i * D + k ) = 1.0;
+        Y( i * D + k, 0 ) = displacements[ i * D + k ];
+      }
+    }
+
+    solver->Solve( L, Y );
+
+    for( unsigned int i = 0; i < N * D; ++i )
+    {
+      this->m_Weights[ i ] = Y( i, 0 );
+    }
+    for( unsigned int j = 0; j < D; ++j )
+    {
+      for( unsigned int k = 0; k < D; ++k )
+      {
+        this->m_AffineMatrix( k, j ) = Y( N * D + j * D + k, 0 );
+      }
+    }
+    for( unsigned int k = 0; k < D; ++k )
+    {
+      this->m_Translation[ k ] = Y( N * D + D * D + k, 0 );
+    }
+  }
+
+  /** The tree is built on demand. */
+  this->m_Tree.clear();
+  this->m_TotalWeight = 0.0;
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    double norm = 0.0;
+    for( unsigned int d = 0; d < D; ++d )
+    {
+      norm += this->m_Weights[ i * D + d ] * this->m_Weights[ i * D + d ];
+    }
+    this->m_TotalWeight += std::sqrt( norm );
+  }
+
+  this->m_WeightsComputeTime.Modified();
+
+} // end ComputeWeights()
+
+
+/**
+ * ******************* BuildTree *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::BuildTree( void )
+{
+  const unsigned int D = ImageDimension;
+  const unsigned int N = this->m_Landmarks.size() / D;
+
+  std::vector<unsigned int> order( N );
+  for( unsigned int i = 0; i < N; ++i ) order[ i ] = i;
+
+  this->m_Tree.clear();
+  this->m_Tree.reserve( 2 * ( N / 8 + 1 ) );
+  this->BuildNode( order, 0, N );
+
+  /** Store the landmarks in the order of the tree. */
+  std::vector<double> landmarks( N * D );
+  std::vector<double> weights( N * D );
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    for( unsigned int d = 0; d < D; ++d )
+    {
+      landmarks[ i * D + d ] = this->m_Landmarks[ order[ i ] * D + d ];
+      weights[ i * D + d ] = this->m_Weights[ order[ i ] * D + d ];
+    }
+  }
+  this->m_Landmarks.swap( landmarks );
+  this->m_Weights.swap( weights );
+
+} // end BuildTree()
+
+
+/**
+ * ******************* BuildNode *******************
+ */
+
+template< class TOutputImage >
+unsigned int
+KernelSplineDeformationFieldSource< TOutputImage >
+::BuildNode( std::vector<unsigned int> & order, unsigned int begin, unsigned int end )
+{
+  const unsigned int D = ImageDimension;
+  const unsigned int leafSize = 16;
+  const double * p = &this->m_Landmarks[ 0 ];
+  const double * w = &this->m_Weights[ 0 ];
+
+  /** The bounding box gives the center and the split axis. */
+  double minimum[ ImageDimension ];
+  double maximum[ ImageDimension ];
+  for( unsigned int d = 0; d < D; ++d )
+  {
+    minimum[ d ] = maximum[ d ] = p[ order[ begin ] * D + d ];
+  }
+  for( unsigned int i = begin + 1; i < end; ++i )
+  {
+    for( unsigned int d = 0; d < D; ++d )
+    {
+      minimum[ d ] = std::min( minimum[ d ], p[ order[ i ] * D + d ] );
+      maximum[ d ] = std::max( maximum[ d ], p[ order[ i ] * D + d ] );
+    }
+  }
+
+  TreeNode node;
+  node.Begin = begin;
+  node.End = end;
+  node.IsLeaf = end - begin <= leafSize;
+  node.Children[ 0 ] = node.Children[ 1 ] = 0;
+  node.Radius = 0.0;
+  for( unsigned int d = 0; d < D; ++d )
+  {
+    node.Center[ d ] = 0.5 * ( minimum[ d ] + maximum[ d ] );
+    node.M0[ d ] = 0.0;
+  }
+  for( unsigned int d = 0; d < D * D; ++d ) node.M1[ d ] = 0.0;
+
+  /** The radius and the moments. */
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    const double * pi = p + order[ i ] * D;
+    const double * wi = w + order[ i ] * D;
+    double r = 0.0;
+    for( unsigned int j = 0; j < D; ++j )
+    {
+      const double delta = pi[ j ] - node.Center[ j ];
+      r += delta * delta;
+      for( unsigned int k = 0; k < D; ++k )
+      {
+        node.M1[ j * D + k ] += delta * wi[ k ];
+      }
+    }
+    node.Radius = std::max( node.Radius, std::sqrt( r ) );
+    for( unsigned int k = 0; k < D; ++k ) node.M0[ k ] += wi[ k ];
+  }
+
+  const unsigned int nodeIndex = this->m_Tree.size();
+  this->m_Tree.push_back( node );
+  if( node.IsLeaf ) return nodeIndex;
+
+  /** Split at the median of the longest side. */
+  LandmarkComparator comparator;
+  comparator.Landmarks = p;
+  comparator.Axis = 0;
+  for( unsigned int d = 1; d < D; ++d )
+  {
+    if( maximum[ d ] - minimum[ d ] > maximum[ comparator.Axis ] - minimum[ comparator.Axis ] )
+    {
+      comparator.Axis = d;
+    }
+  }
+  const unsigned int middle = begin + ( end - begin ) / 2;
+  std::nth_element( order.begin() + begin, order.begin() + middle,
+    order.begin() + end, comparator );
+
+  const unsigned int child0 = this->BuildNode( order, begin, middle );
+  const unsigned int child1 = this->BuildNode( order, middle, end );
+  this->m_Tree[ nodeIndex ].Children[ 0 ] = child0;
+  this->m_Tree[ nodeIndex ].Children[ 1 ] = child1;
+  return nodeIndex;
+
+} // end BuildNode()
+
+
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  const unsigned long computeTime = this->m_WeightsComputeTime.GetMTime();
+  if( this->m_Landmarks.empty() || computeTime < this->GetMTime()
+    || ( this->m_SourceLandmarks.IsNotNull() && computeTime < this->m_SourceLandmarks->GetMTime() )
+    || ( this->m_TargetLandmarks.IsNotNull() && computeTime < this->m_TargetLandmarks->GetMTime() ) )
+  {
+    this->ComputeWeights();
+  }
+
+  if( this->m_Tolerance > 0.0 && this->m_Tree.empty() )
+  {
+    if( this->KernelIsRadial() )
+    {
+      this->BuildTree();
+    }
+    else
+    {
+      itkWarningMacro( << "The tolerance is only used for the radial kernels; "
+        << "the field is computed exactly." );
+    }
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* AddRadialContribution *******************
+ */
+
+template< class TOutputImage >
+template< class TKernel >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::AddRadialContribution( const double * const * points, unsigned int lanes,
+  unsigned int begin, unsigned int end, double * const * result ) const
+{
+  const unsigned int D = ImageDimension;
+  double phi[ NumberOfLanes ];
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    const double * p = &this->m_Landmarks[ i * D ];
+    const double * w = &this->m_Weights[ i * D ];
+    for( unsigned int b = 0; b < lanes; ++b )
+    {
+      double r = 0.0;
+      for( unsigned int d = 0; d < D; ++d )
+      {
+        const double diff = points[ d ][ b ] - p[ d ];
+        r += diff * diff;
+      }
+      phi[ b ] = TKernel::Phi( std::sqrt( r ) );
+    }
+    for( unsigned int k = 0; k < D; ++k )
+    {
+      const double wk = w[ k ];
+      double * resultK = result[ k ];
+      for( unsigned int b = 0; b < lanes; ++b )
+      {
+        resultK[ b ] += phi[ b ] * wk;
+      }
+    }
+  }
+
+} // end AddRadialContribution()
+
+
+/**
+ * ******************* AddElasticContribution *******************
+ */
+
+template< class TOutputImage >
+template< class TKernel >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::AddElasticContribution( const double * const * points, unsigned int lanes,
+  unsigned int begin, unsigned int end, double * const * result ) const
+{
+  /** G( x ) w = Radial( r ) w + Factor( r ) x ( x^T w ). */
+  const unsigned int D = ImageDimension;
+  double x[ ImageDimension ];
+  for( unsigned int i = begin; i < end; ++i )
+  {
+    const double * p = &this->m_Landmarks[ i * D ];
+    const double * w = &this->m_Weights[ i * D ];
+    for( unsigned int b = 0; b < lanes; ++b )
+    {
+      double r = 0.0;
+      double xw = 0.0;
+      for( unsigned int d = 0; d < D; ++d )
+      {
+        x[ d ] = points[ d ][ b ] - p[ d ];
+        r += x[ d ] * x[ d ];
+        xw += x[ d ] * w[ d ];
+      }
+      r = std::sqrt( r );
+      const double radial = TKernel::Radial( r );
+      const double factor = TKernel::Factor( r ) * xw;
+      for( unsigned int k = 0; k < D; ++k )
+      {
+        result[ k ][ b ] += radial * w[ k ] + factor * x[ k ];
+      }
+    }
+  }
+
+} // end AddElasticContribution()
+
+
+/**
+ * ******************* AddTreeContribution *******************
+ */
+
+template< class TOutputImage >
+template< class TKernel >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::AddTreeContribution( const double * const * points, unsigned int lanes,
+  std::vector<unsigned int> & stack, double * const * result ) const
+{
+  const unsigned int D = ImageDimension;
+
+  /** The bounding sphere of the block, which is a line segment. */
+  double center[ ImageDimension ];
+  double blockRadius = 0.0;
+  for( unsigned int d = 0; d < D; ++d )
+  {
+    center[ d ] = 0.5 * ( points[ d ][ 0 ] + points[ d ][ lanes - 1 ] );
+    const double half = 0.5 * ( points[ d ][ lanes - 1 ] - points[ d ][ 0 ] );
+    blockRadius += half * half;
+  }
+  blockRadius = std::sqrt( blockRadius );
+
+  /** A node is expanded if |H| R^2 sum_i |w_i| / 2 <= tolerance. */
+  const double threshold = 2.0 * this->m_Tolerance / this->m_TotalWeight;
+
+  double diff[ ImageDimension ];
+  stack.clear();
+  stack.push_back( 0 );
+  while( !stack.empty() )
+  {
+    const TreeNode & node = this->m_Tree[ stack.back() ];
+    stack.pop_back();
+
+    double distance = 0.0;
+    for( unsigned int d = 0; d < D; ++d )
+    {
+      const double delta = center[ d ] - node.Center[ d ];
+      distance += delta * delta;
+    }
+    distance = std::sqrt( distance );
+
+    const double rMin = distance - blockRadius - node.Radius;
+    if( rMin > 0.0 )
+    {
+      const double rMax = distance + blockRadius + node.Radius;
+      const double R2 = node.Radius * node.Radius;
+      if( R2 == 0.0 || TKernel::HessianBound( rMin, rMax ) * R2 <= threshold )
+      {
+        /** phi( r ) M0 - phi'( r ) / r ( x - c )^T M1, with r = |x - c| > 0. */
+        for( unsigned int b = 0; b < lanes; ++b )
+        {
+          double r = 0.0;
+          for( unsigned int d = 0; d < D; ++d )
+          {
+            diff[ d ] = points[ d ][ b ] - node.Center[ d ];
+            r += diff[ d ] * diff[ d ];
+          }
+          r = std::sqrt( r );
+          const double phi = TKernel::Phi( r );
+          const double derivative = TKernel::Derivative( r ) / r;
+          for( unsigned int k = 0; k < D; ++k )
+          {
+            double dipole = 0.0;
+            for( unsigned int j = 0; j < D; ++j )
+            {
+              dipole += diff[ j ] * node.M1[ j * D + k ];
+            }
+            result[ k ][ b ] += phi * node.M0[ k ] - derivative * dipole;
+          }
+        }
+        continue;
+      }
+    }
+
+    if( node.IsLeaf )
+    {
+      this->template AddRadialContribution<TKernel>(
+        points, lanes, node.Begin, node.End, result );
+    }
+    else
+    {
+      stack.push_back( node.Children[ 0 ] );
+      stack.push_back( node.Children[ 1 ] );
+    }
+  }
+
+} // end AddTreeContribution()
+
+
+/**
+ * ******************* AddContribution *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::AddContribution( const double * const * points, unsigned int lanes,
+  std::vector<unsigned int> & stack, double * const * result ) const
+{
+  const unsigned int N = this->m_Landmarks.size() / ImageDimension;
+  const bool useTree = this->m_Tolerance > 0.0 && !this->m_Tree.empty();
+
+  switch( this->m_Kernel )
+  {
+    case ThinPlateSpline:
+      if( useTree ) this->template AddTreeContribution<ThinPlateKernel>( points, lanes, stack, result );
+      else this->template AddRadialContribution<ThinPlateKernel>( points, lanes, 0, N, result );
+      break;
+    case ThinPlateR2LogRSpline:
+      if( useTree ) this->template AddTreeContribution<ThinPlateR2LogRKernel>( points, lanes, stack, result );
+      else this->template AddRadialContribution<ThinPlateR2LogRKernel>( points, lanes, 0, N, result );
+      break;
+    case VolumeSpline:
+      if( useTree ) this->template AddTreeContribution<VolumeKernel>( points, lanes, stack, result );
+      else this->template AddRadialContribution<VolumeKernel>( points, lanes, 0, N, result );
+      break;
+    case ElasticBodySpline:
+      this->template AddElasticContribution<ElasticBodyKernel>( points, lanes, 0, N, result );
+      break;
+    case ElasticBodyReciprocalSpline:
+      this->template AddElasticContribution<ElasticBodyReciprocalKernel>( points, lanes, 0, N, result );
+      break;
+  }
+
+} // end AddContribution()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+{
+  const unsigned int D = ImageDimension;
+  OutputImageType * output = this->GetOutput();
+
+  /** The step in physical space along the first axis. */
+  double step[ ImageDimension ];
+  for( unsigned int d = 0; d < D; ++d )
+  {
+    step[ d ] = output->GetDirection()[ d ][ 0 ] * output->GetSpacing()[ 0 ];
+  }
+
+  /** Copy the affine part. */
+  double affine[ ImageDimension * ImageDimension ];
+  for( unsigned int k = 0; k < D; ++k )
+  {
+    for( unsigned int j = 0; j < D; ++j )
+    {
+      affine[ k * D + j ] = this->m_AffineMatrix( k, j );
+    }
+  }
+
+  /** The positions and the displacements of a block, per dimension. */
+  double pointBuffer[ ImageDimension ][ NumberOfLanes ];
+  double resultBuffer[ ImageDimension ][ NumberOfLanes ];
+  const double * points[ ImageDimension ];
+  double * result[ ImageDimension ];
+  for( unsigned int d = 0; d < D; ++d )
+  {
+    points[ d ] = pointBuffer[ d ];
+    result[ d ] = resultBuffer[ d ];
+  }
+  std::vector<unsigned int> stack;
+
+  typedef ImageLinearIteratorWithIndex<OutputImageType> IteratorType;
+  IteratorType it( output, outputRegionForThread );
+  it.SetDirection( 0 );
+  it.GoToBegin();
+
+  const unsigned long lineLength = outputRegionForThread.GetSize()[ 0 ];
+  ProgressReporter progress( this, threadId,
+    outputRegionForThread.GetNumberOfPixels() / lineLength );
+
+  typename OutputImageType::PointType lineStart;
+  OutputPixelType value;
+  while( !it.IsAtEnd() )
+  {
+    output->TransformIndexToPhysicalPoint( it.GetIndex(), lineStart );
+    for( unsigned long start = 0; start < lineLength; start += NumberOfLanes )
+    {
+      const unsigned int lanes = static_cast<unsigned int>(
+        std::min<unsigned long>( NumberOfLanes, lineLength - start ) );
+      for( unsigned int d = 0; d < D; ++d )
+      {
+        for( unsigned int b = 0; b < lanes; ++b )
+        {
+          pointBuffer[ d ][ b ] = lineStart[ d ] + ( start + b ) * step[ d ];
+          resultBuffer[ d ][ b ] = 0.0;
+        }
+      }
+
+      this->AddContribution( points, lanes, stack, result );
+
+      /** Add the affine part, and store the displacements. */
+      for( unsigned int k = 0; k < D; ++k )
+      {
+        for( unsigned int b = 0; b < lanes; ++b )
+        {
+          double affinePart = this->m_Translation[ k ];
+          for( unsigned int j = 0; j < D; ++j )
+          {
+            affinePart += affine[ k * D + j ] * pointBuffer[ j ][ b ];
+          }
+          resultBuffer[ k ][ b ] += affinePart;
+        }
+      }
+      for( unsigned int b = 0; b < lanes; ++b, ++it )
+      {
+        for( unsigned int k = 0; k < D; ++k )
+        {
+          value[ k ] = static_cast<OutputValueType>( resultBuffer[ k ][ b ] );
+        }
+        it.Set( value );
+      }
+    }
+    it.NextLine();
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TOutputImage >
+void
+KernelSplineDeformationFieldSource< TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Kernel: " << this->m_Kernel << std::endl;
+  os << indent << "Stiffness: " << this->m_Stiffness << std::endl;
+  os << indent << "Tolerance: " << this->m_Tolerance << std::endl;
+  os << indent << "OutputRegion: " << this->m_OutputRegion << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+  os << indent << "NumberOfTreeNodes: " << this->m_Tree.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkKernelSplineDeformationFieldSource_txx_
@@ -0,0 +1,308 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "itkThreadedDenseLinearSolver.h"
+#include "itkMacro.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+ThreadedDenseLinearSolver::ThreadedDenseLinearSolver()
+{
+  this->m_MultiThreader = MultiThreader::New();
+  this->m_NumberOfThreads = this->m_MultiThreader->GetNumberOfThreads();
+  this->m_BlockSize = 64;
+
+} // end Constructor()
+
+
+/**
+ * ******************* Solve *******************
+ */
+
+void
+ThreadedDenseLinearSolver::Solve( MatrixType & A, MatrixType & B )
+{
+  const unsigned int n = A.rows();
+  if( A.cols() != n || B.rows() != n )
+  {
+    itkExceptionMacro( << "ERROR: the system is not square, or the right hand side "
+      << "does not match: A is " << A.rows() << "x" << A.cols()
+      << ", B is " << B.rows() << "x" << B.cols() << "." );
+  }
+
+  const unsigned int blockSize = std::max( this->m_BlockSize, 1u );
+
+  SolverThreadStruct str;
+  str.Solver = this;
+  str.Matrix = &A;
+  this->m_MultiThreader->SetNumberOfThreads( this->m_NumberOfThreads );
+  this->m_MultiThreader->SetSingleMethod( this->SolverThreaderCallback, &str );
+
+  for( unsigned int k0 = 0; k0 < n; k0 += blockSize )
+  {
+    const unsigned int kb = std::min( blockSize, n - k0 );
+    this->FactorizePanel( A, B, k0, kb );
+    if( k0 + kb == n ) break;
+
+    str.PanelStart = k0;
+    str.PanelSize = kb;
+    str.UpdateTrailingMatrix = false;
+    this->m_MultiThreader->SingleMethodExecute();
+    str.UpdateTrailingMatrix = true;
+    this->m_MultiThreader->SingleMethodExecute();
+  }
+
+  this->SubstituteRightHandSide( A, B );
+
+} // end Solve()
+
+
+/**
+ * ******************* SolverThreaderCallback *******************
+ */
+
+ITK_THREAD_RETURN_TYPE
+ThreadedDenseLinearSolver::SolverThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  SolverThreadStruct * str = static_cast<SolverThreadStruct *>( info->UserData );
+
+  /** Both updates work on the rows or columns after the panel;
+   * give each thread a contiguous part.
+   */
+  const unsigned int n = str->Matrix->rows();
+  const unsigned int first = str->PanelStart + str->PanelSize;
+  const unsigned int chunk = ( n - first + threadCount - 1 ) / threadCount;
+  const unsigned int begin = std::min( n, first + threadId * chunk );
+  const unsigned int end = std::min( n, begin + chunk );
+  if( begin < end )
+  {
+    if( str->UpdateTrailingMatrix )
+    {
+      str->Solver->ThreadedUpdateTrailingMatrix( *str->Matrix,
+        str->PanelStart, str->PanelSize, begin, end );
+    }
+    else
+    {
+      str->Solver->ThreadedUpdateRowsOfU( *str->Matrix,
+        str->PanelStart, str->PanelSize, begin, end );
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end SolverThreaderCallback()
+
+
+/**
+ * ******************* FactorizePanel *******************
+ */
+
+void
+ThreadedDenseLinearSolver::FactorizePanel( MatrixType & A, MatrixType & B,
+  unsigned int k0, unsigned int kb )
+{
+  const unsigned int n = A.rows();
+  const unsigned int kEnd = k0 + kb;
+  double ** a = A.data_array();
+
+  for( unsigned int k = k0; k < kEnd; ++k )
+  {
+    /** Find the pivot. */
+    unsigned int pivot = k;
+    double maximum = std::abs( a[ k ][ k ] );
+    for( unsigned int i = k + 1; i < n; ++i )
+    {
+      const double value = std::abs( a[ i ][ k ] );
+      if( value > maximum )
+      {
+        maximum = value;
+        pivot = i;
+      }
+    }
+    if( !( maximum > 0.0 ) )
+    {
+      itkExceptionMacro( << "ERROR: the matrix is singular (zero pivot in column "
+        << k << ")." );
+    }
+
+    /** Swap complete rows, so that the permutation is applied to B as well. */
+    if( pivot != k )
+    {
+      std::swap_ranges( a[ k ], a[ k ] + n, a[ pivot ] );
+      for( unsigned int c = 0; c < B.cols(); ++c )
+      {
+        std::swap( B( k, c ), B( pivot, c ) );
+      }
+    }
+
+    /** Compute the column of L, and update the rest of the panel. */
+    const double inversePivot = 1.0 / a[ k ][ k ];
+    for( unsigned int i = k + 1; i < n; ++i )
+    {
+      double * row = a[ i ];
+      const double l = row[ k ] * inversePivot;
+      row[ k ] = l;
+      if( l == 0.0 ) continue;
+      for( unsigned int j = k + 1; j < kEnd; ++j )
+      {
+        row[ j ] -= l * a[ k ][ j ];
+      }
+    }
+  }
+
+} // end FactorizePanel()
+
+
+/**
+ * ******************* ThreadedUpdateRowsOfU *******************
+ */
+
+void
+ThreadedDenseLinearSolver::ThreadedUpdateRowsOfU( MatrixType & A,
+  unsigned int k0, unsigned int kb, unsigned int j0, unsigned int j1 )
+{
+  /** U12 = L11^-1 A12, with L11 unit lower triangular. */
+  double ** a = A.data_array();
+  const unsigned int kEnd = k0 + kb;
+  for( unsigned int k = k0; k < kEnd; ++k )
+  {
+    const double * rowK = a[ k ];
+    for( unsigned int i = k + 1; i < kEnd; ++i )
+    {
+      double * row = a[ i ];
+      const double l = row[ k ];
+      if( l == 0.0 ) continue;
+      for( unsigned int j = j0; j < j1; ++j )
+      {
+        row[ j ] -= l * rowK[ j ];
+      }
+    }
+  }
+
+} // end ThreadedUpdateRowsOfU()
+
+
+/**
+ * ******************* ThreadedUpdateTrailingMatrix *******************
+ */
+
+void
+ThreadedDenseLinearSolver::ThreadedUpdateTrailingMatrix( MatrixType & A,
+  unsigned int k0, unsigned int kb, unsigned int i0, unsigned int i1 )
+{
+  /** A22 -= L21 U12, in tiles of columns. */
+  double ** a = A.data_array();
+  const unsigned int n = A.cols();
+  const unsigned int kEnd = k0 + kb;
+  const unsigned int tileSize = 256;
+  for( unsigned int t0 = kEnd; t0 < n; t0 += tileSize )
+  {
+    const unsigned int t1 = std::min( n, t0 + tileSize );
+    for( unsigned int i = i0; i < i1; ++i )
+    {
+      double * row = a[ i ];
+      for( unsigned int k = k0; k < kEnd; ++k )
+      {
+        const double l = row[ k ];
+        if( l == 0.0 ) continue;
+        const double * rowK = a[ k ];
+        for( unsigned int j = t0; j < t1; ++j )
+        {
+          row[ j ] -= l * rowK[ j ];
+        }
+      }
+    }
+  }
+
+} // end ThreadedUpdateTrailingMatrix()
+
+
+/**
+ * ******************* SubstituteRightHandSide *******************
+ */
+
+void
+ThreadedDenseLinearSolver::SubstituteRightHandSide(
+  const MatrixType & A, MatrixType & B )
+{
+  const unsigned int n = A.rows();
+  const unsigned int m = B.cols();
+  double ** b = B.data_array();
+
+  /** Forward substitution with the unit lower triangular L. */
+  for( unsigned int i = 1; i < n; ++i )
+  {
+    for( unsigned int k = 0; k < i; ++k )
+    {
+      const double l = A( i, k );
+      if( l == 0.0 ) continue;
+      for( unsigned int c = 0; c < m; ++c )
+      {
+        b[ i ][ c ] -= l * b[ k ][ c ];
+      }
+    }
+  }
+
+  /** Backward substitution with U. */
+  for( unsigned int i = n; i-- > 0; )
+  {
+    for( unsigned int k = i + 1; k < n; ++k )
+    {
+      const double u = A( i, k );
+      if( u == 0.0 ) continue;
+      for( unsigned int c = 0; c < m; ++c )
+      {
+        b[ i ][ c ] -= u * b[ k ][ c ];
+      }
+    }
+    const double inverseDiagonal = 1.0 / A( i, i );
+    for( unsigned int c = 0; c < m; ++c )
+    {
+      b[ i ][ c ] *= inverseDiagonal;
+    }
+  }
+
+} // end SubstituteRightHandSide()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+void
+ThreadedDenseLinearSolver::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "BlockSize: " << this->m_BlockSize << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
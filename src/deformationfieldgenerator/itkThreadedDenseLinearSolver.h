@@ -0,0 +1,117 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkThreadedDenseLinearSolver_h_
+#define __itkThreadedDenseLinearSolver_h_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include "vnl/vnl_matrix.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class ThreadedDenseLinearSolver
+ * \brief Solves a dense, square linear system A X = B with a blocked,
+ * multithreaded LU decomposition with partial pivoting.
+ *
+ * The columns of A are factorized in panels of BlockSize columns. The
+ * panel itself is factorized by one thread; the update of the rows of U
+ * right of the panel, and of the trailing submatrix, which are O(n^3)
+ * together, are divided over the threads. The trailing update is done
+ * in tiles of columns, so that the rows of U that are used stay in the
+ * cache.
+ *
+ * Unlike vnl_svd, which is used by KernelTransform, this does not
+ * compute a least squares solution of a singular system: an exception
+ * is thrown if a pivot is zero.
+ */
+
+class ThreadedDenseLinearSolver : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ThreadedDenseLinearSolver   Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ThreadedDenseLinearSolver, Object );
+
+  typedef vnl_matrix<double>          MatrixType;
+
+  /** Set the number of threads, by default the global default. */
+  itkSetMacro( NumberOfThreads, ThreadIdType );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Set the width of the panels, default 64. */
+  itkSetMacro( BlockSize, unsigned int );
+  itkGetConstMacro( BlockSize, unsigned int );
+
+  /** Solve A X = B. A is overwritten by its LU factors and B by X. */
+  void Solve( MatrixType & A, MatrixType & B );
+
+protected:
+  ThreadedDenseLinearSolver();
+  virtual ~ThreadedDenseLinearSolver() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Factorize the panel starting at column k0, swapping rows of A and B. */
+  void FactorizePanel( MatrixType & A, MatrixType & B,
+    unsigned int k0, unsigned int kb );
+
+  /** Update the rows of the panel right of it, columns [j0, j1). */
+  void ThreadedUpdateRowsOfU( MatrixType & A,
+    unsigned int k0, unsigned int kb, unsigned int j0, unsigned int j1 );
+
+  /** Update the trailing submatrix, rows [i0, i1). */
+  void ThreadedUpdateTrailingMatrix( MatrixType & A,
+    unsigned int k0, unsigned int kb, unsigned int i0, unsigned int i1 );
+
+  /** Forward and backward substitution of B with the factors in A. */
+  void SubstituteRightHandSide( const MatrixType & A, MatrixType & B );
+
+private:
+  ThreadedDenseLinearSolver( const Self & ); // purposely not implemented
+  void operator=( const Self & );            // purposely not implemented
+
+  /** Struct and callback for the multithreader. */
+  struct SolverThreadStruct
+  {
+    Self *        Solver;
+    MatrixType *  Matrix;
+    unsigned int  PanelStart;
+    unsigned int  PanelSize;
+    bool          UpdateTrailingMatrix;
+  };
+  static ITK_THREAD_RETURN_TYPE SolverThreaderCallback( void * arg );
+
+  MultiThreader::Pointer  m_MultiThreader;
+  ThreadIdType            m_NumberOfThreads;
+  unsigned int            m_BlockSize;
+
+}; // end class ThreadedDenseLinearSolver
+
+} // end namespace itk
+
+#endif // end #ifndef __itkThreadedDenseLinearSolver_h_
@@ -16,7 +16,7 @@
 *
 *=========================================================================*/
 /** \file
- \brief This program converts between deformations (displacement fields) and transformations, and computes the magnitude or Jacobian of a deformation field.
+ \brief This program converts between deformations (displacement fields) and transformations, computes the magnitude, Jacobian or inverse of a deformation field, and composes deformation fields.
 
  \verbinclude deformationfieldoperator.help
  */
@@ -42,16 +42,26 @@ std::string GetHelpString( void )
     << "Usage:" << std::endl
     << "pxdeformationfieldoperator\n"
     << "This program converts between deformations (displacement fields)\n"
-    << "and transformations, and computes the magnitude or Jacobian of a\n"
-    << "deformation field.\n"
+    << "and transformations, computes the magnitude, Jacobian or inverse of a\n"
+    << "deformation field, and composes deformation fields.\n"
+    << "All operations are streamed.\n"
     << "  -in      inputFilename\n"
+    << "  [-in2]   second input filename, for COMPOSE: the output is the deformation\n"
+    << "           x -> in( x ) + in2( x + in( x ) ), on the grid of in\n"
     << "  [-out]   outputFilename; default: in + {operation}.mhd\n"
     << "  [-ops]   operation, choose one of {DEF2TRANS, TRANS2DEF,\n"
-    << "           MAGNITUDE, JACOBIAN, DEF2JAC, INVERSE}.\n"
+    << "           MAGNITUDE, JACOBIAN, DEF2JAC, INVERSE, COMPOSE}.\n"
     << "           default: MAGNITUDE\n"
     << "  [-s]     number of streams, default 1\n"
-    << "  [-it]    number of iterations, for the iterative inversion, default 1, increase to get better results\n"
-    << "  [-stop]  allowed error, default 0.0, increase to get faster convergence\n"
+    << "  [-it]    maximum number of iterations per voxel, for the inversion, default 20\n"
+    << "  [-stop]  allowed residual in physical units, default 0.0, increase to get faster convergence;\n"
+    << "           the convergence is only reported if it is larger than 0\n"
+    << "  [-levels] number of resolution levels of the inversion, default 1\n"
+    << "  [-init]  initial inverse, on any grid, to warm start the inversion\n"
+    << "  [-pad]   padding in voxels of the input pieces when streaming INVERSE,\n"
+    << "           or of the pieces of in2 when streaming COMPOSE;\n"
+    << "           should exceed the largest displacement. default: the whole input is read\n"
+    << "  [-threads] maximum number of threads, default all\n"
     << "Supported: 2D, 3D, vector of floats or doubles, number of components\n"
     << "must equal number of dimensions.";
   return ss.str();
@@ -86,6 +96,9 @@ int main( int argc, char **argv )
   std::string inputFileName = "";
   parser->GetCommandLineArgument( "-in", inputFileName );
 
+  std::string secondInputFileName = "";
+  parser->GetCommandLineArgument( "-in2", secondInputFileName );
+
   std::string ops = "MAGNITUDE";
   parser->GetCommandLineArgument( "-ops", ops );
 
@@ -105,12 +118,26 @@ int main( int argc, char **argv )
   parser->GetCommandLineArgument( "-s", numberOfStreams );
 
   /** Parameters for the inversion. */
-  unsigned int numberOfIterations = 1;
+  unsigned int numberOfIterations = 20;
   parser->GetCommandLineArgument( "-it", numberOfIterations );
 
   double stopValue = 0.0;
   parser->GetCommandLineArgument( "-stop", stopValue );
 
+  unsigned int numberOfLevels = 1;
+  parser->GetCommandLineArgument( "-levels", numberOfLevels );
+
+  std::string initialInverseFileName = "";
+  parser->GetCommandLineArgument( "-init", initialInverseFileName );
+
+  long inputPadding = -1;
+  parser->GetCommandLineArgument( "-pad", inputPadding );
+
+  /** Threads. */
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
   /** Determine image properties. */
   itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
@@ -156,6 +183,10 @@ int main( int argc, char **argv )
     filter->m_NumberOfStreams = numberOfStreams;
     filter->m_NumberOfIterations = numberOfIterations;
     filter->m_StopValue = stopValue;
+    filter->m_NumberOfLevels = numberOfLevels;
+    filter->m_InitialInverseFileName = initialInverseFileName;
+    filter->m_SecondInputFileName = secondInputFileName;
+    filter->m_InputPadding = inputPadding;
 
     filter->Run();
 
@@ -24,10 +24,11 @@
 #include "itkExceptionObject.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
-#include "itkImageRegionIteratorWithIndex.h"
 #include "itkDisplacementFieldJacobianDeterminantFilter.h"
 #include "itkGradientToMagnitudeImageFilter.h"
-#include "itkIterativeInverseDisplacementFieldImageFilter.h"
+#include "itkFixedPointInverseDisplacementFieldImageFilter.h"
+#include "itkDeformationToTransformationImageFilter.h"
+#include "itkThreadedComposeDisplacementFieldsImageFilter.h"
 
 
 /** \class ITKToolsDeformationFieldOperatorBase
@@ -43,22 +44,30 @@ public:
   ITKToolsDeformationFieldOperatorBase()
   {
     this->m_InputFileName = "";
+    this->m_InitialInverseFileName = "";
+    this->m_SecondInputFileName = "";
     this->m_OutputFileName = "";
     this->m_Ops = "";
     this->m_NumberOfStreams = 0;
     this->m_NumberOfIterations = 0;
     this->m_StopValue = 0.0f;
+    this->m_NumberOfLevels = 1;
+    this->m_InputPadding = -1;
   };
   /** Destructor. */
   ~ITKToolsDeformationFieldOperatorBase(){};
 
   /** Input member parameters. */
   std::string m_InputFileName;
+  std::string m_InitialInverseFileName;
+  std::string m_SecondInputFileName;
   std::string m_OutputFileName;
   std::string m_Ops;
   unsigned int m_NumberOfStreams;
   unsigned int m_NumberOfIterations;
   double m_StopValue;
+  unsigned int m_NumberOfLevels;
+  long m_InputPadding;
 
 }; // end class ITKToolsDeformationFieldOperatorBase
 
@@ -89,37 +98,22 @@ public:
   /** Run function. */
   void Run( void )
   {
-    typedef itk::ImageFileReader< VectorImageType >       ReaderType;
-
-    /** DECLARATION'S. */
-    typename VectorImageType::Pointer workingImage;
-    typename ReaderType::Pointer reader = ReaderType::New();
-
-    /** Read in the inputImage. */
-    reader->SetFileName( this->m_InputFileName.c_str() );
-    // temporarily: only streaming support for Jacobian case needed for EMPIRE10 challenge.
-    if( this->m_Ops != "DEF2JAC" && this->m_Ops != "JACOBIAN" )
-    {
-      reader->Update();
-    }
-
-    /** Change to Transformation or Deformation by adding/subtracting pixel coordinates */
-    workingImage = reader->GetOutput();
-
-    /** Do something with this image and save the result */
+    /** All operations read and write in pieces, so no Update() is
+     * called before the writer.
+     */
     if( this->m_Ops == "DEF2TRANS" )
     {
-      this->Deformation2Transformation( workingImage, true );
+      this->Deformation2Transformation( true );
     }
     else if( this->m_Ops == "TRANS2DEF" )
     {
-      this->Deformation2Transformation( workingImage, false );
+      this->Deformation2Transformation( false );
     }
     else if( this->m_Ops == "MAGNITUDE" )
     {
-      this->ComputeMagnitude( workingImage );
+      this->ComputeMagnitude();
     }
-    else if( this->m_Ops == "DEF2JAC" )
+    else if( this->m_Ops == "DEF2JAC" || this->m_Ops == "JACOBIAN" )
     {
       this->ComputeJacobian();
     }
@@ -127,6 +121,10 @@ public:
     {
       this->ComputeInverse();
     }
+    else if( this->m_Ops == "COMPOSE" )
+    {
+      this->ComputeComposition();
+    }
     else
     {
       itkGenericExceptionMacro( << "<< invalid operator: " << this->m_Ops );
@@ -134,10 +132,11 @@ public:
   } // end Run()
 
   /** Helper functions that implement the real functionality. */
-  void Deformation2Transformation( VectorImageType * inputImage, bool def2trans );
-  void ComputeMagnitude( VectorImageType * inputImage );
+  void Deformation2Transformation( bool def2trans );
+  void ComputeMagnitude( void );
   void ComputeJacobian( void );
   void ComputeInverse( void );
+  void ComputeComposition( void );
 
 }; // end class ITKToolsDeformationFieldOperator
 
@@ -151,47 +150,37 @@ public:
 template< unsigned int VDimension, class TComponentType >
 void
 ITKToolsDeformationFieldOperator< VDimension, TComponentType >
-::Deformation2Transformation( VectorImageType * inputImage, bool def2trans )
+::Deformation2Transformation( bool def2trans )
 {
-  typedef itk::ImageFileWriter< VectorImageType >     WriterType;
-  typedef itk::ImageRegionIteratorWithIndex<
-    VectorImageType >                                 IteratorType;
-  typedef typename VectorImageType::IndexType         IndexType;
-  typedef typename VectorImageType::PointType         PointType;
-
-  /** We are going to change the image, so make sure these changes are not undone */
-  inputImage->Update();
-  inputImage->DisconnectPipeline();
-
-  IteratorType it( inputImage, inputImage->GetLargestPossibleRegion() );
-  it.GoToBegin();
-  double plusormin = 1.0;
+  /** Typedef's. */
+  typedef itk::ImageFileReader< VectorImageType >       ReaderType;
+  typedef itk::DeformationToTransformationImageFilter<
+    VectorImageType, VectorImageType >                  ConvertFilterType;
+  typedef itk::ImageFileWriter< VectorImageType >       WriterType;
+
+  /** Setup reader. */
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( this->m_InputFileName.c_str() );
+
+  /** Setup the conversion. */
+  typename ConvertFilterType::Pointer convertFilter = ConvertFilterType::New();
+  convertFilter->SetInput( reader->GetOutput() );
+  convertFilter->SetDeformationToTransformation( def2trans );
+
   std::string message = "from deformation to transformation";
   if( !def2trans )
   {
-    plusormin = -1.0;
     message = "from transformation to deformation";
   }
   std::cout << "Changing image " << message << "..." << std::endl;
-  while ( !( it.IsAtEnd() ) )
-  {
-    const IndexType & index = it.GetIndex();
-    VectorPixelType & value = it.Value();
-    PointType point;
-    inputImage->TransformIndexToPhysicalPoint( index, point );
-    for( unsigned int i = 0; i < VDimension; ++i )
-    {
-      value[ i ] += static_cast<TComponentType>( plusormin * point[ i ] );
-    }
-    ++it;
-  }
-  std::cout << "Ready changing image " << message << "." << std::endl;
 
   /** Write the output image. */
   typename WriterType::Pointer writer = WriterType::New();
-  writer->SetInput( inputImage );
+  writer->SetInput( convertFilter->GetOutput() );
   writer->SetFileName( this->m_OutputFileName.c_str() );
+  writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
   writer->Update();
+  std::cout << "Ready changing image " << message << "." << std::endl;
 
 } // end Deformation2Transformation()
 
@@ -204,21 +193,24 @@ ITKToolsDeformationFieldOperator< VDimension, TComponentType >
 template< unsigned int VDimension, class TComponentType >
 void
 ITKToolsDeformationFieldOperator< VDimension, TComponentType >
-::ComputeMagnitude( VectorImageType * inputImage )
+::ComputeMagnitude( void )
 {
+  typedef itk::ImageFileReader< VectorImageType >     ReaderType;
   typedef itk::ImageFileWriter< ScalarImageType >     WriterType;
   typedef itk::GradientToMagnitudeImageFilter<
     VectorImageType, ScalarImageType >                MagnitudeFilterType;
 
+  typename ReaderType::Pointer reader = ReaderType::New();
   typename MagnitudeFilterType::Pointer magnitudeFilter = MagnitudeFilterType::New();
   typename WriterType::Pointer writer = WriterType::New();
 
-  magnitudeFilter->SetInput( inputImage );
-  magnitudeFilter->Update();
+  reader->SetFileName( this->m_InputFileName.c_str() );
+  magnitudeFilter->SetInput( reader->GetOutput() );
 
   /** Write the output image. */
   writer->SetInput( magnitudeFilter->GetOutput() );
   writer->SetFileName( this->m_OutputFileName.c_str() );
+  writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
   writer->Update();
 
 } // end ComputeMagnitude()
@@ -274,7 +266,7 @@ ITKToolsDeformationFieldOperator< VDimension, TComponentType >
   /** Typedef's. */
   typedef itk::ImageFileReader< VectorImageType >     ReaderType;
   typedef itk::ImageFileWriter< VectorImageType >     WriterType;
-  typedef itk::IterativeInverseDisplacementFieldImageFilter<
+  typedef itk::FixedPointInverseDisplacementFieldImageFilter<
     VectorImageType, VectorImageType >                InverseDeformationFilterType;
 
   /** Declare filters. */
@@ -290,6 +282,16 @@ ITKToolsDeformationFieldOperator< VDimension, TComponentType >
   inversionFilter->SetInput( reader->GetOutput() );
   inversionFilter->SetNumberOfIterations( this->m_NumberOfIterations );
   inversionFilter->SetStopValue( this->m_StopValue );
+  inversionFilter->SetNumberOfLevels( this->m_NumberOfLevels );
+  inversionFilter->SetInputPadding( this->m_InputPadding );
+
+  /** Warm start from an earlier, e.g. downsampled, inverse. */
+  typename ReaderType::Pointer initialReader = ReaderType::New();
+  if( this->m_InitialInverseFileName != "" )
+  {
+    initialReader->SetFileName( this->m_InitialInverseFileName.c_str() );
+    inversionFilter->SetInitialInverseField( initialReader->GetOutput() );
+  }
 
   /** Setup writer.  No intermediate calls to Update() are allowed,
    * otherwise streaming does not work.
@@ -299,7 +301,65 @@ ITKToolsDeformationFieldOperator< VDimension, TComponentType >
   writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
   writer->Update();
 
+  /** Report the residual, and the convergence if a tolerance was given;
+   * without one every voxel runs all iterations.
+   */
+  std::cout << "Residual of the inverse:\n"
+    << "  maximum:           " << inversionFilter->GetMaximumResidual() << "\n"
+    << "  mean:              " << inversionFilter->GetMeanResidual() << std::endl;
+  if( this->m_StopValue > 0.0 )
+  {
+    std::cout << "  mean iterations:   " << inversionFilter->GetMeanNumberOfIterations() << "\n"
+      << "  unconverged voxels: " << inversionFilter->GetNumberOfUnconvergedPixels()
+      << std::endl;
+  }
+
 } // end ComputeInverse()
 
 
+/**
+ * ******************* ComputeComposition ************************
+ * Compose the second deformation field after the first
+ */
+
+template< unsigned int VDimension, class TComponentType >
+void
+ITKToolsDeformationFieldOperator< VDimension, TComponentType >
+::ComputeComposition( void )
+{
+  /** Typedef's. */
+  typedef itk::ImageFileReader< VectorImageType >     ReaderType;
+  typedef itk::ImageFileWriter< VectorImageType >     WriterType;
+  typedef itk::ThreadedComposeDisplacementFieldsImageFilter<
+    VectorImageType, VectorImageType >                ComposeFilterType;
+
+  if( this->m_SecondInputFileName == "" )
+  {
+    itkGenericExceptionMacro( << "COMPOSE requires a second input field." );
+  }
+
+  /** Setup readers. */
+  typename ReaderType::Pointer innerReader = ReaderType::New();
+  innerReader->SetFileName( this->m_InputFileName.c_str() );
+  typename ReaderType::Pointer outerReader = ReaderType::New();
+  outerReader->SetFileName( this->m_SecondInputFileName.c_str() );
+
+  /** Setup composition filter. */
+  typename ComposeFilterType::Pointer composeFilter = ComposeFilterType::New();
+  composeFilter->SetInput( innerReader->GetOutput() );
+  composeFilter->SetOuterField( outerReader->GetOutput() );
+  composeFilter->SetOuterPadding( this->m_InputPadding );
+
+  /** Setup writer.  No intermediate calls to Update() are allowed,
+   * otherwise streaming does not work.
+   */
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( composeFilter->GetOutput() );
+  writer->SetFileName( this->m_OutputFileName.c_str() );
+  writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+  writer->Update();
+
+} // end ComputeComposition()
+
+
 #endif // end #ifndef __deformationfieldoperator_h_
@@ -0,0 +1,97 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkClampedLinearVectorInterpolation_h_
+#define __itkClampedLinearVectorInterpolation_h_
+
+#include "itkContinuousIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/** Linearly interpolates a vector image at a physical point.
+ *
+ * The point is clamped to the buffered region of the image, so that a
+ * displacement field is extended by its border values. The result is
+ * returned in double precision, in value[0] .. value[ImageDimension-1].
+ * Only the buffer and offset table are used, so it is cheap enough to be
+ * called per voxel from a threaded loop.
+ */
+
+template< class TImage, class TPoint >
+void ClampedLinearVectorInterpolation( const TImage * image,
+  const TPoint & point, double * value )
+{
+  const unsigned int Dimension = TImage::ImageDimension;
+
+  ContinuousIndex<double, TImage::ImageDimension> cindex;
+  image->TransformPhysicalPointToContinuousIndex( point, cindex );
+
+  /** Clamp to the buffered region, and find the corners and weights. */
+  const typename TImage::RegionType & region = image->GetBufferedRegion();
+  const OffsetValueType * offsetTable = image->GetOffsetTable();
+  OffsetValueType lower[ TImage::ImageDimension ];
+  OffsetValueType upper[ TImage::ImageDimension ];
+  double fraction[ TImage::ImageDimension ];
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    const double first = static_cast<double>( region.GetIndex()[ d ] );
+    const double last = first + static_cast<double>( region.GetSize()[ d ] ) - 1.0;
+    const double c = std::min( std::max( cindex[ d ], first ), last );
+    const double base = std::floor( c );
+    fraction[ d ] = c - base;
+    lower[ d ] = static_cast<OffsetValueType>( base - first );
+    upper[ d ] = std::min( lower[ d ] + 1,
+      static_cast<OffsetValueType>( region.GetSize()[ d ] ) - 1 );
+    lower[ d ] *= offsetTable[ d ];
+    upper[ d ] *= offsetTable[ d ];
+  }
+
+  std::fill( value, value + Dimension, 0.0 );
+  const typename TImage::PixelType * buffer = image->GetBufferPointer();
+  for( unsigned int corner = 0; corner < ( 1u << Dimension ); ++corner )
+  {
+    double weight = 1.0;
+    OffsetValueType offset = 0;
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        weight *= fraction[ d ];
+        offset += upper[ d ];
+      }
+      else
+      {
+        weight *= 1.0 - fraction[ d ];
+        offset += lower[ d ];
+      }
+    }
+    if( weight == 0.0 ) continue;
+    const typename TImage::PixelType & pixel = buffer[ offset ];
+    for( unsigned int k = 0; k < Dimension; ++k )
+    {
+      value[ k ] += weight * pixel[ k ];
+    }
+  }
+
+} // end ClampedLinearVectorInterpolation()
+
+} // end namespace itk
+
+#endif // end #ifndef __itkClampedLinearVectorInterpolation_h_
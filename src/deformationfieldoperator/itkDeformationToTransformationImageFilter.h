@@ -0,0 +1,94 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkDeformationToTransformationImageFilter_h_
+#define __itkDeformationToTransformationImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+
+namespace itk
+{
+
+/** \class DeformationToTransformationImageFilter
+ * \brief Converts a deformation (displacement) field to a transformation
+ * field, or vice versa, by adding or subtracting the physical coordinates
+ * of every voxel.
+ *
+ * Since every output voxel only depends on the same input voxel, the
+ * filter is multithreaded and supports streaming.
+ *
+ * \ingroup ImageToImageFilter Multithreaded
+ */
+
+template< class TInputImage, class TOutputImage >
+class DeformationToTransformationImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef DeformationToTransformationImageFilter            Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( DeformationToTransformationImageFilter, ImageToImageFilter );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputPixelType::ValueType         OutputValueType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+
+  /** Select the direction: true (the default) adds the coordinates, i.e.
+   * converts a deformation to a transformation, false subtracts them.
+   */
+  itkSetMacro( DeformationToTransformation, bool );
+  itkGetConstMacro( DeformationToTransformation, bool );
+  itkBooleanMacro( DeformationToTransformation );
+
+protected:
+  DeformationToTransformationImageFilter();
+  virtual ~DeformationToTransformationImageFilter() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Adds or subtracts the coordinates in a region. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+private:
+  DeformationToTransformationImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );                         // purposely not implemented
+
+  bool m_DeformationToTransformation;
+
+}; // end class DeformationToTransformationImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkDeformationToTransformationImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkDeformationToTransformationImageFilter_h_
@@ -0,0 +1,94 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkDeformationToTransformationImageFilter_txx_
+#define __itkDeformationToTransformationImageFilter_txx_
+
+#include "itkDeformationToTransformationImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+DeformationToTransformationImageFilter< TInputImage, TOutputImage >
+::DeformationToTransformationImageFilter()
+{
+  this->m_DeformationToTransformation = true;
+
+} // end Constructor()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+DeformationToTransformationImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+
+  ImageRegionConstIterator<InputImageType> inputIt( input, outputRegionForThread );
+  ImageRegionIteratorWithIndex<OutputImageType> outputIt( output, outputRegionForThread );
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  const double plusOrMinus = this->m_DeformationToTransformation ? 1.0 : -1.0;
+  typename OutputImageType::PointType point;
+  OutputPixelType value;
+  for( ; !outputIt.IsAtEnd(); ++inputIt, ++outputIt )
+  {
+    output->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
+    const typename InputImageType::PixelType & inputValue = inputIt.Value();
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      value[ i ] = static_cast<OutputValueType>( inputValue[ i ] + plusOrMinus * point[ i ] );
+    }
+    outputIt.Set( value );
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+DeformationToTransformationImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "DeformationToTransformation: " << this->m_DeformationToTransformation << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkDeformationToTransformationImageFilter_txx_
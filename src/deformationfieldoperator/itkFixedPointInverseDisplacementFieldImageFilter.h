@@ -0,0 +1,182 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkFixedPointInverseDisplacementFieldImageFilter_h_
+#define __itkFixedPointInverseDisplacementFieldImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+#include "itkTimeStamp.h"
+#include <vector>
+
+namespace itk
+{
+
+/** \class FixedPointInverseDisplacementFieldImageFilter
+ * \brief Computes the inverse of a displacement field by fixed point
+ * iteration, multithreaded.
+ *
+ * The inverse v of the displacement field u satisfies
+ * v( x ) = -u( x + v( x ) ), which is iterated for every voxel x:
+ * v_{k+1}( x ) = -u( x + v_k( x ) ), with u linearly interpolated and
+ * clamped at the border of the buffered input. Since the iteration of
+ * a voxel only depends on u, the voxels are independent: every voxel
+ * iterates until the residual |v_k( x ) + u( x + v_k( x ) )| is at most
+ * StopValue, or NumberOfIterations is reached.
+ *
+ * The iteration is warm started. With NumberOfLevels > 1 the inverse is
+ * first computed on grids that are coarser by a factor 2 per level, and
+ * every level starts from the interpolated solution of the coarser one.
+ * An initial inverse, e.g. a downsampled solution of an earlier run, can
+ * be given with SetInitialInverseField(); it may have any grid.
+ *
+ * The output has the grid of the input. The filter supports streaming:
+ * by default the whole input is requested, but if InputPadding is set
+ * to a nonnegative number of voxels, only the requested output region
+ * padded by that many voxels is requested. The padding should then
+ * exceed the largest displacement.
+ *
+ * After an update, the residual statistics of the finest level are
+ * available, accumulated over all pieces of a streamed update.
+ *
+ * \sa IterativeInverseDisplacementFieldImageFilter
+ * \ingroup ImageToImageFilter Multithreaded
+ */
+
+template< class TInputImage, class TOutputImage >
+class FixedPointInverseDisplacementFieldImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef FixedPointInverseDisplacementFieldImageFilter     Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FixedPointInverseDisplacementFieldImageFilter, ImageToImageFilter );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::Pointer           OutputImagePointer;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputPixelType::ValueType         OutputValueType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename OutputImageType::PointType         PointType;
+
+  /** Set the maximum number of iterations per voxel, default 20. */
+  itkSetMacro( NumberOfIterations, unsigned int );
+  itkGetConstMacro( NumberOfIterations, unsigned int );
+
+  /** Set the residual, in physical units, at which a voxel has converged. */
+  itkSetMacro( StopValue, double );
+  itkGetConstMacro( StopValue, double );
+
+  /** Set the number of resolution levels, default 1. */
+  itkSetClampMacro( NumberOfLevels, unsigned int, 1, 16 );
+  itkGetConstMacro( NumberOfLevels, unsigned int );
+
+  /** Set the padding of the input requested region in voxels;
+   * negative (the default) requests the whole input.
+   */
+  itkSetMacro( InputPadding, long );
+  itkGetConstMacro( InputPadding, long );
+
+  /** Set an initial estimate of the inverse, on any grid. */
+  void SetInitialInverseField( const OutputImageType * field );
+  const OutputImageType * GetInitialInverseField( void ) const;
+
+  /** Residual statistics of the finest level. */
+  itkGetConstMacro( MaximumResidual, double );
+  double GetMeanResidual( void ) const;
+  double GetMeanNumberOfIterations( void ) const;
+  itkGetConstMacro( NumberOfUnconvergedPixels, SizeValueType );
+
+protected:
+  FixedPointInverseDisplacementFieldImageFilter();
+  virtual ~FixedPointInverseDisplacementFieldImageFilter() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Requests the (padded) input region, and the whole initial inverse. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** The initial inverse may have another grid than the input. */
+  virtual void VerifyInputInformation( void ) {};
+
+  /** Solves the levels from coarse to fine. */
+  virtual void GenerateData( void );
+
+  /** Solve on all voxels of a grid, starting from the interpolated initial inverse. */
+  void SolveOnGrid( OutputImageType * grid, const OutputImageType * initial, bool finest );
+
+  /** Solve on the voxels of a part of a grid. */
+  void ThreadedSolveOnGrid( OutputImageType * grid, const OutputImageType * initial,
+    bool finest, const OutputImageRegionType & region, ThreadIdType threadId );
+
+private:
+  FixedPointInverseDisplacementFieldImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );                                // purposely not implemented
+
+  /** Struct and callback for the multithreader. */
+  struct InverseThreadStruct
+  {
+    Self *                    Filter;
+    OutputImageType *         Grid;
+    const OutputImageType *   Initial;
+    bool                      Finest;
+  };
+  static ITK_THREAD_RETURN_TYPE InverseThreaderCallback( void * arg );
+
+  /** Statistics, per thread and in total. */
+  struct ResidualStatistics
+  {
+    double          MaximumResidual;
+    double          ResidualSum;
+    SizeValueType   NumberOfPixels;
+    SizeValueType   NumberOfIterations;
+    SizeValueType   NumberOfUnconvergedPixels;
+  };
+
+  unsigned int      m_NumberOfIterations;
+  double            m_StopValue;
+  unsigned int      m_NumberOfLevels;
+  long              m_InputPadding;
+
+  std::vector<ResidualStatistics> m_ThreadStatistics;
+  double            m_MaximumResidual;
+  double            m_ResidualSum;
+  SizeValueType     m_NumberOfPixels;
+  SizeValueType     m_NumberOfIterationsSum;
+  SizeValueType     m_NumberOfUnconvergedPixels;
+  TimeStamp         m_StatisticsTime;
+
+}; // end class FixedPointInverseDisplacementFieldImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkFixedPointInverseDisplacementFieldImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkFixedPointInverseDisplacementFieldImageFilter_h_
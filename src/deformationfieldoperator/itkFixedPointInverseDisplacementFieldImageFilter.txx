@@ -0,0 +1,383 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkFixedPointInverseDisplacementFieldImageFilter_txx_
+#define __itkFixedPointInverseDisplacementFieldImageFilter_txx_
+
+#include "itkFixedPointInverseDisplacementFieldImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionSplitter.h"
+#include "itkClampedLinearVectorInterpolation.h"
+#include "itkProgressReporter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::FixedPointInverseDisplacementFieldImageFilter()
+{
+  this->m_NumberOfIterations = 20;
+  this->m_StopValue = 0.0;
+  this->m_NumberOfLevels = 1;
+  this->m_InputPadding = -1;
+
+  this->m_MaximumResidual = 0.0;
+  this->m_ResidualSum = 0.0;
+  this->m_NumberOfPixels = 0;
+  this->m_NumberOfIterationsSum = 0;
+  this->m_NumberOfUnconvergedPixels = 0;
+
+} // end Constructor()
+
+
+/**
+ * ******************* SetInitialInverseField *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::SetInitialInverseField( const OutputImageType * field )
+{
+  this->SetNthInput( 1, const_cast<OutputImageType *>( field ) );
+
+} // end SetInitialInverseField()
+
+
+/**
+ * ******************* GetInitialInverseField *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+const typename FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >::OutputImageType *
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::GetInitialInverseField( void ) const
+{
+  return static_cast<const OutputImageType *>( this->ProcessObject::GetInput( 1 ) );
+
+} // end GetInitialInverseField()
+
+
+/**
+ * ******************* GetMeanResidual *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+double
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::GetMeanResidual( void ) const
+{
+  if( this->m_NumberOfPixels == 0 ) return 0.0;
+  return this->m_ResidualSum / static_cast<double>( this->m_NumberOfPixels );
+
+} // end GetMeanResidual()
+
+
+/**
+ * ******************* GetMeanNumberOfIterations *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+double
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::GetMeanNumberOfIterations( void ) const
+{
+  if( this->m_NumberOfPixels == 0 ) return 0.0;
+  return static_cast<double>( this->m_NumberOfIterationsSum )
+    / static_cast<double>( this->m_NumberOfPixels );
+
+} // end GetMeanNumberOfIterations()
+
+
+/**
+ * ******************* GenerateInputRequestedRegion *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  /** The superclass is not called, since it would request the output
+   * region of the initial inverse, which has another grid.
+   */
+  InputImageType * input = const_cast<InputImageType *>( this->GetInput() );
+  if( input )
+  {
+    if( this->m_InputPadding < 0 )
+    {
+      input->SetRequestedRegionToLargestPossibleRegion();
+    }
+    else
+    {
+      typename InputImageType::RegionType region = this->GetOutput()->GetRequestedRegion();
+      region.PadByRadius( this->m_InputPadding );
+      region.Crop( input->GetLargestPossibleRegion() );
+      input->SetRequestedRegion( region );
+    }
+  }
+
+  OutputImageType * initial = const_cast<OutputImageType *>( this->GetInitialInverseField() );
+  if( initial )
+  {
+    initial->SetRequestedRegionToLargestPossibleRegion();
+  }
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * ******************* GenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::GenerateData( void )
+{
+  this->AllocateOutputs();
+
+  /** Accumulate the statistics over the pieces of a streamed update. */
+  if( this->m_StatisticsTime.GetMTime() < this->GetMTime() )
+  {
+    this->m_MaximumResidual = 0.0;
+    this->m_ResidualSum = 0.0;
+    this->m_NumberOfPixels = 0;
+    this->m_NumberOfIterationsSum = 0;
+    this->m_NumberOfUnconvergedPixels = 0;
+    this->m_StatisticsTime.Modified();
+  }
+
+  OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType region = output->GetRequestedRegion();
+
+  /** Solve on the coarse levels, each starting from the previous one. */
+  OutputImagePointer previous;
+  for( unsigned int level = this->m_NumberOfLevels - 1; level > 0; --level )
+  {
+    const unsigned int shrink = 1u << level;
+    typename OutputImageType::SpacingType spacing = output->GetSpacing();
+    typename OutputImageType::SizeType size;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      spacing[ d ] *= shrink;
+      size[ d ] = ( region.GetSize()[ d ] + shrink - 1 ) / shrink;
+    }
+    PointType origin;
+    output->TransformIndexToPhysicalPoint( region.GetIndex(), origin );
+
+    OutputImagePointer grid = OutputImageType::New();
+    grid->SetRegions( size );
+    grid->SetSpacing( spacing );
+    grid->SetOrigin( origin );
+    grid->SetDirection( output->GetDirection() );
+    grid->Allocate();
+
+    this->SolveOnGrid( grid,
+      previous.IsNotNull() ? previous.GetPointer() : this->GetInitialInverseField(), false );
+    previous = grid;
+  }
+
+  /** Solve on the output grid. */
+  this->SolveOnGrid( output,
+    previous.IsNotNull() ? previous.GetPointer() : this->GetInitialInverseField(), true );
+
+} // end GenerateData()
+
+
+/**
+ * ******************* SolveOnGrid *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::SolveOnGrid( OutputImageType * grid, const OutputImageType * initial, bool finest )
+{
+  InverseThreadStruct str;
+  str.Filter = this;
+  str.Grid = grid;
+  str.Initial = initial;
+  str.Finest = finest;
+
+  ResidualStatistics zero;
+  zero.MaximumResidual = 0.0;
+  zero.ResidualSum = 0.0;
+  zero.NumberOfPixels = 0;
+  zero.NumberOfIterations = 0;
+  zero.NumberOfUnconvergedPixels = 0;
+  this->m_ThreadStatistics.assign( this->GetNumberOfThreads(), zero );
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->InverseThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  if( !finest ) return;
+
+  for( unsigned int t = 0; t < this->m_ThreadStatistics.size(); ++t )
+  {
+    const ResidualStatistics & statistics = this->m_ThreadStatistics[ t ];
+    this->m_MaximumResidual = std::max( this->m_MaximumResidual, statistics.MaximumResidual );
+    this->m_ResidualSum += statistics.ResidualSum;
+    this->m_NumberOfPixels += statistics.NumberOfPixels;
+    this->m_NumberOfIterationsSum += statistics.NumberOfIterations;
+    this->m_NumberOfUnconvergedPixels += statistics.NumberOfUnconvergedPixels;
+  }
+
+} // end SolveOnGrid()
+
+
+/**
+ * ******************* InverseThreaderCallback *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::InverseThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  InverseThreadStruct * str = static_cast<InverseThreadStruct *>( info->UserData );
+
+  /** Split the grid, and let this thread process its part. */
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const OutputImageRegionType & gridRegion = str->Grid->GetBufferedRegion();
+  const unsigned int total = splitter->GetNumberOfSplits( gridRegion, threadCount );
+  if( threadId < total )
+  {
+    const OutputImageRegionType region = splitter->GetSplit( threadId, total, gridRegion );
+    str->Filter->ThreadedSolveOnGrid( str->Grid, str->Initial, str->Finest, region, threadId );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end InverseThreaderCallback()
+
+
+/**
+ * ******************* ThreadedSolveOnGrid *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::ThreadedSolveOnGrid( OutputImageType * grid, const OutputImageType * initial,
+  bool finest, const OutputImageRegionType & region, ThreadIdType threadId )
+{
+  const InputImageType * input = this->GetInput();
+  const unsigned int maximumIterations = std::max( this->m_NumberOfIterations, 1u );
+  ResidualStatistics & statistics = this->m_ThreadStatistics[ threadId ];
+
+  ProgressReporter progress( this, threadId, region.GetNumberOfPixels() );
+
+  ImageRegionIteratorWithIndex<OutputImageType> it( grid, region );
+  PointType x, q;
+  double v[ ImageDimension ];
+  double u[ ImageDimension ];
+  OutputPixelType value;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    grid->TransformIndexToPhysicalPoint( it.GetIndex(), x );
+    if( initial )
+    {
+      ClampedLinearVectorInterpolation( initial, x, v );
+    }
+    else
+    {
+      std::fill( v, v + ImageDimension, 0.0 );
+    }
+
+    /** v <- -u( x + v ); the residual is that of the previous iterate. */
+    double residual = 0.0;
+    unsigned int iterations = 0;
+    bool converged = false;
+    while( iterations < maximumIterations )
+    {
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        q[ d ] = x[ d ] + v[ d ];
+      }
+      ClampedLinearVectorInterpolation( input, q, u );
+
+      residual = 0.0;
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        const double difference = u[ d ] + v[ d ];
+        residual += difference * difference;
+        v[ d ] = -u[ d ];
+      }
+      residual = std::sqrt( residual );
+      ++iterations;
+      if( residual <= this->m_StopValue )
+      {
+        converged = true;
+        break;
+      }
+    }
+
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      value[ d ] = static_cast<OutputValueType>( v[ d ] );
+    }
+    it.Set( value );
+
+    statistics.MaximumResidual = std::max( statistics.MaximumResidual, residual );
+    statistics.ResidualSum += residual;
+    statistics.NumberOfPixels++;
+    statistics.NumberOfIterations += iterations;
+    if( !converged ) statistics.NumberOfUnconvergedPixels++;
+    if( finest ) progress.CompletedPixel();
+  }
+
+} // end ThreadedSolveOnGrid()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+FixedPointInverseDisplacementFieldImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfIterations: " << this->m_NumberOfIterations << std::endl;
+  os << indent << "StopValue: " << this->m_StopValue << std::endl;
+  os << indent << "NumberOfLevels: " << this->m_NumberOfLevels << std::endl;
+  os << indent << "InputPadding: " << this->m_InputPadding << std::endl;
+  os << indent << "MaximumResidual: " << this->m_MaximumResidual << std::endl;
+  os << indent << "MeanResidual: " << this->GetMeanResidual() << std::endl;
+  os << indent << "NumberOfUnconvergedPixels: " << this->m_NumberOfUnconvergedPixels << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkFixedPointInverseDisplacementFieldImageFilter_txx_
@@ -0,0 +1,112 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkThreadedComposeDisplacementFieldsImageFilter_h_
+#define __itkThreadedComposeDisplacementFieldsImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+
+namespace itk
+{
+
+/** \class ThreadedComposeDisplacementFieldsImageFilter
+ * \brief Composes two displacement fields, multithreaded and streaming.
+ *
+ * The input v is the inner field, the outer field u is set with
+ * SetOuterField(). The output is the displacement of the composed
+ * transformation x -> x + v( x ) + u( x + v( x ) ), on the grid of v:
+ * w( x ) = v( x ) + u( x + v( x ) ), with u linearly interpolated and
+ * clamped at its border. The outer field may have another grid.
+ *
+ * The output region is split over the threads. For the inner field only
+ * the requested output region is needed. By default the whole outer field
+ * is requested; if OuterPadding is set to a nonnegative number of voxels,
+ * only the bounding box of the requested output region on the grid of u,
+ * padded by that many voxels, is requested. The padding should then exceed
+ * the largest displacement of v, so that the fields can be streamed in
+ * slabs.
+ *
+ * \ingroup ImageToImageFilter Multithreaded
+ */
+
+template< class TInputImage, class TOutputImage >
+class ThreadedComposeDisplacementFieldsImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ThreadedComposeDisplacementFieldsImageFilter      Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ThreadedComposeDisplacementFieldsImageFilter, ImageToImageFilter );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputPixelType::ValueType         OutputValueType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+
+  /** Set the outer field u, which is applied after the input. */
+  void SetOuterField( const InputImageType * field );
+  const InputImageType * GetOuterField( void ) const;
+
+  /** Set the padding of the outer field requested region in voxels;
+   * negative (the default) requests the whole outer field.
+   */
+  itkSetMacro( OuterPadding, long );
+  itkGetConstMacro( OuterPadding, long );
+
+protected:
+  ThreadedComposeDisplacementFieldsImageFilter();
+  virtual ~ThreadedComposeDisplacementFieldsImageFilter() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Requests the output region of v, and the (padded) region of u. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** The outer field may have another grid than the input. */
+  virtual void VerifyInputInformation( void ) {};
+
+  /** Composes the fields in a region. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+private:
+  ThreadedComposeDisplacementFieldsImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );                               // purposely not implemented
+
+  long m_OuterPadding;
+
+}; // end class ThreadedComposeDisplacementFieldsImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkThreadedComposeDisplacementFieldsImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkThreadedComposeDisplacementFieldsImageFilter_h_
@@ -0,0 +1,200 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkThreadedComposeDisplacementFieldsImageFilter_txx_
+#define __itkThreadedComposeDisplacementFieldsImageFilter_txx_
+
+#include "itkThreadedComposeDisplacementFieldsImageFilter.h"
+#include "itkClampedLinearVectorInterpolation.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkProgressReporter.h"
+#include <cmath>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::ThreadedComposeDisplacementFieldsImageFilter()
+{
+  this->SetNumberOfRequiredInputs( 2 );
+  this->m_OuterPadding = -1;
+
+} // end Constructor()
+
+
+/**
+ * ******************* SetOuterField *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::SetOuterField( const InputImageType * field )
+{
+  this->SetNthInput( 1, const_cast<InputImageType *>( field ) );
+
+} // end SetOuterField()
+
+
+/**
+ * ******************* GetOuterField *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+const typename ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >::InputImageType *
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::GetOuterField( void ) const
+{
+  return static_cast<const InputImageType *>( this->ProcessObject::GetInput( 1 ) );
+
+} // end GetOuterField()
+
+
+/**
+ * ******************* GenerateInputRequestedRegion *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  /** The superclass requests the output region of both inputs. */
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * outer = const_cast<InputImageType *>( this->GetOuterField() );
+  if( !outer ) return;
+  const typename InputImageType::RegionType & largest = outer->GetLargestPossibleRegion();
+  if( this->m_OuterPadding < 0 )
+  {
+    outer->SetRequestedRegion( largest );
+    return;
+  }
+
+  /** Map the corners of the output region to the grid of u. */
+  const OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType & region = output->GetRequestedRegion();
+  typename InputImageType::IndexType lower;
+  typename InputImageType::IndexType upper;
+  lower.Fill( NumericTraits<IndexValueType>::max() );
+  upper.Fill( NumericTraits<IndexValueType>::NonpositiveMin() );
+  typename OutputImageType::PointType point;
+  ContinuousIndex<double, ImageDimension> cindex;
+  for( unsigned int corner = 0; corner < ( 1u << ImageDimension ); ++corner )
+  {
+    typename OutputImageType::IndexType index = region.GetIndex();
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        index[ d ] += static_cast<IndexValueType>( region.GetSize()[ d ] ) - 1;
+      }
+    }
+    output->TransformIndexToPhysicalPoint( index, point );
+    outer->TransformPhysicalPointToContinuousIndex( point, cindex );
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      lower[ d ] = std::min( lower[ d ],
+        static_cast<IndexValueType>( std::floor( cindex[ d ] ) ) - this->m_OuterPadding );
+      upper[ d ] = std::max( upper[ d ],
+        static_cast<IndexValueType>( std::ceil( cindex[ d ] ) ) + this->m_OuterPadding );
+    }
+  }
+
+  /** Crop to u; when the region falls outside u, the nearest border slab is
+   * requested, since u is clamped there anyway.
+   */
+  typename InputImageType::RegionType outerRegion;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    const IndexValueType first = largest.GetIndex()[ d ];
+    const IndexValueType last = first + static_cast<IndexValueType>( largest.GetSize()[ d ] ) - 1;
+    lower[ d ] = std::min( std::max( lower[ d ], first ), last );
+    upper[ d ] = std::min( std::max( upper[ d ], first ), last );
+    outerRegion.SetIndex( d, lower[ d ] );
+    outerRegion.SetSize( d, static_cast<SizeValueType>( upper[ d ] - lower[ d ] + 1 ) );
+  }
+  outer->SetRequestedRegion( outerRegion );
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+{
+  const InputImageType * inner = this->GetInput();
+  const InputImageType * outer = this->GetOuterField();
+  OutputImageType * output = this->GetOutput();
+
+  ImageRegionConstIterator<InputImageType> innerIt( inner, outputRegionForThread );
+  ImageRegionIteratorWithIndex<OutputImageType> outputIt( output, outputRegionForThread );
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  typename OutputImageType::PointType point;
+  double u[ ImageDimension ];
+  OutputPixelType value;
+  for( ; !outputIt.IsAtEnd(); ++innerIt, ++outputIt )
+  {
+    const typename InputImageType::PixelType & v = innerIt.Value();
+    output->TransformIndexToPhysicalPoint( outputIt.GetIndex(), point );
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      point[ d ] += v[ d ];
+    }
+    ClampedLinearVectorInterpolation( outer, point, u );
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      value[ d ] = static_cast<OutputValueType>( v[ d ] + u[ d ] );
+    }
+    outputIt.Set( value );
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ThreadedComposeDisplacementFieldsImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "OuterPadding: " << this->m_OuterPadding << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkThreadedComposeDisplacementFieldsImageFilter_txx_
@@ -42,14 +42,16 @@ std::string GetHelpString( void )
     << "pxdistancetransform\n"
     << "  -in      inputFilename: the input image (a binary mask\n"
     << "           threshold at 0 is performed if the image is not binary).\n"
-    << "  -out     outputFilename: the output of distance transform\n"
+    << "  -out     outputFilename: the output of distance transform;\n"
+    << "           for method OrderK three: the Voronoi map, the K distance map\n"
+    << "           and the K ID map\n"
     << "  [-s]     flag: if set, output squared distances instead of distances\n"
-    << "  [-m]     method, one of {Maurer, Danielsson, Morphological, MorphologicalSigned}, default Maurer\n"
+    << "  [-m]     method, one of {Maurer, Danielsson, Morphological, MorphologicalSigned, OrderK}, default Maurer\n"
+    << "  [-k]     for method OrderK: the number of closest objects, default 5;\n"
+    << "           the input then contains the object labels (> 0)\n"
     << "Note: voxel spacing is taken into account. Voxels inside the\n"
     << "object (=1) receive a negative distance.\n"
     << "Supported: 2D/3D. input: unsigned char, output: float";
-  //std::cout << "  [-m]     method, one of {Maurer, Danielsson, OrderK}, default Maurer\n";
-  //std::cout << "  [-K]     for method \"OrderK\", specify K, default 5\n";
   return ss.str();
 
 } // end GetHelpString()
@@ -101,9 +103,10 @@ int main( int argc, char **argv )
 
   /** Checks. */
   if( method != "Maurer" && method != "Danielsson"
-    && method != "Morphological" && method != "MorphologicalSigned" )
+    && method != "Morphological" && method != "MorphologicalSigned"
+    && method != "OrderK" )
   {
-    std::cerr << "ERROR: the method should be one of { Maurer, Danielsson, Morphological, MorphologicalSigned }!"
+    std::cerr << "ERROR: the method should be one of { Maurer, Danielsson, Morphological, MorphologicalSigned, OrderK }!"
       << std::endl;
     return EXIT_FAILURE;
   }
@@ -29,7 +29,7 @@
 #include "itkSignedDanielssonDistanceMapImageFilter.h"
 #include "itkMorphologicalSignedDistanceTransformImageFilter.h"
 #include "itkMorphologicalDistanceTransformImageFilter.h"
-//#include "itkOrderKDistanceTransformImageFilter.h"
+#include "itkOrderKDistanceTransformImageFilter.h"
 
 
 /*
@@ -64,12 +64,12 @@ void DistanceTransform(
     InputImageType, OutputImageType >               MorphologicalSignedDistanceType;
   typedef itk::MorphologicalDistanceTransformImageFilter<
     InputImageType, OutputImageType >               MorphologicalDistanceType;
-//   typedef itk::OrderKDistanceTransformImageFilter<
-//     FloatImageType, ULImageType >                   OrderKDistanceType;
-//
-//   typedef typename OrderKDistanceType::OutputImageType    VoronoiMapType;
-//   typedef typename OrderKDistanceType::KDistanceImageType KDistanceImageType;
-//   typedef typename OrderKDistanceType::KIDImageType       KIDImageType;
+  typedef itk::OrderKDistanceTransformImageFilter<
+    FloatImageType, ULImageType >                   OrderKDistanceType;
+
+  typedef typename OrderKDistanceType::OutputImageType    VoronoiMapType;
+  typedef typename OrderKDistanceType::KDistanceImageType KDistanceImageType;
+  typedef typename OrderKDistanceType::KIDImageType       KIDImageType;
 
   typedef typename InputImageType::Pointer          InputImagePointer;
   typedef typename OutputImageType::Pointer         OutputImagePointer;
@@ -77,9 +77,9 @@ void DistanceTransform(
   typedef itk::ImageFileReader< InputImageType >    ReaderType;
   typedef itk::ImageFileReader< FloatImageType >    FloatReaderType;
   typedef itk::ImageFileWriter< OutputImageType >   WriterType;
-//   typedef itk::ImageFileWriter< VoronoiMapType >    VoronoiWriterType;
-//   typedef itk::ImageFileWriter< KDistanceImageType > KDistanceWriterType;
-//   typedef itk::ImageFileWriter< KIDImageType >      KIDWriterType;
+  typedef itk::ImageFileWriter< VoronoiMapType >    VoronoiWriterType;
+  typedef itk::ImageFileWriter< KDistanceImageType > KDistanceWriterType;
+  typedef itk::ImageFileWriter< KIDImageType >      KIDWriterType;
 
   /** Read the input images */
   typename ReaderType::Pointer reader = ReaderType::New();
@@ -122,25 +122,18 @@ void DistanceTransform(
   distance_MorphologicalSigned->SetOutsideValue( 0 );
 
   /** Setup the OrderK distance transform filter. */
-//   typename OrderKDistanceType::Pointer distance_OrderK
-//     = OrderKDistanceType::New();
-//   distance_OrderK->SetInput( freader->GetOutput() );
-//   distance_OrderK->SetUseImageSpacing( true );
-//   distance_OrderK->SetInputIsBinary( false );
-//   distance_OrderK->SetSquaredDistance( outputSquaredDistance );
-//   distance_OrderK->SetK( K );
+  typename OrderKDistanceType::Pointer distance_OrderK
+    = OrderKDistanceType::New();
+  distance_OrderK->SetInput( freader->GetOutput() );
+  distance_OrderK->SetUseImageSpacing( true );
+  distance_OrderK->SetInputIsBinary( false );
+  distance_OrderK->SetSquaredDistance( outputSquaredDistance );
+  distance_OrderK->SetK( K );
 
   /** Setup writer. */
   typename WriterType::Pointer writer = WriterType::New();
   writer->SetFileName( outputFileNames[ 0 ].c_str() );
 
-//   typename VoronoiWriterType::Pointer voronoiWriter = VoronoiWriterType::New();
-//   typename KDistanceWriterType::Pointer kDistanceWriter = KDistanceWriterType::New();
-//   typename KIDWriterType::Pointer kIDWriter = KIDWriterType::New();
-//   voronoiWriter->SetFileName( outputFileNames[ 0 ].c_str() );
-//   kDistanceWriter->SetFileName( outputFileNames[ 1 ].c_str() );
-//   kIDWriter->SetFileName( outputFileNames[ 2 ].c_str() );
-
   /** Run! */
   if( method == "Maurer" )
   {
@@ -166,22 +159,25 @@ void DistanceTransform(
     writer->SetInput( distance_MorphologicalSigned->GetOutput() );
     writer->Update();
   }
-
-//   else if( method == "OrderK" )
-//   {
-//     std::cerr << "to here";
-//     freader->Update();
-//     std::cerr << "to here";
-//     distance_OrderK->Update();
-//     std::cerr << "to here";
-//     voronoiWriter->SetInput( distance_OrderK->GetVoronoiMap() );
-//     kDistanceWriter->SetInput( distance_OrderK->GetKDistanceMap() );
-//     kIDWriter->SetInput( distance_OrderK->GetKclosestIDMap() );
-//
-//     voronoiWriter->Update();
-//     kDistanceWriter->Update();
-//     kIDWriter->Update();
-//   }
+  else if( method == "OrderK" )
+  {
+    distance_OrderK->Update();
+
+    typename VoronoiWriterType::Pointer voronoiWriter = VoronoiWriterType::New();
+    typename KDistanceWriterType::Pointer kDistanceWriter = KDistanceWriterType::New();
+    typename KIDWriterType::Pointer kIDWriter = KIDWriterType::New();
+    voronoiWriter->SetFileName( outputFileNames[ 0 ].c_str() );
+    kDistanceWriter->SetFileName( outputFileNames[ 1 ].c_str() );
+    kIDWriter->SetFileName( outputFileNames[ 2 ].c_str() );
+
+    voronoiWriter->SetInput( distance_OrderK->GetVoronoiMap() );
+    kDistanceWriter->SetInput( distance_OrderK->GetKDistanceMap() );
+    kIDWriter->SetInput( distance_OrderK->GetKclosestIDMap() );
+
+    voronoiWriter->Update();
+    kDistanceWriter->Update();
+    kIDWriter->Update();
+  }
 
 } // end DistanceTransform()
 
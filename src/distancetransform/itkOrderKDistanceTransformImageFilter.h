@@ -11,63 +11,50 @@ reference: following an approach described in:
 #define __itkOrderKDistanceTransformImageFilter_h
 
 #include "itkImageToImageFilter.h"
-#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
 
 #include "itkImage.h"
 #include "itkVectorImage.h"
 
+#include <vector>
+
 namespace itk
 {
 
-/** \struct SortingElement
- *
- *  This struct is used to insert the identifiers into a sorted list (increasing distance).
- */
-template<class T1, class T2=unsigned int>
-struct SortingElement  {
-    T1 element;
-    T2 index;
-    bool operator<(const SortingElement v) const {
-      return element<v.element;
-    }
-    bool operator==(const SortingElement v) const {
-      return (element==v.element && index==v.index);
-    }
-    void operator=(SortingElement v) {
-      element = v.element;
-      index = v.index;
-    }
-};
-
-
-
 /** \class OrderKDistanceTransformImageFilter
 *
 * This class is parametrized over the type of the input image
 * and the type of the output image.
 *
-* This filter computes the distance map of the input image
-* as an approximation with pixel accuracy to the Euclidean distance.
+* This filter computes for every pixel the exact Euclidean distances to,
+* and the IDs of, the K closest objects in the input image.
 *
-* The input is assumed to contain numeric codes defining objects.
-* The filter will produce as output the following images:
+* If InputIsBinary is set, each nonzero pixel of the input is an object
+* with a unique ID, numbered 1, 2, ... in the order of the pixels in the
+* buffer. Otherwise the input is assumed to contain numeric codes (> 0)
+* defining objects, and the K closest distinct objects are computed,
+* i.e. the closest, second closest, etc. structure.
 *
-* - A voronoi partition using the same numeric codes as the input.
-* - A distance map with the approximation to the euclidean distance.
-*   from a particular pixel to the nearest object to this pixel
-*   in the input image.
-* - A vector map containing the component of the vector relating
-*   the current pixel with the closest point of the closest object
-*   to this pixel. Given that the components of the distance are
-*   computed in "pixels", the vector is represented by an
-*   itk::Offset.  That is, physical coordinates are not used.
+* The filter will produce as output the following images:
 *
-* This filter is N-dimensional and known to be efficient
-* in computational time.  The algorithm is the N-dimensional version
-* of the 4SED algorithm given for two dimensions in:
+* - A VectorImage with the distances to the K closest objects, in
+*   increasing order. Entries for which no object exists are set to
+*   twice the size of the image.
+* - A VectorImage with the IDs of the K closest objects, or -1.
+* - A Voronoi partition: a labeling of the connected regions in which
+*   the list of the K closest objects is constant (the order K Voronoi
+*   cells), computed with ConnectedComponentVectorImageFilter.
 *
-* Danielsson, Per-Erik.  Euclidean Distance Mapping.  Computer
-* Graphics and Image Processing 14, 227-248 (1980).
+* The distance transform is separable: the K closest objects of a pixel
+* in an n-dimensional slice are among the K closest objects within the
+* (n-1)-dimensional slices of the pixels on the line through it, since
+* the squared distance adds over the dimensions. So the filter makes
+* one pass per dimension, in which each line of the image is processed
+* independently; the lines are divided over the threads. For each pixel
+* the candidates on the line are visited outward from the pixel, and the
+* search stops as soon as the distance along the line alone exceeds the
+* current K-th distance. The K distances and IDs of a pixel are stored
+* interleaved in one buffer.
 *
 * \ingroup ImageFeatureExtraction
 *
@@ -208,33 +195,58 @@ public:
    * considered). **/
   KDistanceImageType * GetKDistanceMap( void );
 
-  /** Get VectorImage<int, Dimension> of IDs of k closest
-   *  pixels (use together with m_IndexLookUpTable). */
+  /** Get VectorImage<int, Dimension> of IDs of k closest objects. */
   KIDImageType *       GetKclosestIDMap( void );
 
-  /** inserts a new found closest object pixel in ascending order of distance */
-  bool InsertSorted( KDistanceValueType dist, KIDValueType index, KDistancePixelType& distances, KIDPixelType& indices);
-
 
 protected:
   OrderKDistanceTransformImageFilter();
   virtual ~OrderKDistanceTransformImageFilter() {};
   void PrintSelf(std::ostream& os, Indent indent) const;
 
-  /** Compute Danielsson distance map and Voronoi Map. */
+  /** Compute the K distance map, the K ID map and the Voronoi Map. */
   void GenerateData();
 
+  /** The whole input is needed, and the whole output is produced. */
   void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * output );
 
-  /** Prepare data. */
+  /** Prepare data: allocate the outputs and initialize the K nearest buffer. */
   void PrepareData();
 
+  /** Copy the K nearest buffer to the K distance and K ID maps. */
+  void CopyKNearestToOutputs();
+
   /**  Compute Voronoi Map. */
   void ComputeVoronoiMap();
 
-  /** Update distance map locally.  Used by GenerateData(). */
-  void UpdateLocalDistance(const IndexType&,
-                           const OffsetType&);
+  /** One entry of the list of K closest objects of a pixel. A negative ID
+   * marks an empty entry, which has the maximum distance.
+   */
+  struct KNearestEntry
+  {
+    KDistanceValueType  Distance;
+    KIDValueType        ID;
+  };
+
+  /** Process the lines along dimension dim that belong to this thread. */
+  void ThreadedPass( unsigned int dim, ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** Merge the list of a pixel on the line, shifted by add, into the list out. */
+  void MergeCandidates( const KNearestEntry * candidates, double add, KNearestEntry * out ) const;
+
+  /** Insert an object in the sorted list out. If the ID is already in the
+   * list, only the smallest distance is kept.
+   */
+  void InsertNearest( KNearestEntry * out, KDistanceValueType distance, KIDValueType id ) const;
+
+  /** Static thread callback of the passes. */
+  struct OrderKThreadStruct
+  {
+    Self *        Filter;
+    unsigned int  Dimension;
+  };
+  static ITK_THREAD_RETURN_TYPE OrderKThreaderCallback( void * arg );
 
 
 
@@ -249,11 +261,11 @@ private:
 
   unsigned int    m_K;
 
-  /** should the constructor or other method reserve memory for m_IndexLookUpTable? */
-  std::vector<IndexType> m_IndexLookUpTable;
+  /** The K closest objects of all pixels, interleaved, in buffer order. */
+  std::vector<KNearestEntry> m_KNearest;
 
-  KDistanceImagePointer m_KDistanceImage;
-  KIDImagePointer             m_KIDImage;
+  /** The distance used for empty entries in the K distance map. */
+  double                m_EmptyDistance;
 
 
 }; // end of OrderKDistanceTransformImageFilter class
@@ -10,11 +10,11 @@ reference: following an approach described in:
 #ifndef _itkOrderKDistanceTransformImageFilter_txx
 #define _itkOrderKDistanceTransformImageFilter_txx
 
-#include <iostream>
-
 #include "itkOrderKDistanceTransformImageFilter.h"
-#include "itkReflectiveImageRegionConstIterator.h"
-#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+
+#include <algorithm>
+#include <cmath>
 
 /** This class is needed to compute the voronoi diagram */
 #include "itkConnectedComponentVectorImageFilter.h"
@@ -41,6 +41,7 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
   this->m_UseImageSpacing     = true; // this also
   this->m_FullyConnected    = true;  /// should this be true or false?
   this->m_K                   = 5;
+  this->m_EmptyDistance       = 0.0;
 
   this->SetNumberOfRequiredOutputs( 3 );
 
@@ -54,8 +55,6 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
 
   OutputImagePointer voronoiMap = OutputImageType::New();
   this->SetNthOutput( 2, voronoiMap.GetPointer() );
-
-//  this->m_IndexLookUpTable.reserve(1000);
 }
 
 /**
@@ -135,156 +134,117 @@ void
 OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
 ::PrepareData( void )
 {
-
   itkDebugMacro(<< "PrepareData Start");
 
-  InputImagePointer  inputImage  =
-    dynamic_cast<const TInputImage  *>( ProcessObject::GetInput(0) );
-
+  if( this->m_K == 0 )
+    {
+    itkExceptionMacro(<< "K should be at least 1.");
+    }
 
-  typename OutputImageType::RegionType region  = inputImage->GetLargestPossibleRegion() ;
+  InputImagePointer  inputImage  = this->GetInput();
+  const RegionType region = inputImage->GetLargestPossibleRegion();
 
-  // find the largest of the image dimensions
-  //
-  // This should include the image spacing!!!! (in DanielssonDM also!)
-  //
-  typename TInputImage::SizeType size = region.GetSize();
-  typename TInputImage::SpacingType spacing = inputImage->GetSpacing();
+  // the distance for empty entries: twice the largest image dimension
+  const typename TInputImage::SizeType size = region.GetSize();
+  const typename TInputImage::SpacingType spacing = inputImage->GetSpacing();
   double maxLength = 0;
-  if( this->m_InputIsBinary)
+  for( unsigned int dim=0; dim < TInputImage::ImageDimension; dim++)
     {
-    for( unsigned int dim=0; dim < TInputImage::ImageDimension; dim++)
+    double length = static_cast<double>( size[ dim ] );
+    if( this->m_UseImageSpacing )
       {
-      if( maxLength < size[ dim ] )
-        {
-        maxLength = size[ dim ];
-        }
+      length *= spacing[ dim ];
       }
-    }
-  else
-    {
-    for( unsigned int dim=0; dim < TInputImage::ImageDimension; dim++)
+    if( maxLength < length )
       {
-      if( maxLength < size[ dim ]*spacing[dim] )
-        {
-        maxLength = size[ dim ]*spacing[dim];
-        }
+      maxLength = length;
       }
     }
+  this->m_EmptyDistance = 2 * maxLength;
+  if( this->m_SquaredDistance )
+    {
+    this->m_EmptyDistance *= this->m_EmptyDistance;
+    }
 
+  itkDebugMacro(<< "allocating memory for the K Distance and K ID Images");
 
-
-  itkDebugMacro(<< "allocating memory for K Distance Image");
-
-  // prepare the k-distance image, all distances are set to infinity = 2*maxLength
-  KDistanceImagePointer kdistanceImage = GetKDistanceMap();
-
-  kdistanceImage->SetLargestPossibleRegion(
-    inputImage->GetLargestPossibleRegion() );
-
-  kdistanceImage->SetBufferedRegion(
-    inputImage->GetBufferedRegion() );
-
-  kdistanceImage->SetRequestedRegion(
-    inputImage->GetRequestedRegion() );
-
+  KDistanceImagePointer kdistanceImage = this->GetKDistanceMap();
+  kdistanceImage->SetVectorLength( this->m_K );
+  kdistanceImage->SetBufferedRegion( kdistanceImage->GetRequestedRegion() );
   kdistanceImage->Allocate();
 
-
-
-  itkDebugMacro(<< "allocating memory for K ID Image");
-  // prepare the k-distance image, all distances are set to infinity = 2*maxLength
-  KIDImagePointer kidImage = GetKclosestIDMap();
-
-  kidImage->SetLargestPossibleRegion(
-    inputImage->GetLargestPossibleRegion() );
-
-  kidImage->SetBufferedRegion(
-    inputImage->GetBufferedRegion() );
-
-  kidImage->SetRequestedRegion(
-    inputImage->GetRequestedRegion() );
-
+  KIDImagePointer kidImage = this->GetKclosestIDMap();
+  kidImage->SetVectorLength( this->m_K );
+  kidImage->SetBufferedRegion( kidImage->GetRequestedRegion() );
   kidImage->Allocate();
 
+  itkDebugMacro(<< "PrepareData: initialize the K nearest buffer");
 
+  // object pixels have themselves as closest object, all other entries are empty
+  KNearestEntry empty;
+  empty.Distance = NumericTraits<KDistanceValueType>::max();
+  empty.ID = -1;
+  const unsigned int K = this->m_K;
+  this->m_KNearest.assign( region.GetNumberOfPixels() * K, empty );
 
-
-  itkDebugMacro(<< "PrepareData: initialize the k-distance map  and  k-id map");
-
-  ImageRegionConstIteratorWithIndex< TInputImage >  it( inputImage,  region );
-
-  typename KIDImageType::PixelType idObject( this->m_K );
-  typename KIDImageType::PixelType idBackground( this->m_K );
-  idObject.Fill(-1);
-  idBackground.Fill(-1);
-
-  typename KDistanceImageType::PixelType distanceObect( this->m_K );
-  typename KDistanceImageType::PixelType distanceBackground( this->m_K );
-  distanceObect.Fill(2*maxLength);
-  distanceObect[0] = 0;
-  distanceBackground.Fill(2*maxLength);
-
+  ImageRegionConstIterator< TInputImage >  it( inputImage,  region );
   it.GoToBegin();
-  int npt = 1;
-  if( this->m_InputIsBinary)
-  {
-    while( !it.IsAtEnd() )
+  KIDValueType npt = 1;
+  for( SizeValueType i = 0; !it.IsAtEnd(); ++it, i += K )
+    {
+    if( it.Get() > NumericTraits<typename InputImageType::PixelType>::Zero )
       {
-      IndexType index = it.GetIndex();
-      if( it.Get() )
+      this->m_KNearest[ i ].Distance = NumericTraits<KDistanceValueType>::Zero;
+      if( this->m_InputIsBinary )
         {
-        kdistanceImage->SetPixel(index, distanceObect);
-        idObject[0] = npt++;
-        kidImage->SetPixel(index, idObject);
-        this->m_IndexLookUpTable.push_back(index);
+        this->m_KNearest[ i ].ID = npt++;
         }
       else
         {
-        kdistanceImage->SetPixel(index, distanceBackground);
-        kidImage->SetPixel(index, idBackground);
+        this->m_KNearest[ i ].ID = static_cast<KIDValueType>( it.Get() );
         }
-      ++it;
       }
     }
-  else // Input is not binary
-    {
-    typedef SortingElement<typename InputImageType::PixelType,
-                                                  typename InputImageType::IndexType>  Element;
-    std::vector<Element> indices;
 
-    while( !it.IsAtEnd() )
+  itkDebugMacro(<< "PrepareData End");
+}
+
+
+/**
+ *  Copy the K nearest buffer to the outputs
+ */
+template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
+void
+OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
+::CopyKNearestToOutputs( void )
+{
+  typename KDistanceImageType::InternalPixelType * distances
+    = this->GetKDistanceMap()->GetBufferPointer();
+  typename KIDImageType::InternalPixelType * ids
+    = this->GetKclosestIDMap()->GetBufferPointer();
+
+  const SizeValueType numberOfEntries = this->m_KNearest.size();
+  for( SizeValueType i = 0; i < numberOfEntries; ++i )
+    {
+    const KNearestEntry & entry = this->m_KNearest[ i ];
+    double distance = this->m_EmptyDistance;
+    if( entry.ID >= 0 )
       {
-      IndexType index = it.GetIndex();
-      if( it.Get()>0 )
-        {
-        kdistanceImage->SetPixel(index, distanceObect);
-        idObject[0] = static_cast< typename KIDPixelType::ValueType >( it.Get() );
-        kidImage->SetPixel(index, idObject);
-        Element  el;
-        el.element = it.Get();
-        el.index = index;
-        indices.push_back( el );
-        }
-      else
+      distance = entry.Distance;
+      if( !this->m_SquaredDistance )
         {
-        kdistanceImage->SetPixel(index, distanceBackground);
-        kidImage->SetPixel(index, idBackground);
+        distance = std::sqrt( distance );
         }
-      ++it;
       }
-     std::sort( indices.begin(), indices.end() );
-     for( unsigned int kk=0; kk<indices.size(); kk++)    {
-        this->m_IndexLookUpTable.push_back( indices[kk].index );
-        }
-    } // End If: Input is binary
+    distances[ i ] = static_cast<typename KDistanceImageType::InternalPixelType>( distance );
+    ids[ i ] = static_cast<typename KIDImageType::InternalPixelType>( entry.ID );
+    }
 
-  itkDebugMacro(<< "PrepareData End");
+  // release the buffer
+  std::vector<KNearestEntry>().swap( this->m_KNearest );
 }
 
 
-
-
 /**
  *  Post processing for computing the Voronoi Map
  */
@@ -298,6 +258,7 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
   typedef typename itk::ConnectedComponentVectorImageFilter<KIDImageType, OutputImageType> ConnectedComponentFilterType;
   typename ConnectedComponentFilterType::Pointer connectedCompFilter = ConnectedComponentFilterType::New();
   connectedCompFilter->SetInput( this->GetKclosestIDMap() );
+  connectedCompFilter->SetFullyConnected( this->m_FullyConnected );
 
   connectedCompFilter->UpdateLargestPossibleRegion();
 
@@ -305,208 +266,200 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
 }
 
 
-
-
-
 /**
- *  Locally update the distance.
+ *  Insert an object in a sorted list of K closest objects
  */
 template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
 void
 OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
-::UpdateLocalDistance(const IndexType& here,
-                      const OffsetType& offset)
+::InsertNearest( KNearestEntry * out, KDistanceValueType distance, KIDValueType id ) const
 {
+  const unsigned int K = this->m_K;
 
-  IndexType  there            = here + offset;
-  typename KDistanceImageType::PixelType kd = this->m_KDistanceImage->GetPixel(here);
-  typename KIDImageType::PixelType       kid_here = this->m_KIDImage->GetPixel(here);
-  typename KIDImageType::PixelType       kid_there = this->m_KIDImage->GetPixel(there);
-
-  for( unsigned int j=0; j<m_K; j++)
+  // an object may reach the line through several pixels: keep the closest
+  unsigned int k = 0;
+  while( k < K && out[ k ].ID != id )
+    {
+    ++k;
+    }
+  if( k < K )
     {
-    // instead of this (using distance components), use ID image and this->m_IndexLookUpTable
-    if(kid_there[j]>-1)
+    if( distance >= out[ k ].Distance )
       {
-      IndexType objectIndex = this->m_IndexLookUpTable[kid_there[j]-1];
-      OffsetType offsetToObject = objectIndex - here;
-
-      typename InputImageType::SpacingType spacing = Self::GetInput()->GetSpacing();
-
-      double sqdist = 0.0;
-      for( unsigned int i=0; i<InputImageDimension; i++ )
-        {
-        double v1 = static_cast< double >(  offsetToObject[ i ]  );
-
-        if( this->m_UseImageSpacing)
-          {
-          double spacingComponent = static_cast< double >(spacing[ i ]);
-          v1 *= spacingComponent;
-          }
-
-        sqdist +=  v1 * v1;
-        }
-
-      if( !m_SquaredDistance ) {
-        InsertSorted(std::sqrt(sqdist), kid_there[j], kd, kid_here );
-        }
-      else {
-        InsertSorted(sqdist, kid_there[j], kd, kid_here );
-        }
+      return;
       }
+    for( ; k + 1 < K; ++k )
+      {
+      out[ k ] = out[ k + 1 ];
+      }
+    out[ K - 1 ].Distance = NumericTraits<KDistanceValueType>::max();
+    out[ K - 1 ].ID = -1;
+    }
+  else if( distance >= out[ K - 1 ].Distance )
+    {
+    return;
     }
 
+  // insertion from the back, dropping the last entry
+  k = K - 1;
+  while( k > 0 && out[ k - 1 ].Distance > distance )
+    {
+    out[ k ] = out[ k - 1 ];
+    --k;
+    }
+  out[ k ].Distance = distance;
+  out[ k ].ID = id;
 }
 
 
-
 /**
- *  Add element (distance and index) to list of nearest neighbors.
- *  Inserts so distances are sorted.
+ *  Merge the list of a pixel on the line into the list of the current pixel
  */
 template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
-bool
+void
 OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
-::InsertSorted( KDistanceValueType dist, KIDValueType index, KDistancePixelType& distances, KIDPixelType& indices)
+::MergeCandidates( const KNearestEntry * candidates, double add, KNearestEntry * out ) const
 {
+  const unsigned int K = this->m_K;
 
-  // Test if distance is larger than largest distance
-  if(dist >= distances[distances.GetSize()-1])
-    return false; // did not insert an element
-
-
-  // Test if id is already in list, must replace it and re-sort the list.
-  bool isalreadyinlist = false;
-  int posinlist;
-  for( unsigned int k=0; k<m_K; k++)
-  {
-    if(index==indices[k])
+  // the candidates are sorted, so stop at the first one that is too far
+  for( unsigned int k = 0; k < K; ++k )
+    {
+    if( candidates[ k ].ID < 0 )
       {
-      // Test if the distance is actually smaller, if not do not add to list
-      if(dist<distances[k])
-        {
-        isalreadyinlist = true;
-        posinlist = k;
-        break;
-      }
-      else
-        {
-        return false;
-        }
-      }
-  }
-
-  if(isalreadyinlist)
-  {
-    std::cout << "ID is already in list. This is an incorrect behaviour." <<std::endl;
-    exit(1);
-  }
-  else
-  {
-    int insertpos = distances.GetSize();
-    for (int i=0; i<distances.GetSize(); i++ ) {
-      if(dist < distances[ i ]) {
-        insertpos = i;
-        break;
+      return;
       }
-    }
-    if(insertpos<distances.GetSize()) {
-      for( unsigned int k = distances.GetSize()-1; k>insertpos; k--) {
-        distances[k] = distances[k-1];
-        indices[k] = indices[k-1];
+    const double distance = candidates[ k ].Distance + add;
+    if( distance >= out[ K - 1 ].Distance )
+      {
+      return;
       }
-      distances[insertpos] = dist;
-      indices[insertpos] = index;
+    this->InsertNearest( out, static_cast<KDistanceValueType>( distance ), candidates[ k ].ID );
     }
-  }
-  return true; // did insert an element
 }
 
 
 /**
- *  Compute Distance and Voronoi maps
+ *  Process the lines along one dimension
  */
 template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
 void
 OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
-::GenerateData()
+::ThreadedPass( unsigned int dim, ThreadIdType threadId, ThreadIdType numberOfThreads )
 {
+  const RegionType region = this->GetInput()->GetLargestPossibleRegion();
+  const SizeType size = region.GetSize();
+  const unsigned int K = this->m_K;
 
-  std::cerr << "to here inside 1";
-  this->PrepareData();
-
-  // Specify images and regions.
+  // the lines along dim, divided in contiguous chunks over the threads
+  SizeValueType stride = 1;
+  for( unsigned int d = 0; d < dim; ++d )
+    {
+    stride *= size[ d ];
+    }
+  const SizeValueType length = size[ dim ];
+  const SizeValueType numberOfLines = region.GetNumberOfPixels() / length;
+  const SizeValueType firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType lastLine = numberOfLines * ( threadId + 1 ) / numberOfThreads;
 
-  InputImagePointer    inputimage             =  this->GetInput();
+  double spacing2 = 1.0;
+  if( this->m_UseImageSpacing )
+    {
+    spacing2 = this->GetInput()->GetSpacing()[ dim ];
+    spacing2 *= spacing2;
+    }
 
-  this->m_KDistanceImage    =  this->GetKDistanceMap();
-  this->m_KIDImage          =  this->GetKclosestIDMap();
+  KNearestEntry empty;
+  empty.Distance = NumericTraits<KDistanceValueType>::max();
+  empty.ID = -1;
 
-  std::cerr << "to here inside 2";
+  std::vector<KNearestEntry> line( length * K );
+  KNearestEntry * buffer = &this->m_KNearest[ 0 ];
+  for( SizeValueType l = firstLine; l < lastLine; ++l )
+    {
+    const SizeValueType start = ( l % stride ) + ( l / stride ) * stride * length;
 
-  typename InputImageType::RegionType region  = inputimage->GetLargestPossibleRegion();
+    // copy the line, since the results are written in place
+    for( SizeValueType x = 0; x < length; ++x )
+      {
+      const KNearestEntry * in = buffer + ( start + x * stride ) * K;
+      std::copy( in, in + K, &line[ x * K ] );
+      }
 
-  itkDebugMacro (<< "Region to process: " << region);
+    for( SizeValueType x = 0; x < length; ++x )
+      {
+      KNearestEntry * out = buffer + ( start + x * stride ) * K;
+      std::fill( out, out + K, empty );
 
-  // Instantiate reflective iterator
+      // visit the pixels on the line outward from x
+      for( SizeValueType r = 0; r < length; ++r )
+        {
+        const double add = static_cast<double>( r * r ) * spacing2;
+        if( add >= out[ K - 1 ].Distance )
+          {
+          break;
+          }
+        if( r <= x )
+          {
+          this->MergeCandidates( &line[ ( x - r ) * K ], add, out );
+          }
+        if( r > 0 && x + r < length )
+          {
+          this->MergeCandidates( &line[ ( x + r ) * K ], add, out );
+          }
+        }
+      }
+    }
+}
 
-  ReflectiveImageRegionConstIterator< const InputImageType >
-    it( inputimage, region );
-  it.FillOffsets(1); // what exactly is happening here?
 
-  it.GoToBegin();
+/**
+ *  Thread callback
+ */
+template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
+ITK_THREAD_RETURN_TYPE
+OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
+::OrderKThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  OrderKThreadStruct * str = static_cast<OrderKThreadStruct *>( info->UserData );
 
-  // Support progress methods/callbacks.
+  str->Filter->ThreadedPass( str->Dimension, info->ThreadID, info->NumberOfThreads );
 
-  // Each pixel is visited 2^InputImageDimension times, and the number
-  // of visits per pixel needs to be computed for progress reporting.
-  unsigned long visitsPerPixel = (1 << InputImageDimension);
-  unsigned long updateVisits, i=0;
-  updateVisits = region.GetNumberOfPixels() * visitsPerPixel / 10;
-  if( updateVisits < 1 )
-    {
-    updateVisits = 1;
-    }
-  const float updatePeriod = static_cast<float>(updateVisits) * 10.0;
+  return ITK_THREAD_RETURN_VALUE;
+}
 
-  // Process image.
 
-  OffsetType  offset;
-  offset.Fill( 0 );
+/**
+ *  Compute Distance and Voronoi maps
+ */
+template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
+void
+OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
+::GenerateData()
+{
+  this->PrepareData();
 
-std::cerr << "to here inside 3";
   itkDebugMacro(<< "GenerateData: Computing distance transform");
-  while( !it.IsAtEnd() )
-    {
-    if( !(i % updateVisits ) )
-      {
-      this->UpdateProgress( (float) i / updatePeriod );
-      }
 
-    IndexType here = it.GetIndex();
-    for( unsigned int dim=0; dim <OutputImageType::ImageDimension; dim++)
-      {
-      if( it.IsReflected(dim) )
-        {
-        offset[dim]++;
-        UpdateLocalDistance( here, offset );
-        offset[dim]=0;
-        }
-      else
-        {
-        offset[dim]--;
-        UpdateLocalDistance( here, offset );
-        offset[dim]=0;
-        }
-      }
-    ++it;
-    ++i;
+  // one pass per dimension, the lines of a pass are processed in parallel
+  OrderKThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->OrderKThreaderCallback, &str );
+  for( unsigned int dim = 0; dim < InputImageDimension; ++dim )
+    {
+    str.Dimension = dim;
+    this->GetMultiThreader()->SingleMethodExecute();
+    this->UpdateProgress( static_cast<float>( dim + 1 ) / ( InputImageDimension + 1 ) );
     }
 
+  this->CopyKNearestToOutputs();
+
   itkDebugMacro(<< "GenerateData: ComputeVoronoiMap");
-  std::cerr << "to here inside 4";
   this->ComputeVoronoiMap();
-std::cerr << "to here inside 5";
+  this->UpdateProgress( 1.0f );
 } // end GenerateData()
 
 
@@ -538,6 +491,19 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
 }
 
 
+/**
+ *  The whole output is produced
+ */
+template <class TInputImage, class TOutputImage, class TKDistanceImage, class TKIDImage >
+void
+OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, TKIDImage >
+::EnlargeOutputRequestedRegion( DataObject * output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+
 
 /**
  *  Print Self
@@ -553,6 +519,8 @@ OrderKDistanceTransformImageFilter<TInputImage, TOutputImage, TKDistanceImage, T
   os << indent << "Input Is Binary   : " << this->m_InputIsBinary << std::endl;
   os << indent << "Use Image Spacing : " << this->m_UseImageSpacing << std::endl;
   os << indent << "Squared Distance  : " << this->m_SquaredDistance << std::endl;
+  os << indent << "Fully Connected   : " << this->m_FullyConnected << std::endl;
+  os << indent << "K                 : " << this->m_K << std::endl;
 
 }
 
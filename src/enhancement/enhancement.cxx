@@ -48,6 +48,13 @@ std::string GetHelpString( void )
     << "             {0 - Equispaced sigma steps, 1 - Logarithmic sigma steps }\n"
     << "             default: 1 - Logarithmic sigma steps\n"
     << "  [-rescaleoff]   Rescale off. Default on.\n"
+    << "  [-fused]   process the image in blocks, computing all scales without\n"
+    << "             full size Hessian and eigenvalue images. Uses much less memory,\n"
+    << "             but results differ slightly near the image border. Unless\n"
+    << "             -rescaleoff is given, one extra image of the output size is used.\n"
+    << "  [-closedformeigen] compute the Hessian eigenvalues with a closed form\n"
+    << "             solution instead of the iterative solver. Faster, and as accurate\n"
+    << "             up to round off.\n"
     << "  [-threads] maximum number of threads used, default all.\n"
     << std::endl
     << "  [-m]     method, choose one of:\n"
@@ -142,6 +149,10 @@ int main( int argc, char ** argv )
 
   bool retrescale = parser->ArgumentExists( "-rescaleoff" );
 
+  bool useFusedEngine = parser->ArgumentExists( "-fused" );
+
+  bool useClosedFormEigenSolver = parser->ArgumentExists( "-closedformeigen" );
+
   unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
   parser->GetCommandLineArgument( "-threads", maxThreads );
   itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
@@ -249,6 +260,8 @@ int main( int argc, char ** argv )
     filter->m_OutputFileNames = outputFileNames;
     filter->m_Method = method;
     filter->m_Rescale = !retrescale;
+    filter->m_UseFusedEngine = useFusedEngine;
+    filter->m_UseClosedFormEigenSolver = useClosedFormEigenSolver;
     filter->m_SigmaStepMethod = sigmaStepMethod;
     filter->m_SigmaMinimum = sigmaMinimum;
     filter->m_SigmaMaximum = sigmaMaximum;
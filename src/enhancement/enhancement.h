@@ -57,6 +57,8 @@ public:
     this->m_Method = "";
 
     this->m_Rescale = true;
+    this->m_UseFusedEngine = false;
+    this->m_UseClosedFormEigenSolver = false;
 
     this->m_SigmaStepMethod = 1;
     this->m_SigmaMinimum = 1.0;
@@ -79,6 +81,8 @@ public:
   std::string m_Method;
 
   bool m_Rescale;
+  bool m_UseFusedEngine;
+  bool m_UseClosedFormEigenSolver;
 
   unsigned int m_SigmaStepMethod;
   double m_SigmaMinimum;
@@ -170,6 +174,8 @@ public:
     multiScaleFilter->SetGenerateScalesOutput( generateScalesOutput );
     multiScaleFilter->SetSigmaStepMethod( this->m_SigmaStepMethod );
     multiScaleFilter->SetRescale( this->m_Rescale );
+    multiScaleFilter->SetUseFusedEngine( this->m_UseFusedEngine );
+    multiScaleFilter->SetUseClosedFormEigenSolver( this->m_UseClosedFormEigenSolver );
     multiScaleFilter->SetInput( reader->GetOutput() );
 
     /** Setup the requested functor and connect it to the filter. */
@@ -28,6 +28,7 @@
 
 #include "itkSymmetricSecondRankTensor.h"
 #include "itkSymmetricEigenAnalysisImageFilter.h"
+#include "itkSymmetricEigenValuesClosedFormImageFilter.h"
 #include "itkGradientMagnitudeRecursiveGaussianImageFilter.h"
 #include "itkHessianRecursiveGaussianImageFilter.h"
 #include "itkRescaleIntensityImageFilter.h"
@@ -94,6 +95,8 @@ public:
     itkGetStaticConstMacro( ImageDimension ) >    EigenValueImageType;
   typedef SymmetricEigenAnalysisImageFilter<
     HessianTensorImageType, EigenValueImageType > EigenAnalysisFilterType;
+  typedef SymmetricEigenValuesClosedFormImageFilter<
+    HessianTensorImageType, EigenValueImageType > ClosedFormEigenAnalysisFilterType;
 
   /** Rescale filter type */
   typedef RescaleIntensityImageFilter<
@@ -134,6 +137,13 @@ public:
   void SetNormalizeAcrossScale( bool normalize );
   itkGetConstMacro( NormalizeAcrossScale, bool );
 
+  /** Methods to turn on/off the closed form eigenvalue solver for 2D and 3D,
+   * instead of the iterative SymmetricEigenAnalysis. Default off.
+   */
+  itkSetMacro( UseClosedFormEigenSolver, bool );
+  itkGetConstMacro( UseClosedFormEigenSolver, bool );
+  itkBooleanMacro( UseClosedFormEigenSolver );
+
   /** Set the number of threads to create when executing. */
   void SetNumberOfThreads( ThreadIdType nt );
 
@@ -162,6 +172,7 @@ private:
   typename GradientMagnitudeFilterType::Pointer   m_GradientMagnitudeFilter;
   typename HessianFilterType::Pointer             m_HessianFilter;
   typename EigenAnalysisFilterType::Pointer       m_SymmetricEigenValueFilter;
+  typename ClosedFormEigenAnalysisFilterType::Pointer m_ClosedFormEigenValueFilter;
   typename RescaleFilterType::Pointer             m_RescaleFilter;
 
   typename UnaryFunctorBaseType::Pointer m_UnaryFunctor;
@@ -172,6 +183,7 @@ private:
   double  m_Sigma;
   bool    m_Rescale;
   bool    m_NormalizeAcrossScale; // Normalize the image across scale space
+  bool    m_UseClosedFormEigenSolver;
 };
 
 } // end namespace itk
@@ -38,6 +38,7 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   this->m_Sigma = 1.0;
   this->m_Rescale = true;
   this->m_NormalizeAcrossScale = true;
+  this->m_UseClosedFormEigenSolver = false;
 
   // Construct the gradient magnitude filter
   this->m_GradientMagnitudeFilter = GradientMagnitudeFilterType::New();
@@ -52,6 +53,7 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   this->m_SymmetricEigenValueFilter->SetDimension( ImageDimension );
   this->m_SymmetricEigenValueFilter->OrderEigenValuesBy(
     EigenAnalysisFilterType::FunctorType::OrderByValue );//OrderByMagnitude?
+  this->m_ClosedFormEigenValueFilter = ClosedFormEigenAnalysisFilterType::New();
 
   // Construct the rescale filter
   this->m_RescaleFilter = RescaleFilterType::New();
@@ -62,6 +64,7 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   this->m_HessianFilter->ReleaseDataFlagOn();
   this->m_GradientMagnitudeFilter->ReleaseDataFlagOn();
   this->m_SymmetricEigenValueFilter->ReleaseDataFlagOn();
+  this->m_ClosedFormEigenValueFilter->ReleaseDataFlagOn();
   this->m_RescaleFilter->ReleaseDataFlagOn();
 
 } // end Constructor
@@ -121,6 +124,7 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   this->m_GradientMagnitudeFilter->SetNumberOfThreads( nt );
   this->m_HessianFilter->SetNumberOfThreads( nt );
   this->m_SymmetricEigenValueFilter->SetNumberOfThreads( nt );
+  this->m_ClosedFormEigenValueFilter->SetNumberOfThreads( nt );
   this->m_RescaleFilter->SetNumberOfThreads( nt );
 
   if ( this->m_UnaryFunctorFilter.IsNotNull() )
@@ -191,23 +195,32 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   this->m_HessianFilter->SetInput( this->GetInput() );
   this->m_HessianFilter->SetSigma( this->m_Sigma );
 
-  this->m_SymmetricEigenValueFilter->SetInput( this->m_HessianFilter->GetOutput() );
-  this->m_SymmetricEigenValueFilter->Update();
+  EigenValueImageType * eigenValueImage = 0;
+  if ( this->m_UseClosedFormEigenSolver )
+  {
+    this->m_ClosedFormEigenValueFilter->SetInput( this->m_HessianFilter->GetOutput() );
+    this->m_ClosedFormEigenValueFilter->Update();
+    eigenValueImage = this->m_ClosedFormEigenValueFilter->GetOutput();
+  }
+  else
+  {
+    this->m_SymmetricEigenValueFilter->SetInput( this->m_HessianFilter->GetOutput() );
+    this->m_SymmetricEigenValueFilter->Update();
+    eigenValueImage = this->m_SymmetricEigenValueFilter->GetOutput();
+  }
 
   if ( this->m_BinaryFunctor.IsNotNull() )
   {
     // Calculate binary functor filter.
     this->m_BinaryFunctorFilter->SetInput1(
       this->m_GradientMagnitudeFilter->GetOutput() );
-    this->m_BinaryFunctorFilter->SetInput2(
-      this->m_SymmetricEigenValueFilter->GetOutput() );
+    this->m_BinaryFunctorFilter->SetInput2( eigenValueImage );
     this->m_BinaryFunctorFilter->Update();
   }
   else
   {
     // Calculate unary functor filter.
-    this->m_UnaryFunctorFilter->SetInput(
-      this->m_SymmetricEigenValueFilter->GetOutput() );
+    this->m_UnaryFunctorFilter->SetInput( eigenValueImage );
     this->m_UnaryFunctorFilter->Update();
   }
 
@@ -256,6 +269,7 @@ GaussianEnhancementImageFilter< TInPixel, TOutPixel >
   os << indent << "Sigma: " << this->m_Sigma << std::endl;
   os << indent << "Rescale: " << this->m_Rescale << std::endl;
   os << indent << "NormalizeAcrossScale: " << this->m_NormalizeAcrossScale << std::endl;
+  os << indent << "UseClosedFormEigenSolver: " << this->m_UseClosedFormEigenSolver << std::endl;
 
   Indent nextIndent = indent.GetNextIndent();
   if ( this->m_BinaryFunctorFilter.IsNotNull() )
@@ -19,6 +19,9 @@
 #define __itkMultiScaleGaussianEnhancementImageFilter_h
 
 #include "itkGaussianEnhancementImageFilter.h"
+#include "itkMultiThreader.h"
+#include "itkImageRegionIterator.h"
+#include <vector>
 
 namespace itk
 {
@@ -34,6 +37,20 @@ namespace itk
  * The filter computes a second output image (accessed by the GetScalesOutput method)
  * containing the scales at which each pixel gave the best response.
  *
+ * By default every scale runs the full single scale pipeline, which
+ * allocates a Hessian and an eigenvalue image of the size of the input.
+ * With UseFusedEngine on, the image is processed in blocks instead: for
+ * each block the Hessian (and gradient) is computed with sampled Gaussian
+ * derivative kernels on the block plus a margin, followed by the eigen
+ * analysis and the functor, and only the running maximum and the scales
+ * image are kept. Since sampled kernels with a replicated border are used
+ * instead of the recursive Gaussian, results differ slightly from the
+ * default engine, mostly near the image border. When Rescale is on, the
+ * response range of a scale is only known after all its blocks, so the
+ * responses of the scale are kept in one image and merged afterwards.
+ * This costs one more image of the output size: besides the input, the
+ * maximum, the responses and, if requested, the scales are in memory.
+ *
  * \sa GaussianEnhancementImageFilter
  * \sa HessianRecursiveGaussianImageFilter
  * \sa SymmetricEigenAnalysisImageFilter
@@ -89,6 +106,7 @@ public:
   typedef typename SingleScaleFilterType::EigenValueArrayType           EigenValueArrayType;
   typedef typename SingleScaleFilterType::EigenValueImageType           EigenValueImageType;
   typedef typename SingleScaleFilterType::EigenAnalysisFilterType       EigenAnalysisFilterType;
+  typedef typename SingleScaleFilterType::ClosedFormEigenAnalysisFilterType ClosedFormEigenAnalysisFilterType;
   typedef typename SingleScaleFilterType::RescaleFilterType             RescaleFilterType;
   typedef typename SingleScaleFilterType::UnaryFunctorImageFilterType   UnaryFunctorImageFilterType;
   typedef typename SingleScaleFilterType::UnaryFunctorBaseType          UnaryFunctorBaseType;
@@ -170,9 +188,27 @@ public:
   void SetNormalizeAcrossScale( bool normalize );
   bool GetNormalizeAcrossScale() const;
 
+  /** Define whether the closed form eigenvalue solver is used for 2D and 3D,
+   * in both engines. Default false.
+   */
+  void SetUseClosedFormEigenSolver( bool closedForm );
+  bool GetUseClosedFormEigenSolver() const;
+
   /** Set the number of threads to create when executing. */
   void SetNumberOfThreads( ThreadIdType nt );
 
+  /** Methods to turn on/off the fused blocked engine. Off by default. */
+  itkSetMacro( UseFusedEngine, bool );
+  itkGetConstMacro( UseFusedEngine, bool );
+  itkBooleanMacro( UseFusedEngine );
+
+  /** Set/Get the edge length of the blocks of the fused engine. The block
+   * is enlarged for large scales, so that the margin does not dominate.
+   * Default 32.
+   */
+  itkSetClampMacro( BlockSize, unsigned int, 1, NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( BlockSize, unsigned int );
+
   /** Get the image containing the scales at which each pixel gave the best response */
   const ScalesImageType * GetScalesOutput( void ) const;
 
@@ -195,6 +231,60 @@ protected:
   /** Does the work. */
   virtual void GenerateData( void );
 
+  /** Types for the fused engine. */
+  typedef typename OutputRegionType::IndexType            OutputIndexType;
+  typedef typename OutputRegionType::SizeType             OutputSizeType;
+  typedef std::vector< OutputPixelType >                  BlockBufferType;
+  typedef std::vector< BlockBufferType >                  BlockBufferContainerType;
+  typedef FixedArray< unsigned int,
+    itkGetStaticConstMacro( ImageDimension ) >            DerivativeOrderType;
+
+  /** The fused engine: a threaded pass over all blocks for each scale. */
+  virtual void GenerateDataFused( void );
+
+  /** Compute the Gaussian derivative kernels and the blocks for a scale. */
+  void InitializeFusedScale( const unsigned int & scaleLevel );
+
+  /** Buffers of one thread, reused for all its blocks. */
+  struct FusedWorkspaceType
+  {
+    BlockBufferType           Input;
+    BlockBufferContainerType  Intermediates;
+    BlockBufferContainerType  Derivatives;
+    BlockBufferContainerType  EigenValues;
+  };
+
+  /** Process one block for the current scale. With Rescale on, the
+   * responses are stored in the response image, and their minimum and
+   * maximum are accumulated for this thread; otherwise they are merged
+   * into the output directly.
+   */
+  void ProcessFusedBlock( const OutputRegionType & block, ThreadIdType threadId );
+
+  /** Rescale the stored responses of one block and merge them into the output. */
+  void MergeFusedBlock( const OutputRegionType & block );
+
+  /** Merge a response into the output and the scales output. */
+  void MergeFusedResponse( OutputPixelType value,
+    ImageRegionIterator<OutputImageType> & outputIt,
+    ImageRegionIterator<ScalesImageType> & scalesIt ) const;
+
+  /** Convolve along the axes axis, ..., 0 for all derivatives that match the
+   * orders already applied along the higher axes. The result along an axis
+   * is stored in intermediates[ axis ].
+   */
+  void ConvolveFusedBlock( const BlockBufferType & in, const OutputSizeType & inSize,
+    int axis, DerivativeOrderType & prefix, BlockBufferContainerType & intermediates,
+    BlockBufferContainerType & results ) const;
+
+  /** Static thread callback of the fused engine. */
+  struct FusedEnhancementThreadStruct
+  {
+    Self *       Filter;
+    bool         Merge;
+  };
+  static ITK_THREAD_RETURN_TYPE FusedEnhancementThreaderCallback( void * arg );
+
   /** Print member variables. */
   virtual void PrintSelf( std::ostream& os, Indent indent ) const;
 
@@ -223,6 +313,22 @@ private:
   unsigned int         m_NumberOfSigmaSteps;
   SigmaStepMethodType  m_SigmaStepMethod;
 
+  /** Fused engine settings and the state of the current scale. */
+  bool                              m_UseFusedEngine;
+  unsigned int                      m_BlockSize;
+  unsigned int                      m_FusedScaleLevel;
+  double                            m_FusedSigma;
+  double                            m_FusedRescaleFactor;
+  double                            m_FusedRescaleOffset;
+  std::vector< DerivativeOrderType > m_FusedDerivativeOrders;
+  BlockBufferType                   m_FusedKernels[ 3 ][ ImageDimension ];
+  OutputSizeType                    m_FusedKernelRadius;
+  std::vector< OutputRegionType >   m_FusedBlocks;
+  std::vector< double >             m_FusedThreadMinimum;
+  std::vector< double >             m_FusedThreadMaximum;
+  std::vector< FusedWorkspaceType > m_FusedWorkspaces;
+  typename OutputImageType::Pointer m_FusedResponse;
+
 }; // end class MultiScaleGaussianEnhancementImageFilter
 
 } // end namespace itk
@@ -24,6 +24,8 @@
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
 #include "itkMaximumImageFilter.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -47,6 +49,14 @@ MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
   this->m_GenerateScalesOutput = false;
   this->m_Rescale = true;
 
+  this->m_UseFusedEngine = false;
+  this->m_BlockSize = 32;
+  this->m_FusedScaleLevel = 0;
+  this->m_FusedSigma = 1.0;
+  this->m_FusedRescaleFactor = 1.0;
+  this->m_FusedRescaleOffset = 0.0;
+  this->m_FusedKernelRadius.Fill( 0 );
+
   typename ScalesImageType::Pointer scalesImage = ScalesImageType::New();
   this->ProcessObject::SetNumberOfRequiredOutputs( 2 );
   this->ProcessObject::SetNthOutput( 1, scalesImage.GetPointer() );
@@ -108,6 +118,49 @@ MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
 } // end SetNormalizeAcrossScale()
 
 
+/**
+ * ********************* GetNormalizeAcrossScale ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+bool
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::GetNormalizeAcrossScale( void ) const
+{
+  return this->m_GaussianEnhancementFilter->GetNormalizeAcrossScale();
+} // end GetNormalizeAcrossScale()
+
+
+/**
+ * ********************* SetUseClosedFormEigenSolver ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::SetUseClosedFormEigenSolver( bool closedForm )
+{
+  if ( this->m_GaussianEnhancementFilter->GetUseClosedFormEigenSolver() != closedForm )
+  {
+    this->m_GaussianEnhancementFilter->SetUseClosedFormEigenSolver( closedForm );
+    this->Modified();
+  }
+} // end SetUseClosedFormEigenSolver()
+
+
+/**
+ * ********************* GetUseClosedFormEigenSolver ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+bool
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::GetUseClosedFormEigenSolver( void ) const
+{
+  return this->m_GaussianEnhancementFilter->GetUseClosedFormEigenSolver();
+} // end GetUseClosedFormEigenSolver()
+
+
 /**
  * ********************* MakeOutput ****************************
  */
@@ -197,6 +250,13 @@ MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
       << " cannot be greater than SigmaMaximum: " << this->m_SigmaMaximum );
   }
 
+  // Process the image block by block
+  if ( this->m_UseFusedEngine )
+  {
+    this->GenerateDataFused();
+    return;
+  }
+
   typename InputImageType::ConstPointer input = this->GetInput();
 
   // Set filter input
@@ -273,6 +333,542 @@ MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
 } // end UpdateMaximumResponse()
 
 
+/**
+ * ********************* GenerateDataFused ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::GenerateDataFused( void )
+{
+  if ( this->m_GaussianEnhancementFilter->GetUnaryFunctor() == NULL
+    && this->m_GaussianEnhancementFilter->GetBinaryFunctor() == NULL )
+  {
+    itkExceptionMacro( << "ERROR: Missing Functor. "
+      << "Please provide functor for multi scale framework." );
+  }
+
+  // The Hessian components in the order of the tensor, followed by the
+  // gradient components when a binary functor is used.
+  DerivativeOrderType order;
+  this->m_FusedDerivativeOrders.clear();
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+  {
+    for ( unsigned int j = i; j < ImageDimension; ++j )
+    {
+      order.Fill( 0 );
+      order[ i ]++;
+      order[ j ]++;
+      this->m_FusedDerivativeOrders.push_back( order );
+    }
+  }
+  if ( this->m_GaussianEnhancementFilter->GetBinaryFunctor() != NULL )
+  {
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      order.Fill( 0 );
+      order[ i ] = 1;
+      this->m_FusedDerivativeOrders.push_back( order );
+    }
+  }
+
+  FusedEnhancementThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(
+    this->FusedEnhancementThreaderCallback, &str );
+  const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+  this->m_FusedWorkspaces.resize( numberOfThreads );
+
+  // When rescaling, the responses of a scale are stored until its range is
+  // known, and then merged with the linear map to [0,1] that
+  // RescaleIntensityImageFilter uses.
+  if ( this->m_Rescale )
+  {
+    this->m_FusedResponse = OutputImageType::New();
+    this->m_FusedResponse->CopyInformation( this->GetOutput() );
+    this->m_FusedResponse->SetRegions( this->GetOutput()->GetRequestedRegion() );
+    this->m_FusedResponse->Allocate();
+  }
+
+  for ( unsigned int scaleLevel = 0; scaleLevel < this->m_NumberOfSigmaSteps; ++scaleLevel )
+  {
+    this->InitializeFusedScale( scaleLevel );
+    this->m_FusedThreadMinimum.assign( numberOfThreads, NumericTraits<double>::max() );
+    this->m_FusedThreadMaximum.assign( numberOfThreads, NumericTraits<double>::NonpositiveMin() );
+    str.Merge = false;
+    this->GetMultiThreader()->SingleMethodExecute();
+    if ( !this->m_Rescale ) continue;
+
+    const double minimum = *std::min_element(
+      this->m_FusedThreadMinimum.begin(), this->m_FusedThreadMinimum.end() );
+    const double maximum = *std::max_element(
+      this->m_FusedThreadMaximum.begin(), this->m_FusedThreadMaximum.end() );
+    if ( minimum != maximum )
+    {
+      this->m_FusedRescaleFactor = 1.0 / ( maximum - minimum );
+    }
+    else if ( maximum != 0.0 )
+    {
+      this->m_FusedRescaleFactor = 1.0 / maximum;
+    }
+    else
+    {
+      this->m_FusedRescaleFactor = 0.0;
+    }
+    this->m_FusedRescaleOffset = -minimum * this->m_FusedRescaleFactor;
+
+    str.Merge = true;
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+
+  // Release the block list and the buffers
+  this->m_FusedBlocks.clear();
+  this->m_FusedWorkspaces.clear();
+  this->m_FusedResponse = NULL;
+
+} // end GenerateDataFused()
+
+
+/**
+ * ********************* InitializeFusedScale ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::InitializeFusedScale( const unsigned int & scaleLevel )
+{
+  this->m_FusedScaleLevel = scaleLevel;
+  this->m_FusedSigma = this->ComputeSigmaValue( scaleLevel );
+
+  const double sigma = this->m_FusedSigma;
+  const bool normalize = this->m_GaussianEnhancementFilter->GetNormalizeAcrossScale();
+  const typename InputImageType::SpacingType spacing = this->GetInput()->GetSpacing();
+
+  // Sampled Gaussian derivative kernels, normalized such that they are exact
+  // for polynomials of their order. They are stored reversed, so that the
+  // convolution is a plain inner product.
+  for ( unsigned int k = 0; k < ImageDimension; ++k )
+  {
+    const double s = sigma / spacing[ k ];
+    const int r = std::max( 1, static_cast<int>( std::ceil( 4.0 * s ) ) );
+    this->m_FusedKernelRadius[ k ] = r;
+
+    std::vector<double> g0( 2 * r + 1 ), g1( 2 * r + 1 ), g2( 2 * r + 1 );
+    double sum0 = 0.0;
+    for ( int t = -r; t <= r; ++t )
+    {
+      g0[ t + r ] = std::exp( -0.5 * t * t / ( s * s ) );
+      sum0 += g0[ t + r ];
+    }
+    double moment1 = 0.0, moment2 = 0.0;
+    for ( int t = -r; t <= r; ++t )
+    {
+      g0[ t + r ] /= sum0;
+      moment2 += t * t * g0[ t + r ];
+    }
+    for ( int t = -r; t <= r; ++t )
+    {
+      g1[ t + r ] = -t * g0[ t + r ];
+      g2[ t + r ] = ( t * t - moment2 ) * g0[ t + r ];
+      moment1 -= t * g1[ t + r ];
+    }
+    double moment22 = 0.0;
+    for ( int t = -r; t <= r; ++t )
+    {
+      moment22 += t * t * g2[ t + r ];
+    }
+
+    const double scale1 = ( normalize ? sigma : 1.0 ) / ( spacing[ k ] * moment1 );
+    const double scale2 = ( normalize ? sigma * sigma : 1.0 )
+      * 2.0 / ( spacing[ k ] * spacing[ k ] * moment22 );
+    for ( unsigned int order = 0; order < 3; ++order )
+    {
+      this->m_FusedKernels[ order ][ k ].resize( 2 * r + 1 );
+    }
+    for ( int m = 0; m <= 2 * r; ++m )
+    {
+      const int t = r - m;
+      this->m_FusedKernels[ 0 ][ k ][ m ] = static_cast<OutputPixelType>( g0[ t + r ] );
+      this->m_FusedKernels[ 1 ][ k ][ m ] = static_cast<OutputPixelType>( g1[ t + r ] * scale1 );
+      this->m_FusedKernels[ 2 ][ k ][ m ] = static_cast<OutputPixelType>( g2[ t + r ] * scale2 );
+    }
+  }
+
+  // Split the output in blocks. Blocks are at least as large as the kernel
+  // radius, so that the margin does not dominate the work.
+  const OutputRegionType outputRegion = this->GetOutput()->GetRequestedRegion();
+  OutputSizeType blockSize, numberOfBlocks;
+  SizeValueType totalBlocks = 1;
+  for ( unsigned int k = 0; k < ImageDimension; ++k )
+  {
+    blockSize[ k ] = std::max<SizeValueType>( this->m_BlockSize, this->m_FusedKernelRadius[ k ] );
+    numberOfBlocks[ k ] = ( outputRegion.GetSize()[ k ] + blockSize[ k ] - 1 ) / blockSize[ k ];
+    totalBlocks *= numberOfBlocks[ k ];
+  }
+
+  this->m_FusedBlocks.resize( totalBlocks );
+  OutputSizeType blockPosition; blockPosition.Fill( 0 );
+  for ( SizeValueType b = 0; b < totalBlocks; ++b )
+  {
+    OutputIndexType index;
+    OutputSizeType size;
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      const SizeValueType offset = blockPosition[ k ] * blockSize[ k ];
+      index[ k ] = outputRegion.GetIndex()[ k ] + static_cast<OffsetValueType>( offset );
+      size[ k ] = std::min( blockSize[ k ], outputRegion.GetSize()[ k ] - offset );
+    }
+    this->m_FusedBlocks[ b ] = OutputRegionType( index, size );
+
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      if ( ++blockPosition[ k ] < numberOfBlocks[ k ] ) break;
+      blockPosition[ k ] = 0;
+    }
+  }
+
+} // end InitializeFusedScale()
+
+
+/**
+ * ********************* FusedEnhancementThreaderCallback ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::FusedEnhancementThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  FusedEnhancementThreadStruct * str
+    = static_cast<FusedEnhancementThreadStruct *>( info->UserData );
+
+  // The blocks are dealt out round robin
+  const std::vector<OutputRegionType> & blocks = str->Filter->m_FusedBlocks;
+  for ( std::size_t b = threadId; b < blocks.size(); b += threadCount )
+  {
+    if ( str->Merge )
+    {
+      str->Filter->MergeFusedBlock( blocks[ b ] );
+    }
+    else
+    {
+      str->Filter->ProcessFusedBlock( blocks[ b ], threadId );
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end FusedEnhancementThreaderCallback()
+
+
+/**
+ * ********************* ProcessFusedBlock ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::ProcessFusedBlock( const OutputRegionType & block, ThreadIdType threadId )
+{
+  const InputImageType * input = this->GetInput();
+  FusedWorkspaceType & workspace = this->m_FusedWorkspaces[ threadId ];
+  const typename InputImageType::RegionType inputRegion = input->GetBufferedRegion();
+
+  // Copy the block plus a margin of the kernel radius, replicating the border.
+  OutputIndexType inStart;
+  OutputSizeType inSize;
+  SizeValueType numberOfPixels = 1;
+  for ( unsigned int k = 0; k < ImageDimension; ++k )
+  {
+    inStart[ k ] = block.GetIndex()[ k ]
+      - static_cast<OffsetValueType>( this->m_FusedKernelRadius[ k ] );
+    inSize[ k ] = block.GetSize()[ k ] + 2 * this->m_FusedKernelRadius[ k ];
+    numberOfPixels *= inSize[ k ];
+  }
+
+  BlockBufferType & buffer = workspace.Input;
+  buffer.resize( numberOfPixels );
+  OutputIndexType position = inStart;
+  typename InputImageType::IndexType clamped;
+  for ( SizeValueType n = 0; n < numberOfPixels; ++n )
+  {
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      const OffsetValueType first = inputRegion.GetIndex()[ k ];
+      const OffsetValueType last = first
+        + static_cast<OffsetValueType>( inputRegion.GetSize()[ k ] ) - 1;
+      clamped[ k ] = std::max( first, std::min( last, position[ k ] ) );
+    }
+    buffer[ n ] = static_cast<OutputPixelType>( input->GetPixel( clamped ) );
+
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      if ( ++position[ k ] < inStart[ k ] + static_cast<OffsetValueType>( inSize[ k ] ) ) break;
+      position[ k ] = inStart[ k ];
+    }
+  }
+
+  // Compute all derivatives of the block.
+  BlockBufferContainerType & derivatives = workspace.Derivatives;
+  derivatives.resize( this->m_FusedDerivativeOrders.size() );
+  workspace.Intermediates.resize( ImageDimension );
+  DerivativeOrderType prefix;
+  prefix.Fill( 0 );
+  this->ConvolveFusedBlock( buffer, inSize, ImageDimension - 1, prefix,
+    workspace.Intermediates, derivatives );
+
+  // Eigen analysis, functor and maximum over the scales.
+  typedef typename EigenAnalysisFilterType::FunctorType     EigenFunctorType;
+  typedef typename HessianTensorImageType::PixelType        TensorType;
+  EigenFunctorType eigenFunctor;
+  eigenFunctor.SetDimension( ImageDimension );
+  eigenFunctor.OrderEigenValuesBy( EigenFunctorType::OrderByValue );
+
+  const UnaryFunctorBaseType * unaryFunctor
+    = this->m_GaussianEnhancementFilter->GetUnaryFunctor();
+  const BinaryFunctorBaseType * binaryFunctor
+    = this->m_GaussianEnhancementFilter->GetBinaryFunctor();
+
+  ImageRegionIterator<OutputImageType> outputIt( this->GetOutput(), block );
+  ImageRegionIterator<OutputImageType> responseIt;
+  ImageRegionIterator<ScalesImageType> scalesIt;
+  if ( this->m_Rescale )
+  {
+    responseIt = ImageRegionIterator<OutputImageType>( this->m_FusedResponse, block );
+  }
+  else if ( this->m_GenerateScalesOutput )
+  {
+    scalesIt = ImageRegionIterator<ScalesImageType>( static_cast<ScalesImageType *>(
+      this->ProcessObject::GetOutput( 1 ) ), block );
+  }
+
+  double minimum = this->m_FusedThreadMinimum[ threadId ];
+  double maximum = this->m_FusedThreadMaximum[ threadId ];
+
+  // The Hessian components are already stored in lanes, so the closed form
+  // solver can process the whole block at once.
+  typedef typename ClosedFormEigenAnalysisFilterType::SolverType ClosedFormSolverType;
+  const SizeValueType blockPixels = block.GetNumberOfPixels();
+  const unsigned int numberOfHessianComponents = ImageDimension * ( ImageDimension + 1 ) / 2;
+  const bool closedForm = ClosedFormSolverType::Supported
+    && this->m_GaussianEnhancementFilter->GetUseClosedFormEigenSolver();
+  BlockBufferContainerType & closedFormEigenValues = workspace.EigenValues;
+  if ( closedForm )
+  {
+    closedFormEigenValues.resize( ImageDimension );
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      closedFormEigenValues[ k ].resize( blockPixels );
+    }
+    std::vector<const OutputPixelType *> components( numberOfHessianComponents );
+    std::vector<OutputPixelType *> eigenValueLanes( ImageDimension );
+    for ( unsigned int c = 0; c < numberOfHessianComponents; ++c )
+    {
+      components[ c ] = &derivatives[ c ][ 0 ];
+    }
+    for ( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      eigenValueLanes[ k ] = &closedFormEigenValues[ k ][ 0 ];
+    }
+    ClosedFormSolverType::Compute( &components[ 0 ], &eigenValueLanes[ 0 ], blockPixels );
+  }
+
+  TensorType tensor;
+  EigenValueArrayType eigenValues;
+  for ( SizeValueType n = 0; n < blockPixels; ++n )
+  {
+    const unsigned int d = numberOfHessianComponents;
+    if ( closedForm )
+    {
+      for ( unsigned int k = 0; k < ImageDimension; ++k )
+      {
+        eigenValues[ k ] = closedFormEigenValues[ k ][ n ];
+      }
+    }
+    else
+    {
+      unsigned int c = 0;
+      for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        for ( unsigned int j = i; j < ImageDimension; ++j )
+        {
+          tensor( i, j ) = derivatives[ c++ ][ n ];
+        }
+      }
+      eigenValues = eigenFunctor( tensor );
+    }
+
+    OutputPixelType value;
+    if ( binaryFunctor != NULL )
+    {
+      double squaredMagnitude = 0.0;
+      for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        squaredMagnitude += derivatives[ d + i ][ n ] * derivatives[ d + i ][ n ];
+      }
+      value = binaryFunctor->Evaluate(
+        static_cast<GradientMagnitudePixelType>( std::sqrt( squaredMagnitude ) ), eigenValues );
+    }
+    else
+    {
+      value = unaryFunctor->Evaluate( eigenValues );
+    }
+
+    if ( this->m_Rescale )
+    {
+      minimum = std::min( minimum, static_cast<double>( value ) );
+      maximum = std::max( maximum, static_cast<double>( value ) );
+      responseIt.Set( value );
+      ++responseIt;
+    }
+    else
+    {
+      this->MergeFusedResponse( value, outputIt, scalesIt );
+    }
+  }
+
+  this->m_FusedThreadMinimum[ threadId ] = minimum;
+  this->m_FusedThreadMaximum[ threadId ] = maximum;
+
+} // end ProcessFusedBlock()
+
+
+/**
+ * ********************* MergeFusedBlock ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::MergeFusedBlock( const OutputRegionType & block )
+{
+  ImageRegionConstIterator<OutputImageType> responseIt( this->m_FusedResponse, block );
+  ImageRegionIterator<OutputImageType> outputIt( this->GetOutput(), block );
+  ImageRegionIterator<ScalesImageType> scalesIt;
+  if ( this->m_GenerateScalesOutput )
+  {
+    scalesIt = ImageRegionIterator<ScalesImageType>( static_cast<ScalesImageType *>(
+      this->ProcessObject::GetOutput( 1 ) ), block );
+  }
+
+  for ( ; !responseIt.IsAtEnd(); ++responseIt )
+  {
+    const double rescaled = responseIt.Get() * this->m_FusedRescaleFactor
+      + this->m_FusedRescaleOffset;
+    this->MergeFusedResponse(
+      static_cast<OutputPixelType>( std::max( 0.0, std::min( 1.0, rescaled ) ) ),
+      outputIt, scalesIt );
+  }
+
+} // end MergeFusedBlock()
+
+
+/**
+ * ********************* MergeFusedResponse ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::MergeFusedResponse( OutputPixelType value,
+  ImageRegionIterator<OutputImageType> & outputIt,
+  ImageRegionIterator<ScalesImageType> & scalesIt ) const
+{
+  const OutputPixelType previous = outputIt.Get();
+  if ( this->m_GenerateScalesOutput )
+  {
+    if ( previous < value )
+    {
+      scalesIt.Set( static_cast<ScalesPixelType>( this->m_FusedSigma ) );
+    }
+    ++scalesIt;
+  }
+  if ( value > previous )
+  {
+    outputIt.Set( value );
+  }
+  ++outputIt;
+
+} // end MergeFusedResponse()
+
+
+/**
+ * ********************* ConvolveFusedBlock ****************************
+ */
+
+template< typename TInputImage, typename TOutputImage >
+void
+MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
+::ConvolveFusedBlock( const BlockBufferType & in, const OutputSizeType & inSize,
+  int axis, DerivativeOrderType & prefix, BlockBufferContainerType & intermediates,
+  BlockBufferContainerType & results ) const
+{
+  const unsigned int numberOfDerivatives = this->m_FusedDerivativeOrders.size();
+  const SizeValueType radius = this->m_FusedKernelRadius[ axis ];
+
+  SizeValueType inner = 1, outer = 1;
+  for ( int k = 0; k < axis; ++k ) inner *= inSize[ k ];
+  for ( unsigned int k = axis + 1; k < ImageDimension; ++k ) outer *= inSize[ k ];
+  OutputSizeType outSize = inSize;
+  outSize[ axis ] -= 2 * radius;
+
+  for ( unsigned int order = 0; order < 3; ++order )
+  {
+    // Only convolve when some derivative continues along this branch. Along
+    // the last axis the match is the derivative itself.
+    bool needed = false;
+    unsigned int matched = 0;
+    for ( unsigned int d = 0; d < numberOfDerivatives && !needed; ++d )
+    {
+      const DerivativeOrderType & orders = this->m_FusedDerivativeOrders[ d ];
+      bool match = ( orders[ axis ] == order );
+      for ( unsigned int k = axis + 1; k < ImageDimension; ++k )
+      {
+        match &= ( orders[ k ] == prefix[ k ] );
+      }
+      needed = match;
+      matched = d;
+    }
+    if ( !needed ) continue;
+
+    // Convolution along the axis; only the pixels with a full kernel support are kept
+    const BlockBufferType & kernel = this->m_FusedKernels[ order ][ axis ];
+    BlockBufferType & out = ( axis == 0 ) ? results[ matched ] : intermediates[ axis ];
+    out.assign( inner * outSize[ axis ] * outer, NumericTraits<OutputPixelType>::Zero );
+    for ( SizeValueType o = 0; o < outer; ++o )
+    {
+      for ( SizeValueType j = 0; j < outSize[ axis ]; ++j )
+      {
+        OutputPixelType * dst = &out[ ( o * outSize[ axis ] + j ) * inner ];
+        for ( SizeValueType m = 0; m <= 2 * radius; ++m )
+        {
+          const OutputPixelType w = kernel[ m ];
+          const OutputPixelType * src = &in[ ( o * inSize[ axis ] + j + m ) * inner ];
+          for ( SizeValueType i = 0; i < inner; ++i )
+          {
+            dst[ i ] += w * src[ i ];
+          }
+        }
+      }
+    }
+
+    if ( axis > 0 )
+    {
+      prefix[ axis ] = order;
+      this->ConvolveFusedBlock( out, outSize, axis - 1, prefix, intermediates, results );
+    }
+  }
+
+} // end ConvolveFusedBlock()
+
+
 /**
  * ********************* ComputeSigmaValue ****************************
  */
@@ -368,8 +964,12 @@ MultiScaleGaussianEnhancementImageFilter< TInputImage, TOutputImage >
     << this->m_NonNegativeHessianBasedMeasure << std::endl;
   os << indent << "GenerateScalesOutput: " << this->m_GenerateScalesOutput << std::endl;
   os << indent << "Rescale: " << this->m_Rescale << std::endl;
+  os << indent << "UseFusedEngine: " << this->m_UseFusedEngine << std::endl;
+  os << indent << "BlockSize: " << this->m_BlockSize << std::endl;
   os << indent << "NormalizeAcrossScale: "
     << this->m_GaussianEnhancementFilter->GetNormalizeAcrossScale() << std::endl;
+  os << indent << "UseClosedFormEigenSolver: "
+    << this->m_GaussianEnhancementFilter->GetUseClosedFormEigenSolver() << std::endl;
 
 } // end PrintSelf()
 
@@ -0,0 +1,208 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSymmetricEigenValuesClosedFormImageFilter_h
+#define __itkSymmetricEigenValuesClosedFormImageFilter_h
+
+#include "itkImageToImageFilter.h"
+#include "itkSymmetricEigenAnalysis.h"
+#include "vnl/vnl_math.h"
+#include <cmath>
+
+namespace itk
+{
+
+/** \class SymmetricEigenValuesClosedFormSolver
+ * \brief Computes the eigenvalues of many symmetric 2x2 or 3x3 matrices
+ * at once with an analytic formula.
+ *
+ * The matrices are passed as lanes: components[c][i] is the c-th unique
+ * component of matrix i, in the order of SymmetricSecondRankTensor, i.e.
+ * the upper triangle row by row. The eigenvalues are returned in
+ * increasing order, as SymmetricEigenAnalysis does with OrderByValue, in
+ * eigenValues[k][i]. The loop over the lanes has no data dependent
+ * branches, so that the compiler can vectorize it. All arithmetic is done
+ * in double precision.
+ *
+ * For 2x2 matrices the roots of the characteristic polynomial are used
+ * directly. For 3x3 matrices the trigonometric solution of the cubic is
+ * used (O.K. Smith, "Eigenvalues of a symmetric 3x3 matrix", Comm. ACM
+ * 4(4), 1961), on the shifted and scaled matrix (A - qI) / p.
+ *
+ * Other dimensions are not supported, which is reported by Supported.
+ */
+
+template< class TReal, unsigned int VDimension >
+class SymmetricEigenValuesClosedFormSolver
+{
+public:
+  static const bool Supported = false;
+  static void Compute( const TReal * const *, TReal * const *, SizeValueType ) {}
+};
+
+template< class TReal >
+class SymmetricEigenValuesClosedFormSolver< TReal, 2 >
+{
+public:
+  static const bool Supported = true;
+
+  static void Compute( const TReal * const * components,
+    TReal * const * eigenValues, SizeValueType numberOfLanes )
+  {
+    const TReal * a00 = components[ 0 ];
+    const TReal * a01 = components[ 1 ];
+    const TReal * a11 = components[ 2 ];
+    TReal * l0 = eigenValues[ 0 ];
+    TReal * l1 = eigenValues[ 1 ];
+
+    for ( SizeValueType i = 0; i < numberOfLanes; ++i )
+    {
+      const double mean = 0.5 * ( static_cast<double>( a00[ i ] ) + a11[ i ] );
+      const double half = 0.5 * ( static_cast<double>( a00[ i ] ) - a11[ i ] );
+      const double offDiagonal = a01[ i ];
+      const double radius = std::sqrt( half * half + offDiagonal * offDiagonal );
+      l0[ i ] = static_cast<TReal>( mean - radius );
+      l1[ i ] = static_cast<TReal>( mean + radius );
+    }
+  }
+};
+
+template< class TReal >
+class SymmetricEigenValuesClosedFormSolver< TReal, 3 >
+{
+public:
+  static const bool Supported = true;
+
+  static void Compute( const TReal * const * components,
+    TReal * const * eigenValues, SizeValueType numberOfLanes )
+  {
+    const TReal * a00 = components[ 0 ];
+    const TReal * a01 = components[ 1 ];
+    const TReal * a02 = components[ 2 ];
+    const TReal * a11 = components[ 3 ];
+    const TReal * a12 = components[ 4 ];
+    const TReal * a22 = components[ 5 ];
+    TReal * l0 = eigenValues[ 0 ];
+    TReal * l1 = eigenValues[ 1 ];
+    TReal * l2 = eigenValues[ 2 ];
+
+    const double third = 1.0 / 3.0;
+    const double twoPiThird = 2.0 * vnl_math::pi / 3.0;
+
+    for ( SizeValueType i = 0; i < numberOfLanes; ++i )
+    {
+      const double q = ( static_cast<double>( a00[ i ] ) + a11[ i ] + a22[ i ] ) * third;
+      const double b00 = a00[ i ] - q;
+      const double b11 = a11[ i ] - q;
+      const double b22 = a22[ i ] - q;
+      const double b01 = a01[ i ];
+      const double b02 = a02[ i ];
+      const double b12 = a12[ i ];
+
+      /** p is the root mean square of the eigenvalues of A - qI. */
+      const double offDiagonal = b01 * b01 + b02 * b02 + b12 * b12;
+      const double p = std::sqrt( ( b00 * b00 + b11 * b11 + b22 * b22
+        + 2.0 * offDiagonal ) / 6.0 );
+      const double invP = p > 0.0 ? 1.0 / p : 0.0;
+
+      /** r = det( ( A - qI ) / p ) / 2, clamped against round off. */
+      const double determinant
+        = b00 * ( b11 * b22 - b12 * b12 )
+        - b01 * ( b01 * b22 - b12 * b02 )
+        + b02 * ( b01 * b12 - b11 * b02 );
+      double r = 0.5 * determinant * invP * invP * invP;
+      r = r < -1.0 ? -1.0 : ( r > 1.0 ? 1.0 : r );
+
+      const double phi = std::acos( r ) * third;
+      const double largest = q + 2.0 * p * std::cos( phi );
+      const double smallest = q + 2.0 * p * std::cos( phi + twoPiThird );
+      l0[ i ] = static_cast<TReal>( smallest );
+      l1[ i ] = static_cast<TReal>( 3.0 * q - largest - smallest );
+      l2[ i ] = static_cast<TReal>( largest );
+    }
+  }
+};
+
+
+/** \class SymmetricEigenValuesClosedFormImageFilter
+ * \brief Computes the eigenvalues of an image of symmetric 2x2 or 3x3
+ * tensors, ordered by value.
+ *
+ * This is a faster alternative for SymmetricEigenAnalysisImageFilter with
+ * OrderByValue, when only the eigenvalues are needed. The pixels are
+ * processed in batches with SymmetricEigenValuesClosedFormSolver. For
+ * other dimensions it falls back to SymmetricEigenAnalysis.
+ *
+ * \sa SymmetricEigenAnalysisImageFilter
+ * \ingroup IntensityImageFilters TensorObjects Multithreaded
+ */
+
+template< class TInputImage, class TOutputImage >
+class SymmetricEigenValuesClosedFormImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SymmetricEigenValuesClosedFormImageFilter         Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SymmetricEigenValuesClosedFormImageFilter, ImageToImageFilter );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename InputImageType::PixelType          InputPixelType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename OutputPixelType::ValueType         RealType;
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, InputImageType::ImageDimension );
+
+  /** The solver, and the fall back. */
+  typedef SymmetricEigenValuesClosedFormSolver<
+    RealType, itkGetStaticConstMacro( ImageDimension ) >  SolverType;
+  typedef SymmetricEigenAnalysis<
+    InputPixelType, OutputPixelType >                     FallbackCalculatorType;
+
+protected:
+  SymmetricEigenValuesClosedFormImageFilter() {};
+  virtual ~SymmetricEigenValuesClosedFormImageFilter() {};
+
+  /** Computes the eigenvalues of the region in batches. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+private:
+  SymmetricEigenValuesClosedFormImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );                            // purposely not implemented
+
+}; // end class SymmetricEigenValuesClosedFormImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSymmetricEigenValuesClosedFormImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkSymmetricEigenValuesClosedFormImageFilter_h
@@ -0,0 +1,109 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSymmetricEigenValuesClosedFormImageFilter_hxx
+#define __itkSymmetricEigenValuesClosedFormImageFilter_hxx
+
+#include "itkSymmetricEigenValuesClosedFormImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkProgressReporter.h"
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ********************* ThreadedGenerateData ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SymmetricEigenValuesClosedFormImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+{
+  ImageRegionConstIterator<InputImageType> inputIt( this->GetInput(), outputRegionForThread );
+  ImageRegionIterator<OutputImageType> outputIt( this->GetOutput(), outputRegionForThread );
+
+  /** Fall back to the iterative solver. */
+  if ( !SolverType::Supported )
+  {
+    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+    FallbackCalculatorType calculator( ImageDimension );
+    calculator.SetOrderEigenValues( true );
+    OutputPixelType eigenValues;
+    while ( !inputIt.IsAtEnd() )
+    {
+      calculator.ComputeEigenValues( inputIt.Get(), eigenValues );
+      outputIt.Set( eigenValues );
+      ++inputIt; ++outputIt;
+      progress.CompletedPixel();
+    }
+    return;
+  }
+
+  /** Gather batches of tensors in lanes, solve, and scatter the eigenvalues. */
+  const unsigned int numberOfComponents = ImageDimension * ( ImageDimension + 1 ) / 2;
+  const SizeValueType numberOfLanes = 256;
+  ProgressReporter progress( this, threadId,
+    ( outputRegionForThread.GetNumberOfPixels() + numberOfLanes - 1 ) / numberOfLanes );
+  std::vector<RealType> componentBuffer( numberOfComponents * numberOfLanes );
+  std::vector<RealType> eigenValueBuffer( ImageDimension * numberOfLanes );
+  std::vector<const RealType *> components( numberOfComponents );
+  std::vector<RealType *> eigenValues( ImageDimension );
+  for ( unsigned int c = 0; c < numberOfComponents; ++c )
+  {
+    components[ c ] = &componentBuffer[ c * numberOfLanes ];
+  }
+  for ( unsigned int k = 0; k < ImageDimension; ++k )
+  {
+    eigenValues[ k ] = &eigenValueBuffer[ k * numberOfLanes ];
+  }
+
+  OutputPixelType value;
+  while ( !inputIt.IsAtEnd() )
+  {
+    SizeValueType lanes = 0;
+    for ( ; lanes < numberOfLanes && !inputIt.IsAtEnd(); ++lanes, ++inputIt )
+    {
+      const InputPixelType & tensor = inputIt.Value();
+      for ( unsigned int c = 0; c < numberOfComponents; ++c )
+      {
+        componentBuffer[ c * numberOfLanes + lanes ] = static_cast<RealType>( tensor[ c ] );
+      }
+    }
+
+    SolverType::Compute( &components[ 0 ], &eigenValues[ 0 ], lanes );
+
+    for ( SizeValueType i = 0; i < lanes; ++i, ++outputIt )
+    {
+      for ( unsigned int k = 0; k < ImageDimension; ++k )
+      {
+        value[ k ] = eigenValues[ k ][ i ];
+      }
+      outputIt.Set( value );
+    }
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkSymmetricEigenValuesClosedFormImageFilter_hxx
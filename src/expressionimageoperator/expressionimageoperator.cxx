@@ -0,0 +1,247 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Evaluate an expression over multiple images.
+
+ \verbinclude expressionimageoperator.help
+ */
+
+/** Setup Mevislab DicomTiff IO support */
+#include "itkUseMevisDicomTiff.h"
+
+#include "itkCommandLineArgumentParser.h"
+#include "ITKToolsHelpers.h"
+#include "ITKToolsImageProperties.h"
+#include "expressionimageoperator.h"
+
+
+/**
+ * ******************* GetHelpString *******************
+ */
+
+std::string GetHelpString( void )
+{
+  std::stringstream ss;
+  ss << "ITKTools v" << itktools::GetITKToolsVersion() << "\n"
+    << "Evaluates an arithmetic expression over multiple images, voxel by voxel.\n"
+    << "The whole expression is evaluated in a single streamed pass, without\n"
+    << "intermediate images.\n"
+    << "Usage:\npxexpressionimageoperator\n"
+    << "  -in      inputFilenames, referred to as a, b, c, ... in the expression\n"
+    << "  -out     outputFilename\n"
+    << "  -e       expression, e.g. \"sqrt( a*a + b*b )\" or \"select( a > 100, b, 0 )\"\n"
+    << "           operators: + - * / % ^ < <= > >= == != ! && ||\n"
+    << "           functions: log, ln, log10, exp, sqrt, sqr, abs, sign,\n"
+    << "             sin, cos, tan, asin, acos, atan, floor, ceil, round, erf,\n"
+    << "             min(x,y), max(x,y), pow(x,y), select(c,x,y)\n"
+    << "           constants: numbers and pi\n"
+    << "           Comparisons and logical operators give 0 or 1. Division by zero\n"
+    << "           leaves the numerator unchanged. All arithmetic is in double precision;\n"
+    << "           for an integer output type the result is clamped to its range.\n"
+    << "  [-z]     compression flag; if provided, the output image is compressed\n"
+    << "  [-s]     number of streams, default equals number of inputs.\n"
+    << "  [-opct]  output component type, by default the largest of the input images\n"
+    << "             choose one of: {[unsigned_]{char,short,int,long},float,double}\n"
+    << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
+
+  return ss.str();
+
+} // end GetHelpString()
+
+//-------------------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+  RegisterMevisDicomTiff();
+
+  /** Create a command line argument parser. */
+  itk::CommandLineArgumentParser::Pointer parser = itk::CommandLineArgumentParser::New();
+  parser->SetCommandLineArguments( argc, argv );
+  parser->SetProgramHelpText( GetHelpString() );
+
+  parser->MarkArgumentAsRequired( "-in", "The input filename." );
+  parser->MarkArgumentAsRequired( "-out", "The output filename." );
+  parser->MarkArgumentAsRequired( "-e", "The expression." );
+
+  itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
+
+  if( validateArguments == itk::CommandLineArgumentParser::FAILED )
+  {
+    return EXIT_FAILURE;
+  }
+  else if( validateArguments == itk::CommandLineArgumentParser::HELPREQUESTED )
+  {
+    return EXIT_SUCCESS;
+  }
+
+  /** Get arguments. */
+  std::vector<std::string> inputFileNames;
+  parser->GetCommandLineArgument( "-in", inputFileNames );
+
+  std::string outputFileName = "";
+  parser->GetCommandLineArgument( "-out", outputFileName );
+
+  std::string expression = "";
+  parser->GetCommandLineArgument( "-e", expression );
+
+  std::string opct = "";
+  bool retopct = parser->GetCommandLineArgument( "-opct", opct );
+
+  const bool useCompression = parser->ArgumentExists( "-z" );
+
+  /** Support for streaming. */
+  unsigned int numberOfStreams = inputFileNames.size();
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  /** Compile the expression, to report syntax errors before reading any image. */
+  itk::ExpressionProgram program;
+  try
+  {
+    program.Compile( expression );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Check the number of inputs. */
+  if( inputFileNames.size() < program.GetNumberOfVariables() )
+  {
+    std::cerr << "ERROR: The expression uses " << program.GetNumberOfVariables()
+      << " input images, but only " << inputFileNames.size()
+      << " are given." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Determine image properties. The inputs should be scalar images of
+   * the same dimension and size.
+   */
+  itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+  itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  itk::ImageIOBase::IOComponentType componentTypeOut = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  itk::ImageIOBase::IOComponentType componentTypeIn = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  unsigned int dim = 2;
+  unsigned int numberOfComponents = 1;
+  std::vector<unsigned int> imageSize0;
+  std::vector<unsigned int> imageSize;
+  for( unsigned int i = 0; i < inputFileNames.size(); ++i )
+  {
+    unsigned int dim_i = 2;
+    bool retgip = itktools::GetImageProperties(
+      inputFileNames[ i ], pixelType, componentType, dim_i, numberOfComponents, imageSize );
+    if( !retgip ) return EXIT_FAILURE;
+
+    if( numberOfComponents > 1 )
+    {
+      std::cerr << "ERROR: The NumberOfComponents is larger than 1!" << std::endl;
+      std::cerr << "Vector images are not supported." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if( i == 0 )
+    {
+      dim = dim_i;
+      imageSize0 = imageSize;
+      componentTypeOut = componentType;
+      componentTypeIn = componentType;
+    }
+    else if( dim_i != dim || imageSize != imageSize0 )
+    {
+      std::cerr << "ERROR: the input images have different sizes." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** The inputs are read in their own type only if they all have the same type. */
+    if( componentType != componentTypeIn )
+    {
+      componentTypeIn = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+    }
+
+    /** The output type is the largest of the input types. */
+    componentTypeOut = itktools::GetLargestComponentType( componentTypeOut, componentType );
+  }
+
+  /** Let the user override the output component type. */
+  if( retopct )
+  {
+    componentTypeOut = itk::ImageIOBase::GetComponentTypeFromString( opct );
+    if( !itktools::ComponentTypeIsValid( componentTypeOut ) )
+    {
+      std::cerr << "ERROR: the you specified an invalid opct." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Class that does the work. */
+  ITKToolsExpressionImageOperatorBase * filter = NULL;
+
+  try
+  {
+    // now call all possible template combinations.
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, char >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, unsigned char >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, short >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, unsigned short >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, int >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, unsigned int >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, long >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, unsigned long >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, float >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 2, double >::New( dim, componentTypeOut );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, char >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, unsigned char >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, short >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, unsigned short >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, int >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, unsigned int >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, long >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, unsigned long >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, float >::New( dim, componentTypeOut );
+    if( !filter ) filter = ITKToolsExpressionImageOperator< 3, double >::New( dim, componentTypeOut );
+#endif
+    /** Check if filter was instantiated. */
+    bool supported = itktools::IsFilterSupportedCheck( filter, dim, componentTypeOut );
+    if( !supported ) return EXIT_FAILURE;
+
+    /** Set the filter arguments. */
+    filter->m_InputFileNames = inputFileNames;
+    filter->m_OutputFileName = outputFileName;
+    filter->m_Expression = expression;
+    filter->m_UseCompression = useCompression;
+    filter->m_NumberOfStreams = numberOfStreams;
+    filter->m_InputComponentType = componentTypeIn;
+    filter->m_Program = program;
+
+    filter->Run();
+
+    delete filter;
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    delete filter;
+    return EXIT_FAILURE;
+  }
+
+  /** End program. */
+  return EXIT_SUCCESS;
+
+} // end main
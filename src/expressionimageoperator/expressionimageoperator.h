@@ -0,0 +1,174 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __expressionimageoperator_h_
+#define __expressionimageoperator_h_
+
+#include "ITKToolsBase.h"
+#include "ITKToolsHelpers.h"
+
+#include "itkImage.h"
+#include "itkExpressionImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
+#include "itkImageIOBase.h"
+#include "itkStreamingImageFilter.h"
+
+#include <vector>
+
+
+/** \class ITKToolsExpressionImageOperatorBase
+ *
+ * Untemplated pure virtual base class that holds
+ * the Run() function and all required parameters.
+ */
+
+class ITKToolsExpressionImageOperatorBase : public itktools::ITKToolsBase
+{
+public:
+  /** Constructor. */
+  ITKToolsExpressionImageOperatorBase()
+  {
+    this->m_OutputFileName = "";
+    this->m_Expression = "";
+    this->m_UseCompression = false;
+    this->m_NumberOfStreams = 0;
+    this->m_InputComponentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  };
+  /** Destructor. */
+  ~ITKToolsExpressionImageOperatorBase(){};
+
+  /** Input member parameters. */
+  std::vector<std::string> m_InputFileNames;
+  std::string       m_OutputFileName;
+  std::string       m_Expression;
+  bool              m_UseCompression;
+  unsigned int      m_NumberOfStreams;
+
+  /** The component type of the inputs, unknown if they differ. */
+  itk::ImageIOBase::IOComponentType m_InputComponentType;
+
+  /** The expression, compiled by main. */
+  itk::ExpressionProgram m_Program;
+
+}; // end class ITKToolsExpressionImageOperatorBase
+
+
+/** \class ITKToolsExpressionImageOperator
+ *
+ * Templated class that implements the Run() function
+ * and the New() function for its creation.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+class ITKToolsExpressionImageOperator : public ITKToolsExpressionImageOperatorBase
+{
+public:
+  /** Standard ITKTools stuff. */
+  typedef ITKToolsExpressionImageOperator Self;
+  itktoolsOneTypeNewMacro( Self );
+
+  ITKToolsExpressionImageOperator(){};
+  ~ITKToolsExpressionImageOperator(){};
+
+  /** Run function. */
+  void Run( void )
+  {
+    /** The inputs are read in their own type if they all have the same
+     * type and it is the output type, which is the default. Otherwise,
+     * e.g. for mixed inputs or with -opct, they are read as double. The
+     * filter converts to double per block.
+     */
+    if( itktools::IsType<TComponentType>( this->m_InputComponentType ) )
+    {
+      this->template RunWithInputType<TComponentType>();
+    }
+    else
+    {
+      this->template RunWithInputType<double>();
+    }
+
+  } // end Run()
+
+protected:
+
+  /** Run the pipeline, reading the inputs with pixel type TInputComponentType. */
+  template< class TInputComponentType >
+  void RunWithInputType( void )
+  {
+    /** Typedefs. */
+    typedef itk::Image< TInputComponentType, VDimension >   InputImageType;
+    typedef itk::Image< TComponentType, VDimension >        OutputImageType;
+    typedef itk::ImageFileReader< InputImageType >          ReaderType;
+    typedef itk::ExpressionImageFilter<
+      InputImageType, OutputImageType >                     ExpressionFilterType;
+    typedef itk::ImageFileWriter< OutputImageType >         WriterType;
+    typedef itk::StreamingImageFilter<
+      OutputImageType, OutputImageType >                    StreamerType;
+
+    /** Set up the expression filter with the compiled expression. */
+    typename ExpressionFilterType::Pointer expressionFilter = ExpressionFilterType::New();
+    expressionFilter->SetProgram( this->m_Program );
+
+    /** Read the input images that are used by the expression. The readers
+     * only read the requested piece, if the file format supports it.
+     */
+    const unsigned int numberOfVariables = this->m_Program.GetNumberOfVariables();
+    const unsigned int numberOfInputs = numberOfVariables > 0 ? numberOfVariables : 1;
+    std::vector<typename ReaderType::Pointer> readers( numberOfInputs );
+    for( unsigned int i = 0; i < numberOfInputs; ++i )
+    {
+      readers[ i ] = ReaderType::New();
+      readers[ i ]->SetFileName( this->m_InputFileNames[ i ] );
+      readers[ i ]->SetUseStreaming( true );
+      expressionFilter->SetInput( i, readers[ i ]->GetOutput() );
+    }
+
+    /** Write the image to disk. The pipeline is driven slab by slab by
+     * the writer, or by a streamer if the output can not be written in
+     * pieces, as in pxnaryimageoperator.
+     */
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+
+    itk::ImageIOBase::Pointer outputIO = itk::ImageIOFactory::CreateImageIO(
+      this->m_OutputFileName.c_str(), itk::ImageIOFactory::WriteMode );
+    const bool canStreamWrite = outputIO.IsNotNull()
+      && outputIO->CanStreamWrite() && !this->m_UseCompression;
+
+    typename StreamerType::Pointer streamer = StreamerType::New();
+    if( canStreamWrite || this->m_NumberOfStreams < 2 )
+    {
+      writer->SetInput( expressionFilter->GetOutput() );
+    }
+    else
+    {
+      streamer->SetInput( expressionFilter->GetOutput() );
+      streamer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+      writer->SetInput( streamer->GetOutput() );
+    }
+    writer->Update();
+
+  } // end RunWithInputType()
+
+}; // end class ITKToolsExpressionImageOperator
+
+
+#endif // end #ifndef __expressionimageoperator_h_
@@ -0,0 +1,118 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkExpressionImageFilter_h_
+#define __itkExpressionImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+#include "itkExpressionProgram.h"
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ExpressionImageFilter
+ * \brief Evaluates an arithmetic expression over several images voxel by
+ * voxel, in a single pass.
+ *
+ * The expression is compiled by ExpressionProgram; the variables a, b, ...
+ * refer to input 0, 1, .... Instead of chaining a filter per operation,
+ * which makes a full temporary image per intermediate result, the whole
+ * expression is evaluated per block of voxels: the values of the inputs
+ * are gathered in a small buffer, the program is run on the block, and
+ * the result is cast to the output pixel type. All arithmetic is in
+ * double precision. For integer output types the result is clamped to
+ * the range of the type; NaN gives zero.
+ *
+ * All inputs must have the same size. The filter supports streaming.
+ *
+ * \sa ExpressionProgram
+ * \ingroup IntensityImageFilters Multithreaded
+ */
+
+template< class TInputImage, class TOutputImage >
+class ExpressionImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ExpressionImageFilter                             Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ExpressionImageFilter, ImageToImageFilter );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename InputImageType::PixelType          InputPixelType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+
+  /** Set the expression. Throws an exception on a syntax error. */
+  void SetExpression( const std::string & expression );
+  itkGetStringMacro( Expression );
+
+  /** Set an already compiled expression, which avoids compiling it again. */
+  void SetProgram( const ExpressionProgram & program );
+
+  /** Get the compiled expression. */
+  const ExpressionProgram & GetProgram( void ) const
+  { return this->m_Program; }
+
+  /** Set the number of voxels evaluated at once, default 256. */
+  itkSetMacro( BlockSize, unsigned int );
+  itkGetConstMacro( BlockSize, unsigned int );
+
+protected:
+  ExpressionImageFilter();
+  virtual ~ExpressionImageFilter() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Checks the inputs and allocates the buffers of the threads. */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Evaluates the expression on the region in blocks. */
+  virtual void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+private:
+  ExpressionImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );        // purposely not implemented
+
+  std::string         m_Expression;
+  ExpressionProgram   m_Program;
+  unsigned int        m_BlockSize;
+
+  /** Per thread: the values of the variables, the stack and the result. */
+  std::vector< std::vector<double> >  m_ThreadBuffers;
+
+}; // end class ExpressionImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkExpressionImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkExpressionImageFilter_h_
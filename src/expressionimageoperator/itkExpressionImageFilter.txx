@@ -0,0 +1,227 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkExpressionImageFilter_txx_
+#define __itkExpressionImageFilter_txx_
+
+#include "itkExpressionImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkProgressReporter.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+ExpressionImageFilter< TInputImage, TOutputImage >
+::ExpressionImageFilter()
+{
+  this->m_BlockSize = 256;
+
+} // end Constructor()
+
+
+/**
+ * ******************* SetExpression *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ExpressionImageFilter< TInputImage, TOutputImage >
+::SetExpression( const std::string & expression )
+{
+  if( expression == this->m_Expression ) return;
+
+  this->m_Program.Compile( expression );
+  this->m_Expression = expression;
+  this->Modified();
+
+} // end SetExpression()
+
+
+/**
+ * ******************* SetProgram *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ExpressionImageFilter< TInputImage, TOutputImage >
+::SetProgram( const ExpressionProgram & program )
+{
+  this->m_Program = program;
+  this->m_Expression = program.GetExpression();
+  this->Modified();
+
+} // end SetProgram()
+
+
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ExpressionImageFilter< TInputImage, TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  const unsigned int numberOfVariables = this->m_Program.GetNumberOfVariables();
+  if( this->m_Program.GetInstructions().empty() )
+  {
+    itkExceptionMacro( << "ERROR: no expression has been set." );
+  }
+  if( this->GetNumberOfInputs() < numberOfVariables )
+  {
+    itkExceptionMacro( << "ERROR: the expression uses " << numberOfVariables
+      << " inputs, but only " << this->GetNumberOfInputs() << " are given." );
+  }
+  for( unsigned int i = 0; i < numberOfVariables; ++i )
+  {
+    if( this->GetInput( i ) == 0 )
+    {
+      itkExceptionMacro( << "ERROR: input " << i << " is not set." );
+    }
+  }
+  if( this->m_BlockSize == 0 ) this->m_BlockSize = 1;
+
+  /** Allocate the buffers once, instead of in every thread. */
+  const unsigned int bufferSize = this->m_BlockSize
+    * ( numberOfVariables + this->m_Program.GetStackDepth() + 1 );
+  this->m_ThreadBuffers.resize( this->GetNumberOfThreads() );
+  for( unsigned int t = 0; t < this->m_ThreadBuffers.size(); ++t )
+  {
+    this->m_ThreadBuffers[ t ].resize( bufferSize );
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ExpressionImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId )
+{
+  typedef ImageRegionConstIterator<InputImageType>  InputIteratorType;
+  typedef ImageRegionIterator<OutputImageType>      OutputIteratorType;
+
+  const unsigned int numberOfVariables = this->m_Program.GetNumberOfVariables();
+  const unsigned int blockSize = this->m_BlockSize;
+
+  /** Divide the buffer of this thread. */
+  double * buffer = &this->m_ThreadBuffers[ threadId ][ 0 ];
+  std::vector<const double *> variables( numberOfVariables );
+  for( unsigned int v = 0; v < numberOfVariables; ++v )
+  {
+    variables[ v ] = buffer + v * blockSize;
+  }
+  double * result = buffer + numberOfVariables * blockSize;
+  double * stack = result + blockSize;
+
+  /** Set up the iterators. */
+  std::vector<InputIteratorType> inputIts;
+  for( unsigned int v = 0; v < numberOfVariables; ++v )
+  {
+    inputIts.push_back( InputIteratorType( this->GetInput( v ), outputRegionForThread ) );
+  }
+  OutputIteratorType outputIt( this->GetOutput(), outputRegionForThread );
+
+  /** The range of the output type, to clamp the result of integer types.
+   * The limits are compared before casting, since the maximum of the 64 bit
+   * types is not exactly representable as a double.
+   */
+  const bool clampOutput = NumericTraits<OutputPixelType>::is_integer;
+  const double outputMinimum = static_cast<double>(
+    NumericTraits<OutputPixelType>::NonpositiveMin() );
+  const double outputMaximum = static_cast<double>(
+    NumericTraits<OutputPixelType>::max() );
+
+  ProgressReporter progress( this, threadId,
+    ( outputRegionForThread.GetNumberOfPixels() + blockSize - 1 ) / blockSize );
+
+  /** Gather a block of every input, evaluate, and scatter the result. */
+  while( !outputIt.IsAtEnd() )
+  {
+    unsigned int lanes = 0;
+    OutputIteratorType blockIt = outputIt;
+    for( ; lanes < blockSize && !blockIt.IsAtEnd(); ++lanes, ++blockIt ) {}
+
+    for( unsigned int v = 0; v < numberOfVariables; ++v )
+    {
+      double * values = buffer + v * blockSize;
+      InputIteratorType & it = inputIts[ v ];
+      for( unsigned int i = 0; i < lanes; ++i, ++it )
+      {
+        values[ i ] = static_cast<double>( it.Get() );
+      }
+    }
+
+    this->m_Program.Evaluate( variables.empty() ? 0 : &variables[ 0 ],
+      result, lanes, stack );
+
+    if( clampOutput )
+    {
+      for( unsigned int i = 0; i < lanes; ++i, ++outputIt )
+      {
+        const double value = result[ i ];
+        if( value != value ) outputIt.Set( NumericTraits<OutputPixelType>::Zero );
+        else if( value <= outputMinimum ) outputIt.Set( NumericTraits<OutputPixelType>::NonpositiveMin() );
+        else if( value >= outputMaximum ) outputIt.Set( NumericTraits<OutputPixelType>::max() );
+        else outputIt.Set( static_cast<OutputPixelType>( value ) );
+      }
+    }
+    else
+    {
+      for( unsigned int i = 0; i < lanes; ++i, ++outputIt )
+      {
+        outputIt.Set( static_cast<OutputPixelType>( result[ i ] ) );
+      }
+    }
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+ExpressionImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Expression: " << this->m_Expression << std::endl;
+  os << indent << "BlockSize: " << this->m_BlockSize << std::endl;
+  os << indent << "Program:\n" << this->m_Program.ToString();
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkExpressionImageFilter_txx_
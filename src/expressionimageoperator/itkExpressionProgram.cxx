@@ -0,0 +1,665 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "itkExpressionProgram.h"
+#include "itkMacro.h"
+#include "itkUnaryFunctorImageFilter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "../unaryimageoperator/itkUnaryFunctors.h"
+
+namespace itk
+{
+
+namespace
+{
+
+/** Apply one of the unary functors of pxunaryimageoperator to a block. */
+template< class TFunctor >
+inline void ApplyFunctor( double * a, unsigned int lanes )
+{
+  TFunctor functor;
+  for( unsigned int i = 0; i < lanes; ++i )
+  {
+    a[ i ] = functor( a[ i ] );
+  }
+}
+
+/** The functions, their names and their instructions. */
+struct FunctionEntry
+{
+  const char *                    Name;
+  ExpressionProgram::OpCodeType   OpCode;
+};
+
+const FunctionEntry functionTable[] = {
+  { "log", ExpressionProgram::Log },
+  { "ln", ExpressionProgram::Log },
+  { "log10", ExpressionProgram::Log10 },
+  { "exp", ExpressionProgram::Exp },
+  { "sqrt", ExpressionProgram::Sqrt },
+  { "sqr", ExpressionProgram::Sqr },
+  { "abs", ExpressionProgram::Abs },
+  { "sign", ExpressionProgram::Sign },
+  { "sin", ExpressionProgram::Sin },
+  { "cos", ExpressionProgram::Cos },
+  { "tan", ExpressionProgram::Tan },
+  { "asin", ExpressionProgram::ArcSin },
+  { "acos", ExpressionProgram::ArcCos },
+  { "atan", ExpressionProgram::ArcTan },
+  { "floor", ExpressionProgram::Floor },
+  { "ceil", ExpressionProgram::Ceil },
+  { "round", ExpressionProgram::Round },
+  { "erf", ExpressionProgram::Erf },
+  { "min", ExpressionProgram::Minimum },
+  { "max", ExpressionProgram::Maximum },
+  { "pow", ExpressionProgram::Power },
+  { "select", ExpressionProgram::Select },
+  { 0, ExpressionProgram::PushConstant }
+};
+
+/** Names for ToString(), in the order of OpCodeType. */
+const char * const opCodeNames[] = {
+  "push", "var",
+  "neg", "not", "log", "log10", "exp", "sqrt", "sqr", "abs", "sign",
+  "sin", "cos", "tan", "asin", "acos", "atan", "floor", "ceil", "round", "erf",
+  "add", "sub", "mul", "div", "mod", "pow", "min", "max",
+  "lt", "le", "gt", "ge", "eq", "ne", "and", "or",
+  "select"
+};
+
+} // end namespace
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+ExpressionProgram::ExpressionProgram()
+{
+  this->m_Position = 0;
+  this->m_NumberOfVariables = 0;
+  this->m_StackDepth = 0;
+
+} // end Constructor()
+
+
+/**
+ * ******************* Compile *******************
+ */
+
+void
+ExpressionProgram::Compile( const std::string & expression )
+{
+  this->m_Expression = expression;
+  this->m_Position = 0;
+  this->m_Instructions.clear();
+  this->m_NumberOfVariables = 0;
+  this->m_StackDepth = 0;
+
+  /** Skip an assignment like "out =". */
+  this->SkipWhiteSpace();
+  std::string::size_type pos = this->m_Position;
+  while( pos < expression.size()
+    && ( std::isalnum( expression[ pos ] ) || expression[ pos ] == '_' ) ) ++pos;
+  while( pos < expression.size() && std::isspace( expression[ pos ] ) ) ++pos;
+  if( pos > this->m_Position && pos + 1 < expression.size()
+    && expression[ pos ] == '=' && expression[ pos + 1 ] != '=' )
+  {
+    this->m_Position = pos + 1;
+  }
+
+  /** Parse the expression. */
+  this->ParseOr();
+  this->SkipWhiteSpace();
+  if( this->m_Position != expression.size() )
+  {
+    this->SyntaxError( "unexpected character" );
+  }
+
+  /** Determine the stack depth. */
+  unsigned int depth = 0;
+  for( unsigned int i = 0; i < this->m_Instructions.size(); ++i )
+  {
+    const OpCodeType op = this->m_Instructions[ i ].OpCode;
+    if( op == PushConstant || op == PushVariable )
+    {
+      ++depth;
+      if( depth > this->m_StackDepth ) this->m_StackDepth = depth;
+    }
+    else
+    {
+      depth -= GetArity( op ) - 1;
+    }
+  }
+
+} // end Compile()
+
+
+/**
+ * ******************* ToString *******************
+ */
+
+std::string
+ExpressionProgram::ToString( void ) const
+{
+  std::ostringstream ss;
+  for( unsigned int i = 0; i < this->m_Instructions.size(); ++i )
+  {
+    const Instruction & instruction = this->m_Instructions[ i ];
+    ss << opCodeNames[ instruction.OpCode ];
+    if( instruction.OpCode == PushConstant )
+    {
+      ss << " " << instruction.Value;
+    }
+    else if( instruction.OpCode == PushVariable )
+    {
+      ss << " " << static_cast<char>( 'a' + instruction.Index );
+    }
+    ss << "\n";
+  }
+  return ss.str();
+
+} // end ToString()
+
+
+/**
+ * ******************* Evaluate *******************
+ */
+
+void
+ExpressionProgram::Evaluate( const double * const * variables, double * result,
+  unsigned int lanes, double * stack ) const
+{
+  unsigned int top = 0;
+  for( unsigned int i = 0; i < this->m_Instructions.size(); ++i )
+  {
+    const Instruction & instruction = this->m_Instructions[ i ];
+    if( instruction.OpCode == PushConstant )
+    {
+      std::fill( stack + top * lanes, stack + ( top + 1 ) * lanes, instruction.Value );
+      ++top;
+    }
+    else if( instruction.OpCode == PushVariable )
+    {
+      const double * v = variables[ instruction.Index ];
+      std::copy( v, v + lanes, stack + top * lanes );
+      ++top;
+    }
+    else
+    {
+      const unsigned int arity = GetArity( instruction.OpCode );
+      double * a = stack + ( top - arity ) * lanes;
+      Apply( instruction.OpCode, a, a + lanes, a + 2 * lanes, lanes );
+      top -= arity - 1;
+    }
+  }
+  std::copy( stack, stack + lanes, result );
+
+} // end Evaluate()
+
+
+/**
+ * ******************* GetArity *******************
+ */
+
+unsigned int
+ExpressionProgram::GetArity( OpCodeType op )
+{
+  if( op == PushConstant || op == PushVariable ) return 0;
+  if( op < Add ) return 1;
+  if( op < Select ) return 2;
+  return 3;
+
+} // end GetArity()
+
+
+/**
+ * ******************* Apply *******************
+ */
+
+void
+ExpressionProgram::Apply( OpCodeType op, double * a, const double * b,
+  const double * c, unsigned int lanes )
+{
+  unsigned int i = 0;
+  switch( op )
+  {
+    case Negate:
+      for( i = 0; i < lanes; ++i ) a[ i ] = -a[ i ];
+      break;
+    case Not:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] == 0.0 ? 1.0 : 0.0;
+      break;
+    case Log:     ApplyFunctor< Functor::LN<double> >( a, lanes ); break;
+    case Log10:   ApplyFunctor< Functor::LOG10<double> >( a, lanes ); break;
+    case Exp:     ApplyFunctor< Functor::EXP<double> >( a, lanes ); break;
+    case Sqrt:    ApplyFunctor< Functor::SQRT<double> >( a, lanes ); break;
+    case Sqr:     ApplyFunctor< Functor::SQR<double> >( a, lanes ); break;
+    case Abs:     ApplyFunctor< Functor::ABSDOUBLE<double> >( a, lanes ); break;
+    case Sign:    ApplyFunctor< Functor::SIGNDOUBLE<double> >( a, lanes ); break;
+    case Sin:     ApplyFunctor< Functor::SIN<double> >( a, lanes ); break;
+    case Cos:     ApplyFunctor< Functor::COS<double> >( a, lanes ); break;
+    case Tan:     ApplyFunctor< Functor::TAN<double> >( a, lanes ); break;
+    case ArcSin:  ApplyFunctor< Functor::ARCSIN<double> >( a, lanes ); break;
+    case ArcCos:  ApplyFunctor< Functor::ARCCOS<double> >( a, lanes ); break;
+    case ArcTan:  ApplyFunctor< Functor::ARCTAN<double> >( a, lanes ); break;
+    case Floor:   ApplyFunctor< Functor::FLOOR<double> >( a, lanes ); break;
+    case Ceil:    ApplyFunctor< Functor::CEIL<double> >( a, lanes ); break;
+    case Round:   ApplyFunctor< Functor::ROUND<double> >( a, lanes ); break;
+    case Erf:     ApplyFunctor< Functor::ERRFUNC<double> >( a, lanes ); break;
+    case Add:
+      for( i = 0; i < lanes; ++i ) a[ i ] += b[ i ];
+      break;
+    case Subtract:
+      for( i = 0; i < lanes; ++i ) a[ i ] -= b[ i ];
+      break;
+    case Multiply:
+      for( i = 0; i < lanes; ++i ) a[ i ] *= b[ i ];
+      break;
+    case Divide:
+      for( i = 0; i < lanes; ++i ) a[ i ] = b[ i ] != 0.0 ? a[ i ] / b[ i ] : a[ i ];
+      break;
+    case Modulo:
+      for( i = 0; i < lanes; ++i ) a[ i ] = b[ i ] != 0.0 ? std::fmod( a[ i ], b[ i ] ) : a[ i ];
+      break;
+    case Power:
+      for( i = 0; i < lanes; ++i ) a[ i ] = std::pow( a[ i ], b[ i ] );
+      break;
+    case Minimum:
+      for( i = 0; i < lanes; ++i ) a[ i ] = b[ i ] < a[ i ] ? b[ i ] : a[ i ];
+      break;
+    case Maximum:
+      for( i = 0; i < lanes; ++i ) a[ i ] = b[ i ] > a[ i ] ? b[ i ] : a[ i ];
+      break;
+    case Less:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] < b[ i ] ? 1.0 : 0.0;
+      break;
+    case LessEqual:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] <= b[ i ] ? 1.0 : 0.0;
+      break;
+    case Greater:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] > b[ i ] ? 1.0 : 0.0;
+      break;
+    case GreaterEqual:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] >= b[ i ] ? 1.0 : 0.0;
+      break;
+    case Equal:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] == b[ i ] ? 1.0 : 0.0;
+      break;
+    case NotEqual:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] != b[ i ] ? 1.0 : 0.0;
+      break;
+    case And:
+      for( i = 0; i < lanes; ++i ) a[ i ] = ( a[ i ] != 0.0 && b[ i ] != 0.0 ) ? 1.0 : 0.0;
+      break;
+    case Or:
+      for( i = 0; i < lanes; ++i ) a[ i ] = ( a[ i ] != 0.0 || b[ i ] != 0.0 ) ? 1.0 : 0.0;
+      break;
+    case Select:
+      for( i = 0; i < lanes; ++i ) a[ i ] = a[ i ] != 0.0 ? b[ i ] : c[ i ];
+      break;
+    default:
+      break;
+  }
+
+} // end Apply()
+
+
+/**
+ * ******************* Parser *******************
+ */
+
+void
+ExpressionProgram::ParseOr( void )
+{
+  this->ParseAnd();
+  while( this->Accept( "||" ) )
+  {
+    this->ParseAnd();
+    this->Emit( Or );
+  }
+
+} // end ParseOr()
+
+
+void
+ExpressionProgram::ParseAnd( void )
+{
+  this->ParseComparison();
+  while( this->Accept( "&&" ) )
+  {
+    this->ParseComparison();
+    this->Emit( And );
+  }
+
+} // end ParseAnd()
+
+
+void
+ExpressionProgram::ParseComparison( void )
+{
+  this->ParseAdditive();
+  while( true )
+  {
+    OpCodeType op;
+    if( this->Accept( "<=" ) ) op = LessEqual;
+    else if( this->Accept( ">=" ) ) op = GreaterEqual;
+    else if( this->Accept( "==" ) ) op = Equal;
+    else if( this->Accept( "!=" ) ) op = NotEqual;
+    else if( this->Accept( "<" ) ) op = Less;
+    else if( this->Accept( ">" ) ) op = Greater;
+    else break;
+    this->ParseAdditive();
+    this->Emit( op );
+  }
+
+} // end ParseComparison()
+
+
+void
+ExpressionProgram::ParseAdditive( void )
+{
+  this->ParseMultiplicative();
+  while( true )
+  {
+    OpCodeType op;
+    if( this->Accept( "+" ) ) op = Add;
+    else if( this->Accept( "-" ) ) op = Subtract;
+    else break;
+    this->ParseMultiplicative();
+    this->Emit( op );
+  }
+
+} // end ParseAdditive()
+
+
+void
+ExpressionProgram::ParseMultiplicative( void )
+{
+  this->ParseUnary();
+  while( true )
+  {
+    OpCodeType op;
+    if( this->Accept( "*" ) ) op = Multiply;
+    else if( this->Accept( "/" ) ) op = Divide;
+    else if( this->Accept( "%" ) ) op = Modulo;
+    else break;
+    this->ParseUnary();
+    this->Emit( op );
+  }
+
+} // end ParseMultiplicative()
+
+
+void
+ExpressionProgram::ParseUnary( void )
+{
+  if( this->Accept( "-" ) )
+  {
+    this->ParseUnary();
+    this->Emit( Negate );
+  }
+  else if( this->Accept( "+" ) )
+  {
+    this->ParseUnary();
+  }
+  else if( this->Accept( "!" ) )
+  {
+    this->ParseUnary();
+    this->Emit( Not );
+  }
+  else
+  {
+    this->ParsePower();
+  }
+
+} // end ParseUnary()
+
+
+void
+ExpressionProgram::ParsePower( void )
+{
+  /** Right associative, and binding stronger than a unary minus on the left. */
+  this->ParsePrimary();
+  if( this->Accept( "^" ) )
+  {
+    this->ParseUnary();
+    this->Emit( Power );
+  }
+
+} // end ParsePower()
+
+
+void
+ExpressionProgram::ParsePrimary( void )
+{
+  this->SkipWhiteSpace();
+  if( this->m_Position >= this->m_Expression.size() )
+  {
+    this->SyntaxError( "unexpected end of the expression" );
+  }
+
+  const char current = this->m_Expression[ this->m_Position ];
+
+  /** A sub expression. */
+  if( current == '(' )
+  {
+    ++this->m_Position;
+    this->ParseOr();
+    this->Expect( ")" );
+    return;
+  }
+
+  /** A number. */
+  if( std::isdigit( current ) || current == '.' )
+  {
+    const char * begin = this->m_Expression.c_str() + this->m_Position;
+    char * end = 0;
+    const double value = std::strtod( begin, &end );
+    if( end == begin ) this->SyntaxError( "invalid number" );
+    this->m_Position += end - begin;
+    this->EmitConstant( value );
+    return;
+  }
+
+  /** A variable, a constant or a function. */
+  if( std::isalpha( current ) )
+  {
+    const std::string::size_type begin = this->m_Position;
+    while( this->m_Position < this->m_Expression.size()
+      && ( std::isalnum( this->m_Expression[ this->m_Position ] )
+      || this->m_Expression[ this->m_Position ] == '_' ) )
+    {
+      ++this->m_Position;
+    }
+    const std::string name = this->m_Expression.substr( begin, this->m_Position - begin );
+
+    if( name.size() == 1 && std::islower( current ) )
+    {
+      this->EmitVariable( current - 'a' );
+      return;
+    }
+    if( name == "pi" )
+    {
+      this->EmitConstant( 3.14159265358979323846 );
+      return;
+    }
+
+    for( unsigned int f = 0; functionTable[ f ].Name; ++f )
+    {
+      if( name == functionTable[ f ].Name )
+      {
+        const OpCodeType op = functionTable[ f ].OpCode;
+        const unsigned int arity = GetArity( op );
+        this->Expect( "(" );
+        for( unsigned int arg = 0; arg < arity; ++arg )
+        {
+          if( arg > 0 ) this->Expect( "," );
+          this->ParseOr();
+        }
+        this->Expect( ")" );
+        this->Emit( op );
+        return;
+      }
+    }
+
+    this->m_Position = begin;
+    this->SyntaxError( "unknown function or variable \"" + name + "\"" );
+  }
+
+  this->SyntaxError( "unexpected character" );
+
+} // end ParsePrimary()
+
+
+/**
+ * ******************* Parser helpers *******************
+ */
+
+void
+ExpressionProgram::SkipWhiteSpace( void )
+{
+  while( this->m_Position < this->m_Expression.size()
+    && std::isspace( this->m_Expression[ this->m_Position ] ) )
+  {
+    ++this->m_Position;
+  }
+
+} // end SkipWhiteSpace()
+
+
+bool
+ExpressionProgram::Accept( const char * token )
+{
+  this->SkipWhiteSpace();
+  const std::string::size_type length = std::strlen( token );
+  if( this->m_Expression.compare( this->m_Position, length, token ) != 0 )
+  {
+    return false;
+  }
+
+  /** Do not take the first character of a two character operator. */
+  const std::string::size_type next = this->m_Position + length;
+  if( length == 1 && next < this->m_Expression.size() )
+  {
+    const char c = this->m_Expression[ next ];
+    if( ( token[ 0 ] == '!' || token[ 0 ] == '<' || token[ 0 ] == '>' ) && c == '=' )
+    {
+      return false;
+    }
+  }
+
+  this->m_Position = next;
+  return true;
+
+} // end Accept()
+
+
+void
+ExpressionProgram::Expect( const char * token )
+{
+  if( !this->Accept( token ) )
+  {
+    this->SyntaxError( std::string( "expected \"" ) + token + "\"" );
+  }
+
+} // end Expect()
+
+
+void
+ExpressionProgram::SyntaxError( const std::string & message ) const
+{
+  itkGenericExceptionMacro( << "Syntax error in expression \"" << this->m_Expression
+    << "\" at position " << this->m_Position << ": " << message );
+
+} // end SyntaxError()
+
+
+/**
+ * ******************* Emit *******************
+ */
+
+void
+ExpressionProgram::Emit( OpCodeType op )
+{
+  /** Fold the operation if all operands are constants. */
+  const unsigned int arity = GetArity( op );
+  const unsigned int size = this->m_Instructions.size();
+  bool constant = size >= arity;
+  for( unsigned int k = 0; constant && k < arity; ++k )
+  {
+    constant = this->m_Instructions[ size - arity + k ].OpCode == PushConstant;
+  }
+  if( constant )
+  {
+    double operands[ 3 ] = { 0.0, 0.0, 0.0 };
+    for( unsigned int k = 0; k < arity; ++k )
+    {
+      operands[ k ] = this->m_Instructions[ size - arity + k ].Value;
+    }
+    Apply( op, &operands[ 0 ], &operands[ 1 ], &operands[ 2 ], 1 );
+    this->m_Instructions.resize( size - arity );
+    this->EmitConstant( operands[ 0 ] );
+    return;
+  }
+
+  Instruction instruction;
+  instruction.OpCode = op;
+  instruction.Index = 0;
+  instruction.Value = 0.0;
+  this->m_Instructions.push_back( instruction );
+
+} // end Emit()
+
+
+void
+ExpressionProgram::EmitConstant( double value )
+{
+  Instruction instruction;
+  instruction.OpCode = PushConstant;
+  instruction.Index = 0;
+  instruction.Value = value;
+  this->m_Instructions.push_back( instruction );
+
+} // end EmitConstant()
+
+
+void
+ExpressionProgram::EmitVariable( unsigned int index )
+{
+  Instruction instruction;
+  instruction.OpCode = PushVariable;
+  instruction.Index = index;
+  instruction.Value = 0.0;
+  this->m_Instructions.push_back( instruction );
+  if( index + 1 > this->m_NumberOfVariables )
+  {
+    this->m_NumberOfVariables = index + 1;
+  }
+
+} // end EmitVariable()
+
+
+} // end namespace itk
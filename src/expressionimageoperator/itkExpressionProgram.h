@@ -0,0 +1,144 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkExpressionProgram_h_
+#define __itkExpressionProgram_h_
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ExpressionProgram
+ * \brief Compiles a per-voxel arithmetic expression over several images
+ * into a postfix program, and evaluates it on blocks of voxels.
+ *
+ * The expression may contain:
+ * - the variables a, b, ..., z, referring to the first, second, ... input;
+ * - numbers, and the constant pi;
+ * - the operators + - * / % ^, the comparisons < <= > >= == != and the
+ *   logical operators ! && ||, with the usual precedence. Comparisons
+ *   and logical operators give 0 or 1;
+ * - the functions log (natural), ln, log10, exp, sqrt, sqr, abs, sign,
+ *   sin, cos, tan, asin, acos, atan, floor, ceil, round, erf, and
+ *   min(x,y), max(x,y), pow(x,y), select(c,x,y) (x if c is nonzero, else y).
+ * An optional assignment "out =" in front of the expression is ignored.
+ *
+ * All arithmetic is in double precision. The unary functions use the
+ * functors of pxunaryimageoperator. Division by zero leaves the
+ * numerator unchanged, as in pxnaryimageoperator.
+ *
+ * The program is evaluated on a block of voxels at once: every
+ * instruction is a simple loop over the block, which the compiler can
+ * vectorize. Operations on constants only are folded at compile time.
+ */
+
+class ExpressionProgram
+{
+public:
+  /** The instructions of the program. */
+  typedef enum {
+    PushConstant, PushVariable,
+    Negate, Not, Log, Log10, Exp, Sqrt, Sqr, Abs, Sign,
+    Sin, Cos, Tan, ArcSin, ArcCos, ArcTan, Floor, Ceil, Round, Erf,
+    Add, Subtract, Multiply, Divide, Modulo, Power, Minimum, Maximum,
+    Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual, And, Or,
+    Select
+  } OpCodeType;
+
+  struct Instruction
+  {
+    OpCodeType    OpCode;
+    unsigned int  Index;  // the variable of PushVariable
+    double        Value;  // the constant of PushConstant
+  };
+
+  ExpressionProgram();
+  ~ExpressionProgram() {};
+
+  /** Compile an expression. Throws an itk::ExceptionObject on a syntax error. */
+  void Compile( const std::string & expression );
+
+  /** The expression that was compiled. */
+  const std::string & GetExpression( void ) const
+  { return this->m_Expression; }
+
+  /** The number of inputs used: the highest variable plus one. */
+  unsigned int GetNumberOfVariables( void ) const
+  { return this->m_NumberOfVariables; }
+
+  /** The stack depth needed by Evaluate(), in blocks. */
+  unsigned int GetStackDepth( void ) const
+  { return this->m_StackDepth; }
+
+  /** Get the compiled instructions. */
+  const std::vector<Instruction> & GetInstructions( void ) const
+  { return this->m_Instructions; }
+
+  /** A readable listing of the program. */
+  std::string ToString( void ) const;
+
+  /** Evaluate the program on a block of voxels. variables[ v ] points to
+   * the values of variable v, result receives the values of the
+   * expression, and stack should hold GetStackDepth() * lanes doubles.
+   */
+  void Evaluate( const double * const * variables, double * result,
+    unsigned int lanes, double * stack ) const;
+
+  /** Apply an operation to a block: a holds the first operand and the
+   * result, b and c the second and third operand if any.
+   */
+  static void Apply( OpCodeType op, double * a, const double * b,
+    const double * c, unsigned int lanes );
+
+  /** The number of operands of an operation. */
+  static unsigned int GetArity( OpCodeType op );
+
+private:
+  /** Recursive descent parser, from low to high precedence. */
+  void ParseOr( void );
+  void ParseAnd( void );
+  void ParseComparison( void );
+  void ParseAdditive( void );
+  void ParseMultiplicative( void );
+  void ParseUnary( void );
+  void ParsePower( void );
+  void ParsePrimary( void );
+
+  /** Helpers of the parser. */
+  void SkipWhiteSpace( void );
+  bool Accept( const char * token );
+  void Expect( const char * token );
+  void SyntaxError( const std::string & message ) const;
+
+  /** Append an instruction, folding constants. */
+  void Emit( OpCodeType op );
+  void EmitConstant( double value );
+  void EmitVariable( unsigned int index );
+
+  std::string               m_Expression;
+  std::string::size_type    m_Position;
+  std::vector<Instruction>  m_Instructions;
+  unsigned int              m_NumberOfVariables;
+  unsigned int              m_StackDepth;
+
+}; // end class ExpressionProgram
+
+} // end namespace itk
+
+#endif // end #ifndef __itkExpressionProgram_h_
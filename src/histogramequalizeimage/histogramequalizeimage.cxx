@@ -45,6 +45,13 @@ std::string GetHelpString( void )
     << "  -in      inputFileName\n"
     << "  -out     outputFileName\n"
     << "  -[mask]  maskFileName\n"
+    << "  [-clahe] contrast-limited adaptive histogram equalization (CLAHE),\n"
+    << "           optionally followed by the number of tiles, one value\n"
+    << "           or one per dimension, default 8\n"
+    << "  [-clip]  CLAHE clip limit, as a multiple of the mean frequency of\n"
+    << "           a tile histogram, default 4; 0 disables the clipping\n"
+    << "  [-bins]  CLAHE number of histogram bins, default 256\n"
+    << "  [-threads] maximum number of threads, default all\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int";
 
   return ss.str();
@@ -86,6 +93,40 @@ int main( int argc, char** argv )
   std::string maskFileName = "";
   parser->GetCommandLineArgument( "-mask", maskFileName );
 
+  const bool adaptive = parser->ArgumentExists( "-clahe" );
+  std::vector<unsigned int> numberOfTiles( 1, 8 );
+  parser->GetCommandLineArgument( "-clahe", numberOfTiles );
+
+  double clipLimit = 4.0;
+  parser->GetCommandLineArgument( "-clip", clipLimit );
+
+  unsigned int numberOfHistogramBins = 256;
+  parser->GetCommandLineArgument( "-bins", numberOfHistogramBins );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
+  /** Check command line arguments. */
+  if( !adaptive && ( parser->ArgumentExists( "-clip" ) || parser->ArgumentExists( "-bins" ) ) )
+  {
+    std::cerr << "ERROR: -clip and -bins can only be used with -clahe." << std::endl;
+    return EXIT_FAILURE;
+  }
+  for( unsigned int i = 0; i < numberOfTiles.size(); ++i )
+  {
+    if( numberOfTiles[ i ] == 0 )
+    {
+      std::cerr << "ERROR: the number of tiles should be positive." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if( numberOfHistogramBins == 0 )
+  {
+    std::cerr << "ERROR: the number of bins should be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Determine image properties. */
   itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
@@ -99,6 +140,13 @@ int main( int argc, char** argv )
   bool retNOCCheck = itktools::NumberOfComponentsCheck( numberOfComponents );
   if( !retNOCCheck ) return EXIT_FAILURE;
 
+  /** Check the number of tiles. */
+  if( numberOfTiles.size() != 1 && numberOfTiles.size() != dim )
+  {
+    std::cerr << "ERROR: the number of tiles should be given once or for every dimension." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Class that does the work. */
   ITKToolsHistogramEqualizeImageBase * filter = NULL;
 
@@ -127,6 +175,10 @@ int main( int argc, char** argv )
     filter->m_InputFileName = inputFileName;
     filter->m_OutputFileName = outputFileName;
     filter->m_MaskFileName = maskFileName;
+    filter->m_Adaptive = adaptive;
+    filter->m_NumberOfTiles = numberOfTiles;
+    filter->m_ClipLimit = clipLimit;
+    filter->m_NumberOfHistogramBins = numberOfHistogramBins;
 
     filter->Run();
 
@@ -40,6 +40,10 @@ public:
     this->m_InputFileName = "";
     this->m_OutputFileName = "";
     this->m_MaskFileName = "";
+    this->m_Adaptive = false;
+    this->m_NumberOfTiles.resize( 1, 8 );
+    this->m_ClipLimit = 4.0;
+    this->m_NumberOfHistogramBins = 256;
   };
   /** Destructor. */
   ~ITKToolsHistogramEqualizeImageBase(){};
@@ -48,6 +52,10 @@ public:
   std::string m_InputFileName;
   std::string m_OutputFileName;
   std::string m_MaskFileName;
+  bool m_Adaptive;
+  std::vector<unsigned int> m_NumberOfTiles;
+  double m_ClipLimit;
+  unsigned int m_NumberOfHistogramBins;
 
 }; // end class ITKToolsHistogramEqualizeImageBase
 
@@ -107,6 +115,20 @@ public:
 
     /** Setup pipeline and configure its components */
     enhancer->SetInput( reader->GetOutput() );
+    if( this->m_Adaptive )
+    {
+      /** One number of tiles applies to all dimensions. */
+      typename EnhancerType::TilesType tiles;
+      for( unsigned int i = 0; i < VDimension; ++i )
+      {
+        tiles[ i ] = this->m_NumberOfTiles.size() == VDimension
+          ? this->m_NumberOfTiles[ i ] : this->m_NumberOfTiles[ 0 ];
+      }
+      enhancer->AdaptiveOn();
+      enhancer->SetNumberOfTiles( tiles );
+      enhancer->SetClipLimit( this->m_ClipLimit );
+      enhancer->SetNumberOfHistogramBins( this->m_NumberOfHistogramBins );
+    }
     if( this->m_MaskFileName != "" )
     {
       enhancer->SetMask( maskReader->GetOutput() );
@@ -20,6 +20,8 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkArray.h"
+#include "itkFixedArray.h"
+#include <vector>
 
 
 namespace itk
@@ -30,7 +32,22 @@ namespace itk
  *
  * HistogramEqualizationImageFilter applies a classic histogram equalization.
  * In contrast to the AdaptiveHistogramEqualizationImageFilter it is not adaptive
- * and therefore faster.
+ * and therefore faster. The minimum, maximum and histogram of the image are
+ * computed by the threads, each in its own accumulators, which are merged
+ * before the LUT is made.
+ *
+ * Optionally a contrast-limited adaptive histogram equalization (CLAHE) is
+ * done. The image is divided in NumberOfTiles tiles per dimension, and for
+ * each tile a histogram with NumberOfHistogramBins bins between the minimum
+ * and maximum of the image is computed, in parallel over the tiles. Each
+ * histogram is clipped at ClipLimit times its mean frequency, the clipped
+ * counts are spread over all bins, and the cumulative histogram is the
+ * mapping of the tile. A pixel is mapped by bilinear (2D) or trilinear (3D)
+ * interpolation of the mappings of the surrounding tile centers. A ClipLimit
+ * of 0 disables the clipping.
+ *
+ * If a mask is set, only the pixels inside the mask count in the histograms
+ * and are changed; the other pixels keep their value.
  *
  * \ingroup IntensityImageFilters
  *
@@ -85,10 +102,31 @@ public:
   typedef Image<MaskPixelType, ImageDimension>    MaskImageType;
   typedef typename MaskImageType::Pointer         MaskImagePointer;
 
+  /** Typedef for the number of tiles. */
+  typedef FixedArray<unsigned int, ImageDimension> TilesType;
+
   /** Set/Get mask */
   itkSetObjectMacro( Mask, MaskImageType );
   itkGetObjectMacro( Mask, MaskImageType );
 
+  /** Select the contrast-limited adaptive mode. */
+  itkSetMacro( Adaptive, bool );
+  itkGetConstMacro( Adaptive, bool );
+  itkBooleanMacro( Adaptive );
+
+  /** Set the number of tiles per dimension of the adaptive mode, default 8. */
+  itkSetMacro( NumberOfTiles, TilesType );
+  itkGetConstMacro( NumberOfTiles, TilesType );
+
+  /** Set the clip limit of the adaptive mode, as a multiple of the
+   * mean frequency of a tile histogram, default 4. */
+  itkSetMacro( ClipLimit, double );
+  itkGetConstMacro( ClipLimit, double );
+
+  /** Set the number of bins of the tile histograms, default 256. */
+  itkSetMacro( NumberOfHistogramBins, unsigned int );
+  itkGetConstMacro( NumberOfHistogramBins, unsigned int );
+
   //itkSetMacro( NumberOfBins, unsigned int );
   //itkGetConstReferenceMacro( NumberOfBins, unsigned int );
 
@@ -106,6 +144,57 @@ protected:
   double              m_MeanFrequency;
   MaskImagePointer    m_Mask;
 
+  bool                m_Adaptive;
+  TilesType           m_NumberOfTiles;
+  double              m_ClipLimit;
+  unsigned int        m_NumberOfHistogramBins;
+
+  /** The passes over the image before the LUTs are applied. */
+  enum PassType { MinimumMaximumPass = 0, HistogramPass = 1, TileHistogramPass = 2 };
+
+  /** Run a pass over the image with the multithreader. */
+  void ExecutePass( PassType pass );
+
+  /** Callback for the multithreader. */
+  static ITK_THREAD_RETURN_TYPE PassThreaderCallback( void * arg );
+
+  /** The passes, on the part of the requested region of a thread. */
+  void ThreadedComputeMinimumMaximum( const OutputImageRegionType & region, ThreadIdType threadId );
+  void ThreadedComputeHistogram( const OutputImageRegionType & region, ThreadIdType threadId );
+
+  /** Computes the clipped and normalized cumulative histograms of every
+   * numberOfThreads-th tile, starting at tile threadId. */
+  void ThreadedComputeTileMappings( ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** The region of a tile. */
+  OutputImageRegionType GetTileRegion( const TilesType & tile ) const;
+
+  /** Applies the interpolated tile mappings. */
+  void ThreadedApplyTileMappings(
+    const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId );
+
+  /** The bin of a pixel in the tile histograms. */
+  unsigned int GetTileHistogramBin( const InputImagePixelType & value ) const
+  {
+    return static_cast<unsigned int>(
+      ( static_cast<double>( value ) - this->m_Min ) * this->m_TileBinScale );
+  }
+
+  /** Per thread accumulators. */
+  PassType                                  m_Pass;
+  std::vector<InputImagePixelType>          m_ThreadMinimum;
+  std::vector<InputImagePixelType>          m_ThreadMaximum;
+  std::vector<SizeValueType>                m_ThreadCount;
+  std::vector< std::vector<SizeValueType> > m_ThreadHistograms;
+
+  /** The adaptive mode: the tiles actually used, and per tile a mapping of
+   * the bins to [0,1], stored tile after tile. */
+  TilesType                                 m_TileGrid;
+  unsigned int                              m_TileBins;
+  double                                    m_TileBinScale;
+  std::vector<double>                       m_TileMappings;
+
   /** Initialize some accumulators before the threads run.
    * Create a LUT */
   virtual void BeforeThreadedGenerateData( void );
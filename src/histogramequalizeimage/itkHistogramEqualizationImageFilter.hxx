@@ -22,6 +22,7 @@
 
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
 
@@ -36,6 +37,16 @@ HistogramEqualizationImageFilter<TImage>
   this->m_Max = itk::NumericTraits<InputImagePixelType>::NonpositiveMin();
   this->m_MeanFrequency = 1.0;
   this->m_NumberOfBins = 1;
+
+  this->m_Adaptive = false;
+  this->m_NumberOfTiles.Fill( 8 );
+  this->m_ClipLimit = 4.0;
+  this->m_NumberOfHistogramBins = 256;
+
+  this->m_Pass = MinimumMaximumPass;
+  this->m_TileGrid.Fill( 1 );
+  this->m_TileBins = 1;
+  this->m_TileBinScale = 0.0;
 }
 
 template<class TImage>
@@ -48,32 +59,180 @@ template<class TImage>
 void
 HistogramEqualizationImageFilter<TImage>
 ::BeforeThreadedGenerateData( void )
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+
+  /** Compute minimum and maximum of the input image, per thread */
+  this->m_ThreadMinimum.assign( numberOfThreads,
+    itk::NumericTraits<InputImagePixelType>::max() );
+  this->m_ThreadMaximum.assign( numberOfThreads,
+    itk::NumericTraits<InputImagePixelType>::NonpositiveMin() );
+  this->m_ThreadCount.assign( numberOfThreads, 0 );
+  this->ExecutePass( MinimumMaximumPass );
+
+  InputImagePixelType tempmin = itk::NumericTraits<InputImagePixelType>::max();
+  InputImagePixelType tempmax =
+    itk::NumericTraits<InputImagePixelType>::NonpositiveMin();
+  SizeValueType numberOfValidPixels = 0;
+  for( ThreadIdType i = 0; i < numberOfThreads; i++ )
+  {
+    if( this->m_ThreadCount[ i ] == 0 ) continue;
+    if( this->m_ThreadMinimum[ i ] < tempmin ) tempmin = this->m_ThreadMinimum[ i ];
+    if( this->m_ThreadMaximum[ i ] > tempmax ) tempmax = this->m_ThreadMaximum[ i ];
+    numberOfValidPixels += this->m_ThreadCount[ i ];
+  }
+
+  /** Nothing is changed without valid pixels */
+  if( numberOfValidPixels == 0 )
+  {
+    tempmin = tempmax = itk::NumericTraits<InputImagePixelType>::Zero;
+  }
+
+  this->m_Min = tempmin;
+  this->m_Max = tempmax;
+
+  /** The adaptive mode: compute a mapping per tile */
+  if( this->m_Adaptive )
+  {
+    const OutputImageSizeType size = this->GetOutput()->GetRequestedRegion().GetSize();
+    SizeValueType numberOfTiles = 1;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+      this->m_TileGrid[ d ] = vnl_math_max( 1u, this->m_NumberOfTiles[ d ] );
+      if( this->m_TileGrid[ d ] > size[ d ] )
+      {
+        this->m_TileGrid[ d ] = static_cast<unsigned int>( size[ d ] );
+      }
+      numberOfTiles *= this->m_TileGrid[ d ];
+    }
+
+    const double range = static_cast<double>( tempmax ) - static_cast<double>( tempmin ) + 1.0;
+    this->m_TileBins = static_cast<unsigned int>( vnl_math_max( 1.0,
+      vnl_math_min( static_cast<double>( this->m_NumberOfHistogramBins ), range ) ) );
+    this->m_TileBinScale = this->m_TileBins / range;
+    this->m_TileMappings.assign( numberOfTiles * this->m_TileBins, 0.0 );
+
+    this->ExecutePass( TileHistogramPass );
+    return;
+  }
+
+  /** Compute the number of bins and the ideal number of times a intensity value
+   * should occur in the image */
+  this->m_NumberOfBins = tempmax - tempmin + 1;
+  this->m_MeanFrequency =
+    static_cast<double>( numberOfValidPixels ) /
+    static_cast<double>( this->m_NumberOfBins );
+
+  /** Compute the histogram of the input image, per thread, and merge */
+  this->m_ThreadHistograms.assign( numberOfThreads,
+    std::vector<SizeValueType>( this->m_NumberOfBins, 0 ) );
+  this->ExecutePass( HistogramPass );
+
+  std::vector<SizeValueType> hist( this->m_NumberOfBins, 0 );
+  for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+  {
+    const std::vector<SizeValueType> & threadHist = this->m_ThreadHistograms[ t ];
+    for( unsigned int i = 0; i < this->m_NumberOfBins; i++ )
+    {
+      hist[ i ] += threadHist[ i ];
+    }
+  }
+  this->m_ThreadHistograms.clear();
+
+  /** convert it to a cumulative histogram */
+  for( unsigned int i = 1; i < this->m_NumberOfBins; i++ )
+  {
+    hist[ i ] += hist[i-1];
+  }
+
+  /** Compute LUT */
+  this->m_LUT.SetSize(this->m_NumberOfBins);
+  for( unsigned int i = 0; i < this->m_NumberOfBins; i++ )
+  {
+    this->m_LUT[ i ] = static_cast<OutputImagePixelType>(
+      vnl_math_max(
+      static_cast<double>( tempmin ),
+      -1.0 + tempmin + vcl_floor( static_cast<double>( hist[ i ] ) / this->m_MeanFrequency + 0.5 ) ) );
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+template<class TImage>
+void
+HistogramEqualizationImageFilter<TImage>
+::ExecutePass( PassType pass )
+{
+  this->m_Pass = pass;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->PassThreaderCallback, this );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+} // end ExecutePass()
+
+
+template<class TImage>
+ITK_THREAD_RETURN_TYPE
+HistogramEqualizationImageFilter<TImage>
+::PassThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  /** The tiles are divided over the threads */
+  if( self->m_Pass == TileHistogramPass )
+  {
+    self->ThreadedComputeTileMappings( threadId, threadCount );
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  /** The requested region is divided over the threads */
+  OutputImageRegionType splitRegion;
+  const unsigned int total = self->SplitRequestedRegion( threadId, threadCount, splitRegion );
+  if( threadId < total )
+  {
+    if( self->m_Pass == MinimumMaximumPass )
+    {
+      self->ThreadedComputeMinimumMaximum( splitRegion, threadId );
+    }
+    else
+    {
+      self->ThreadedComputeHistogram( splitRegion, threadId );
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end PassThreaderCallback()
+
+
+template<class TImage>
+void
+HistogramEqualizationImageFilter<TImage>
+::ThreadedComputeMinimumMaximum(
+  const OutputImageRegionType & region, ThreadIdType threadId )
 {
   typedef ImageRegionConstIterator<InputImageType>   ImageIteratorType;
   typedef ImageRegionConstIterator<MaskImageType>    MaskIteratorType;
 
   /** Use a mask or not */
   bool useMask = false;
-  if( this->GetMask() )
-  {
-    useMask = true;
-  }
+  if( this->GetMask() ) useMask = true;
 
-  /** Compute minimum and maximum of the input image */
-  ImageIteratorType it( this->GetInput(), this->GetOutput()->GetRequestedRegion() );
+  ImageIteratorType it( this->GetInput(), region );
   MaskIteratorType maskIt;
   if( useMask )
   {
-    maskIt = MaskIteratorType( this->GetMask(), this->GetOutput()->GetRequestedRegion() );
+    maskIt = MaskIteratorType( this->GetMask(), region );
     maskIt.GoToBegin();
   }
 
-  InputImagePixelType tempmin = itk::NumericTraits<InputImagePixelType>::max();
-  InputImagePixelType tempmax =
-    itk::NumericTraits<InputImagePixelType>::NonpositiveMin();
-
-  unsigned long numberOfValidPixels = 0;
-  it.GoToBegin();
+  InputImagePixelType tempmin = this->m_ThreadMinimum[ threadId ];
+  InputImagePixelType tempmax = this->m_ThreadMaximum[ threadId ];
+  SizeValueType numberOfValidPixels = 0;
   while ( !it.IsAtEnd() )
   {
     bool validPixel = true;
@@ -98,25 +257,36 @@ HistogramEqualizationImageFilter<TImage>
     ++it;
   }
 
-  this->m_Min = tempmin;
-  this->m_Max = tempmax;
+  this->m_ThreadMinimum[ threadId ] = tempmin;
+  this->m_ThreadMaximum[ threadId ] = tempmax;
+  this->m_ThreadCount[ threadId ] = numberOfValidPixels;
 
-  /** Compute the number of bins and the ideal number of times a intensity value
-   * should occur in the image */
-  this->m_NumberOfBins = tempmax - tempmin + 1;
-  this->m_MeanFrequency =
-    static_cast<double>( numberOfValidPixels ) /
-    static_cast<double>( this->m_NumberOfBins );
+} // end ThreadedComputeMinimumMaximum()
 
-  /** Compute the histogram of the input image */
-  typedef itk::Array<unsigned long> HistogramType;
-  HistogramType hist( this->m_NumberOfBins );
-  hist.Fill( 0 );
-  it.GoToBegin();
+
+template<class TImage>
+void
+HistogramEqualizationImageFilter<TImage>
+::ThreadedComputeHistogram(
+  const OutputImageRegionType & region, ThreadIdType threadId )
+{
+  typedef ImageRegionConstIterator<InputImageType>   ImageIteratorType;
+  typedef ImageRegionConstIterator<MaskImageType>    MaskIteratorType;
+
+  /** Use a mask or not */
+  bool useMask = false;
+  if( this->GetMask() ) useMask = true;
+
+  ImageIteratorType it( this->GetInput(), region );
+  MaskIteratorType maskIt;
   if( useMask )
   {
+    maskIt = MaskIteratorType( this->GetMask(), region );
     maskIt.GoToBegin();
   }
+
+  std::vector<SizeValueType> & hist = this->m_ThreadHistograms[ threadId ];
+  const InputImagePixelType tempmin = this->m_Min;
   while ( !it.IsAtEnd() )
   {
     bool validPixel = true;
@@ -133,23 +303,129 @@ HistogramEqualizationImageFilter<TImage>
     ++it;
   }
 
-  /** convert it to a cumulative histogram */
-  for( unsigned int i = 1; i < this->m_NumberOfBins; i++ )
+} // end ThreadedComputeHistogram()
+
+
+template<class TImage>
+typename HistogramEqualizationImageFilter<TImage>::OutputImageRegionType
+HistogramEqualizationImageFilter<TImage>
+::GetTileRegion( const TilesType & tile ) const
+{
+  /** The tiles divide the requested region as evenly as possible */
+  const OutputImageRegionType & requested = this->GetOutput()->GetRequestedRegion();
+  OutputImageRegionType region;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
   {
-    hist[ i ] += hist[i-1];
+    const SizeValueType size = requested.GetSize()[ d ];
+    const SizeValueType begin = size * tile[ d ] / this->m_TileGrid[ d ];
+    const SizeValueType end = size * ( tile[ d ] + 1 ) / this->m_TileGrid[ d ];
+    region.SetIndex( d, requested.GetIndex()[ d ] + static_cast<IndexValueType>( begin ) );
+    region.SetSize( d, end - begin );
   }
+  return region;
 
-  /** Compute LUT */
-  this->m_LUT.SetSize(this->m_NumberOfBins);
-  for( unsigned int i = 0; i < this->m_NumberOfBins; i++ )
+} // end GetTileRegion()
+
+
+template<class TImage>
+void
+HistogramEqualizationImageFilter<TImage>
+::ThreadedComputeTileMappings( ThreadIdType threadId, ThreadIdType numberOfThreads )
+{
+  typedef ImageRegionConstIterator<InputImageType>   ImageIteratorType;
+  typedef ImageRegionConstIterator<MaskImageType>    MaskIteratorType;
+
+  /** Use a mask or not */
+  bool useMask = false;
+  if( this->GetMask() ) useMask = true;
+
+  SizeValueType numberOfTiles = 1;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
   {
-    this->m_LUT[ i ] = static_cast<OutputImagePixelType>(
-      vnl_math_max(
-      static_cast<double>( tempmin ),
-      -1.0 + tempmin + vcl_floor( static_cast<double>( hist[ i ] ) / this->m_MeanFrequency + 0.5 ) ) );
+    numberOfTiles *= this->m_TileGrid[ d ];
   }
 
-} // end BeforeThreadedGenerateData()
+  const unsigned int bins = this->m_TileBins;
+  std::vector<double> hist( bins );
+  for( SizeValueType tileNumber = threadId; tileNumber < numberOfTiles; tileNumber += numberOfThreads )
+  {
+    /** The first dimension runs fastest */
+    TilesType tile;
+    SizeValueType rest = tileNumber;
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+      tile[ d ] = static_cast<unsigned int>( rest % this->m_TileGrid[ d ] );
+      rest /= this->m_TileGrid[ d ];
+    }
+    const OutputImageRegionType region = this->GetTileRegion( tile );
+
+    /** Compute the histogram of the tile */
+    ImageIteratorType it( this->GetInput(), region );
+    MaskIteratorType maskIt;
+    if( useMask )
+    {
+      maskIt = MaskIteratorType( this->GetMask(), region );
+      maskIt.GoToBegin();
+    }
+    std::fill( hist.begin(), hist.end(), 0.0 );
+    SizeValueType numberOfValidPixels = 0;
+    while ( !it.IsAtEnd() )
+    {
+      bool validPixel = true;
+      if( useMask )
+      {
+        validPixel = static_cast<bool>( maskIt.Value() );
+        ++maskIt;
+      }
+      if( validPixel )
+      {
+        ++numberOfValidPixels;
+        hist[ vnl_math_min( this->GetTileHistogramBin( it.Value() ), bins - 1 ) ] += 1.0;
+      }
+      ++it;
+    }
+
+    double * mapping = &this->m_TileMappings[ tileNumber * bins ];
+    if( numberOfValidPixels == 0 )
+    {
+      for( unsigned int i = 0; i < bins; i++ )
+      {
+        mapping[ i ] = ( i + 1.0 ) / bins;
+      }
+      continue;
+    }
+
+    /** Clip the histogram, and spread the excess over all bins */
+    const double count = static_cast<double>( numberOfValidPixels );
+    if( this->m_ClipLimit > 0.0 )
+    {
+      const double limit = vnl_math_max( 1.0, this->m_ClipLimit * count / bins );
+      double excess = 0.0;
+      for( unsigned int i = 0; i < bins; i++ )
+      {
+        if( hist[ i ] > limit )
+        {
+          excess += hist[ i ] - limit;
+          hist[ i ] = limit;
+        }
+      }
+      const double spread = excess / bins;
+      for( unsigned int i = 0; i < bins; i++ )
+      {
+        hist[ i ] += spread;
+      }
+    }
+
+    /** The normalized cumulative histogram is the mapping */
+    double cumulative = 0.0;
+    for( unsigned int i = 0; i < bins; i++ )
+    {
+      cumulative += hist[ i ];
+      mapping[ i ] = vnl_math_min( 1.0, cumulative / count );
+    }
+  }
+
+} // end ThreadedComputeTileMappings()
 
 
 template<class TImage>
@@ -168,6 +444,12 @@ HistogramEqualizationImageFilter<TImage>
   const OutputImageRegionType & outputRegionForThread,
   ThreadIdType threadId )
 {
+  if( this->m_Adaptive )
+  {
+    this->ThreadedApplyTileMappings( outputRegionForThread, threadId );
+    return;
+  }
+
   typedef ImageRegionConstIterator<InputImageType>   InputImageIteratorType;
   typedef ImageRegionIterator<OutputImageType>       OutputImageIteratorType;
   typedef ImageRegionConstIterator<MaskImageType>    MaskIteratorType;
@@ -215,6 +497,137 @@ HistogramEqualizationImageFilter<TImage>
 } // end ThreadedGenerateData()
 
 
+template<class TImage>
+void
+HistogramEqualizationImageFilter<TImage>
+::ThreadedApplyTileMappings(
+  const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  typedef ImageRegionConstIteratorWithIndex<InputImageType> InputImageIteratorType;
+  typedef ImageRegionIterator<OutputImageType>              OutputImageIteratorType;
+  typedef ImageRegionConstIterator<MaskImageType>           MaskIteratorType;
+
+  /** Use a mask or not */
+  bool useMask = false;
+  if( this->GetMask() ) useMask = true;
+
+  /** Per dimension and position: the tile center below, and the weight of
+   * the tile center above. Beyond the outer tile centers the mapping of
+   * the outer tile is used. */
+  const OutputImageRegionType & requested = this->GetOutput()->GetRequestedRegion();
+  std::vector<unsigned int> lowerTile[ ImageDimension ];
+  std::vector<double> upperWeight[ ImageDimension ];
+  SizeValueType stride[ ImageDimension ];
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+  {
+    const double tiles = static_cast<double>( this->m_TileGrid[ d ] );
+    const double size = static_cast<double>( requested.GetSize()[ d ] );
+    const SizeValueType length = outputRegionForThread.GetSize()[ d ];
+    lowerTile[ d ].resize( length );
+    upperWeight[ d ].resize( length );
+    for( SizeValueType i = 0; i < length; i++ )
+    {
+      const double index = static_cast<double>( outputRegionForThread.GetIndex()[ d ]
+        - requested.GetIndex()[ d ] + static_cast<IndexValueType>( i ) );
+      const double position = ( index + 0.5 ) * tiles / size - 0.5;
+      if( position <= 0.0 )
+      {
+        lowerTile[ d ][ i ] = 0;
+        upperWeight[ d ][ i ] = 0.0;
+      }
+      else if( position >= tiles - 1.0 )
+      {
+        lowerTile[ d ][ i ] = this->m_TileGrid[ d ] - 1;
+        upperWeight[ d ][ i ] = 0.0;
+      }
+      else
+      {
+        lowerTile[ d ][ i ] = static_cast<unsigned int>( vcl_floor( position ) );
+        upperWeight[ d ][ i ] = position - lowerTile[ d ][ i ];
+      }
+    }
+    stride[ d ] = d == 0 ? 1 : stride[ d - 1 ] * this->m_TileGrid[ d - 1 ];
+  }
+
+  InputImageIteratorType  it( this->GetInput(), outputRegionForThread );
+  OutputImageIteratorType ot( this->GetOutput(), outputRegionForThread );
+  MaskIteratorType maskIt;
+  if( useMask )
+  {
+    maskIt = MaskIteratorType( this->GetMask(), outputRegionForThread );
+    maskIt.GoToBegin();
+  }
+
+  // support progress methods/callbacks
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  const unsigned int bins = this->m_TileBins;
+  const unsigned int numberOfCorners = 1u << ImageDimension;
+  const double tempmin = static_cast<double>( this->m_Min );
+  const double range = static_cast<double>( this->m_Max ) - tempmin;
+  const double * mappings = &this->m_TileMappings[ 0 ];
+  unsigned int lower[ ImageDimension ];
+  double weight[ ImageDimension ];
+  while( !it.IsAtEnd() )
+  {
+    bool validPixel = true;
+    if( useMask )
+    {
+      validPixel = static_cast<bool>( maskIt.Value() );
+      ++maskIt;
+    }
+    if( validPixel )
+    {
+      const unsigned int bin = vnl_math_min( this->GetTileHistogramBin( it.Value() ), bins - 1 );
+      const InputImageIndexType & index = it.GetIndex();
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+        const SizeValueType i = index[ d ] - outputRegionForThread.GetIndex()[ d ];
+        lower[ d ] = lowerTile[ d ][ i ];
+        weight[ d ] = upperWeight[ d ][ i ];
+      }
+
+      /** Interpolate the mappings of the surrounding tile centers */
+      double mapped = 0.0;
+      for( unsigned int c = 0; c < numberOfCorners; c++ )
+      {
+        double cornerWeight = 1.0;
+        SizeValueType tileNumber = 0;
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+          if( c & ( 1u << d ) )
+          {
+            cornerWeight *= weight[ d ];
+            tileNumber += vnl_math_min( lower[ d ] + 1, this->m_TileGrid[ d ] - 1 ) * stride[ d ];
+          }
+          else
+          {
+            cornerWeight *= 1.0 - weight[ d ];
+            tileNumber += lower[ d ] * stride[ d ];
+          }
+        }
+        if( cornerWeight > 0.0 )
+        {
+          mapped += cornerWeight * mappings[ tileNumber * bins + bin ];
+        }
+      }
+
+      ot.Set( static_cast<OutputImagePixelType>(
+        vcl_floor( tempmin + mapped * range + 0.5 ) ) );
+    }
+    else
+    {
+      ot.Set( it.Get() );
+    }
+    ++it;
+    ++ot;
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedApplyTileMappings()
+
+
 template <class TImage>
 void
 HistogramEqualizationImageFilter<TImage>
@@ -225,6 +638,10 @@ HistogramEqualizationImageFilter<TImage>
   os << indent << "NumberOfBins: "  << this->m_NumberOfBins << std::endl;
   os << indent << "Minimum intensity: "  << this->m_Min << std::endl;
   os << indent << "Maximum intensity: "  << this->m_Max << std::endl;
+  os << indent << "Adaptive: "  << this->m_Adaptive << std::endl;
+  os << indent << "NumberOfTiles: "  << this->m_NumberOfTiles << std::endl;
+  os << indent << "ClipLimit: "  << this->m_ClipLimit << std::endl;
+  os << indent << "NumberOfHistogramBins: "  << this->m_NumberOfHistogramBins << std::endl;
 
 } // end PrintSelf()
 
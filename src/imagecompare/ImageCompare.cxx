@@ -26,6 +26,7 @@
 
 #include "itkCommandLineArgumentParser.h"
 #include "ITKToolsHelpers.h"
+#include "imagecompare.h"
 
 #include "itkNumericTraits.h"
 #include "itkImage.h"
@@ -50,7 +51,16 @@ std::string GetHelpString( void )
     << "Usage:\n"
     << "pximagecompare\n"
     << "  -test      image filename to test against baseline\n"
-    << "  -base      baseline image filename";
+    << "  -base      baseline image filename\n"
+    << "  [-t]       difference threshold: larger differences are reported, default 0\n"
+    << "  [-r]       tolerance radius: a test pixel may match any baseline pixel\n"
+    << "             within this radius, default 0\n"
+    << "  [-s]       number of streams, default 8\n"
+    << "  [-diff]    write the difference image, <test>_DIFF<ext>, if the images differ\n"
+    << "The images are compared slab by slab in their own component type; the comparison\n"
+    << "stops at the first difference, unless the difference image is requested.\n"
+    << "Images with more than 4 dimensions, or with a different dimension, number\n"
+    << "of components or component type, are compared as 6D double images.";
   return ss.str();
 
 } // end GetHelpString()
@@ -61,34 +71,20 @@ std::string GetHelpString( void )
 // must be compared, change this variable.
 static const unsigned int ITK_TEST_DIMENSION_MAX = 6;
 
-int main( int argc, char **argv )
-{
-  RegisterMevisDicomTiff();
-
-  itk::CommandLineArgumentParser::Pointer parser = itk::CommandLineArgumentParser::New();
-  parser->SetCommandLineArguments( argc, argv );
-  parser->SetProgramHelpText( GetHelpString() );
-
-  parser->MarkArgumentAsRequired( "-test", "The input filename." );
-  parser->MarkArgumentAsRequired( "-base", "The baseline image filename." );
-
-  itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
-
-  if( validateArguments == itk::CommandLineArgumentParser::FAILED )
-  {
-    return EXIT_FAILURE;
-  }
-  else if( validateArguments == itk::CommandLineArgumentParser::HELPREQUESTED )
-  {
-    return EXIT_SUCCESS;
-  }
-
-  std::string testImageFileName;
-  parser->GetCommandLineArgument( "-test", testImageFileName );
-
-  std::string baselineImageFileName;
-  parser->GetCommandLineArgument( "-base", baselineImageFileName );
+/**
+ * ******************* CompareAsDouble *******************
+ *
+ * The fall back comparison, for images that can not be compared in their
+ * own type. Returns the number of different pixels, or -1 on errors.
+ */
 
+long CompareAsDouble(
+  const std::string & testImageFileName,
+  const std::string & baselineImageFileName,
+  double differenceThreshold,
+  unsigned int toleranceRadius,
+  bool writeDifferenceImage )
+{
   // Read images
   typedef itk::Image<double,ITK_TEST_DIMENSION_MAX>           ImageType;
   typedef itk::ImageFileReader<ImageType>                     ReaderType;
@@ -103,7 +99,7 @@ int main( int argc, char **argv )
   catch( itk::ExceptionObject & excp )
   {
     std::cerr << "Error during reading baseline image: " << excp << std::endl;
-    return EXIT_FAILURE;
+    return -1;
   }
 
   // Read the file to test
@@ -116,7 +112,7 @@ int main( int argc, char **argv )
   catch( itk::ExceptionObject & excp )
   {
     std::cerr << "Error during reading test image: " << excp << std::endl;
-    return EXIT_FAILURE;
+    return -1;
   }
 
   // The sizes of the baseline and test image must match
@@ -132,7 +128,7 @@ int main( int argc, char **argv )
       << " has size " << baselineSize << std::endl;
     std::cerr << "Test image:     " << testImageFileName
       << " has size " << testSize << std::endl;
-    return EXIT_FAILURE;
+    return -1;
   }
 
   // Now compare the two images
@@ -140,6 +136,8 @@ int main( int argc, char **argv )
   ComparisonFilterType::Pointer comparisonFilter = ComparisonFilterType::New();
   comparisonFilter->SetTestInput(testReader->GetOutput());
   comparisonFilter->SetValidInput(baselineReader->GetOutput());
+  comparisonFilter->SetDifferenceThreshold( differenceThreshold );
+  comparisonFilter->SetToleranceRadius( toleranceRadius );
   try
   {
     comparisonFilter->Update();
@@ -147,7 +145,7 @@ int main( int argc, char **argv )
   catch( itk::ExceptionObject & excp )
   {
     std::cerr << "Error during comparing image: " << excp << std::endl;
-    return EXIT_FAILURE;
+    return -1;
   }
 
   itk::SizeValueType numberOfDifferentPixels = comparisonFilter->GetNumberOfPixelsWithDifferences();
@@ -155,6 +153,7 @@ int main( int argc, char **argv )
   if(numberOfDifferentPixels > 0)
   {
     std::cerr << "There are " << numberOfDifferentPixels << " different pixels!" << std::endl;
+    if( !writeDifferenceImage ) return static_cast<long>( numberOfDifferentPixels );
 
     // Create name for diff image
     std::string diffImageFileName =
@@ -173,13 +172,168 @@ int main( int argc, char **argv )
     catch( itk::ExceptionObject & excp )
     {
       std::cerr << "Error during writing difference image: " << excp << std::endl;
+      return -1;
+    }
+
+  } // end if discrepancies
+
+  return static_cast<long>( numberOfDifferentPixels );
+
+} // end CompareAsDouble()
+
+
+//-------------------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+  RegisterMevisDicomTiff();
+
+  itk::CommandLineArgumentParser::Pointer parser = itk::CommandLineArgumentParser::New();
+  parser->SetCommandLineArguments( argc, argv );
+  parser->SetProgramHelpText( GetHelpString() );
+
+  parser->MarkArgumentAsRequired( "-test", "The input filename." );
+  parser->MarkArgumentAsRequired( "-base", "The baseline image filename." );
+
+  itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
+
+  if( validateArguments == itk::CommandLineArgumentParser::FAILED )
+  {
+    return EXIT_FAILURE;
+  }
+  else if( validateArguments == itk::CommandLineArgumentParser::HELPREQUESTED )
+  {
+    return EXIT_SUCCESS;
+  }
+
+  std::string testImageFileName;
+  parser->GetCommandLineArgument( "-test", testImageFileName );
+
+  std::string baselineImageFileName;
+  parser->GetCommandLineArgument( "-base", baselineImageFileName );
+
+  double differenceThreshold = 0.0;
+  parser->GetCommandLineArgument( "-t", differenceThreshold );
+
+  unsigned int toleranceRadius = 0;
+  parser->GetCommandLineArgument( "-r", toleranceRadius );
+
+  unsigned int numberOfStreams = 8;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  const bool writeDifferenceImage = parser->ArgumentExists( "-diff" );
+
+  /** Determine image properties. */
+  itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+  itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  unsigned int dim = 0;
+  unsigned int numberOfComponents = 0;
+  std::vector<unsigned int> baselineSize;
+  bool retgip = itktools::GetImageProperties(
+    baselineImageFileName, pixelType, componentType, dim, numberOfComponents, baselineSize );
+  if( !retgip ) return EXIT_FAILURE;
+
+  itk::ImageIOBase::IOPixelType testPixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+  itk::ImageIOBase::IOComponentType testComponentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  unsigned int testDim = 0;
+  unsigned int testNumberOfComponents = 0;
+  std::vector<unsigned int> testSize;
+  retgip = itktools::GetImageProperties(
+    testImageFileName, testPixelType, testComponentType, testDim, testNumberOfComponents, testSize );
+  if( !retgip ) return EXIT_FAILURE;
+
+  /** Class that does the work. */
+  ITKToolsImageCompareBase * filter = NULL;
+
+  /** Images of the same layout and component type are compared in their
+   * own type. Reading the test image in the type of the baseline would hide
+   * differences, e.g. the fractions of a float image against a short baseline.
+   */
+  if( dim == testDim && numberOfComponents == testNumberOfComponents
+    && componentType == testComponentType )
+  {
+    if( baselineSize != testSize )
+    {
+      std::cerr << "The size of the Baseline image and Test image do not match!" << std::endl;
+      std::cerr << "Baseline image: " << baselineImageFileName << " has size";
+      for( unsigned int i = 0; i < dim; ++i ) std::cerr << " " << baselineSize[ i ];
+      std::cerr << std::endl;
+      std::cerr << "Test image:     " << testImageFileName << " has size";
+      for( unsigned int i = 0; i < dim; ++i ) std::cerr << " " << testSize[ i ];
+      std::cerr << std::endl;
       return EXIT_FAILURE;
     }
 
+    // 2D
+    if( !filter ) filter = ITKToolsImageCompare< 2, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, unsigned long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, float >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 2, double >::New( dim, componentType );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+    // 3D
+    if( !filter ) filter = ITKToolsImageCompare< 3, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, unsigned long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, float >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 3, double >::New( dim, componentType );
+#endif
+#ifdef ITKTOOLS_4D_SUPPORT
+    // 4D
+    if( !filter ) filter = ITKToolsImageCompare< 4, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, unsigned long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, float >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageCompare< 4, double >::New( dim, componentType );
+#endif
+  }
+
+  /** Otherwise fall back to the comparison as 6D double images. */
+  if( !filter )
+  {
+    const long numberOfDifferentPixels = CompareAsDouble( testImageFileName,
+      baselineImageFileName, differenceThreshold, toleranceRadius, writeDifferenceImage );
+    return numberOfDifferentPixels == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  try
+  {
+    /** Set the filter arguments. */
+    filter->m_TestFileName = testImageFileName;
+    filter->m_BaselineFileName = baselineImageFileName;
+    filter->m_DifferenceThreshold = differenceThreshold;
+    filter->m_ToleranceRadius = toleranceRadius;
+    filter->m_NumberOfStreams = numberOfStreams;
+    filter->m_WriteDifferenceImage = writeDifferenceImage;
+
+    filter->Run();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "Error during comparing image: " << excp << std::endl;
+    delete filter;
     return EXIT_FAILURE;
+  }
 
-  } // end if discrepancies
+  const bool identical = filter->m_NumberOfPixelsWithDifferences == 0;
+  delete filter;
 
-  return EXIT_SUCCESS;
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
 
 } // end main
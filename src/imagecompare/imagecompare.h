@@ -0,0 +1,145 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __imagecompare_h_
+#define __imagecompare_h_
+
+#include "ITKToolsBase.h"
+
+#include "itkVectorImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkStreamedImageComparator.h"
+#include "itksys/SystemTools.hxx"
+
+
+/** \class ITKToolsImageCompareBase
+ *
+ * Untemplated pure virtual base class that holds
+ * the Run() function and all required parameters.
+ */
+
+class ITKToolsImageCompareBase : public itktools::ITKToolsBase
+{
+public:
+  /** Constructor. */
+  ITKToolsImageCompareBase()
+  {
+    this->m_TestFileName = "";
+    this->m_BaselineFileName = "";
+    this->m_DifferenceThreshold = 0.0;
+    this->m_ToleranceRadius = 0;
+    this->m_NumberOfStreams = 8;
+    this->m_WriteDifferenceImage = false;
+    this->m_NumberOfPixelsWithDifferences = 0;
+  };
+  /** Destructor. */
+  ~ITKToolsImageCompareBase(){};
+
+  /** Input member parameters. */
+  std::string m_TestFileName;
+  std::string m_BaselineFileName;
+  double m_DifferenceThreshold;
+  unsigned int m_ToleranceRadius;
+  unsigned int m_NumberOfStreams;
+  bool m_WriteDifferenceImage;
+
+  /** Output member parameters. */
+  itk::SizeValueType m_NumberOfPixelsWithDifferences;
+
+}; // end class ITKToolsImageCompareBase
+
+
+/** \class ITKToolsImageCompare
+ *
+ * Templated class that implements the Run() function
+ * and the New() function for its creation.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+class ITKToolsImageCompare : public ITKToolsImageCompareBase
+{
+public:
+  /** Standard ITKTools stuff. */
+  typedef ITKToolsImageCompare Self;
+  itktoolsOneTypeNewMacro( Self );
+
+  ITKToolsImageCompare(){};
+  ~ITKToolsImageCompare(){};
+
+  /** Run function. */
+  void Run( void )
+  {
+    /** The images are compared in their own component type, which is
+     * the same for the baseline and the test image.
+     */
+    typedef itk::VectorImage< TComponentType, VDimension >  ImageType;
+    typedef itk::ImageFileReader< ImageType >               ReaderType;
+    typedef itk::StreamedImageComparator< ImageType >       ComparatorType;
+    typedef typename ComparatorType::DifferenceImageType    DifferenceImageType;
+    typedef itk::ImageFileWriter< DifferenceImageType >     WriterType;
+
+    /** Setup the readers; the pixels are read piece by piece by the comparator. */
+    typename ReaderType::Pointer baselineReader = ReaderType::New();
+    baselineReader->SetFileName( this->m_BaselineFileName );
+    typename ReaderType::Pointer testReader = ReaderType::New();
+    testReader->SetFileName( this->m_TestFileName );
+
+    /** Compare, and stop at the first difference. */
+    typename ComparatorType::Pointer comparator = ComparatorType::New();
+    comparator->SetTestInput( testReader->GetOutput() );
+    comparator->SetValidInput( baselineReader->GetOutput() );
+    comparator->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    comparator->SetDifferenceThreshold( this->m_DifferenceThreshold );
+    comparator->SetToleranceRadius( this->m_ToleranceRadius );
+    comparator->SetStopAtFirstDifference( true );
+    comparator->Compute();
+
+    this->m_NumberOfPixelsWithDifferences = comparator->GetNumberOfPixelsWithDifferences();
+    if( this->m_NumberOfPixelsWithDifferences == 0 ) return;
+
+    std::cerr << "The images differ, first at index "
+      << comparator->GetFirstDifferenceIndex() << "." << std::endl;
+    if( !this->m_WriteDifferenceImage ) return;
+
+    /** Only now the full difference image is computed. */
+    comparator->SetStopAtFirstDifference( false );
+    comparator->SetComputeDifferenceImage( true );
+    comparator->Compute();
+    this->m_NumberOfPixelsWithDifferences = comparator->GetNumberOfPixelsWithDifferences();
+
+    std::cerr << "There are " << this->m_NumberOfPixelsWithDifferences
+      << " different pixels, the maximum difference is "
+      << comparator->GetMaximumDifference() << "!" << std::endl;
+
+    /** Create name for diff image */
+    std::string diffImageFileName =
+      itksys::SystemTools::GetFilenameWithoutLastExtension( this->m_TestFileName );
+    diffImageFileName += "_DIFF";
+    diffImageFileName += itksys::SystemTools::GetFilenameLastExtension( this->m_TestFileName );
+
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( diffImageFileName );
+    writer->SetInput( comparator->GetDifferenceImage() );
+    writer->Update();
+
+  } // end Run()
+
+}; // end class ITKToolsImageCompare
+
+
+#endif // end #ifndef __imagecompare_h_
@@ -0,0 +1,180 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkStreamedImageComparator_h_
+#define __itkStreamedImageComparator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkOffset.h"
+#include <vector>
+
+
+namespace itk {
+
+/** \class StreamedImageComparator
+ * \brief Compares a test image with a baseline (valid) image in a single
+ * streamed pass, in the native pixel type of the images.
+ *
+ * Both inputs are requested piece by piece from the upstream pipeline,
+ * typically two ImageFileReaders, so that only one slab of each image is
+ * in memory at a time. The image type is a VectorImage, so that scalar and
+ * multi-component images of any component type are compared without a
+ * conversion.
+ *
+ * For each piece the raw buffers are compared first. Only if they differ
+ * the pixels are compared one by one, with the same semantics as
+ * Testing::ComparisonImageFilter: a test pixel differs if the difference
+ * with all baseline pixels within ToleranceRadius is larger than
+ * DifferenceThreshold. For multi-component pixels the difference is the
+ * maximum absolute difference of the components.
+ *
+ * If StopAtFirstDifference is set, the pass stops at the first pixel that
+ * differs, so that the number of pixels with differences is then at most
+ * one. The difference image, with the pixel differences above the
+ * threshold and zero elsewhere, is only allocated if
+ * ComputeDifferenceImage is set.
+ */
+
+template< class TImage >
+class StreamedImageComparator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef StreamedImageComparator     Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( StreamedImageComparator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TImage::ImageDimension );
+
+  /** Image typedefs. */
+  typedef TImage                                    ImageType;
+  typedef typename ImageType::Pointer               ImagePointer;
+  typedef typename ImageType::InternalPixelType     InternalPixelType;
+  typedef typename ImageType::RegionType            RegionType;
+  typedef typename ImageType::IndexType             IndexType;
+  typedef Offset< itkGetStaticConstMacro( ImageDimension ) > OffsetType;
+  typedef Image< double,
+    itkGetStaticConstMacro( ImageDimension ) >      DifferenceImageType;
+  typedef typename DifferenceImageType::Pointer     DifferenceImagePointer;
+
+  /** Connect the test and the baseline image. They are not const, since
+   * requested regions are set on them to drive the upstream pipeline.
+   */
+  void SetTestInput( ImageType * image );
+  void SetValidInput( ImageType * image );
+
+  /** Set the number of pieces in which the images are processed. */
+  itkSetMacro( NumberOfStreamDivisions, unsigned int );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
+  /** Set the largest difference that is not reported. */
+  itkSetMacro( DifferenceThreshold, double );
+  itkGetConstMacro( DifferenceThreshold, double );
+
+  /** Set the radius of the baseline neighbourhood a test pixel may match. */
+  itkSetMacro( ToleranceRadius, unsigned int );
+  itkGetConstMacro( ToleranceRadius, unsigned int );
+
+  /** Stop the pass at the first pixel that differs. */
+  itkSetMacro( StopAtFirstDifference, bool );
+  itkGetConstMacro( StopAtFirstDifference, bool );
+  itkBooleanMacro( StopAtFirstDifference );
+
+  /** Select whether the difference image is computed. */
+  itkSetMacro( ComputeDifferenceImage, bool );
+  itkGetConstMacro( ComputeDifferenceImage, bool );
+  itkBooleanMacro( ComputeDifferenceImage );
+
+  /** Triggers the comparison. */
+  void Compute( void );
+
+  /** Results. Valid after Compute(). */
+  itkGetConstMacro( NumberOfPixelsWithDifferences, SizeValueType );
+  itkGetConstMacro( MaximumDifference, double );
+  itkGetConstReferenceMacro( FirstDifferenceIndex, IndexType );
+
+  /** The difference image; only valid if ComputeDifferenceImage is set. */
+  DifferenceImageType * GetDifferenceImage( void )
+  {
+    return this->m_DifferenceImage.GetPointer();
+  }
+
+protected:
+  StreamedImageComparator();
+  virtual ~StreamedImageComparator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Returns a pointer to the region in the buffer of the image, or null if
+   * the region is not one contiguous block of that buffer.
+   */
+  const InternalPixelType * GetContiguousPointer(
+    const ImageType * image, const RegionType & region ) const;
+
+  /** Compare the pixels of one piece of the images. */
+  void ComparePiece( const RegionType & piece );
+
+  /** Maximum absolute difference of the components of two pixels. */
+  double PixelDifference( const InternalPixelType * test,
+    const InternalPixelType * valid ) const;
+
+  /** Minimum difference of a test pixel with the baseline neighbourhood. */
+  double NeighborhoodDifference( const InternalPixelType * test,
+    const IndexType & index, double centerDifference ) const;
+
+private:
+  StreamedImageComparator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  ImagePointer      m_TestInput;
+  ImagePointer      m_ValidInput;
+
+  unsigned int      m_NumberOfStreamDivisions;
+  double            m_DifferenceThreshold;
+  unsigned int      m_ToleranceRadius;
+  bool              m_StopAtFirstDifference;
+  bool              m_ComputeDifferenceImage;
+
+  /** Used during the pass. */
+  RegionType                m_LargestRegion;
+  unsigned int              m_NumberOfComponents;
+  std::vector<OffsetType>   m_NeighborhoodOffsets;
+
+  /** Results. */
+  SizeValueType             m_NumberOfPixelsWithDifferences;
+  double                    m_MaximumDifference;
+  IndexType                 m_FirstDifferenceIndex;
+  DifferenceImagePointer    m_DifferenceImage;
+
+}; // end class StreamedImageComparator
+
+
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStreamedImageComparator.txx"
+#endif
+
+#endif // end #ifndef __itkStreamedImageComparator_h_
@@ -0,0 +1,381 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkStreamedImageComparator_txx_
+#define __itkStreamedImageComparator_txx_
+
+#include "itkStreamedImageComparator.h"
+
+#include "itkImageLinearConstIteratorWithIndex.h"
+#include "itkImageRegionSplitter.h"
+#include "itkNeighborhood.h"
+#include "vnl/vnl_math.h"
+#include <cstring>
+
+
+namespace itk {
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImage >
+StreamedImageComparator< TImage >
+::StreamedImageComparator()
+{
+  this->m_NumberOfStreamDivisions = 8;
+  this->m_DifferenceThreshold = 0.0;
+  this->m_ToleranceRadius = 0;
+  this->m_StopAtFirstDifference = false;
+  this->m_ComputeDifferenceImage = false;
+
+  this->m_NumberOfComponents = 1;
+  this->m_NumberOfPixelsWithDifferences = 0;
+  this->m_MaximumDifference = 0.0;
+  this->m_FirstDifferenceIndex.Fill( 0 );
+
+} // end Constructor
+
+
+/**
+ * ******************* SetTestInput *******************
+ */
+
+template< class TImage >
+void
+StreamedImageComparator< TImage >
+::SetTestInput( ImageType * image )
+{
+  if( this->m_TestInput != image )
+  {
+    this->m_TestInput = image;
+    this->Modified();
+  }
+} // end SetTestInput()
+
+
+/**
+ * ******************* SetValidInput *******************
+ */
+
+template< class TImage >
+void
+StreamedImageComparator< TImage >
+::SetValidInput( ImageType * image )
+{
+  if( this->m_ValidInput != image )
+  {
+    this->m_ValidInput = image;
+    this->Modified();
+  }
+} // end SetValidInput()
+
+
+/**
+ * ******************* Compute *******************
+ */
+
+template< class TImage >
+void
+StreamedImageComparator< TImage >
+::Compute( void )
+{
+  if( this->m_TestInput.IsNull() || this->m_ValidInput.IsNull() )
+  {
+    itkExceptionMacro( << "ERROR: the test and the valid image should both be set." );
+  }
+
+  /** Reset the results. */
+  this->m_NumberOfPixelsWithDifferences = 0;
+  this->m_MaximumDifference = 0.0;
+  this->m_FirstDifferenceIndex.Fill( 0 );
+  this->m_DifferenceImage = 0;
+
+  /** Only the meta data is read here. */
+  this->m_TestInput->UpdateOutputInformation();
+  this->m_ValidInput->UpdateOutputInformation();
+  this->m_LargestRegion = this->m_TestInput->GetLargestPossibleRegion();
+  if( this->m_ValidInput->GetLargestPossibleRegion() != this->m_LargestRegion )
+  {
+    itkExceptionMacro( << "ERROR: the test and the valid image do not have the same size." );
+  }
+  this->m_NumberOfComponents = this->m_TestInput->GetNumberOfComponentsPerPixel();
+  if( this->m_ValidInput->GetNumberOfComponentsPerPixel() != this->m_NumberOfComponents )
+  {
+    itkExceptionMacro( << "ERROR: the test and the valid image do not have the same number of components." );
+  }
+
+  /** The offsets of the baseline neighbourhood, excluding the center. */
+  this->m_NeighborhoodOffsets.clear();
+  if( this->m_ToleranceRadius > 0 )
+  {
+    Neighborhood< char, ImageDimension > neighborhood;
+    neighborhood.SetRadius( this->m_ToleranceRadius );
+    for( unsigned int i = 0; i < neighborhood.Size(); ++i )
+    {
+      if( i != neighborhood.GetCenterNeighborhoodIndex() )
+      {
+        this->m_NeighborhoodOffsets.push_back( neighborhood.GetOffset( i ) );
+      }
+    }
+  }
+
+  if( this->m_ComputeDifferenceImage )
+  {
+    this->m_DifferenceImage = DifferenceImageType::New();
+    this->m_DifferenceImage->SetRegions( this->m_LargestRegion );
+    this->m_DifferenceImage->SetSpacing( this->m_TestInput->GetSpacing() );
+    this->m_DifferenceImage->SetOrigin( this->m_TestInput->GetOrigin() );
+    this->m_DifferenceImage->SetDirection( this->m_TestInput->GetDirection() );
+    this->m_DifferenceImage->Allocate();
+    this->m_DifferenceImage->FillBuffer( 0.0 );
+  }
+
+  /** Split the images in pieces along the slowest varying dimension. */
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(
+    this->m_LargestRegion, vnl_math_max( 1u, this->m_NumberOfStreamDivisions ) );
+
+  /** The single pass over the images. */
+  for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+  {
+    const RegionType pieceRegion = splitter->GetSplit( piece, numberOfPieces, this->m_LargestRegion );
+
+    /** The baseline is needed in the neighbourhood of the piece. */
+    RegionType paddedRegion = pieceRegion;
+    paddedRegion.PadByRadius( this->m_ToleranceRadius );
+    paddedRegion.Crop( this->m_LargestRegion );
+
+    this->m_TestInput->SetRequestedRegion( pieceRegion );
+    this->m_TestInput->Update();
+    this->m_ValidInput->SetRequestedRegion( paddedRegion );
+    this->m_ValidInput->Update();
+
+    /** Identical buffers have no differences, whatever the tolerance. */
+    const InternalPixelType * testBuffer
+      = this->GetContiguousPointer( this->m_TestInput, pieceRegion );
+    const InternalPixelType * validBuffer
+      = this->GetContiguousPointer( this->m_ValidInput, pieceRegion );
+    if( testBuffer && validBuffer && std::memcmp( testBuffer, validBuffer,
+      pieceRegion.GetNumberOfPixels() * this->m_NumberOfComponents
+      * sizeof( InternalPixelType ) ) == 0 )
+    {
+      continue;
+    }
+
+    this->ComparePiece( pieceRegion );
+
+    if( this->m_StopAtFirstDifference && this->m_NumberOfPixelsWithDifferences > 0 )
+    {
+      break;
+    }
+  }
+
+} // end Compute()
+
+
+/**
+ * ******************* GetContiguousPointer *******************
+ */
+
+template< class TImage >
+const typename StreamedImageComparator< TImage >::InternalPixelType *
+StreamedImageComparator< TImage >
+::GetContiguousPointer( const ImageType * image, const RegionType & region ) const
+{
+  const RegionType & bufferedRegion = image->GetBufferedRegion();
+  if( !bufferedRegion.IsInside( region ) )
+  {
+    return 0;
+  }
+
+  /** The region is contiguous if it spans the buffered region in the
+   * dimensions below some dimension k, and has size one above k.
+   */
+  unsigned int k = 0;
+  while( k < ImageDimension - 1
+    && region.GetSize()[ k ] == bufferedRegion.GetSize()[ k ] )
+  {
+    ++k;
+  }
+  for( unsigned int i = k + 1; i < ImageDimension; ++i )
+  {
+    if( region.GetSize()[ i ] != 1 ) return 0;
+  }
+
+  return image->GetBufferPointer()
+    + image->ComputeOffset( region.GetIndex() ) * this->m_NumberOfComponents;
+
+} // end GetContiguousPointer()
+
+
+/**
+ * ******************* ComparePiece *******************
+ */
+
+template< class TImage >
+void
+StreamedImageComparator< TImage >
+::ComparePiece( const RegionType & piece )
+{
+  const unsigned int nc = this->m_NumberOfComponents;
+  const InternalPixelType * testBuffer = this->m_TestInput->GetBufferPointer();
+  const InternalPixelType * validBuffer = this->m_ValidInput->GetBufferPointer();
+  const SizeValueType lineLength = piece.GetSize()[ 0 ];
+
+  /** Walk over the lines of the piece, and over the raw buffers within a line. */
+  typedef ImageLinearConstIteratorWithIndex<ImageType> LineIteratorType;
+  LineIteratorType it( this->m_TestInput, piece );
+  it.SetDirection( 0 );
+  it.GoToBegin();
+  while( !it.IsAtEnd() )
+  {
+    IndexType index = it.GetIndex();
+    const InternalPixelType * test = testBuffer
+      + this->m_TestInput->ComputeOffset( index ) * nc;
+    const InternalPixelType * valid = validBuffer
+      + this->m_ValidInput->ComputeOffset( index ) * nc;
+
+    for( SizeValueType i = 0; i < lineLength; ++i, ++index[ 0 ], test += nc, valid += nc )
+    {
+      double difference = this->PixelDifference( test, valid );
+      if( difference <= this->m_DifferenceThreshold ) continue;
+
+      /** Maybe the test pixel matches one of the neighbouring baseline pixels. */
+      if( !this->m_NeighborhoodOffsets.empty() )
+      {
+        difference = this->NeighborhoodDifference( test, index, difference );
+        if( difference <= this->m_DifferenceThreshold ) continue;
+      }
+
+      if( this->m_NumberOfPixelsWithDifferences == 0 )
+      {
+        this->m_FirstDifferenceIndex = index;
+      }
+      ++this->m_NumberOfPixelsWithDifferences;
+      this->m_MaximumDifference = vnl_math_max( this->m_MaximumDifference, difference );
+      if( this->m_ComputeDifferenceImage )
+      {
+        this->m_DifferenceImage->SetPixel( index, difference );
+      }
+      if( this->m_StopAtFirstDifference ) return;
+    }
+
+    it.NextLine();
+  }
+
+} // end ComparePiece()
+
+
+/**
+ * ******************* PixelDifference *******************
+ */
+
+template< class TImage >
+double
+StreamedImageComparator< TImage >
+::PixelDifference( const InternalPixelType * test,
+  const InternalPixelType * valid ) const
+{
+  double difference = 0.0;
+  for( unsigned int c = 0; c < this->m_NumberOfComponents; ++c )
+  {
+    const double t = static_cast<double>( test[ c ] );
+    const double v = static_cast<double>( valid[ c ] );
+
+    /** A NaN only matches a NaN. */
+    if( vnl_math_isnan( t ) || vnl_math_isnan( v ) )
+    {
+      if( vnl_math_isnan( t ) != vnl_math_isnan( v ) )
+      {
+        return NumericTraits<double>::max();
+      }
+      continue;
+    }
+
+    difference = vnl_math_max( difference, vnl_math_abs( t - v ) );
+  }
+
+  return difference;
+
+} // end PixelDifference()
+
+
+/**
+ * ******************* NeighborhoodDifference *******************
+ */
+
+template< class TImage >
+double
+StreamedImageComparator< TImage >
+::NeighborhoodDifference( const InternalPixelType * test,
+  const IndexType & index, double centerDifference ) const
+{
+  const InternalPixelType * validBuffer = this->m_ValidInput->GetBufferPointer();
+  const IndexType & start = this->m_LargestRegion.GetIndex();
+  const typename RegionType::SizeType & size = this->m_LargestRegion.GetSize();
+
+  /** Outside the image the baseline is extended by its border, as the zero
+   * flux Neumann boundary condition of ComparisonImageFilter does.
+   */
+  double minimumDifference = centerDifference;
+  for( unsigned int i = 0; i < this->m_NeighborhoodOffsets.size(); ++i )
+  {
+    IndexType neighbor = index + this->m_NeighborhoodOffsets[ i ];
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      const IndexValueType last = start[ d ] + static_cast<IndexValueType>( size[ d ] ) - 1;
+      neighbor[ d ] = vnl_math_min( vnl_math_max( neighbor[ d ], start[ d ] ), last );
+    }
+
+    const InternalPixelType * valid = validBuffer
+      + this->m_ValidInput->ComputeOffset( neighbor ) * this->m_NumberOfComponents;
+    minimumDifference = vnl_math_min( minimumDifference,
+      this->PixelDifference( test, valid ) );
+    if( minimumDifference <= this->m_DifferenceThreshold ) break;
+  }
+
+  return minimumDifference;
+
+} // end NeighborhoodDifference()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TImage >
+void
+StreamedImageComparator< TImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfStreamDivisions: " << this->m_NumberOfStreamDivisions << std::endl;
+  os << indent << "DifferenceThreshold: " << this->m_DifferenceThreshold << std::endl;
+  os << indent << "ToleranceRadius: " << this->m_ToleranceRadius << std::endl;
+  os << indent << "StopAtFirstDifference: " << this->m_StopAtFirstDifference << std::endl;
+  os << indent << "ComputeDifferenceImage: " << this->m_ComputeDifferenceImage << std::endl;
+  os << indent << "NumberOfPixelsWithDifferences: " << this->m_NumberOfPixelsWithDifferences << std::endl;
+  os << indent << "MaximumDifference: " << this->m_MaximumDifference << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace itk
+
+#endif // end #ifndef __itkStreamedImageComparator_txx_
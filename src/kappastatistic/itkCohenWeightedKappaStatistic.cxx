@@ -168,12 +168,9 @@ CohenWeightedKappaStatistic
  */
 
 void CohenWeightedKappaStatistic
-::ComputeConfusionMatrix( const unsigned int N, const unsigned int k )
+::ComputeConfusionMatrix( const unsigned int k )
 {
-  /** n:  the number of observers
-   *  N:  the number of observations
-   *  k:  the number of categories
-   */
+  /** k:  the number of categories */
 
   /** Construct the confusion matrix. */
   this->m_ConfusionMatrix.resize( 0 );
@@ -186,13 +183,14 @@ void CohenWeightedKappaStatistic
   /** An element f_{ij} of the confusion matrix should denote
    * the number of times that observer 1 rates a subject in category i
    * and observer 2 in category j.
-   * We loop over the observations, and increase the correct bin.
+   * We loop over the distinct observations, and increase the correct bin
+   * with the frequency of the observation.
    */
-  for( unsigned int i = 0; i < N; ++i )
+  for( unsigned int i = 0; i < this->m_Observations[ 0 ].size(); ++i )
   {
     unsigned int ind0 = this->m_Indices[ this->m_Observations[ 0 ][ i ] ];
     unsigned int ind1 = this->m_Indices[ this->m_Observations[ 1 ][ i ] ];
-    this->m_ConfusionMatrix[ ind0 ][ ind1 ]++;
+    this->m_ConfusionMatrix[ ind0 ][ ind1 ] += this->m_Frequencies[ i ];
   }
 
 } // end ComputeConfusionMatrix()
@@ -232,7 +230,7 @@ void CohenWeightedKappaStatistic
   }
 
   /** Compute the observation matrix. */
-  this->ComputeConfusionMatrix( N, k );
+  this->ComputeConfusionMatrix( k );
 
   /** We are ready to compute the kappa statistic.
    * This is done in parts:
@@ -260,7 +258,7 @@ void CohenWeightedKappaStatistic
     }
   }
   Po /= N;
-  Pe /= N * N;
+  Pe /= static_cast<double>( N ) * N;
 
   // the above can probably be done in one loop over i and j,
   // but this is much better readable.
@@ -306,7 +304,7 @@ void CohenWeightedKappaStatistic
   }
 
   /** Compute the observation matrix. */
-  this->ComputeConfusionMatrix( N, k );
+  this->ComputeConfusionMatrix( k );
 
   /** We are ready to compute the kappa statistic.
    * This is done in parts:
@@ -340,7 +338,7 @@ void CohenWeightedKappaStatistic
     barwj[ i ] /= N;
   }
   Po /= N;
-  Pe /= N * N;
+  Pe /= static_cast<double>( N ) * N;
 
   // the above can probably be done in one loop over i and j,
   // but this is much better readable.
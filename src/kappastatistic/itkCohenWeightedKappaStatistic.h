@@ -98,7 +98,7 @@ private:
   /** A helper function that calculate the confusion matrix,
    * i.e. the f_{ij}.
    */
-  void ComputeConfusionMatrix( const unsigned int N, const unsigned int k );
+  void ComputeConfusionMatrix( const unsigned int k );
 
   /** Member variables. */
   std::string m_WeightsName;
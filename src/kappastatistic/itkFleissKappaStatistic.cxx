@@ -24,7 +24,7 @@ void FleissKappaStatistic
 {
   /**
    * n:  the number of observers
-   * N:  the number of observations
+   * N:  the number of distinct observations
    * k:  the number of categories
    *
    * The observation matrix is of size N by k, i.e. the columns
@@ -32,7 +32,8 @@ void FleissKappaStatistic
    * observations of the n observers.
    * An element n_{ij} of the observation matrix should denote
    * the number of observers that give observation / subject / case
-   * i a rating in category j.
+   * i a rating in category j. Row i stands for m_Frequencies[ i ]
+   * identical observations.
    */
 
   /** Construct the observation matrix. */
@@ -70,9 +71,10 @@ void FleissKappaStatistic
   unsigned int n = this->GetNumberOfObservers();
   unsigned int N = this->GetNumberOfObservations();
   unsigned int k = this->GetNumberOfCategories();
+  unsigned int distinct = this->m_Observations[ 0 ].size();
 
   /** Compute the observation matrix. */
-  this->ComputeObservationMatrix( n, N, k );
+  this->ComputeObservationMatrix( n, distinct, k );
 
   /** We are ready to compute the kappa statistic.
    * This is done in parts:
@@ -80,19 +82,20 @@ void FleissKappaStatistic
    * - calculate P[ i ] and Po
    */
   std::vector< double > p( k, 0.0 );
-  std::vector< double > P( N, 0.0 );
+  std::vector< double > P( distinct, 0.0 );
   Po = Pe = kappa = 0.0;
   for( unsigned int j = 0; j < k; ++j )
   {
-    for( unsigned int i = 0; i < N; ++i )
+    for( unsigned int i = 0; i < distinct; ++i )
     {
-      p[ j ] += static_cast<double>( this->m_ObservationMatrix[ i ][ j ] );
+      p[ j ] += static_cast<double>( this->m_Frequencies[ i ] )
+        * this->m_ObservationMatrix[ i ][ j ];
     }
-    p[ j ] /= static_cast<double>( n * N );
+    p[ j ] /= static_cast<double>( n ) * N;
     Pe += p[ j ] * p[ j ];
   }
 
-  for( unsigned int i = 0; i < N; ++i )
+  for( unsigned int i = 0; i < distinct; ++i )
   {
     for( unsigned int j = 0; j < k; ++j )
     {
@@ -100,7 +103,7 @@ void FleissKappaStatistic
       P[ i ] += nij * nij - nij;
     }
     P[ i ] /= n * ( n - 1.0 );
-    Po += P[ i ];
+    Po += this->m_Frequencies[ i ] * P[ i ];
   }
   Po /= N;
 
@@ -128,9 +131,10 @@ void FleissKappaStatistic
   unsigned int n = this->GetNumberOfObservers();
   unsigned int N = this->GetNumberOfObservations();
   unsigned int k = this->GetNumberOfCategories();
+  unsigned int distinct = this->m_Observations[ 0 ].size();
 
   /** Compute the observation matrix. */
-  this->ComputeObservationMatrix( n, N, k );
+  this->ComputeObservationMatrix( n, distinct, k );
 
   /** We are ready to compute the kappa statistic.
    * This is done in parts:
@@ -138,21 +142,22 @@ void FleissKappaStatistic
    * - calculate P[ i ] and Po
    */
   std::vector< double > p( k, 0.0 );
-  std::vector< double > P( N, 0.0 );
+  std::vector< double > P( distinct, 0.0 );
   double p3 = 0.0;
   Po = Pe = kappa = std = 0.0;
   for( unsigned int j = 0; j < k; ++j )
   {
-    for( unsigned int i = 0; i < N; ++i )
+    for( unsigned int i = 0; i < distinct; ++i )
     {
-      p[ j ] += static_cast<double>( this->m_ObservationMatrix[ i ][ j ] );
+      p[ j ] += static_cast<double>( this->m_Frequencies[ i ] )
+        * this->m_ObservationMatrix[ i ][ j ];
     }
-    p[ j ] /= static_cast<double>( n * N );
+    p[ j ] /= static_cast<double>( n ) * N;
     Pe += p[ j ] * p[ j ];
     p3 += p[ j ] * p[ j ] * p[ j ];
   }
 
-  for( unsigned int i = 0; i < N; ++i )
+  for( unsigned int i = 0; i < distinct; ++i )
   {
     for( unsigned int j = 0; j < k; ++j )
     {
@@ -160,7 +165,7 @@ void FleissKappaStatistic
       P[ i ] += nij * nij - nij;
     }
     P[ i ] /= n * ( n - 1.0 );
-    Po += P[ i ];
+    Po += this->m_Frequencies[ i ] * P[ i ];
   }
   Po /= N;
 
@@ -170,7 +175,7 @@ void FleissKappaStatistic
   /** Compute the standard deviation. */
   std = Pe - ( 2.0 * n - 3.0 ) * Pe * Pe + 2.0 * ( n - 2.0 ) * p3;
   std /= ( 1.0 - Pe ) * ( 1.0 - Pe );
-  std *= 2.0 / ( N * n * ( n - 1.0 ) );
+  std *= 2.0 / ( static_cast<double>( N ) * n * ( n - 1.0 ) );
   std = vcl_sqrt( std );
 
   /** Compute kappa. */
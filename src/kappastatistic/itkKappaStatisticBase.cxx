@@ -24,12 +24,28 @@ KappaStatisticBase
 
 void KappaStatisticBase
 ::SetObservations( const SamplesType observations )
+{
+  FrequenciesType frequencies;
+  if( observations.size() ) frequencies.resize( observations[ 0 ].size(), 1 );
+  this->SetObservations( observations, frequencies );
+
+} // end SetObservations()
+
+
+/**
+ * *************** SetObservations ****************
+ */
+
+void KappaStatisticBase
+::SetObservations( const SamplesType observations,
+  const FrequenciesType & frequencies )
 {
   bool check = this->CheckObservations( observations );
-  if( check )
+  if( check && frequencies.size() == observations[ 0 ].size() )
   {
     this->Modified();
     this->m_Observations = observations;
+    this->m_Frequencies = frequencies;
 
     this->ComputeNumberOfObservers();
     this->ComputeNumberOfObservations();
@@ -62,6 +78,18 @@ KappaStatisticBase
 } // end GetObservations()
 
 
+/**
+ * *************** GetFrequencies ****************
+ */
+
+KappaStatisticBase::FrequenciesType
+KappaStatisticBase
+::GetFrequencies( void ) const
+{
+  return this->m_Frequencies;
+} // end GetFrequencies()
+
+
 /**
  * *************** ComputeNumberOfObservers ****************
  */
@@ -80,13 +108,11 @@ void KappaStatisticBase
 void KappaStatisticBase
 ::ComputeNumberOfObservations( void )
 {
-  if( this->m_Observations.size() )
-  {
-    this->m_NumberOfObservations = this->m_Observations[ 0 ].size();
-  }
-  else
+  /** The sum of the frequencies. */
+  this->m_NumberOfObservations = 0;
+  for( unsigned int i = 0; i < this->m_Frequencies.size(); ++i )
   {
-    this->m_NumberOfObservations = 0;
+    this->m_NumberOfObservations += this->m_Frequencies[ i ];
   }
 } // end ComputeNumberOfObservations()
 
@@ -115,6 +141,7 @@ void KappaStatisticBase
   categories.unique();
 
   /** Store the indices corresponding to the category label. */
+  this->m_Indices.clear();
   std::list<CategoryType>::iterator iter;
   unsigned int l = 0;
   for ( iter = categories.begin(); iter != categories.end(); iter++ )
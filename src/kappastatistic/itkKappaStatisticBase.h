@@ -40,6 +40,11 @@ namespace Statistics {
  * N:  the number of observations
  * k:  the number of categories
  *
+ * Optionally every observation can be given a frequency, the number of
+ * times it was made. This way a large number of observations, e.g. the
+ * voxels of label images, can be passed compactly as the distinct
+ * combinations of categories and their counts. N is then the sum of the
+ * frequencies.
  *
  * \ingroup Statistics
  *
@@ -65,11 +70,17 @@ public:
   typedef std::vector< CategoryType > SampleType;
   typedef std::vector< SampleType >   SamplesType;
   typedef unsigned int                CountType;
+  typedef std::vector< CountType >    FrequenciesType;
 
-  /** Set and get the observations. */
+  /** Set and get the observations. Each observation is made once. */
   virtual void SetObservations( const SamplesType observations );
   SamplesType GetObservations( void ) const;
 
+  /** Set the observations, where observation i is made frequencies[ i ] times. */
+  virtual void SetObservations( const SamplesType observations,
+    const FrequenciesType & frequencies );
+  FrequenciesType GetFrequencies( void ) const;
+
   /** Get the number of observers. */
   itkGetConstMacro( NumberOfObservers, CountType );
 
@@ -96,6 +107,7 @@ protected:
   virtual bool CheckObservations( const SamplesType & observations ) const;
 
   SamplesType m_Observations;
+  FrequenciesType m_Frequencies;
   std::map<unsigned int,unsigned int>  m_Indices;
 
 private:
@@ -0,0 +1,145 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkLabelImageObservationsGenerator_h_
+#define __itkLabelImageObservationsGenerator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+#include "itkKappaStatisticBase.h"
+#include <vector>
+#include <map>
+
+
+namespace itk {
+namespace Statistics {
+
+/** \class LabelImageObservationsGenerator
+ * \brief Collects the observations for a kappa statistic from the label
+ * images of two or more observers, in a streamed and threaded pass.
+ *
+ * Every voxel is an observation, and the label of observer r in that voxel
+ * is its rating. The labels are cast to KappaStatisticBase::CategoryType.
+ * Instead of one observation per voxel, the distinct combinations of
+ * labels are collected together with the number of voxels in which they
+ * occur. This is all KappaStatisticBase::SetObservations( observations,
+ * frequencies ) needs: for two observers it is the confusion matrix, for
+ * more observers the observation matrix of Fleiss, in compressed form.
+ *
+ * All label images are requested piece by piece from the upstream
+ * pipeline. Every piece is split over the threads, and each thread counts
+ * the combinations in its own table. Segmentations are mostly made of
+ * runs of equal labels, so the combination of the previous voxel is tried
+ * before the table is searched. The tables of the threads are merged
+ * after the pass.
+ */
+
+template< class TLabelImage >
+class LabelImageObservationsGenerator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef LabelImageObservationsGenerator   Self;
+  typedef Object                            Superclass;
+  typedef SmartPointer<Self>                Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( LabelImageObservationsGenerator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TLabelImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TLabelImage                               LabelImageType;
+  typedef typename LabelImageType::Pointer          LabelImagePointer;
+  typedef typename LabelImageType::RegionType       RegionType;
+  typedef KappaStatisticBase::CategoryType          CategoryType;
+  typedef KappaStatisticBase::SampleType            SampleType;
+  typedef KappaStatisticBase::SamplesType           SamplesType;
+  typedef KappaStatisticBase::CountType             CountType;
+  typedef KappaStatisticBase::FrequenciesType       FrequenciesType;
+
+  /** Add the label image of the next observer. It is not const, since
+   * requested regions are set on it to drive the upstream pipeline.
+   */
+  void AddInput( LabelImageType * image );
+
+  /** Set the number of pieces in which the images are processed. */
+  itkSetMacro( NumberOfStreamDivisions, unsigned int );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
+  /** Set the number of threads. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Triggers the computation; this is the only pass over the images. */
+  void Compute( void );
+
+  /** The distinct observations, one vector per observer, and their
+   * frequencies. Valid after Compute().
+   */
+  const SamplesType & GetObservations( void ) const
+  { return this->m_Observations; }
+  const FrequenciesType & GetFrequencies( void ) const
+  { return this->m_Frequencies; }
+
+protected:
+  LabelImageObservationsGenerator();
+  virtual ~LabelImageObservationsGenerator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** The counts per combination of labels. */
+  typedef std::map< SampleType, CountType >         CombinationsType;
+
+  /** Count the combinations in a region of the current piece. */
+  void ThreadedCount( const RegionType & region, ThreadIdType threadId );
+
+private:
+  LabelImageObservationsGenerator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  /** Callback for the multithreader. */
+  static ITK_THREAD_RETURN_TYPE CountThreaderCallback( void * arg );
+
+  std::vector<LabelImagePointer>  m_Inputs;
+  unsigned int                    m_NumberOfStreamDivisions;
+  unsigned int                    m_NumberOfThreads;
+
+  /** The current piece, and the counts of every thread. */
+  RegionType                      m_Piece;
+  std::vector<CombinationsType>   m_ThreadCombinations;
+
+  /** Results. */
+  SamplesType                     m_Observations;
+  FrequenciesType                 m_Frequencies;
+
+}; // end class LabelImageObservationsGenerator
+
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelImageObservationsGenerator.txx"
+#endif
+
+#endif // end #ifndef __itkLabelImageObservationsGenerator_h_
@@ -0,0 +1,229 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkLabelImageObservationsGenerator_txx_
+#define __itkLabelImageObservationsGenerator_txx_
+
+#include "itkLabelImageObservationsGenerator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionSplitter.h"
+#include "vnl/vnl_math.h"
+
+
+namespace itk {
+namespace Statistics {
+
+/**
+ * ************************* Constructor ************************
+ */
+
+template< class TLabelImage >
+LabelImageObservationsGenerator< TLabelImage >
+::LabelImageObservationsGenerator()
+{
+  this->m_NumberOfStreamDivisions = 1;
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+} // end Constructor()
+
+
+/**
+ * ************************* AddInput ************************
+ */
+
+template< class TLabelImage >
+void
+LabelImageObservationsGenerator< TLabelImage >
+::AddInput( LabelImageType * image )
+{
+  this->m_Inputs.push_back( image );
+  this->Modified();
+
+} // end AddInput()
+
+
+/**
+ * ************************* Compute ************************
+ */
+
+template< class TLabelImage >
+void
+LabelImageObservationsGenerator< TLabelImage >
+::Compute( void )
+{
+  const unsigned int numberOfObservers = this->m_Inputs.size();
+  if( numberOfObservers < 2 )
+  {
+    itkExceptionMacro( << "ERROR: at least two label images are required." );
+  }
+
+  /** Only the meta data is read here. */
+  for( unsigned int r = 0; r < numberOfObservers; ++r )
+  {
+    this->m_Inputs[ r ]->UpdateOutputInformation();
+  }
+  const RegionType largestRegion = this->m_Inputs[ 0 ]->GetLargestPossibleRegion();
+  for( unsigned int r = 1; r < numberOfObservers; ++r )
+  {
+    if( this->m_Inputs[ r ]->GetLargestPossibleRegion() != largestRegion )
+    {
+      itkExceptionMacro( << "ERROR: all label images should have the same size." );
+    }
+  }
+
+  /** The single pass over the images. */
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( this->m_NumberOfThreads );
+  this->m_ThreadCombinations.assign( threader->GetNumberOfThreads(), CombinationsType() );
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(
+    largestRegion, vnl_math_max( 1u, this->m_NumberOfStreamDivisions ) );
+  for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+  {
+    this->m_Piece = splitter->GetSplit( piece, numberOfPieces, largestRegion );
+    for( unsigned int r = 0; r < numberOfObservers; ++r )
+    {
+      this->m_Inputs[ r ]->SetRequestedRegion( this->m_Piece );
+      this->m_Inputs[ r ]->Update();
+    }
+
+    threader->SetSingleMethod( this->CountThreaderCallback, this );
+    threader->SingleMethodExecute();
+  }
+
+  /** Merge the threads. */
+  CombinationsType total;
+  for( unsigned int t = 0; t < this->m_ThreadCombinations.size(); ++t )
+  {
+    const CombinationsType & combinations = this->m_ThreadCombinations[ t ];
+    typename CombinationsType::const_iterator it = combinations.begin();
+    for( ; it != combinations.end(); ++it )
+    {
+      total[ it->first ] += it->second;
+    }
+  }
+  this->m_ThreadCombinations.clear();
+
+  /** Store the distinct observations per observer. */
+  this->m_Observations.assign( numberOfObservers, SampleType() );
+  this->m_Frequencies.clear();
+  typename CombinationsType::const_iterator it = total.begin();
+  for( ; it != total.end(); ++it )
+  {
+    for( unsigned int r = 0; r < numberOfObservers; ++r )
+    {
+      this->m_Observations[ r ].push_back( it->first[ r ] );
+    }
+    this->m_Frequencies.push_back( it->second );
+  }
+
+} // end Compute()
+
+
+/**
+ * ************************* CountThreaderCallback ************************
+ */
+
+template< class TLabelImage >
+ITK_THREAD_RETURN_TYPE
+LabelImageObservationsGenerator< TLabelImage >
+::CountThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int total = splitter->GetNumberOfSplits( self->m_Piece, threadCount );
+  if( threadId < total )
+  {
+    self->ThreadedCount( splitter->GetSplit( threadId, total, self->m_Piece ), threadId );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end CountThreaderCallback()
+
+
+/**
+ * ************************* ThreadedCount ************************
+ */
+
+template< class TLabelImage >
+void
+LabelImageObservationsGenerator< TLabelImage >
+::ThreadedCount( const RegionType & region, ThreadIdType threadId )
+{
+  typedef ImageRegionConstIterator<LabelImageType> IteratorType;
+  const unsigned int numberOfObservers = this->m_Inputs.size();
+  CombinationsType & combinations = this->m_ThreadCombinations[ threadId ];
+
+  std::vector<IteratorType> iterators;
+  for( unsigned int r = 0; r < numberOfObservers; ++r )
+  {
+    iterators.push_back( IteratorType( this->m_Inputs[ r ], region ) );
+  }
+
+  /** The combination of the previous voxel, and its counter. */
+  SampleType sample( numberOfObservers );
+  typename CombinationsType::iterator previous = combinations.end();
+  while( !iterators[ 0 ].IsAtEnd() )
+  {
+    for( unsigned int r = 0; r < numberOfObservers; ++r )
+    {
+      sample[ r ] = static_cast<CategoryType>( iterators[ r ].Value() );
+      ++iterators[ r ];
+    }
+
+    if( previous == combinations.end() || previous->first != sample )
+    {
+      previous = combinations.insert(
+        typename CombinationsType::value_type( sample, 0 ) ).first;
+    }
+    ++previous->second;
+  }
+
+} // end ThreadedCount()
+
+
+/**
+ * ************************* PrintSelf ************************
+ */
+
+template< class TLabelImage >
+void
+LabelImageObservationsGenerator< TLabelImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Inputs: " << this->m_Inputs.size() << " images" << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << this->m_NumberOfStreamDivisions << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+  os << indent << "Distinct observations: " << this->m_Frequencies.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#endif // end #ifndef __itkLabelImageObservationsGenerator_txx_
@@ -23,6 +23,7 @@
 #include "itkCommandLineArgumentParser.h"
 #include "ITKToolsHelpers.h"
 #include "KappaStatisticMainHelper.h"
+#include "kappastatistic.h"
 
 #include "itkFleissKappaStatistic.h"
 #include "itkCohenWeightedKappaStatistic.h"
@@ -38,11 +39,13 @@ std::string GetHelpString( void )
   ss << "ITKTools v" << itktools::GetITKToolsVersion() << "\n"
     << "Usage:" << std::endl
     << "pxkappastatistic" << std::endl
-    << "  -in      inputFilename" << std::endl
+    << "  -in      inputFilename, or" << std::endl
+    << "  -im      the label images of the observers" << std::endl
     << "  -type    the type of the kappa test:" << std::endl
     << "             fleiss: unweighted, for many observers" << std::endl
     << "             cohen: weighted, for two observers only" << std::endl
-    << "  -c       the data columns on which the kappa test is performed" << std::endl
+    << "  [-c]     the data columns on which the kappa test is performed," << std::endl
+    << "           required with \"-in\"" << std::endl
     << "  [-w]     the weights used in the Cohen kappa test, default linear:" << std::endl
     << "             linear:    1 - | i - j | / ( k - 1 )" << std::endl
     << "             quadratic: 1 - [ (i - j ) / ( k - 1 ) ]^2" << std::endl
@@ -56,15 +59,28 @@ std::string GetHelpString( void )
     << "             all: print all" << std::endl
     << "             ALL: print more" << std::endl
     << " [-p]     the output precision, default = 8:" << std::endl
+    << "  [-s]     number of streams for \"-im\", default 8" << std::endl
+    << "  [-threads] maximum number of threads, default all" << std::endl
     << "The input file should be in a certain format. No text is allowed." << std::endl
     << "No headers are allowed. The data samples should be displayed in columns." << std::endl
     << "Columns should be separated by a single space or tab." << std::endl
+    << "With \"-im\" every voxel is an observation, and the label of each image" << std::endl
+    << "is the rating of an observer. The images should have the same size." << std::endl
+    << "Supported: 2D, 3D, (unsigned) char, short, int." << std::endl
     << "For more information about the kappa statistic and this implementation, read the tex-file found in the repository.";
 
   return ss.str();
 
 } // end GetHelpString()
 
+/* Declare GetImageObservations. */
+bool GetImageObservations( const std::vector<std::string> & fileNames,
+  const unsigned int numberOfStreams,
+  std::vector<std::vector<unsigned int> > & observations,
+  std::vector<unsigned int> & frequencies );
+
+//-------------------------------------------------------------------------------------
+
 int main( int argc, char **argv )
 {
   /** Create a command line argument parser. */
@@ -72,9 +88,12 @@ int main( int argc, char **argv )
   parser->SetCommandLineArguments( argc, argv );
   parser->SetProgramHelpText( GetHelpString() );
 
-  parser->MarkArgumentAsRequired( "-in", "The input filename." );
+  std::vector<std::string> exactlyOneArguments;
+  exactlyOneArguments.push_back( "-in" );
+  exactlyOneArguments.push_back( "-im" );
+
+  parser->MarkExactlyOneOfArgumentsAsRequired( exactlyOneArguments );
   parser->MarkArgumentAsRequired( "-type", "The type." );
-  parser->MarkArgumentAsRequired( "-c", "Columns." );
 
   itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
 
@@ -91,6 +110,9 @@ int main( int argc, char **argv )
   std::string inputFileName = "";
   bool retin = parser->GetCommandLineArgument( "-in", inputFileName );
 
+  std::vector<std::string> inputImageFileNames;
+  bool retim = parser->GetCommandLineArgument( "-im", inputImageFileNames );
+
   std::vector<unsigned int> columns;
   parser->GetCommandLineArgument( "-c", columns );
 
@@ -111,6 +133,13 @@ int main( int argc, char **argv )
   double kappacmp = 0.0;
   bool retcmp = parser->GetCommandLineArgument( "-cmp", kappacmp );
 
+  unsigned int numberOfStreams = 8;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
   /** Check command line arguments. */
   type = itksys::SystemTools::LowerCase( type );
   if( type != "fleiss" && type != "cohen" )
@@ -119,7 +148,13 @@ int main( int argc, char **argv )
     return EXIT_FAILURE;
   }
 
-  if( columns.size() < 2 )
+  if( retim && inputImageFileNames.size() < 2 )
+  {
+    std::cerr << "ERROR: You should specify at least two images with \"-im\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !retim && columns.size() < 2 )
   {
     std::cerr << "ERROR: You should specify at least two columns with \"-c\"." << std::endl;
     return EXIT_FAILURE;
@@ -134,15 +169,27 @@ int main( int argc, char **argv )
 
   if( retcmp ) exstd = true;
 
-  /** Read the input file. */
-  std::vector< std::vector<unsigned int> > matrix;
-  retin = GetInputData( inputFileName, columns, matrix );
-  if( !retin ) return EXIT_FAILURE;
-
   /** Typedefs. */
   typedef itk::Statistics::FleissKappaStatistic         FleissType;
   typedef itk::Statistics::CohenWeightedKappaStatistic  CohenType;
   typedef FleissType::SamplesType                       SamplesType;
+  typedef FleissType::FrequenciesType                   FrequenciesType;
+
+  /** Read the input file, or collect the observations from the images. */
+  SamplesType matrix;
+  FrequenciesType frequencies;
+  if( retim )
+  {
+    bool retobs = GetImageObservations( inputImageFileNames, numberOfStreams,
+      matrix, frequencies );
+    if( !retobs ) return EXIT_FAILURE;
+  }
+  else
+  {
+    retin = GetInputData( inputFileName, columns, matrix );
+    if( !retin ) return EXIT_FAILURE;
+    frequencies.assign( matrix[ 0 ].size(), 1 );
+  }
 
   /** Create the kappa calculators. */
   FleissType::Pointer fleiss = FleissType::New();
@@ -155,7 +202,7 @@ int main( int argc, char **argv )
   {
     if( type == "fleiss" )
     {
-      fleiss->SetObservations( matrix );
+      fleiss->SetObservations( matrix, frequencies );
 
       n = fleiss->GetNumberOfObservers();
       N = fleiss->GetNumberOfObservations();
@@ -172,7 +219,7 @@ int main( int argc, char **argv )
     }
     else if( type == "cohen" )
     {
-      cohen->SetObservations( matrix );
+      cohen->SetObservations( matrix, frequencies );
 
       n = cohen->GetNumberOfObservers();
       N = cohen->GetNumberOfObservations();
@@ -230,3 +277,77 @@ int main( int argc, char **argv )
   return EXIT_SUCCESS;
 
 } // end main
+
+
+/*
+ * ******************* GetImageObservations *******************
+ *
+ * This function collects the observations from the label images:
+ * the distinct combinations of labels and their frequencies.
+ */
+
+bool GetImageObservations( const std::vector<std::string> & fileNames,
+  const unsigned int numberOfStreams,
+  std::vector<std::vector<unsigned int> > & observations,
+  std::vector<unsigned int> & frequencies )
+{
+  /** Determine image properties. */
+  itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+  itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  unsigned int dim = 0;
+  unsigned int numberOfComponents = 0;
+  bool retgip = itktools::GetImageProperties(
+    fileNames[ 0 ], pixelType, componentType, dim, numberOfComponents );
+  if( !retgip ) return false;
+
+  /** Check for vector images. */
+  bool retNOCCheck = itktools::NumberOfComponentsCheck( numberOfComponents );
+  if( !retNOCCheck ) return false;
+
+  /** Class that does the work. */
+  ITKToolsKappaImageObservationsBase * filter = NULL;
+
+  try
+  {
+    // now call all possible template combinations.
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 2, int >::New( dim, componentType );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsKappaImageObservations< 3, int >::New( dim, componentType );
+#endif
+    /** Check if filter was instantiated. */
+    bool supported = itktools::IsFilterSupportedCheck( filter, dim, componentType );
+    if( !supported ) return false;
+
+    /** Set the filter arguments. */
+    filter->m_InputFileNames = fileNames;
+    filter->m_NumberOfStreams = numberOfStreams;
+
+    filter->Run();
+
+    observations = filter->m_Observations;
+    frequencies = filter->m_Frequencies;
+
+    delete filter;
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    delete filter;
+    return false;
+  }
+
+  /** Return a value. */
+  return true;
+
+} // end GetImageObservations()
@@ -0,0 +1,105 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __kappastatistic_h_
+#define __kappastatistic_h_
+
+#include "ITKToolsBase.h"
+
+#include "itkImageFileReader.h"
+#include "itkLabelImageObservationsGenerator.h"
+
+
+/** \class ITKToolsKappaImageObservationsBase
+ *
+ * Untemplated pure virtual base class that holds
+ * the Run() function and all required parameters.
+ */
+
+class ITKToolsKappaImageObservationsBase : public itktools::ITKToolsBase
+{
+public:
+  typedef itk::Statistics::KappaStatisticBase   KappaStatisticType;
+
+  /** Constructor. */
+  ITKToolsKappaImageObservationsBase()
+  {
+    this->m_NumberOfStreams = 8;
+  };
+  /** Destructor. */
+  ~ITKToolsKappaImageObservationsBase(){};
+
+  /** Input member parameters. */
+  std::vector<std::string> m_InputFileNames;
+  unsigned int m_NumberOfStreams;
+
+  /** Output member parameters. */
+  KappaStatisticType::SamplesType m_Observations;
+  KappaStatisticType::FrequenciesType m_Frequencies;
+
+}; // end class ITKToolsKappaImageObservationsBase
+
+
+/** \class ITKToolsKappaImageObservations
+ *
+ * Templated class that implements the Run() function
+ * and the New() function for its creation.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+class ITKToolsKappaImageObservations : public ITKToolsKappaImageObservationsBase
+{
+public:
+  /** Standard ITKTools stuff. */
+  typedef ITKToolsKappaImageObservations Self;
+  itktoolsOneTypeNewMacro( Self );
+
+  ITKToolsKappaImageObservations(){};
+  ~ITKToolsKappaImageObservations(){};
+
+  /** Run function. */
+  void Run( void )
+  {
+    /** Typedefs. */
+    typedef itk::Image< TComponentType, VDimension >      ImageType;
+    typedef itk::ImageFileReader< ImageType >             ReaderType;
+    typedef itk::Statistics::LabelImageObservationsGenerator<
+      ImageType >                                         GeneratorType;
+
+    /** Setup the readers; the pixels are read piece by piece by the generator. */
+    typename GeneratorType::Pointer generator = GeneratorType::New();
+    std::vector<typename ReaderType::Pointer> readers( this->m_InputFileNames.size() );
+    for( unsigned int i = 0; i < this->m_InputFileNames.size(); ++i )
+    {
+      readers[ i ] = ReaderType::New();
+      readers[ i ]->SetFileName( this->m_InputFileNames[ i ] );
+      generator->AddInput( readers[ i ]->GetOutput() );
+    }
+
+    /** Count the combinations of labels. */
+    generator->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    generator->Compute();
+
+    this->m_Observations = generator->GetObservations();
+    this->m_Frequencies = generator->GetFrequencies();
+
+  } // end Run()
+
+}; // end class ITKToolsKappaImageObservations
+
+
+#endif // end #ifndef __kappastatistic_h_
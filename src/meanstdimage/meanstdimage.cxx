@@ -43,6 +43,9 @@ std::string GetHelpString( void )
     << "  -in        list of inputFilenames\n"
     << "  [-outmean] outputFilename for mean image; always written as float\n"
     << "  [-outstd]  outputFilename for standard deviation image; always written as float,\n"
+    << "  [-s]       number of slabs; if given, the inputs are read slab by slab,\n"
+    << "             several inputs in parallel, and accumulated in double precision.\n"
+    << "             This needs much less memory; default 0: read the inputs as a whole.\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, float, double.";
 
   return ss.str();
@@ -86,6 +89,9 @@ int main( int argc, char **argv )
   parser->GetCommandLineArgument( "-outstd", outputFileNameStd );
   bool retoutstd  = parser->GetCommandLineArgument( "-outstd", outputFileNameStd );
 
+  unsigned int numberOfStreams = 0;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
   /** Determine image properties. */
   itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
@@ -130,6 +136,7 @@ int main( int argc, char **argv )
     filter->m_OutputFileNameStd = outputFileNameStd;
     filter->m_CalcMean = retoutmean;
     filter->m_CalcStd = retoutstd;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
@@ -21,6 +21,8 @@
 #include "ITKToolsBase.h"
 
 #include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkMultiThreader.h"
 #include <string>
 #include <vector>
 
@@ -42,6 +44,7 @@ public:
     this->m_OutputFileNameStd = "";
     this->m_CalcMean = false;
     this->m_CalcStd = false;
+    this->m_NumberOfStreams = 0;
   };
   /** Destructor. */
   ~ITKToolsMeanStdImageBase(){};
@@ -52,6 +55,7 @@ public:
   std::string              m_OutputFileNameStd;
   bool                     m_CalcMean;
   bool                     m_CalcStd;
+  unsigned int             m_NumberOfStreams;
 
 }; // end class ITKToolsMeanStdImageBase
 
@@ -77,9 +81,25 @@ public:
   typedef itk::Image< TComponentType, VDimension >  InputImageType;
   typedef itk::Image< float, VDimension >           OutputImageType;
 
+  typedef itk::ImageFileReader< InputImageType >    ReaderType;
+  typedef typename ReaderType::Pointer              ReaderPointer;
+  typedef typename InputImageType::RegionType       RegionType;
+
   /** Run function. */
   void Run( void )
   {
+    if( this->m_NumberOfStreams > 0 )
+    {
+      this->MeanStdImageStreamed(
+        this->m_InputFileNames,
+        this->m_CalcMean,
+        this->m_OutputFileNameMean,
+        this->m_CalcStd,
+        this->m_OutputFileNameStd,
+        this->m_NumberOfStreams );
+      return;
+    }
+
     this->MeanStdImage(
       this->m_InputFileNames,
       this->m_CalcMean,
@@ -95,6 +115,35 @@ public:
     const bool calc_mean, const std::string & outputFileNameMean,
     const bool calc_std, const std::string & outputFileNameStd );
 
+  /** Computes the same images, but reads the inputs slab by slab,
+   * several inputs in parallel, and accumulates them with Welford's
+   * algorithm in double precision.
+   */
+  void MeanStdImageStreamed(
+    const std::vector<std::string> & inputFileNames,
+    const bool calc_mean, const std::string & outputFileNameMean,
+    const bool calc_std, const std::string & outputFileNameStd,
+    const unsigned int numberOfStreams );
+
+protected:
+
+  /** Thread callback that reads the current slab of one input of the batch. */
+  static ITK_THREAD_RETURN_TYPE ReadThreaderCallback( void * arg );
+
+  /** Thread callback that adds the current batch to a part of the slab accumulators. */
+  static ITK_THREAD_RETURN_TYPE AccumulateThreaderCallback( void * arg );
+
+  /** State of the streamed mode, shared by the threads. */
+  std::vector<ReaderPointer>                  m_Readers;
+  std::vector<std::string>                    m_ReadErrors;
+  std::vector<const TComponentType *>         m_BatchData;
+  std::vector< std::vector<TComponentType> >  m_BatchScratch;
+  std::vector<double>                         m_SlabMean;
+  std::vector<double>                         m_SlabM2;
+  RegionType                                  m_Slab;
+  unsigned int                                m_BatchBegin;
+  unsigned int                                m_BatchEnd;
+
 }; // end class MeanStdImage
 
 #include "meanstdimage.hxx"
@@ -20,6 +20,11 @@
 
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
+#include "itkImageRegionSplitter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageIOFactory.h"
+#include <itksys/SystemTools.hxx>
+#include <algorithm>
 
 template< unsigned int VDimension, class TComponentType >
 void
@@ -150,5 +155,364 @@ ITKToolsMeanStdImage< VDimension, TComponentType >
 
 } // end MeanStdImage()
 
+
+/**
+ * ******************* MeanStdImageStreamed *******************
+ *
+ * The image domain is split in slabs. For each slab the inputs are read
+ * in batches of one input per thread, so that only a few slabs of input
+ * data are in memory at the same time. Each batch is added to double
+ * precision accumulators of the slab with Welford's update:
+ *   mean_n = mean_{n-1} + ( x_n - mean_{n-1} ) / n
+ *   M2_n   = M2_{n-1} + ( x_n - mean_{n-1} ) * ( x_n - mean_n )
+ * which avoids the cancellation of E(X^2) - E(X)^2.
+ * When the output format supports it, the mean and std of each slab are
+ * pasted into the output files as soon as the slab is finished, so that
+ * no full size image is kept in memory.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+void
+ITKToolsMeanStdImage< VDimension, TComponentType >
+::MeanStdImageStreamed(
+  const std::vector<std::string> & inputFileNames,
+  const bool calc_mean,
+  const std::string & outputFileNameMean,
+  const bool calc_std,
+  const std::string & outputFileNameStd,
+  const unsigned int numberOfStreams )
+{
+  /** TYPEDEF's. */
+  typedef typename OutputImageType::Pointer             OutImagePointer;
+  typedef itk::ImageFileWriter< OutputImageType >       WriterType;
+  typedef itk::ImageRegionSplitter< VDimension >        SplitterType;
+  typedef itk::ImageRegionConstIterator<InputImageType> InputIteratorType;
+
+  const unsigned int nrInputs = inputFileNames.size();
+
+  /** Create the readers and read the image information only. The readers
+   * are created here, and not in the threads, since the ImageIO factory
+   * mechanism is not thread safe.
+   */
+  this->m_Readers.resize( nrInputs );
+  bool canStreamRead = true;
+  for( unsigned int i = 0; i < nrInputs; ++i )
+  {
+    this->m_Readers[ i ] = ReaderType::New();
+    this->m_Readers[ i ]->SetFileName( inputFileNames[ i ].c_str() );
+    this->m_Readers[ i ]->UpdateOutputInformation();
+    canStreamRead &= this->m_Readers[ i ]->GetImageIO()->CanStreamRead();
+
+    if( this->m_Readers[ i ]->GetOutput()->GetLargestPossibleRegion()
+      != this->m_Readers[ 0 ]->GetOutput()->GetLargestPossibleRegion() )
+    {
+      itkGenericExceptionMacro( << "ERROR: the size of " << inputFileNames[ i ]
+        << " differs from the size of " << inputFileNames[ 0 ] );
+    }
+  }
+  const RegionType largestRegion
+    = this->m_Readers[ 0 ]->GetOutput()->GetLargestPossibleRegion();
+
+  /** Set up the output files; they can be written slab by slab if the
+   * format supports pasting. The IO objects are configured as
+   * ImageFileWriter does, and write the slabs directly.
+   */
+  const std::string outputFileNames[ 2 ] = { outputFileNameMean, outputFileNameStd };
+  const bool calcOutput[ 2 ] = { calc_mean, calc_std };
+  itk::ImageIOBase::Pointer outputIOs[ 2 ];
+  bool canStreamWrite = true;
+  for( unsigned int o = 0; o < 2; ++o )
+  {
+    if( !calcOutput[ o ] ) continue;
+    outputIOs[ o ] = itk::ImageIOFactory::CreateImageIO(
+      outputFileNames[ o ].c_str(), itk::ImageIOFactory::WriteMode );
+    canStreamWrite &= outputIOs[ o ].IsNotNull() && outputIOs[ o ]->CanStreamWrite();
+  }
+  if( canStreamWrite )
+  {
+    const InputImageType * reference = this->m_Readers[ 0 ]->GetOutput();
+    typename InputImageType::PointType origin;
+    reference->TransformIndexToPhysicalPoint( largestRegion.GetIndex(), origin );
+    for( unsigned int o = 0; o < 2; ++o )
+    {
+      if( !calcOutput[ o ] ) continue;
+      itk::ImageIOBase * io = outputIOs[ o ];
+      io->SetNumberOfDimensions( VDimension );
+      io->SetPixelTypeInfo( static_cast<const float *>( 0 ) );
+      for( unsigned int d = 0; d < VDimension; ++d )
+      {
+        io->SetDimensions( d, largestRegion.GetSize( d ) );
+        io->SetSpacing( d, reference->GetSpacing()[ d ] );
+        io->SetOrigin( d, origin[ d ] );
+        std::vector<double> axisDirection( VDimension );
+        for( unsigned int e = 0; e < VDimension; ++e )
+        {
+          axisDirection[ e ] = reference->GetDirection()[ e ][ d ];
+        }
+        io->SetDirection( d, axisDirection );
+      }
+      io->SetFileName( outputFileNames[ o ].c_str() );
+
+      /** An existing file with another header can not be pasted into. */
+      itksys::SystemTools::RemoveFile( outputFileNames[ o ].c_str() );
+    }
+  }
+
+  /** Otherwise the outputs are kept whole, and written at the end. */
+  OutImagePointer mean = OutputImageType::New();
+  OutImagePointer std = OutputImageType::New();
+  if( !canStreamWrite )
+  {
+    mean->CopyInformation( this->m_Readers[ 0 ]->GetOutput() );
+    std->CopyInformation( this->m_Readers[ 0 ]->GetOutput() );
+    mean->SetRegions( largestRegion );
+    std->SetRegions( largestRegion );
+    if( calc_mean ) mean->Allocate();
+    if( calc_std ) std->Allocate();
+  }
+  std::vector<float> slabOutput;
+
+  /** If the inputs can not be streamed, every reader produces the whole
+   * image; in that case read one input at a time in a single slab, which
+   * needs no more memory than the non-streamed mode.
+   */
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  const unsigned int numberOfThreads = threader->GetNumberOfThreads();
+  unsigned int numberOfSlabs = numberOfStreams;
+  unsigned int batchSize = numberOfThreads;
+  if( !canStreamRead )
+  {
+    std::cout << "The input images can not be streamed; "
+      << "they are read one by one as a whole." << std::endl;
+    numberOfSlabs = 1;
+    batchSize = 1;
+  }
+
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  numberOfSlabs = splitter->GetNumberOfSplits( largestRegion, numberOfSlabs );
+
+  this->m_ReadErrors.resize( batchSize );
+  this->m_BatchData.resize( batchSize );
+  this->m_BatchScratch.resize( batchSize );
+
+  for( unsigned int slab = 0; slab < numberOfSlabs; ++slab )
+  {
+    std::cout << "Processing slab " << slab + 1 << " of " << numberOfSlabs << std::endl;
+    this->m_Slab = splitter->GetSplit( slab, numberOfSlabs, largestRegion );
+    const std::size_t slabSize = this->m_Slab.GetNumberOfPixels();
+    this->m_SlabMean.assign( slabSize, 0.0 );
+    this->m_SlabM2.assign( slabSize, 0.0 );
+
+    for( unsigned int batch = 0; batch < nrInputs; batch += batchSize )
+    {
+      this->m_BatchBegin = batch;
+      this->m_BatchEnd = vnl_math_min( batch + batchSize, nrInputs );
+      const unsigned int batchCount = this->m_BatchEnd - this->m_BatchBegin;
+
+      /** Read the slab of each input of this batch in parallel. */
+      std::fill( this->m_ReadErrors.begin(), this->m_ReadErrors.end(), std::string() );
+      threader->SetNumberOfThreads( batchCount );
+      threader->SetSingleMethod( this->ReadThreaderCallback, this );
+      threader->SingleMethodExecute();
+      for( unsigned int k = 0; k < batchCount; ++k )
+      {
+        if( !this->m_ReadErrors[ k ].empty() )
+        {
+          itkGenericExceptionMacro( << "ERROR: reading "
+            << inputFileNames[ batch + k ] << " failed:\n" << this->m_ReadErrors[ k ] );
+        }
+      }
+
+      /** Locate the slab in the buffer of each reader. The slab is contiguous
+       * in the buffer if the buffered region spans the slab in all but the
+       * slab's outermost non-singleton dimension. Otherwise copy it.
+       */
+      for( unsigned int k = 0; k < batchCount; ++k )
+      {
+        const InputImageType * image = this->m_Readers[ batch + k ]->GetOutput();
+        const RegionType & buffered = image->GetBufferedRegion();
+        bool contiguous = true;
+        bool spansBuffer = true;
+        for( unsigned int d = 0; d < VDimension; ++d )
+        {
+          if( !spansBuffer && this->m_Slab.GetSize( d ) != 1 ) contiguous = false;
+          if( this->m_Slab.GetSize( d ) != buffered.GetSize( d ) ) spansBuffer = false;
+        }
+
+        if( contiguous )
+        {
+          this->m_BatchData[ k ] = image->GetBufferPointer()
+            + image->ComputeOffset( this->m_Slab.GetIndex() );
+        }
+        else
+        {
+          std::vector<TComponentType> & scratch = this->m_BatchScratch[ k ];
+          scratch.resize( slabSize );
+          InputIteratorType it( image, this->m_Slab );
+          std::size_t j = 0;
+          for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++j )
+          {
+            scratch[ j ] = it.Get();
+          }
+          this->m_BatchData[ k ] = &scratch[ 0 ];
+        }
+      }
+
+      /** Add the batch to the accumulators, the slab split over the threads. */
+      threader->SetNumberOfThreads( numberOfThreads );
+      threader->SetSingleMethod( this->AccumulateThreaderCallback, this );
+      threader->SingleMethodExecute();
+
+      /** Free the input slabs. */
+      for( unsigned int k = 0; k < batchCount; ++k )
+      {
+        this->m_Readers[ batch + k ]->GetOutput()->ReleaseData();
+      }
+    } // end loop over batches
+
+    /** Copy the slab results to the outputs, where the slab is contiguous,
+     * or write them to the output files.
+     */
+    itk::ImageIORegion ioRegion( VDimension );
+    itk::ImageIORegionAdaptor< VDimension >::Convert(
+      this->m_Slab, ioRegion, largestRegion.GetIndex() );
+    if( canStreamWrite ) slabOutput.resize( slabSize );
+
+    const double denominator = 1.0 / static_cast<double>( nrInputs );
+    if( calc_mean )
+    {
+      float * meanBuffer = canStreamWrite ? &slabOutput[ 0 ]
+        : mean->GetBufferPointer() + mean->ComputeOffset( this->m_Slab.GetIndex() );
+      for( std::size_t j = 0; j < slabSize; ++j )
+      {
+        meanBuffer[ j ] = static_cast<float>( this->m_SlabMean[ j ] );
+      }
+      if( canStreamWrite )
+      {
+        outputIOs[ 0 ]->SetIORegion( ioRegion );
+        outputIOs[ 0 ]->Write( meanBuffer );
+      }
+    }
+    if( calc_std )
+    {
+      float * stdBuffer = canStreamWrite ? &slabOutput[ 0 ]
+        : std->GetBufferPointer() + std->ComputeOffset( this->m_Slab.GetIndex() );
+      for( std::size_t j = 0; j < slabSize; ++j )
+      {
+        stdBuffer[ j ] = static_cast<float>( std::sqrt( this->m_SlabM2[ j ] * denominator ) );
+      }
+      if( canStreamWrite )
+      {
+        outputIOs[ 1 ]->SetIORegion( ioRegion );
+        outputIOs[ 1 ]->Write( stdBuffer );
+      }
+    }
+  } // end loop over slabs
+
+  /** Release the shared state. */
+  this->m_Readers.clear();
+  this->m_BatchData.clear();
+  this->m_BatchScratch.clear();
+  std::vector<double>().swap( this->m_SlabMean );
+  std::vector<double>().swap( this->m_SlabM2 );
+
+  /** Write the output images, if they were not written slab by slab. */
+  if( canStreamWrite ) return;
+  if( calc_mean )
+  {
+    typename WriterType::Pointer writer_mean = WriterType::New();
+    writer_mean->SetFileName( outputFileNameMean.c_str() );
+    writer_mean->SetInput( mean );
+    writer_mean->Update();
+  }
+
+  if( calc_std )
+  {
+    typename WriterType::Pointer writer_std = WriterType::New();
+    writer_std->SetFileName( outputFileNameStd.c_str() );
+    writer_std->SetInput( std );
+    writer_std->Update();
+  }
+
+} // end MeanStdImageStreamed()
+
+
+/**
+ * ******************* ReadThreaderCallback *******************
+ */
+
+template< unsigned int VDimension, class TComponentType >
+ITK_THREAD_RETURN_TYPE
+ITKToolsMeanStdImage< VDimension, TComponentType >
+::ReadThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info
+    = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  const itk::ThreadIdType threadId = info->ThreadID;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  const unsigned int i = self->m_BatchBegin + threadId;
+  if( i < self->m_BatchEnd )
+  {
+    /** Exceptions can not cross the thread boundary; report them afterwards. */
+    try
+    {
+      self->m_Readers[ i ]->GetOutput()->SetRequestedRegion( self->m_Slab );
+      self->m_Readers[ i ]->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      self->m_ReadErrors[ threadId ] = excp.GetDescription();
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end ReadThreaderCallback()
+
+
+/**
+ * ******************* AccumulateThreaderCallback *******************
+ */
+
+template< unsigned int VDimension, class TComponentType >
+ITK_THREAD_RETURN_TYPE
+ITKToolsMeanStdImage< VDimension, TComponentType >
+::AccumulateThreaderCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info
+    = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  const itk::ThreadIdType threadId = info->ThreadID;
+  const itk::ThreadIdType threadCount = info->NumberOfThreads;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  /** This thread's part of the slab. */
+  const std::size_t slabSize = self->m_SlabMean.size();
+  const std::size_t begin = slabSize * threadId / threadCount;
+  const std::size_t end = slabSize * ( threadId + 1 ) / threadCount;
+  double * mean = &self->m_SlabMean[ 0 ];
+  double * m2 = &self->m_SlabM2[ 0 ];
+
+  /** Add the inputs of the batch one by one; the inner loop is a plain
+   * loop over contiguous buffers, which the compiler can vectorize.
+   */
+  for( unsigned int i = self->m_BatchBegin; i < self->m_BatchEnd; ++i )
+  {
+    const TComponentType * x = self->m_BatchData[ i - self->m_BatchBegin ];
+    const double invN = 1.0 / static_cast<double>( i + 1 );
+    for( std::size_t j = begin; j < end; ++j )
+    {
+      const double value = static_cast<double>( x[ j ] );
+      const double delta = value - mean[ j ];
+      mean[ j ] += delta * invN;
+      m2[ j ] += delta * ( value - mean[ j ] );
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateThreaderCallback()
+
+
 #endif // end #ifndef __meanstdimage_hxx_
 
@@ -4,6 +4,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
+#include "itkParabolicMorphUtils.h"
+#include <vector>
 
 namespace itk
 {
@@ -17,9 +19,11 @@ namespace itk
  * elements are dimensionally decomposable and fast algorithms are
  * available for computing erosions and dilations along lines.
  * This class implements the "point of contact" algorithm, which is
- * reasonably efficient. Improved versions, that are nearly
- * independent of structuring function size, are also known but
- * haven't been implemented here.
+ * reasonably efficient, and by default the lower envelope algorithm
+ * of Felzenszwalb and Huttenlocher, which is linear in the line length
+ * and independent of the structuring function size. For the latter
+ * blocks of neighbouring lines are gathered in a transposed buffer, see
+ * UseBatchedLineEngine.
  *
  * Parabolic structuring functions can be used as a fast alternative
  * to the "rolling ball" structuring element classically used in
@@ -109,6 +113,15 @@ public:
   itkSetMacro(UseImageSpacing, bool);
   itkGetConstReferenceMacro(UseImageSpacing, bool);
   itkBooleanMacro(UseImageSpacing);
+
+  /**
+   * Set/Get whether the lines are processed in batches with the lower
+   * envelope algorithm (linear in the line length, independent of the
+   * scale) instead of the contact point algorithm - default is true
+   */
+  itkSetMacro(UseBatchedLineEngine, bool);
+  itkGetConstReferenceMacro(UseBatchedLineEngine, bool);
+  itkBooleanMacro(UseBatchedLineEngine);
   /** Image related typedefs. */
 
 #ifdef ITK_USE_CONCEPT_CHECKING
@@ -146,6 +159,10 @@ private:
 
   int m_MagnitudeSign;
   int m_CurrentDimension;
+
+  bool m_UseBatchedLineEngine;
+  /** per thread line buffers of the batched engine */
+  std::vector< ParabolicLineBatchBuffers<RealType> > m_LineBuffers;
 };
 
 } // end namespace itk
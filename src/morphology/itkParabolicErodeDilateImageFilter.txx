@@ -37,6 +37,7 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage>
     this->m_MagnitudeSign = -1;
     }
   this->m_UseImageSpacing = false;
+  this->m_UseBatchedLineEngine = true;
 }
 
 template <typename TInputImage, bool doDilate, typename TOutputImage>
@@ -159,6 +160,7 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage >
   str.Filter = this;
   this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
   this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  this->m_LineBuffers.resize( this->GetMultiThreader()->GetNumberOfThreads() );
 
   // multithread the execution
   for( unsigned int d=0; d<ImageDimension; d++ )
@@ -167,6 +169,8 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage >
     this->GetMultiThreader()->SingleMethodExecute();
     }
 
+  // release the line buffers
+  std::vector< ParabolicLineBatchBuffers<RealType> >().swap( this->m_LineBuffers );
 }
 
 template <typename TInputImage, bool doDilate, typename TOutputImage>
@@ -191,7 +195,7 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage>
     }
   float progressPerDimension = 1.0/ImageDimension;
 
-  ProgressReporter * progress = new ProgressReporter(this, threadId, NumberOfRows[m_CurrentDimension], 30, this->m_CurrentDimension * progressPerDimension, progressPerDimension);
+  ProgressReporter progress(this, threadId, NumberOfRows[m_CurrentDimension], 30, this->m_CurrentDimension * progressPerDimension, progressPerDimension);
 
 
   typedef ImageLinearConstIteratorWithIndex< TInputImage  >  InputConstIteratorType;
@@ -206,11 +210,38 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage>
   typename TInputImage::ConstPointer   inputImage(    this->GetInput ()   );
   typename TOutputImage::Pointer       outputImage(   this->GetOutput()        );
 
-
-  outputImage->SetBufferedRegion( outputImage->GetRequestedRegion() );
-  outputImage->Allocate();
   RegionType region = outputRegionForThread;
 
+  // the batched engine, with the line buffers of this thread
+  if( this->m_UseBatchedLineEngine )
+    {
+    const unsigned int d = this->m_CurrentDimension;
+    RealType image_scale = this->GetInput()->GetSpacing()[d];
+    if( this->m_Scale[d] > 0 )
+      {
+      if( d == 0 )
+        {
+        doOneDimensionBatched<TInputImage, TOutputImage, RealType, OutputPixelType, doDilate>(
+          inputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+          this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+          image_scale, this->m_Scale[d]);
+        }
+      else
+        {
+        doOneDimensionBatched<TOutputImage, TOutputImage, RealType, OutputPixelType, doDilate>(
+          outputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+          this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+          image_scale, this->m_Scale[d]);
+        }
+      return;
+      }
+    // a zero scale in the first dimension is handled by the copy below
+    if( d > 0 )
+      {
+      return;
+      }
+    }
+
   InputConstIteratorType  inputIterator(  inputImage,  region );
   OutputIteratorType      outputIterator( outputImage, region );
   OutputConstIteratorType inputIteratorStage2( outputImage, region );
@@ -237,7 +268,7 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage>
 
       doOneDimension<InputConstIteratorType,OutputIteratorType,
   RealType, OutputPixelType, doDilate>(inputIterator, outputIterator,
-               *progress, LineLength, 0,
+               progress, LineLength, 0,
                this->m_MagnitudeSign,
                this->m_UseImageSpacing,
                this->m_Extreme,
@@ -272,7 +303,7 @@ ParabolicErodeDilateImageFilter<TInputImage, doDilate, TOutputImage>
 
       doOneDimension<OutputConstIteratorType,OutputIteratorType,
   RealType, OutputPixelType, doDilate>(inputIteratorStage2, outputIterator,
-               *progress, LineLength, this->m_CurrentDimension,
+               progress, LineLength, this->m_CurrentDimension,
                this->m_MagnitudeSign,
                this->m_UseImageSpacing,
                this->m_Extreme,
@@ -4,6 +4,10 @@
 #include <itkArray.h>
 
 #include "itkProgressReporter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkNumericTraits.h"
+#include <vector>
+
 namespace itk {
 template <class LineBufferType, class RealType, bool doDilate>
 void DoLine(LineBufferType &LineBuf, LineBufferType &tmpLineBuf,
@@ -109,6 +113,166 @@ void doOneDimension(TInIter &inputIterator, TOutIter &outputIterator,
     }
 }
 
+/** Buffers of the batched line engine. One instance is kept per thread
+ * and reused for all lines and all dimension passes, so that nothing is
+ * allocated per line.
+ */
+template <class RealType>
+struct ParabolicLineBatchBuffers
+{
+  std::vector<RealType>      Block;     // transposed block: position major, lane minor
+  std::vector<RealType>      Envelope;  // the result, same layout
+  std::vector<long>          Vertices;  // parabolas of the lower envelope
+  std::vector<RealType>      Bounds;    // where they start
+  std::vector<OffsetValueType> InOffsets;
+  std::vector<OffsetValueType> OutOffsets;
+};
+
+/** Lower envelope of the parabolas a * ( x - q )^2 + f( q ), i.e. the
+ * parabolic erosion of f, after Felzenszwalb and Huttenlocher, "Distance
+ * transforms of sampled functions", 2004. f and d are strided, so that a
+ * lane of a transposed block can be processed in place. Linear in the
+ * line length, independent of the scale.
+ */
+template <class RealType>
+void DoLineEnvelope( const RealType * f, RealType * d, const long stride,
+  const long LineLength, const RealType a, long * v, RealType * z )
+{
+  long k = 0;
+  v[ 0 ] = 0;
+  z[ 0 ] = -NumericTraits<RealType>::max();
+  z[ 1 ] = NumericTraits<RealType>::max();
+  const RealType halfInvA = 0.5 / a;
+  for( long q = 1; q < LineLength; q++ )
+    {
+    const RealType fq = f[ q * stride ];
+    RealType s;
+    while( true )
+      {
+      const long p = v[ k ];
+      s = ( fq - f[ p * stride ] ) * halfInvA / ( q - p ) + 0.5 * ( q + p );
+      if( s > z[ k ] || k == 0 )
+        {
+        break;
+        }
+      --k;
+      }
+    if( s <= z[ k ] )
+      {
+      // only possible for k == 0: the first parabola is hidden entirely
+      v[ k ] = q;
+      z[ k + 1 ] = NumericTraits<RealType>::max();
+      continue;
+      }
+    ++k;
+    v[ k ] = q;
+    z[ k ] = s;
+    z[ k + 1 ] = NumericTraits<RealType>::max();
+    }
+
+  k = 0;
+  for( long x = 0; x < LineLength; x++ )
+    {
+    while( z[ k + 1 ] < x )
+      {
+      ++k;
+      }
+    const RealType dx = x - v[ k ];
+    d[ x * stride ] = a * dx * dx + f[ v[ k ] * stride ];
+    }
+}
+
+/** Batched version of doOneDimension. Blocks of up to NumberOfLanes
+ * neighbouring lines are gathered in a transposed block, so that reading
+ * and writing lines along the slow dimensions touches contiguous memory.
+ * The lower envelope is then computed for each lane of the block. A
+ * dilation is computed as the negated erosion of the negated line.
+ */
+template <class TInImage, class TOutImage, class RealType,
+    class OutputPixelType, bool doDilate>
+void doOneDimensionBatched( const TInImage * inImage, TOutImage * outImage,
+  const typename TOutImage::RegionType & region,
+  ProgressReporter &progress,
+  ParabolicLineBatchBuffers<RealType> & buffers,
+  const unsigned direction,
+  const bool m_UseImageSpacing,
+  const RealType image_scale,
+  const RealType Sigma )
+{
+  const long NumberOfLanes = 16;
+  const long LineLength = region.GetSize()[ direction ];
+  RealType iscale = 1.0;
+  if( m_UseImageSpacing )
+    {
+    iscale = image_scale;
+    }
+  const RealType a = 1.0 / ( 2.0 * Sigma / ( iscale * iscale ) );
+  const RealType sign = doDilate ? -1.0 : 1.0;
+
+  buffers.Block.resize( LineLength * NumberOfLanes );
+  buffers.Envelope.resize( LineLength * NumberOfLanes );
+  buffers.Vertices.resize( LineLength );
+  buffers.Bounds.resize( LineLength + 1 );
+  buffers.InOffsets.resize( NumberOfLanes );
+  buffers.OutOffsets.resize( NumberOfLanes );
+
+  const OffsetValueType inStride = inImage->GetOffsetTable()[ direction ];
+  const OffsetValueType outStride = outImage->GetOffsetTable()[ direction ];
+  const typename TInImage::PixelType * inBuffer = inImage->GetBufferPointer();
+  typename TOutImage::PixelType * outBuffer = outImage->GetBufferPointer();
+
+  // the first pixel of every line
+  typename TOutImage::RegionType startRegion = region;
+  typename TOutImage::SizeType startSize = region.GetSize();
+  startSize[ direction ] = 1;
+  startRegion.SetSize( startSize );
+  ImageRegionConstIteratorWithIndex<TOutImage> startIt( outImage, startRegion );
+  startIt.GoToBegin();
+
+  while( !startIt.IsAtEnd() )
+    {
+    long lanes = 0;
+    for( ; lanes < NumberOfLanes && !startIt.IsAtEnd(); ++lanes, ++startIt )
+      {
+      buffers.InOffsets[ lanes ] = inImage->ComputeOffset( startIt.GetIndex() );
+      buffers.OutOffsets[ lanes ] = outImage->ComputeOffset( startIt.GetIndex() );
+      }
+
+    // gather the transposed block
+    RealType * block = &buffers.Block[ 0 ];
+    for( long x = 0; x < LineLength; x++ )
+      {
+      for( long b = 0; b < lanes; b++ )
+        {
+        block[ x * NumberOfLanes + b ] = sign * static_cast<RealType>(
+          inBuffer[ buffers.InOffsets[ b ] + x * inStride ] );
+        }
+      }
+
+    // the lower envelope of each lane
+    RealType * envelope = &buffers.Envelope[ 0 ];
+    for( long b = 0; b < lanes; b++ )
+      {
+      DoLineEnvelope<RealType>( block + b, envelope + b, NumberOfLanes,
+        LineLength, a, &buffers.Vertices[ 0 ], &buffers.Bounds[ 0 ] );
+      }
+
+    // scatter the block back
+    for( long x = 0; x < LineLength; x++ )
+      {
+      for( long b = 0; b < lanes; b++ )
+        {
+        outBuffer[ buffers.OutOffsets[ b ] + x * outStride ]
+          = static_cast<OutputPixelType>( sign * envelope[ x * NumberOfLanes + b ] );
+        }
+      }
+
+    for( long b = 0; b < lanes; b++ )
+      {
+      progress.CompletedPixel();
+      }
+    }
+}
 
 }
 #endif
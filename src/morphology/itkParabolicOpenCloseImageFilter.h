@@ -4,6 +4,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
+#include "itkParabolicMorphUtils.h"
+#include <vector>
 
 namespace itk
 {
@@ -92,6 +94,15 @@ public:
   itkGetConstReferenceMacro(UseImageSpacing, bool);
   itkBooleanMacro(UseImageSpacing);
 
+  /**
+   * Set/Get whether the lines are processed in batches with the lower
+   * envelope algorithm (linear in the line length, independent of the
+   * scale) instead of the contact point algorithm - default is true
+   */
+  itkSetMacro(UseBatchedLineEngine, bool);
+  itkGetConstReferenceMacro(UseBatchedLineEngine, bool);
+  itkBooleanMacro(UseBatchedLineEngine);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(SameDimension,
@@ -126,6 +137,10 @@ private:
 
   int m_MagnitudeSign, m_MagnitudeSign1, m_MagnitudeSign2;
   int m_CurrentDimension;
+
+  bool m_UseBatchedLineEngine;
+  /** per thread line buffers of the batched engine */
+  std::vector< ParabolicLineBatchBuffers<RealType> > m_LineBuffers;
   int m_Stage;
   bool m_UseImageSpacing;
 };
@@ -47,6 +47,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage>
   this->m_MagnitudeSign = this->m_MagnitudeSign1;
   this->m_UseImageSpacing = false;
   this->m_Stage=1;  // indicate whether we are on the first pass or the second
+  this->m_UseBatchedLineEngine = true;
 }
 
 template <typename TInputImage, bool doOpen, typename TOutputImage>
@@ -182,6 +183,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
   str.Filter = this;
   this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
   this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  this->m_LineBuffers.resize( this->GetMultiThreader()->GetNumberOfThreads() );
 
   // multithread the execution - stage 1
   this->m_Stage=1;
@@ -206,6 +208,8 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
   this->m_MagnitudeSign = this->m_MagnitudeSign1;
   this->m_Stage=1;
 
+  // release the line buffers
+  std::vector< ParabolicLineBatchBuffers<RealType> >().swap( this->m_LineBuffers );
 }
 
 ////////////////////////////////////////////////////////////
@@ -232,7 +236,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
     }
   float progressPerDimension = 1.0/ImageDimension;
 
-  ProgressReporter * progress = new ProgressReporter(this, threadId, NumberOfRows[m_CurrentDimension], 30, this->m_CurrentDimension * progressPerDimension, progressPerDimension);
+  ProgressReporter progress(this, threadId, NumberOfRows[m_CurrentDimension], 30, this->m_CurrentDimension * progressPerDimension, progressPerDimension);
 
 
   typedef ImageLinearConstIteratorWithIndex< TInputImage  >  InputConstIteratorType;
@@ -247,13 +251,58 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
   typename TInputImage::ConstPointer   inputImage(    this->GetInput ()   );
   typename TOutputImage::Pointer       outputImage(   this->GetOutput()   );
 
-
-  //const unsigned int imageDimension = inputImage->GetImageDimension();
-
-  outputImage->SetBufferedRegion( outputImage->GetRequestedRegion() );
-  outputImage->Allocate();
   RegionType region = outputRegionForThread;
 
+  // the batched engine, with the line buffers of this thread
+  if( this->m_UseBatchedLineEngine )
+    {
+    const unsigned int d = this->m_CurrentDimension;
+    RealType image_scale = this->GetInput()->GetSpacing()[d];
+    // erosion then dilation for an opening, the reverse for a closing
+    const bool dilate = ( this->m_Stage == 1 ) ? !doOpen : doOpen;
+    if( this->m_Scale[d] > 0 )
+      {
+      if( this->m_Stage == 1 && d == 0 )
+        {
+        if( dilate )
+          {
+          doOneDimensionBatched<TInputImage, TOutputImage, RealType, OutputPixelType, true>(
+            inputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+            this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+            image_scale, this->m_Scale[d]);
+          }
+        else
+          {
+          doOneDimensionBatched<TInputImage, TOutputImage, RealType, OutputPixelType, false>(
+            inputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+            this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+            image_scale, this->m_Scale[d]);
+          }
+        }
+      else if( dilate )
+        {
+        doOneDimensionBatched<TOutputImage, TOutputImage, RealType, OutputPixelType, true>(
+          outputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+          this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+          image_scale, this->m_Scale[d]);
+        }
+      else
+        {
+        doOneDimensionBatched<TOutputImage, TOutputImage, RealType, OutputPixelType, false>(
+          outputImage.GetPointer(), outputImage.GetPointer(), region, progress,
+          this->m_LineBuffers[threadId], d, this->m_UseImageSpacing,
+          image_scale, this->m_Scale[d]);
+        }
+      return;
+      }
+    // a zero scale in the first dimension of the first stage is handled
+    // by the copy below
+    if( this->m_Stage != 1 || d > 0 )
+      {
+      return;
+      }
+    }
+
 
   InputConstIteratorType  inputIterator(  inputImage,  region );
   OutputIteratorType      outputIterator( outputImage, region );
@@ -274,7 +323,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
 
   doOneDimension<InputConstIteratorType,OutputIteratorType,
     RealType, OutputPixelType, !doOpen>(inputIterator, outputIterator,
-                *progress, LineLength, 0,
+                progress, LineLength, 0,
                 this->m_MagnitudeSign,
                 this->m_UseImageSpacing,
                 this->m_Extreme,
@@ -306,7 +355,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
 
       doOneDimension<OutputConstIteratorType,OutputIteratorType,
   RealType, OutputPixelType, !doOpen>(inputIteratorStage2, outputIterator,
-              *progress, LineLength, this->m_CurrentDimension,
+              progress, LineLength, this->m_CurrentDimension,
               this->m_MagnitudeSign,
               this->m_UseImageSpacing,
               this->m_Extreme,
@@ -326,7 +375,7 @@ ParabolicOpenCloseImageFilter<TInputImage, doOpen, TOutputImage >
 
       doOneDimension<OutputConstIteratorType,OutputIteratorType,
   RealType, OutputPixelType, doOpen>(inputIteratorStage2, outputIterator,
-             *progress, LineLength, this->m_CurrentDimension,
+             progress, LineLength, this->m_CurrentDimension,
              this->m_MagnitudeSign,
              this->m_UseImageSpacing,
              this->m_Extreme,
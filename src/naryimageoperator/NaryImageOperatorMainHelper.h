@@ -33,6 +33,7 @@ int DetermineImageProperties(
   const std::vector<std::string> & inputFileNames,
   itk::ImageIOBase::IOComponentType & componentTypeIn,
   itk::ImageIOBase::IOComponentType & componentTypeOut,
+  itk::ImageIOBase::IOComponentType & componentTypeNative,
   unsigned int & inputDimension )
 {
   /** Determine image properties of image 1. */
@@ -48,6 +49,7 @@ int DetermineImageProperties(
     numberOfComponents1,
     imagesize1 );
   if( retgip1 ) return retgip1;
+  componentTypeNative = componentTypeIn;
 
   /** Determine image properties of other images. */
   itk::ImageIOBase::IOPixelType inputPixelType_i;
@@ -58,7 +60,7 @@ int DetermineImageProperties(
   for( unsigned int i = 1; i < inputFileNames.size(); i++ )
   {
     int retgip_i = itktools::GetImageProperties(
-      inputFileNames[ 1 ],
+      inputFileNames[ i ],
       inputPixelType_i,
       componentTypeIn_i,
       inputDimension_i,
@@ -97,9 +99,19 @@ int DetermineImageProperties(
 
     /** The output type is the largest of the input types. */
     componentTypeOut = itktools::GetLargestComponentType( componentTypeOut, componentTypeIn_i );
+
+    /** The inputs can only be read in their native type if they all have
+     * the same type on disk.
+     */
+    if( componentTypeIn_i != componentTypeNative )
+    {
+      componentTypeNative = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+    }
   }
 
-  /** The input type is set to long or double, depending on the output type. */
+  /** The input type is set to long or double, depending on the output type.
+   * It is used when the native type is not supported.
+   */
   bool outIsInteger = itktools::ComponentTypeIsInteger( componentTypeOut );
   if( outIsInteger )
   {
@@ -126,9 +126,10 @@ int main( int argc, char **argv )
   /** Determine image properties. */
   itk::ImageIOBase::IOComponentType componentTypeIn = itk::ImageIOBase::LONG;
   itk::ImageIOBase::IOComponentType componentTypeOut = itk::ImageIOBase::LONG;
+  itk::ImageIOBase::IOComponentType componentTypeNative = itk::ImageIOBase::LONG;
   unsigned int dim = 2;
   int retdip = DetermineImageProperties( inputFileNames,
-    componentTypeIn, componentTypeOut, dim );
+    componentTypeIn, componentTypeOut, componentTypeNative, dim );
   if( retdip ) return EXIT_FAILURE;
 
   /** Let the user override the output component type. */
@@ -161,6 +162,73 @@ int main( int argc, char **argv )
 
   try
   {
+    /** First try to keep the inputs in their native type, which saves
+     * memory for many small typed inputs. This requires that all inputs
+     * have the same type on disk. Float inputs are only read
+     * natively for a floating point output, since otherwise they are
+     * rounded to long before the operation.
+     */
+    const bool floatNative = componentTypeNative == itk::ImageIOBase::FLOAT;
+    const bool outputIsInteger = itktools::ComponentTypeIsInteger( componentTypeOut );
+    if( !floatNative || !outputIsInteger )
+    {
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, float, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 2, float, double >::New( dim, componentTypeNative, componentTypeOut );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned char >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, short >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, long >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, double >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, float, float >::New( dim, componentTypeNative, componentTypeOut );
+      if( !filter ) filter = ITKToolsNaryImageOperator< 3, float, double >::New( dim, componentTypeNative, componentTypeOut );
+#endif
+    }
+
     // now call all possible template combinations.
     if( !filter ) filter = ITKToolsNaryImageOperator< 2, long, char >::New( dim, componentTypeIn, componentTypeOut );
     if( !filter ) filter = ITKToolsNaryImageOperator< 2, long, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
@@ -23,6 +23,8 @@
 #include "itkNaryFunctorImageFilter.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
+#include "itkImageIOFactory.h"
+#include "itkStreamingImageFilter.h"
 
 #include "NaryFilterFactory.h"
 
@@ -87,13 +89,19 @@ public:
     typedef itk::Image< TOutputComponentType, VDimension >  OutputImageType;
     typedef itk::ImageFileReader< InputImageType >          ReaderType;
     typedef itk::ImageFileWriter< OutputImageType >         WriterType;
+    typedef itk::StreamingImageFilter<
+      OutputImageType, OutputImageType >                    StreamerType;
 
-    /** Read the input images. */
+    /** Read the input images. The readers only read the requested piece,
+     * if the file format supports it. The input component type can be the
+     * native type on disk: the functors compute in floating point.
+     */
     std::vector<typename ReaderType::Pointer> readers( this->m_InputFileNames.size() );
     for ( unsigned int i = 0; i < this->m_InputFileNames.size(); ++i )
     {
       readers[ i ] = ReaderType::New();
       readers[ i ]->SetFileName( this->m_InputFileNames[ i ] );
+      readers[ i ]->SetUseStreaming( true );
     }
 
     std::map <std::string, NaryFilterEnum> naryOperatorMap;
@@ -129,12 +137,32 @@ public:
       naryFilter->SetInput( i, readers[ i ]->GetOutput() );
     }
 
-    /** Write the image to disk */
+    /** Write the image to disk. The pipeline is driven slab by slab by
+     * the writer. If the output can not be written in pieces, e.g. when
+     * compressed, a streamer drives the slabs instead, so that only the
+     * output is fully in memory.
+     */
     typename WriterType::Pointer writer = WriterType::New();
     writer->SetFileName( this->m_OutputFileName.c_str() );
-    writer->SetInput( naryFilter->GetOutput() );
     writer->SetUseCompression( this->m_UseCompression );
     writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+
+    itk::ImageIOBase::Pointer outputIO = itk::ImageIOFactory::CreateImageIO(
+      this->m_OutputFileName.c_str(), itk::ImageIOFactory::WriteMode );
+    const bool canStreamWrite = outputIO.IsNotNull()
+      && outputIO->CanStreamWrite() && !this->m_UseCompression;
+
+    typename StreamerType::Pointer streamer = StreamerType::New();
+    if( canStreamWrite || this->m_NumberOfStreams < 2 )
+    {
+      writer->SetInput( naryFilter->GetOutput() );
+    }
+    else
+    {
+      streamer->SetInput( naryFilter->GetOutput() );
+      streamer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+      writer->SetInput( streamer->GetOutput() );
+    }
     writer->Update();
 
   } // end Run()
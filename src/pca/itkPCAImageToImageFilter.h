@@ -24,6 +24,8 @@
 #include "itkImageToImageFilter.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkMultiThreader.h"
+#include <vector>
 
 
 namespace itk
@@ -43,6 +45,17 @@ namespace itk
  * to perform some matrix manipulations. This filter gives the same output
  * as the Matlab function princomp.
  *
+ * By default the centered feature images are stored in one
+ * NumberOfPixels x NumberOfFeatureImages double matrix. With
+ * UseStreamedCovariance on, this matrix is never formed. The inputs are
+ * requested from the upstream pipeline in NumberOfStreamDivisions pieces.
+ * The covariance matrix is accumulated in a single pass over the pieces,
+ * from sums of the inputs shifted by their first pixel. Each thread sums
+ * blocks of pixels in double precision and adds the block sums to its
+ * Kahan-compensated totals; the totals of the threads are added pairwise.
+ * In a second pass over the pieces the principal components are computed
+ * in threaded blocks and written directly to the outputs.
+ *
  * \ingroup ??
  */
 
@@ -107,6 +120,17 @@ public:
   /** Get the eigen values. */
   itkGetConstReferenceMacro( EigenVectors, MatrixOfDoubleType );
 
+  /** Methods to turn on/off the streamed covariance computation. Default off. */
+  itkSetMacro( UseStreamedCovariance, bool );
+  itkGetConstMacro( UseStreamedCovariance, bool );
+  itkBooleanMacro( UseStreamedCovariance );
+
+  /** Set/Get the number of pieces in which the inputs are processed when
+   * UseStreamedCovariance is on. Default 16.
+   */
+  itkSetClampMacro( NumberOfStreamDivisions, unsigned int, 1, NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
 protected:
 
   /** Constructor. */
@@ -134,6 +158,48 @@ protected:
   /** Starts the image modelling process. */
   void GenerateData( void );
 
+  /** Types for the streamed mode. */
+  typedef typename InputImageType::RegionType       InputImageRegionType;
+  typedef typename OutputImageType::RegionType      OutputImageRegionType;
+
+  /** The streamed mode: accumulate the covariance and project piece by piece. */
+  virtual void GenerateDataStreamed( void );
+
+  /** Get the pieces in which the inputs are processed. */
+  virtual unsigned int SplitStreamedRegion( unsigned int piece,
+    InputImageRegionType & pieceRegion ) const;
+
+  /** Bring the given piece of all inputs in memory. */
+  virtual void UpdateInputPiece( const InputImageRegionType & pieceRegion );
+
+  /** Accumulate the sums of a part of a piece for one thread. */
+  virtual void ThreadedAccumulateCovariance(
+    const InputImageRegionType & region, ThreadIdType threadId );
+
+  /** Compute the principal components of a part of a piece. */
+  virtual void ThreadedProjectPrincipalComponents(
+    const InputImageRegionType & region );
+
+  /** Static thread callback of the streamed mode. */
+  struct PCAThreadStruct
+  {
+    Self *                Filter;
+    InputImageRegionType  Piece;
+    bool                  Project;
+  };
+  static ITK_THREAD_RETURN_TYPE PCAThreaderCallback( void * arg );
+
+  /** Compensated summation: adds value to sum, keeping the lost low order
+   * part in compensation.
+   */
+  static void KahanAdd( double & sum, double & compensation, double value )
+  {
+    const double y = value - compensation;
+    const double t = sum + y;
+    compensation = ( t - sum ) - y;
+    sum = t;
+  }
+
 private:
 
   PCAImageToImageFilter( const Self& ); // purposely not implemented
@@ -164,6 +230,17 @@ private:
   unsigned int          m_NumberOfFeatureImages;
   unsigned int          m_NumberOfPrincipalComponentsRequired;
 
+  /** Streamed mode settings and per-thread accumulators. The cross sums
+   * hold the upper triangle of the K x K matrix, row by row.
+   */
+  bool                  m_UseStreamedCovariance;
+  unsigned int          m_NumberOfStreamDivisions;
+  VectorOfDoubleType    m_Shift;
+  std::vector< std::vector<double> > m_ThreadSums;
+  std::vector< std::vector<double> > m_ThreadSumsCompensation;
+  std::vector< std::vector<double> > m_ThreadCrossSums;
+  std::vector< std::vector<double> > m_ThreadCrossSumsCompensation;
+
 }; // end class PCAImageToImageFilter
 
 
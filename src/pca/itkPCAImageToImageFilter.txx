@@ -23,6 +23,8 @@
 #include "vnl/vnl_math.h"
 #include <vnl/algo/vnl_symmetric_eigensystem.h>
 #include <vnl/vnl_fastops.h>
+#include "itkImageRegionSplitter.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -48,6 +50,10 @@ namespace itk
     this->m_NumberOfFeatureImages = 0;
     this->m_NumberOfPrincipalComponentsRequired = 0;
 
+    this->m_UseStreamedCovariance = false;
+    this->m_NumberOfStreamDivisions = 16;
+    this->m_Shift.set_size( 0 );
+
   } // end Constructor()
 
 
@@ -115,6 +121,23 @@ namespace itk
 
         }
       }
+
+      /** In the streamed mode only the first piece is needed up front;
+       * the other pieces are requested in GenerateDataStreamed().
+       */
+      if( this->m_UseStreamedCovariance )
+      {
+        InputImageRegionType firstPiece;
+        this->SplitStreamedRegion( 0, firstPiece );
+        for( unsigned int i = 0; i < this->GetNumberOfInputs(); ++i )
+        {
+          if( this->GetInput( i ) )
+          {
+            InputImagePointer ptr = const_cast<TInputImage *>( this->GetInput( i ) );
+            ptr->SetRequestedRegion( firstPiece );
+          }
+        }
+      }
     }
 
   } // end GenerateInputRequestedRegion()
@@ -205,6 +228,12 @@ namespace itk
     PCAImageToImageFilter< TInputImage, TOutputImage >
     ::GenerateData( void )
   {
+    if( this->m_UseStreamedCovariance )
+    {
+      this->GenerateDataStreamed();
+      return;
+    }
+
     /** Do the principal component analysis. */
     this->PerformPCA();
 
@@ -440,7 +469,9 @@ namespace itk
 
     /** Calculate the principal components.
      * This is done by multiplying the training data with the eigen vectors.
+     * In the streamed mode this is done piece by piece.
      */
+    if( this->m_CenteredFeatureImages.rows() == 0 ) return;
     this->m_PrincipalComponents =
       this->m_CenteredFeatureImages * this->m_EigenVectors;
 
@@ -450,6 +481,383 @@ namespace itk
   } // end PerformEigenAnalysis()
 
 
+  /**
+   * ********************* SplitStreamedRegion ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    unsigned int
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::SplitStreamedRegion( unsigned int piece, InputImageRegionType & pieceRegion ) const
+  {
+    typedef ImageRegionSplitter< InputImageDimension > SplitterType;
+    typename SplitterType::Pointer splitter = SplitterType::New();
+
+    const InputImageRegionType region = this->GetInput( 0 )->GetLargestPossibleRegion();
+    const unsigned int numberOfPieces
+      = splitter->GetNumberOfSplits( region, this->m_NumberOfStreamDivisions );
+    pieceRegion = splitter->GetSplit( piece, numberOfPieces, region );
+
+    return numberOfPieces;
+
+  } // end SplitStreamedRegion()
+
+
+  /**
+   * ********************* UpdateInputPiece ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    void
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::UpdateInputPiece( const InputImageRegionType & pieceRegion )
+  {
+    /** As in the StreamingImageFilter. If the upstream can not stream,
+     * the whole input is already buffered and nothing is read again.
+     */
+    for( unsigned int i = 0; i < this->m_NumberOfFeatureImages; ++i )
+    {
+      InputImagePointer input = const_cast<TInputImage *>( this->GetInput( i ) );
+      input->SetRequestedRegion( pieceRegion );
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+    }
+
+  } // end UpdateInputPiece()
+
+
+  /**
+   * ********************* GenerateDataStreamed ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    void
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::GenerateDataStreamed( void )
+  {
+    const unsigned int K = this->m_NumberOfFeatureImages;
+    const InputImageRegionType region = this->GetInput( 0 )->GetLargestPossibleRegion();
+    this->m_NumberOfPixels = region.GetNumberOfPixels();
+    this->CheckNumberOfOutputs();
+
+    /** Setup the threader and the per-thread accumulators. */
+    PCAThreadStruct str;
+    str.Filter = this;
+    str.Project = false;
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    this->GetMultiThreader()->SetSingleMethod( this->PCAThreaderCallback, &str );
+    const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+
+    this->m_ThreadSums.assign( numberOfThreads, std::vector<double>( K, 0.0 ) );
+    this->m_ThreadSumsCompensation = this->m_ThreadSums;
+    this->m_ThreadCrossSums.assign( numberOfThreads,
+      std::vector<double>( K * ( K + 1 ) / 2, 0.0 ) );
+    this->m_ThreadCrossSumsCompensation = this->m_ThreadCrossSums;
+
+    /** First pass: accumulate the shifted sums and cross sums. The shift is
+     * the first pixel of every input, which avoids cancellation when the
+     * mean is large compared to the spread.
+     */
+    InputImageRegionType piece;
+    const unsigned int numberOfPieces = this->SplitStreamedRegion( 0, piece );
+    this->m_Shift.set_size( K );
+    for( unsigned int p = 0; p < numberOfPieces; ++p )
+    {
+      this->SplitStreamedRegion( p, piece );
+      this->UpdateInputPiece( piece );
+      if( p == 0 )
+      {
+        for( unsigned int i = 0; i < K; ++i )
+        {
+          this->m_Shift[ i ] = this->GetInput( i )->GetPixel( region.GetIndex() );
+        }
+      }
+      str.Piece = piece;
+      this->GetMultiThreader()->SingleMethodExecute();
+    }
+
+    /** Add the thread totals pairwise. */
+    for( ThreadIdType step = 1; step < numberOfThreads; step *= 2 )
+    {
+      for( ThreadIdType t = 0; t + step < numberOfThreads; t += 2 * step )
+      {
+        for( unsigned int a = 0; a < K; ++a )
+        {
+          this->m_ThreadSums[ t ][ a ] = ( this->m_ThreadSums[ t ][ a ]
+            - this->m_ThreadSumsCompensation[ t ][ a ] )
+            + ( this->m_ThreadSums[ t + step ][ a ]
+            - this->m_ThreadSumsCompensation[ t + step ][ a ] );
+          this->m_ThreadSumsCompensation[ t ][ a ] = 0.0;
+        }
+        for( unsigned int ab = 0; ab < K * ( K + 1 ) / 2; ++ab )
+        {
+          this->m_ThreadCrossSums[ t ][ ab ] = ( this->m_ThreadCrossSums[ t ][ ab ]
+            - this->m_ThreadCrossSumsCompensation[ t ][ ab ] )
+            + ( this->m_ThreadCrossSums[ t + step ][ ab ]
+            - this->m_ThreadCrossSumsCompensation[ t + step ][ ab ] );
+          this->m_ThreadCrossSumsCompensation[ t ][ ab ] = 0.0;
+        }
+      }
+    }
+
+    /** Mean and covariance from the shifted sums. */
+    const double n = static_cast<double>( this->m_NumberOfPixels );
+    VectorOfDoubleType shiftedMean( K );
+    for( unsigned int a = 0; a < K; ++a )
+    {
+      shiftedMean[ a ] = ( this->m_ThreadSums[ 0 ][ a ]
+        - this->m_ThreadSumsCompensation[ 0 ][ a ] ) / n;
+    }
+    this->m_MeanOfFeatureImages = this->m_Shift + shiftedMean;
+
+    this->m_CovarianceMatrix.set_size( K, K );
+    unsigned int ab = 0;
+    for( unsigned int a = 0; a < K; ++a )
+    {
+      for( unsigned int b = a; b < K; ++b, ++ab )
+      {
+        const double crossSum = this->m_ThreadCrossSums[ 0 ][ ab ]
+          - this->m_ThreadCrossSumsCompensation[ 0 ][ ab ];
+        double covariance = 0.0;
+        if( this->m_NumberOfPixels != 1 )
+        {
+          covariance = ( crossSum - n * shiftedMean[ a ] * shiftedMean[ b ] ) / ( n - 1.0 );
+        }
+        this->m_CovarianceMatrix[ a ][ b ] = covariance;
+        this->m_CovarianceMatrix[ b ][ a ] = covariance;
+      }
+    }
+    this->m_ThreadSums.clear();
+    this->m_ThreadSumsCompensation.clear();
+    this->m_ThreadCrossSums.clear();
+    this->m_ThreadCrossSumsCompensation.clear();
+
+    this->m_CenteredFeatureImages.set_size( 0, 0 );
+    this->PerformEigenAnalysis();
+
+    /** Allocate the outputs. */
+    const unsigned int numberOfOutputs = this->GetNumberOfOutputs();
+    for( unsigned int i = 0; i < numberOfOutputs; ++i )
+    {
+      OutputImagePointer output = this->GetOutput( i );
+      output->SetBufferedRegion( output->GetRequestedRegion() );
+      output->Allocate();
+    }
+
+    /** Second pass: project every piece on the eigen vectors. */
+    str.Project = true;
+    for( unsigned int p = 0; p < numberOfPieces; ++p )
+    {
+      this->SplitStreamedRegion( p, piece );
+      this->UpdateInputPiece( piece );
+      str.Piece = piece;
+      this->GetMultiThreader()->SingleMethodExecute();
+    }
+
+  } // end GenerateDataStreamed()
+
+
+  /**
+   * ********************* PCAThreaderCallback ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    ITK_THREAD_RETURN_TYPE
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::PCAThreaderCallback( void * arg )
+  {
+    MultiThreader::ThreadInfoStruct * info
+      = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+    const ThreadIdType threadId = info->ThreadID;
+    const ThreadIdType threadCount = info->NumberOfThreads;
+    PCAThreadStruct * str = static_cast<PCAThreadStruct *>( info->UserData );
+
+    /** Split the piece, and let this thread process its part. */
+    typedef ImageRegionSplitter< InputImageDimension > SplitterType;
+    typename SplitterType::Pointer splitter = SplitterType::New();
+    const unsigned int total = splitter->GetNumberOfSplits( str->Piece, threadCount );
+    if( threadId < total )
+    {
+      const InputImageRegionType region = splitter->GetSplit( threadId, total, str->Piece );
+      if( str->Project )
+      {
+        str->Filter->ThreadedProjectPrincipalComponents( region );
+      }
+      else
+      {
+        str->Filter->ThreadedAccumulateCovariance( region, threadId );
+      }
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+
+  } // end PCAThreaderCallback()
+
+
+  /**
+   * ********************* ThreadedAccumulateCovariance ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    void
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::ThreadedAccumulateCovariance( const InputImageRegionType & region, ThreadIdType threadId )
+  {
+    const unsigned int K = this->m_NumberOfFeatureImages;
+    const unsigned int blockSize = 1024;
+
+    std::vector< InputImageConstIterator > iterators( K );
+    for( unsigned int i = 0; i < K; ++i )
+    {
+      iterators[ i ] = InputImageConstIterator( this->GetInput( i ), region );
+      iterators[ i ].GoToBegin();
+    }
+
+    /** Block buffers: the shifted pixels, row by row, and the block sums. */
+    std::vector<double> block( blockSize * K );
+    std::vector<double> blockSums( K );
+    std::vector<double> blockCrossSums( K * ( K + 1 ) / 2 );
+    std::vector<double> & sums = this->m_ThreadSums[ threadId ];
+    std::vector<double> & sumsCompensation = this->m_ThreadSumsCompensation[ threadId ];
+    std::vector<double> & crossSums = this->m_ThreadCrossSums[ threadId ];
+    std::vector<double> & crossSumsCompensation = this->m_ThreadCrossSumsCompensation[ threadId ];
+
+    SizeValueType remaining = region.GetNumberOfPixels();
+    while( remaining > 0 )
+    {
+      const unsigned int pixels = static_cast<unsigned int>(
+        std::min<SizeValueType>( remaining, blockSize ) );
+      remaining -= pixels;
+
+      /** Gather the block. */
+      for( unsigned int i = 0; i < K; ++i )
+      {
+        const double shift = this->m_Shift[ i ];
+        for( unsigned int pix = 0; pix < pixels; ++pix, ++iterators[ i ] )
+        {
+          block[ pix * K + i ] = iterators[ i ].Get() - shift;
+        }
+      }
+
+      /** Sum the block. */
+      std::fill( blockSums.begin(), blockSums.end(), 0.0 );
+      std::fill( blockCrossSums.begin(), blockCrossSums.end(), 0.0 );
+      for( unsigned int pix = 0; pix < pixels; ++pix )
+      {
+        const double * x = &block[ pix * K ];
+        double * cross = &blockCrossSums[ 0 ];
+        for( unsigned int a = 0; a < K; ++a )
+        {
+          const double xa = x[ a ];
+          blockSums[ a ] += xa;
+          for( unsigned int b = a; b < K; ++b )
+          {
+            *cross++ += xa * x[ b ];
+          }
+        }
+      }
+
+      /** Add the block sums to the compensated totals. */
+      for( unsigned int a = 0; a < K; ++a )
+      {
+        KahanAdd( sums[ a ], sumsCompensation[ a ], blockSums[ a ] );
+      }
+      for( unsigned int ab = 0; ab < blockCrossSums.size(); ++ab )
+      {
+        KahanAdd( crossSums[ ab ], crossSumsCompensation[ ab ], blockCrossSums[ ab ] );
+      }
+    }
+
+  } // end ThreadedAccumulateCovariance()
+
+
+  /**
+   * ********************* ThreadedProjectPrincipalComponents ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    void
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::ThreadedProjectPrincipalComponents( const InputImageRegionType & region )
+  {
+    const unsigned int K = this->m_NumberOfFeatureImages;
+    const unsigned int P = this->GetNumberOfOutputs();
+    const unsigned int blockSize = 1024;
+
+    std::vector< InputImageConstIterator > iterators( K );
+    for( unsigned int i = 0; i < K; ++i )
+    {
+      iterators[ i ] = InputImageConstIterator( this->GetInput( i ), region );
+      iterators[ i ].GoToBegin();
+    }
+    std::vector< OutputImageIterator > outputIterators( P );
+    for( unsigned int j = 0; j < P; ++j )
+    {
+      OutputImageRegionType outputRegion;
+      outputRegion.SetIndex( region.GetIndex() );
+      outputRegion.SetSize( region.GetSize() );
+      outputIterators[ j ] = OutputImageIterator( this->GetOutput( j ), outputRegion );
+      outputIterators[ j ].GoToBegin();
+    }
+
+    /** The first P eigen vectors, row by row. */
+    std::vector<double> eigenVectors( K * P );
+    for( unsigned int a = 0; a < K; ++a )
+    {
+      for( unsigned int j = 0; j < P; ++j )
+      {
+        eigenVectors[ a * P + j ] = this->m_EigenVectors[ a ][ j ];
+      }
+    }
+
+    /** Blocked product of the centered pixels with the eigen vectors. */
+    std::vector<double> block( blockSize * K );
+    std::vector<double> components( blockSize * P );
+    SizeValueType remaining = region.GetNumberOfPixels();
+    while( remaining > 0 )
+    {
+      const unsigned int pixels = static_cast<unsigned int>(
+        std::min<SizeValueType>( remaining, blockSize ) );
+      remaining -= pixels;
+
+      for( unsigned int i = 0; i < K; ++i )
+      {
+        const double mean = this->m_MeanOfFeatureImages[ i ];
+        for( unsigned int pix = 0; pix < pixels; ++pix, ++iterators[ i ] )
+        {
+          block[ pix * K + i ] = iterators[ i ].Get() - mean;
+        }
+      }
+
+      std::fill( components.begin(), components.begin() + pixels * P, 0.0 );
+      for( unsigned int pix = 0; pix < pixels; ++pix )
+      {
+        const double * x = &block[ pix * K ];
+        double * y = &components[ pix * P ];
+        for( unsigned int a = 0; a < K; ++a )
+        {
+          const double xa = x[ a ];
+          const double * v = &eigenVectors[ a * P ];
+          for( unsigned int j = 0; j < P; ++j )
+          {
+            y[ j ] += xa * v[ j ];
+          }
+        }
+      }
+
+      for( unsigned int j = 0; j < P; ++j )
+      {
+        for( unsigned int pix = 0; pix < pixels; ++pix, ++outputIterators[ j ] )
+        {
+          outputIterators[ j ].Set(
+            static_cast< OutputImagePixelType >( components[ pix * P + j ] ) );
+        }
+      }
+    }
+
+  } // end ThreadedProjectPrincipalComponents()
+
+
   /**
    * ********************* PrintSelf ****************************
    */
@@ -469,6 +877,10 @@ namespace itk
       << this->m_NumberOfFeatureImages << std::endl;
     os << indent << "NumberOfPixels: "
       << this->m_NumberOfPixels << std::endl;
+    os << indent << "UseStreamedCovariance: "
+      << this->m_UseStreamedCovariance << std::endl;
+    os << indent << "NumberOfStreamDivisions: "
+      << this->m_NumberOfStreamDivisions << std::endl;
 
     os << indent << "CovarianceMatrix: " << std::endl;
     for( unsigned int i = 0; i < this->m_CovarianceMatrix.size(); i++ )
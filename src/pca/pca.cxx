@@ -43,6 +43,8 @@ std::string GetHelpString( void )
     << "  [-out]   outputDirectory, default equal to the inputFilename directory\n"
     << "  [-opc]   the number of principal components that you want to output, default all\n"
     << "  [-opct]  output pixel component type, default derived from the input image\n"
+    << "  [-ns]    number of streams; if given, the inputs are read piece by piece\n"
+    << "           and the covariance is accumulated without loading all images\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
 
   return ss.str();
@@ -87,6 +89,9 @@ int main( int argc, char **argv )
   unsigned int numberOfPCs = inputFileNames.size();
   parser->GetCommandLineArgument( "-npc", numberOfPCs );
 
+  unsigned int numberOfStreams = 0;
+  parser->GetCommandLineArgument( "-ns", numberOfStreams );
+
   std::string componentTypeString = "";
   bool retopct = parser->GetCommandLineArgument( "-opct", componentTypeString );
 
@@ -155,6 +160,7 @@ int main( int argc, char **argv )
     filter->m_InputFileNames = inputFileNames;
     filter->m_OutputDirectory = outputDirectory;
     filter->m_NumberOfPCs = numberOfPCs;
+    filter->m_NumberOfStreamDivisions = numberOfStreams;
 
     filter->Run();
 
@@ -41,6 +41,7 @@ public:
   {
     this->m_OutputDirectory = "";
     this->m_NumberOfPCs = 0;
+    this->m_NumberOfStreamDivisions = 0;
   };
   /** Destructor. */
   ~ITKToolsPCABase(){};
@@ -49,6 +50,7 @@ public:
   std::vector< std::string > m_InputFileNames;
   std::string m_OutputDirectory;
   unsigned int m_NumberOfPCs;
+  unsigned int m_NumberOfStreamDivisions;
 
 }; // end class ITKToolsPCABase
 
@@ -92,6 +94,12 @@ public:
     typename PCAEstimatorType::Pointer pcaEstimator = PCAEstimatorType::New();
     pcaEstimator->SetNumberOfFeatureImages( noInputs );
     pcaEstimator->SetNumberOfPrincipalComponentsRequired( this->m_NumberOfPCs );
+    const bool streamed = this->m_NumberOfStreamDivisions > 0;
+    if( streamed )
+    {
+      pcaEstimator->SetUseStreamedCovariance( true );
+      pcaEstimator->SetNumberOfStreamDivisions( this->m_NumberOfStreamDivisions );
+    }
 
     /** For all inputs... */
     std::vector<ReaderPointer> readers( noInputs );
@@ -100,7 +108,7 @@ public:
       /** Read in the input images. */
       readers[ i ] = ReaderType::New();
       readers[ i ]->SetFileName( this->m_InputFileNames[ i ] );
-      readers[ i ]->Update();
+      if( !streamed ) readers[ i ]->Update();
 
       /** Setup PCA estimator. */
       pcaEstimator->SetInput( i, readers[ i ]->GetOutput() );
@@ -0,0 +1,208 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSeparableResizeImageFilter_h_
+#define __itkSeparableResizeImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+#include "itkMultiThreader.h"
+#include "vnl/vnl_math.h"
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class SeparableResizeImageFilter
+ * \brief Resizes an image along its axes with separable one-dimensional kernels.
+ *
+ * A resize has no rotation, so the D-dimensional interpolation of
+ * ResampleImageFilter can be replaced by D passes of a 1D kernel, one
+ * along each axis. The kernel weights only depend on the output index
+ * along the axis, so they are computed once per axis. The axes that
+ * shrink the most are processed first, which keeps the intermediate
+ * images small. Each pass is multi-threaded over the image lines.
+ *
+ * The geometry is the one of pxresizeimage: the output has the origin,
+ * direction and start index of the input, and output index j maps to the
+ * continuous input index j * OutputSpacing / InputSpacing. Outside the
+ * image the input is extended by its border, or mirrored for the cubic
+ * B-spline, as BSplineInterpolateImageFunction does.
+ *
+ * The kernels are:
+ * - NearestNeighbor and Linear interpolation.
+ * - CubicBSpline: cubic B-spline interpolation. Each line is first
+ *   converted to B-spline coefficients with the recursive filter of
+ *   BSplineDecompositionImageFilter.
+ * - Lanczos: the Lanczos kernel with three lobes. When downsampling the
+ *   kernel is widened by the downsampling factor, to prevent aliasing.
+ * - AreaAveraging: each output pixel is the average of the input pixels
+ *   it covers, weighted by the overlap. When upsampling this is the same
+ *   as linear interpolation.
+ *
+ * The filter streams: for a requested output region only the input
+ * region that the kernels touch is requested. For the cubic B-spline
+ * the recursive filter needs a margin, beyond which its impulse response
+ * is below 1e-8; streamed pieces are therefore exact up to that level.
+ * Integer outputs are rounded to the nearest value and all outputs are
+ * clamped to the range of the output pixel type.
+ *
+ * \ingroup GeometricTransform Multithreaded Streamed
+ */
+
+template< class TInputImage, class TOutputImage >
+class SeparableResizeImageFilter
+  : public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef SeparableResizeImageFilter                        Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SeparableResizeImageFilter, ImageToImageFilter );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedef's. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename InputImageType::PixelType          InputPixelType;
+  typedef typename OutputImageType::PixelType         OutputPixelType;
+  typedef typename OutputImageType::RegionType        RegionType;
+  typedef typename OutputImageType::SizeType          SizeType;
+  typedef typename OutputImageType::SpacingType       SpacingType;
+  typedef typename NumericTraits<InputPixelType>::FloatType InternalPixelType;
+
+  /** The kernels. */
+  typedef enum { NearestNeighbor = 0,
+    Linear = 1,
+    CubicBSpline = 2,
+    Lanczos = 3,
+    AreaAveraging = 4 } KernelType;
+
+  /** Set/Get the kernel. */
+  itkSetMacro( Kernel, KernelType );
+  itkGetConstMacro( Kernel, KernelType );
+
+  /** Set/Get the size of the output image. */
+  itkSetMacro( Size, SizeType );
+  itkGetConstReferenceMacro( Size, SizeType );
+
+  /** Set/Get the spacing of the output image. */
+  itkSetMacro( OutputSpacing, SpacingType );
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+
+protected:
+  SeparableResizeImageFilter();
+  virtual ~SeparableResizeImageFilter() {};
+  void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The output has the size and spacing that were set. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Only the input region touched by the kernels is requested. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** Performs the passes along the axes. */
+  virtual void GenerateData( void );
+
+  /** The kernel weights of one axis. Output index outputStart + j uses
+   * the input pixels First[ j ], First[ j ] + 1, ..., with the weights
+   * Weights[ Offsets[ j ] ] up to Weights[ Offsets[ j + 1 ] ].
+   */
+  struct KernelTableType
+  {
+    std::vector<IndexValueType>   First;
+    std::vector<SizeValueType>    Offsets;
+    std::vector<double>           Weights;
+  };
+
+  /** Computes the kernel weights for a range of output indices. */
+  void ComputeKernelTable( unsigned int axis, IndexValueType outputStart,
+    SizeValueType outputSize, KernelTableType & table ) const;
+
+  /** Computes the input region that the kernels need for an output region. */
+  RegionType ComputeInputRegion( const RegionType & outputRegion ) const;
+
+  /** The state of a pass along one axis. */
+  struct PassStruct
+  {
+    Self *                  Filter;
+    unsigned int            Axis;
+    const KernelTableType * Table;
+    const void *            Source;
+    RegionType              SourceBufferedRegion;
+    RegionType              SourceRegion;
+    void *                  Destination;
+    RegionType              DestinationBufferedRegion;
+    RegionType              DestinationRegion;
+    bool                    SourceIsInput;
+    bool                    DestinationIsOutput;
+  };
+  static ITK_THREAD_RETURN_TYPE PassThreaderCallback( void * arg );
+
+  /** Resamples the lines of a pass that belong to a thread. */
+  template< class TSourcePixel, class TDestinationPixel >
+  void ThreadedResampleLines( const PassStruct & pass,
+    ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** Converts a line to cubic B-spline coefficients, with mirror boundaries. */
+  static void ComputeBSplineCoefficients( std::vector<double> & line );
+
+  /** Rounds integers, and clamps to the range of the pixel type. */
+  template< class TPixel >
+  static TPixel ClampCast( double value )
+  {
+    if( value <= static_cast<double>( NumericTraits<TPixel>::NonpositiveMin() ) )
+    {
+      return NumericTraits<TPixel>::NonpositiveMin();
+    }
+    if( value >= static_cast<double>( NumericTraits<TPixel>::max() ) )
+    {
+      return NumericTraits<TPixel>::max();
+    }
+    if( NumericTraits<TPixel>::is_integer )
+    {
+      return static_cast<TPixel>( vcl_floor( value + 0.5 ) );
+    }
+    return static_cast<TPixel>( value );
+  }
+
+private:
+  SeparableResizeImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & );             // purposely not implemented
+
+  KernelType    m_Kernel;
+  SizeType      m_Size;
+  SpacingType   m_OutputSpacing;
+
+}; // end class SeparableResizeImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSeparableResizeImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkSeparableResizeImageFilter_h_
@@ -0,0 +1,569 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSeparableResizeImageFilter_txx_
+#define __itkSeparableResizeImageFilter_txx_
+
+#include "itkSeparableResizeImageFilter.h"
+#include <algorithm>
+#include <utility>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::SeparableResizeImageFilter()
+{
+  this->m_Kernel = Self::Linear;
+  this->m_Size.Fill( 0 );
+  this->m_OutputSpacing.Fill( 1.0 );
+
+} // end Constructor
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::GenerateOutputInformation( void )
+{
+  /** Copies the origin and the direction of the input. */
+  Superclass::GenerateOutputInformation();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  if( !input || !output ) return;
+
+  RegionType region;
+  region.SetIndex( input->GetLargestPossibleRegion().GetIndex() );
+  region.SetSize( this->m_Size );
+  output->SetLargestPossibleRegion( region );
+  output->SetSpacing( this->m_OutputSpacing );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* GenerateInputRequestedRegion ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImageType * input = const_cast<InputImageType *>( this->GetInput() );
+  if( !input ) return;
+
+  input->SetRequestedRegion(
+    this->ComputeInputRegion( this->GetOutput()->GetRequestedRegion() ) );
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * ********************* ComputeKernelTable ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::ComputeKernelTable( unsigned int axis, IndexValueType outputStart,
+  SizeValueType outputSize, KernelTableType & table ) const
+{
+  const InputImageType * input = this->GetInput();
+  const RegionType & largestRegion = input->GetLargestPossibleRegion();
+  const IndexValueType lo = largestRegion.GetIndex()[ axis ];
+  const IndexValueType hi = lo + static_cast<IndexValueType>( largestRegion.GetSize()[ axis ] ) - 1;
+  const double ratio = this->m_OutputSpacing[ axis ] / input->GetSpacing()[ axis ];
+
+  table.First.resize( outputSize );
+  table.Offsets.assign( outputSize + 1, 0 );
+  table.Weights.clear();
+
+  std::vector<IndexValueType> indices;
+  std::vector<double> weights;
+  std::vector<double> folded;
+  for( SizeValueType j = 0; j < outputSize; ++j )
+  {
+    /** The continuous input index of this output index. */
+    const double c = static_cast<double>( outputStart + static_cast<IndexValueType>( j ) ) * ratio;
+
+    /** The raw kernel weights. */
+    indices.clear();
+    weights.clear();
+    if( this->m_Kernel == Self::NearestNeighbor )
+    {
+      indices.push_back( static_cast<IndexValueType>( vcl_floor( c + 0.5 ) ) );
+      weights.push_back( 1.0 );
+    }
+    else if( this->m_Kernel == Self::Linear
+      || ( this->m_Kernel == Self::AreaAveraging && ratio <= 1.0 ) )
+    {
+      const IndexValueType i0 = static_cast<IndexValueType>( vcl_floor( c ) );
+      const double f = c - static_cast<double>( i0 );
+      indices.push_back( i0 );     weights.push_back( 1.0 - f );
+      indices.push_back( i0 + 1 ); weights.push_back( f );
+    }
+    else if( this->m_Kernel == Self::CubicBSpline )
+    {
+      const IndexValueType i0 = static_cast<IndexValueType>( vcl_floor( c ) ) - 1;
+      for( IndexValueType i = i0; i < i0 + 4; ++i )
+      {
+        const double x = vnl_math_abs( c - static_cast<double>( i ) );
+        indices.push_back( i );
+        weights.push_back( x < 1.0
+          ? 2.0 / 3.0 - x * x + 0.5 * x * x * x
+          : ( 2.0 - x ) * ( 2.0 - x ) * ( 2.0 - x ) / 6.0 );
+      }
+    }
+    else if( this->m_Kernel == Self::Lanczos )
+    {
+      /** Widened by the downsampling factor, to prevent aliasing. */
+      const double scale = vnl_math_max( 1.0, ratio );
+      const double support = 3.0 * scale;
+      const IndexValueType first = static_cast<IndexValueType>( vcl_ceil( c - support ) );
+      const IndexValueType last = static_cast<IndexValueType>( vcl_floor( c + support ) );
+      for( IndexValueType i = first; i <= last; ++i )
+      {
+        const double x = ( c - static_cast<double>( i ) ) / scale;
+        double w = 1.0;
+        if( vnl_math_abs( x ) >= 3.0 )
+        {
+          w = 0.0;
+        }
+        else if( x != 0.0 )
+        {
+          const double px = vnl_math::pi * x;
+          w = 3.0 * vcl_sin( px ) * vcl_sin( px / 3.0 ) / ( px * px );
+        }
+        indices.push_back( i );
+        weights.push_back( w );
+      }
+    }
+    else // AreaAveraging
+    {
+      /** The overlap of [c - ratio / 2, c + ratio / 2] with the input pixels. */
+      const double a = c - 0.5 * ratio;
+      const double b = c + 0.5 * ratio;
+      const IndexValueType first = static_cast<IndexValueType>( vcl_floor( a + 0.5 ) );
+      const IndexValueType last = static_cast<IndexValueType>( vcl_ceil( b - 0.5 ) );
+      for( IndexValueType i = first; i <= last; ++i )
+      {
+        const double overlap = vnl_math_min( b, i + 0.5 ) - vnl_math_max( a, i - 0.5 );
+        if( overlap > 0.0 )
+        {
+          indices.push_back( i );
+          weights.push_back( overlap );
+        }
+      }
+    }
+
+    /** Fold the indices into the image: mirror for the B-spline, clamp otherwise. */
+    const IndexValueType period = 2 * ( hi - lo );
+    IndexValueType first = hi;
+    IndexValueType last = lo;
+    for( unsigned int t = 0; t < indices.size(); ++t )
+    {
+      IndexValueType i = indices[ t ];
+      if( this->m_Kernel == Self::CubicBSpline && period > 0 )
+      {
+        i = ( i - lo ) % period;
+        if( i < 0 ) i += period;
+        if( i > hi - lo ) i = period - i;
+        i += lo;
+      }
+      else
+      {
+        i = vnl_math_min( vnl_math_max( i, lo ), hi );
+      }
+      indices[ t ] = i;
+      first = vnl_math_min( first, i );
+      last = vnl_math_max( last, i );
+    }
+
+    double sum = 0.0;
+    folded.assign( last - first + 1, 0.0 );
+    for( unsigned int t = 0; t < indices.size(); ++t )
+    {
+      folded[ indices[ t ] - first ] += weights[ t ];
+      sum += weights[ t ];
+    }
+    if( sum != 0.0 )
+    {
+      for( unsigned int t = 0; t < folded.size(); ++t ) folded[ t ] /= sum;
+    }
+
+    table.First[ j ] = first;
+    table.Weights.insert( table.Weights.end(), folded.begin(), folded.end() );
+    table.Offsets[ j + 1 ] = table.Weights.size();
+  }
+
+} // end ComputeKernelTable()
+
+
+/**
+ * ********************* ComputeInputRegion ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+typename SeparableResizeImageFilter< TInputImage, TOutputImage >::RegionType
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::ComputeInputRegion( const RegionType & outputRegion ) const
+{
+  const RegionType & largestRegion = this->GetInput()->GetLargestPossibleRegion();
+
+  /** Beyond this margin the recursive B-spline filter is below 1e-8. */
+  const IndexValueType margin = static_cast<IndexValueType>(
+    vcl_ceil( vcl_log( 1e-8 ) / vcl_log( 2.0 - vcl_sqrt( 3.0 ) ) ) );
+
+  RegionType inputRegion;
+  KernelTableType table;
+  for( unsigned int axis = 0; axis < ImageDimension; ++axis )
+  {
+    this->ComputeKernelTable( axis, outputRegion.GetIndex()[ axis ],
+      outputRegion.GetSize()[ axis ], table );
+
+    const IndexValueType lo = largestRegion.GetIndex()[ axis ];
+    const IndexValueType hi = lo + static_cast<IndexValueType>( largestRegion.GetSize()[ axis ] ) - 1;
+    IndexValueType first = hi;
+    IndexValueType last = lo;
+    for( SizeValueType j = 0; j < table.First.size(); ++j )
+    {
+      first = vnl_math_min( first, table.First[ j ] );
+      last = vnl_math_max( last, table.First[ j ]
+        + static_cast<IndexValueType>( table.Offsets[ j + 1 ] - table.Offsets[ j ] ) - 1 );
+    }
+    if( this->m_Kernel == Self::CubicBSpline )
+    {
+      first = vnl_math_max( first - margin, lo );
+      last = vnl_math_min( last + margin, hi );
+    }
+
+    inputRegion.SetIndex( axis, first );
+    inputRegion.SetSize( axis, static_cast<SizeValueType>( last - first + 1 ) );
+  }
+
+  return inputRegion;
+
+} // end ComputeInputRegion()
+
+
+/**
+ * ********************* GenerateData ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::GenerateData( void )
+{
+  this->AllocateOutputs();
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+  const RegionType outputRegion = output->GetRequestedRegion();
+  const RegionType inputRegion = this->ComputeInputRegion( outputRegion );
+
+  /** The kernel tables, and the order of the passes: shrink first. */
+  std::vector<KernelTableType> tables( ImageDimension );
+  std::vector< std::pair<double, unsigned int> > order;
+  for( unsigned int axis = 0; axis < ImageDimension; ++axis )
+  {
+    this->ComputeKernelTable( axis, outputRegion.GetIndex()[ axis ],
+      outputRegion.GetSize()[ axis ], tables[ axis ] );
+    order.push_back( std::make_pair( static_cast<double>( outputRegion.GetSize()[ axis ] )
+      / static_cast<double>( inputRegion.GetSize()[ axis ] ), axis ) );
+  }
+  std::sort( order.begin(), order.end() );
+
+  /** Setup the threader. */
+  PassStruct pass;
+  pass.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->PassThreaderCallback, &pass );
+
+  /** One pass per axis; the intermediate images are plain buffers. */
+  std::vector<InternalPixelType> buffers[ 2 ];
+  RegionType sourceRegion = inputRegion;
+  for( unsigned int p = 0; p < ImageDimension; ++p )
+  {
+    const unsigned int axis = order[ p ].second;
+    RegionType destinationRegion = sourceRegion;
+    destinationRegion.SetIndex( axis, outputRegion.GetIndex()[ axis ] );
+    destinationRegion.SetSize( axis, outputRegion.GetSize()[ axis ] );
+
+    pass.Axis = axis;
+    pass.Table = &tables[ axis ];
+    pass.SourceIsInput = ( p == 0 );
+    pass.DestinationIsOutput = ( p == ImageDimension - 1 );
+    pass.SourceRegion = sourceRegion;
+    pass.DestinationRegion = destinationRegion;
+    if( pass.SourceIsInput )
+    {
+      pass.Source = input->GetBufferPointer();
+      pass.SourceBufferedRegion = input->GetBufferedRegion();
+    }
+    else
+    {
+      pass.Source = &buffers[ ( p - 1 ) % 2 ][ 0 ];
+      pass.SourceBufferedRegion = sourceRegion;
+    }
+    if( pass.DestinationIsOutput )
+    {
+      pass.Destination = output->GetBufferPointer();
+      pass.DestinationBufferedRegion = output->GetBufferedRegion();
+    }
+    else
+    {
+      buffers[ p % 2 ].resize( destinationRegion.GetNumberOfPixels() );
+      pass.Destination = &buffers[ p % 2 ][ 0 ];
+      pass.DestinationBufferedRegion = destinationRegion;
+    }
+
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    /** Release the source of this pass. */
+    if( !pass.SourceIsInput )
+    {
+      std::vector<InternalPixelType>().swap( buffers[ ( p - 1 ) % 2 ] );
+    }
+    sourceRegion = destinationRegion;
+  }
+
+} // end GenerateData()
+
+
+/**
+ * ********************* PassThreaderCallback ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::PassThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  const PassStruct * pass = static_cast<PassStruct *>( info->UserData );
+
+  if( pass->SourceIsInput && pass->DestinationIsOutput )
+  {
+    pass->Filter->template ThreadedResampleLines<InputPixelType, OutputPixelType>(
+      *pass, threadId, threadCount );
+  }
+  else if( pass->SourceIsInput )
+  {
+    pass->Filter->template ThreadedResampleLines<InputPixelType, InternalPixelType>(
+      *pass, threadId, threadCount );
+  }
+  else if( pass->DestinationIsOutput )
+  {
+    pass->Filter->template ThreadedResampleLines<InternalPixelType, OutputPixelType>(
+      *pass, threadId, threadCount );
+  }
+  else
+  {
+    pass->Filter->template ThreadedResampleLines<InternalPixelType, InternalPixelType>(
+      *pass, threadId, threadCount );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end PassThreaderCallback()
+
+
+/**
+ * ********************* ThreadedResampleLines ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+template< class TSourcePixel, class TDestinationPixel >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::ThreadedResampleLines( const PassStruct & pass,
+  ThreadIdType threadId, ThreadIdType numberOfThreads )
+{
+  const unsigned int axis = pass.Axis;
+  const KernelTableType & table = *pass.Table;
+  const TSourcePixel * source = static_cast<const TSourcePixel *>( pass.Source );
+  TDestinationPixel * destination = static_cast<TDestinationPixel *>( pass.Destination );
+
+  /** The strides of the buffers. */
+  OffsetValueType sourceStride[ ImageDimension ];
+  OffsetValueType destinationStride[ ImageDimension ];
+  sourceStride[ 0 ] = destinationStride[ 0 ] = 1;
+  for( unsigned int k = 1; k < ImageDimension; ++k )
+  {
+    sourceStride[ k ] = sourceStride[ k - 1 ]
+      * static_cast<OffsetValueType>( pass.SourceBufferedRegion.GetSize()[ k - 1 ] );
+    destinationStride[ k ] = destinationStride[ k - 1 ]
+      * static_cast<OffsetValueType>( pass.DestinationBufferedRegion.GetSize()[ k - 1 ] );
+  }
+
+  /** The lines along the axis that belong to this thread. */
+  const IndexValueType sourceStart = pass.SourceRegion.GetIndex()[ axis ];
+  const SizeValueType sourceLength = pass.SourceRegion.GetSize()[ axis ];
+  const SizeValueType destinationLength = pass.DestinationRegion.GetSize()[ axis ];
+  const SizeValueType numberOfLines
+    = pass.DestinationRegion.GetNumberOfPixels() / destinationLength;
+  const SizeValueType firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType lastLine = numberOfLines * ( threadId + 1 ) / numberOfThreads;
+
+  std::vector<double> line( sourceLength );
+  for( SizeValueType l = firstLine; l < lastLine; ++l )
+  {
+    /** The offsets of the start of the line in both buffers. */
+    OffsetValueType s = ( sourceStart - pass.SourceBufferedRegion.GetIndex()[ axis ] )
+      * sourceStride[ axis ];
+    OffsetValueType d = ( pass.DestinationRegion.GetIndex()[ axis ]
+      - pass.DestinationBufferedRegion.GetIndex()[ axis ] ) * destinationStride[ axis ];
+    SizeValueType rest = l;
+    for( unsigned int k = 0; k < ImageDimension; ++k )
+    {
+      if( k == axis ) continue;
+      const SizeValueType size = pass.DestinationRegion.GetSize()[ k ];
+      const IndexValueType index = pass.DestinationRegion.GetIndex()[ k ]
+        + static_cast<IndexValueType>( rest % size );
+      rest /= size;
+      s += ( index - pass.SourceBufferedRegion.GetIndex()[ k ] ) * sourceStride[ k ];
+      d += ( index - pass.DestinationBufferedRegion.GetIndex()[ k ] ) * destinationStride[ k ];
+    }
+
+    /** Gather the line, and apply the kernel. */
+    for( SizeValueType n = 0; n < sourceLength; ++n )
+    {
+      line[ n ] = static_cast<double>( source[ s + n * sourceStride[ axis ] ] );
+    }
+    if( this->m_Kernel == Self::CubicBSpline )
+    {
+      Self::ComputeBSplineCoefficients( line );
+    }
+
+    for( SizeValueType j = 0; j < destinationLength; ++j )
+    {
+      const double * w = &table.Weights[ table.Offsets[ j ] ];
+      const double * x = &line[ table.First[ j ] - sourceStart ];
+      const SizeValueType count = table.Offsets[ j + 1 ] - table.Offsets[ j ];
+      double value = 0.0;
+      for( SizeValueType t = 0; t < count; ++t )
+      {
+        value += w[ t ] * x[ t ];
+      }
+      destination[ d + j * destinationStride[ axis ] ]
+        = ClampCast<TDestinationPixel>( value );
+    }
+  }
+
+} // end ThreadedResampleLines()
+
+
+/**
+ * ********************* ComputeBSplineCoefficients ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::ComputeBSplineCoefficients( std::vector<double> & line )
+{
+  /** As BSplineDecompositionImageFilter, for order 3 and tolerance 1e-10. */
+  const SizeValueType n = line.size();
+  if( n < 2 ) return;
+
+  const double z = vcl_sqrt( 3.0 ) - 2.0;
+  const double lambda = ( 1.0 - z ) * ( 1.0 - 1.0 / z );
+  for( SizeValueType k = 0; k < n; ++k )
+  {
+    line[ k ] *= lambda;
+  }
+
+  /** The initial causal coefficient. */
+  const SizeValueType horizon = static_cast<SizeValueType>(
+    vcl_ceil( vcl_log( 1e-10 ) / vcl_log( vcl_fabs( z ) ) ) );
+  double zn = z;
+  if( horizon < n )
+  {
+    double sum = line[ 0 ];
+    for( SizeValueType k = 1; k < horizon; ++k )
+    {
+      sum += zn * line[ k ];
+      zn *= z;
+    }
+    line[ 0 ] = sum;
+  }
+  else
+  {
+    const double iz = 1.0 / z;
+    double z2n = vcl_pow( z, static_cast<double>( n - 1 ) );
+    double sum = line[ 0 ] + z2n * line[ n - 1 ];
+    z2n *= z2n * iz;
+    for( SizeValueType k = 1; k + 1 < n; ++k )
+    {
+      sum += ( zn + z2n ) * line[ k ];
+      zn *= z;
+      z2n *= iz;
+    }
+    line[ 0 ] = sum / ( 1.0 - zn * zn );
+  }
+
+  /** The causal and anti-causal recursions. */
+  for( SizeValueType k = 1; k < n; ++k )
+  {
+    line[ k ] += z * line[ k - 1 ];
+  }
+  line[ n - 1 ] = ( z / ( z * z - 1.0 ) ) * ( z * line[ n - 2 ] + line[ n - 1 ] );
+  for( SizeValueType k = n - 1; k > 0; --k )
+  {
+    line[ k - 1 ] = z * ( line[ k ] - line[ k - 1 ] );
+  }
+
+} // end ComputeBSplineCoefficients()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+SeparableResizeImageFilter< TInputImage, TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Kernel: " << this->m_Kernel << std::endl;
+  os << indent << "Size: " << this->m_Size << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkSeparableResizeImageFilter_txx_
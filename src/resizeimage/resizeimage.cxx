@@ -44,8 +44,16 @@ std::string GetHelpString( void )
     << "  [-f]     factor\n"
     << "  [-sp]    spacing\n"
     << "  [-io]    interpolation order, default 1\n"
+    << "  [-k]     use the separable engine with kernel: nearest, linear, cubic,\n"
+    << "           lanczos, area; overrides -io\n"
+    << "  [-s]     number of streams of the separable engine, default 1\n"
+    << "  [-threads] maximum number of threads, default all\n"
     << "  [-dim]   dimension, default 3\n"
     << "One of -f and -sp should be given.\n"
+    << "By default the generic resampler is used, with B-spline interpolation of order -io.\n"
+    << "With -k a threaded separable engine is used, one axis at a time, which streams the\n"
+    << "output. It replicates the border instead of using 0 outside the image, and rounds\n"
+    << "integer results. lanczos and area also smooth when downsampling, to prevent aliasing.\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
 
   return ss.str();
@@ -102,6 +110,24 @@ int main( int argc, char **argv )
   unsigned int interpolationOrder = 1;
   parser->GetCommandLineArgument( "-io", interpolationOrder );
 
+  std::string kernel = "";
+  parser->GetCommandLineArgument( "-k", kernel );
+
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
+  /** Check the kernel. */
+  if( kernel != "" && kernel != "nearest" && kernel != "linear"
+    && kernel != "cubic" && kernel != "lanczos" && kernel != "area" )
+  {
+    std::cerr << "ERROR: The kernel should be one of nearest, linear, cubic, lanczos, area." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Check factor and spacing. */
   if( retf )
   {
@@ -195,6 +221,8 @@ int main( int argc, char **argv )
     filter->m_FactorOrSpacing = factorOrSpacing;
     filter->m_IsFactor = isFactor;
     filter->m_InterpolationOrder = interpolationOrder;
+    filter->m_Kernel = kernel;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
@@ -24,6 +24,7 @@
 #include "itkResampleImageFilter.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
+#include "itkSeparableResizeImageFilter.h"
 
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
@@ -45,6 +46,8 @@ public:
     this->m_OutputFileName = "";
     this->m_IsFactor = false;
     this->m_InterpolationOrder = 0;
+    this->m_Kernel = "";
+    this->m_NumberOfStreams = 1;
   };
   /** Destructor. */
   ~ITKToolsResizeImageBase(){};
@@ -55,6 +58,8 @@ public:
   std::vector<double> m_FactorOrSpacing;
   bool m_IsFactor;
   unsigned int m_InterpolationOrder;
+  std::string m_Kernel;
+  unsigned int m_NumberOfStreams;
 
 }; // end class ITKToolsResizeImageBase
 
@@ -88,6 +93,8 @@ public:
       InputImageType, double >                          NNInterpolatorType;
     typedef itk::BSplineInterpolateImageFunction<
       InputImageType >                                  BSplineInterpolatorType;
+    typedef itk::SeparableResizeImageFilter<
+      InputImageType, InputImageType >                  SeparableResizerType;
 
     typedef typename InputImageType::SizeType         SizeType;
     typedef typename InputImageType::SpacingType      SpacingType;
@@ -104,10 +111,10 @@ public:
     typename BSplineInterpolatorType::Pointer bsInterpolator
       = BSplineInterpolatorType::New();
 
-    /** Read in the inputImage. */
+    /** Read the meta data of the inputImage. */
     reader->SetFileName( this->m_InputFileName.c_str() );
     inputImage = reader->GetOutput();
-    inputImage->Update();
+    inputImage->UpdateOutputInformation();
 
     /** Prepare stuff. */
     SpacingType inputSpacing  = inputImage->GetSpacing();
@@ -132,6 +139,36 @@ public:
       }
     }
 
+    /** The separable engine is only used if a kernel is selected;
+     * otherwise the generic resampler is used.
+     */
+    const bool useSeparable = this->m_Kernel != "";
+    typename SeparableResizerType::KernelType kernel = SeparableResizerType::Linear;
+    if( this->m_Kernel == "nearest" ) kernel = SeparableResizerType::NearestNeighbor;
+    else if( this->m_Kernel == "linear" ) kernel = SeparableResizerType::Linear;
+    else if( this->m_Kernel == "cubic" ) kernel = SeparableResizerType::CubicBSpline;
+    else if( this->m_Kernel == "lanczos" ) kernel = SeparableResizerType::Lanczos;
+    else if( this->m_Kernel == "area" ) kernel = SeparableResizerType::AreaAveraging;
+
+    /** The separable engine streams through the output. */
+    if( useSeparable )
+    {
+      typename SeparableResizerType::Pointer resizer = SeparableResizerType::New();
+      resizer->SetInput( inputImage );
+      resizer->SetSize( outputSize );
+      resizer->SetOutputSpacing( outputSpacing );
+      resizer->SetKernel( kernel );
+
+      writer->SetFileName( this->m_OutputFileName.c_str() );
+      writer->SetInput( resizer->GetOutput() );
+      writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+      writer->Update();
+      return;
+    }
+
+    /** The generic resampler needs the whole image. */
+    inputImage->Update();
+
     /** Setup the pipeline. */
     resampler->SetInput( inputImage );
     resampler->SetSize( outputSize );
@@ -0,0 +1,222 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkMultiLabelSphericalDistanceCalculator_h_
+#define __itkMultiLabelSphericalDistanceCalculator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkContinuousIndex.h"
+#include "itkMultiThreader.h"
+#include <vector>
+#include <map>
+
+
+namespace itk {
+
+/** \class MultiLabelSphericalDistanceCalculator
+ * \brief Computes the spherical segmentation distance profiles of one or
+ * more labels in a single fused, multithreaded pass per label.
+ *
+ * For every label the profile is a (theta, phi) image. It holds the mean
+ * signed distance from the edge of the label in Input2 to the surface of
+ * the label in Input1, seen from the center of rotation in each direction.
+ * Both the inner edge (label voxels with a face neighbour outside the
+ * label) and the outer edge (the face neighbours outside) of Input2 are
+ * used. Inner edge voxels take the signed distance of the label in
+ * Input1, outer edge voxels minus the signed distance of its complement,
+ * as in the original pxsegmentationdistance pipeline.
+ *
+ * The labels are given with SetLabels(). Without labels all nonzero voxels
+ * form a single foreground label. The center of rotation is either given,
+ * or the center of mass of the label in Input1.
+ *
+ * The computation avoids full sized intermediate images:
+ * - one pass over both inputs finds the bounding box and center of mass
+ *   of every label;
+ * - the signed distance maps are computed on the bounding box of each
+ *   label, padded by two voxels;
+ * - edge extraction, distance lookup and angular binning are fused in one
+ *   threaded pass over that box, with per-thread (theta, phi)
+ *   accumulators.
+ *
+ * Every edge voxel is sampled at up to MaximumNumberOfSamplesPerVoxel
+ * points, fewer far from the center where the voxels cover more
+ * directions. The points follow a fixed Halton sequence, so the result
+ * does not depend on the number of threads. Every sample is spread over
+ * the two nearest theta and phi bins, and the samples of a direction are
+ * averaged. Unlike the original pipeline there is no radial dimension:
+ * samples on different radii in one direction are averaged together.
+ *
+ * Only 3D images are supported.
+ */
+
+template< class TLabelImage, class TOutputImage >
+class MultiLabelSphericalDistanceCalculator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef MultiLabelSphericalDistanceCalculator Self;
+  typedef Object                                Superclass;
+  typedef SmartPointer<Self>                    Pointer;
+  typedef SmartPointer<const Self>              ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( MultiLabelSphericalDistanceCalculator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Dimension of the inputs. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TLabelImage::ImageDimension );
+
+  /** Input typedefs. */
+  typedef TLabelImage                               LabelImageType;
+  typedef typename LabelImageType::ConstPointer     LabelImageConstPointer;
+  typedef typename LabelImageType::PixelType        LabelType;
+  typedef typename LabelImageType::RegionType       RegionType;
+  typedef typename LabelImageType::IndexType        IndexType;
+  typedef typename LabelImageType::PointType        PointType;
+  typedef std::vector<LabelType>                    LabelContainerType;
+
+  /** Output typedefs. */
+  typedef TOutputImage                              OutputImageType;
+  typedef typename OutputImageType::Pointer         OutputImagePointer;
+  typedef typename OutputImageType::PixelType       OutputPixelType;
+
+  /** Internal typedefs. */
+  typedef Image<unsigned char, itkGetStaticConstMacro( ImageDimension )> BinaryImageType;
+  typedef Image<float, itkGetStaticConstMacro( ImageDimension )>         DistanceImageType;
+  typedef ContinuousIndex<double, itkGetStaticConstMacro( ImageDimension )> ContinuousIndexType;
+
+  /** Set the inputs. Input1 defines the surfaces, Input2 the edges. */
+  itkSetConstObjectMacro( Input1, LabelImageType );
+  itkSetConstObjectMacro( Input2, LabelImageType );
+
+  /** Set the labels; empty means all nonzero voxels. Repeated labels are removed. */
+  void SetLabels( const LabelContainerType & labels );
+  const LabelContainerType & GetLabels( void ) const
+  { return this->m_Labels; }
+
+  /** Set a center of rotation for all labels, in world coordinates.
+   * Empty (the default) uses the center of mass of each label in Input1.
+   */
+  void SetCenterOfRotation( const std::vector<double> & center );
+
+  /** Set the number of theta and phi bins. */
+  itkSetMacro( ThetaSize, unsigned int );
+  itkGetConstMacro( ThetaSize, unsigned int );
+  itkSetMacro( PhiSize, unsigned int );
+  itkGetConstMacro( PhiSize, unsigned int );
+
+  /** Set the maximum number of samples per edge voxel. */
+  itkSetMacro( MaximumNumberOfSamplesPerVoxel, unsigned int );
+  itkGetConstMacro( MaximumNumberOfSamplesPerVoxel, unsigned int );
+
+  /** Set the number of threads. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Triggers the computation. */
+  void Compute( void );
+
+  /** The results, one per label, or one for the foreground. Valid after Compute(). */
+  unsigned int GetNumberOfProfiles( void ) const
+  { return static_cast<unsigned int>( this->m_Profiles.size() ); }
+  OutputImageType * GetProfile( unsigned int i ) const
+  { return this->m_Profiles[ i ].GetPointer(); }
+  const PointType & GetUsedCenterOfRotation( unsigned int i ) const
+  { return this->m_UsedCentersOfRotation[ i ]; }
+
+protected:
+  MultiLabelSphericalDistanceCalculator();
+  virtual ~MultiLabelSphericalDistanceCalculator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Per label: bounding box over both inputs, and the center of mass in Input1. */
+  struct LabelStatistics
+  {
+    IndexType       Lower;
+    IndexType       Upper;
+    double          IndexSum[ ImageDimension ];
+    SizeValueType   Count1;
+    SizeValueType   Count2;
+  };
+
+  /** The profile index of a label value, or -1. */
+  int GetProfileIndex( LabelType value ) const;
+
+  /** Copy the membership of a profile in a region of an input to a binary image. */
+  typename BinaryImageType::Pointer ExtractBinary(
+    const LabelImageType * image, const RegionType & region,
+    unsigned int profile, bool complement ) const;
+
+  /** Compute the signed distance of a binary image. */
+  typename DistanceImageType::Pointer ComputeDistance( const BinaryImageType * binary ) const;
+
+  /** Linear interpolation of a distance map, clamped to its region. */
+  static double InterpolateDistance( const DistanceImageType * distance,
+    const ContinuousIndexType & cindex );
+
+  /** The radical inverse of i in a prime base, for the Halton sequence. */
+  static double RadicalInverse( unsigned int i, unsigned int base );
+
+  /** The fused pass over a part of the edge region. */
+  void ThreadedAccumulate( const RegionType & region, ThreadIdType threadId );
+
+private:
+  MultiLabelSphericalDistanceCalculator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  /** Callback for the multithreader. */
+  static ITK_THREAD_RETURN_TYPE AccumulateThreaderCallback( void * arg );
+
+  LabelImageConstPointer    m_Input1;
+  LabelImageConstPointer    m_Input2;
+  LabelContainerType        m_Labels;
+  std::map<LabelType, int>  m_LabelToProfile;
+  std::vector<double>       m_CenterOfRotation;
+  unsigned int              m_ThetaSize;
+  unsigned int              m_PhiSize;
+  unsigned int              m_MaximumNumberOfSamplesPerVoxel;
+  unsigned int              m_NumberOfThreads;
+
+  /** State of the current label, shared with the threads. */
+  typename BinaryImageType::Pointer   m_CurrentBinary2;
+  typename DistanceImageType::Pointer m_CurrentDistance;
+  typename DistanceImageType::Pointer m_CurrentComplementDistance;
+  RegionType                          m_CurrentEdgeRegion;
+  PointType                           m_CurrentCenter;
+  double                              m_DeltaVolumeRatioFactor;
+  std::vector<ContinuousIndexType>    m_SampleOffsets;
+  std::vector< std::vector<double> >  m_ThreadSums;
+  std::vector< std::vector<double> >  m_ThreadWeights;
+
+  /** Results. */
+  std::vector<OutputImagePointer>     m_Profiles;
+  std::vector<PointType>              m_UsedCentersOfRotation;
+
+}; // end class MultiLabelSphericalDistanceCalculator
+
+
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkMultiLabelSphericalDistanceCalculator.txx"
+#endif
+
+#endif // end #ifndef __itkMultiLabelSphericalDistanceCalculator_h_
@@ -0,0 +1,627 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkMultiLabelSphericalDistanceCalculator_txx_
+#define __itkMultiLabelSphericalDistanceCalculator_txx_
+
+#include "itkMultiLabelSphericalDistanceCalculator.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
+#include "vnl/vnl_math.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace itk {
+
+/**
+ * ************************* Constructor ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::MultiLabelSphericalDistanceCalculator()
+{
+  this->m_ThetaSize = 180;
+  this->m_PhiSize = 90;
+  this->m_MaximumNumberOfSamplesPerVoxel = 20;
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->m_DeltaVolumeRatioFactor = 0.0;
+
+} // end Constructor()
+
+
+/**
+ * ************************* SetLabels ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+void
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::SetLabels( const LabelContainerType & labels )
+{
+  /** Repeated labels are removed, keeping the order of the first occurrence,
+   * so that every profile belongs to exactly one label.
+   */
+  this->m_Labels.clear();
+  this->m_LabelToProfile.clear();
+  for( unsigned int i = 0; i < labels.size(); ++i )
+  {
+    const bool inserted = this->m_LabelToProfile.insert( std::make_pair(
+      labels[ i ], static_cast<int>( this->m_Labels.size() ) ) ).second;
+    if( inserted ) this->m_Labels.push_back( labels[ i ] );
+  }
+  this->Modified();
+
+} // end SetLabels()
+
+
+/**
+ * ************************* SetCenterOfRotation ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+void
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::SetCenterOfRotation( const std::vector<double> & center )
+{
+  this->m_CenterOfRotation = center;
+  this->Modified();
+
+} // end SetCenterOfRotation()
+
+
+/**
+ * ************************* GetProfileIndex ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+int
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::GetProfileIndex( LabelType value ) const
+{
+  if( this->m_Labels.empty() )
+  {
+    return value != NumericTraits<LabelType>::Zero ? 0 : -1;
+  }
+  typename std::map<LabelType, int>::const_iterator found
+    = this->m_LabelToProfile.find( value );
+  return found != this->m_LabelToProfile.end() ? found->second : -1;
+
+} // end GetProfileIndex()
+
+
+/**
+ * ************************* RadicalInverse ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+double
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::RadicalInverse( unsigned int i, unsigned int base )
+{
+  const double invBase = 1.0 / static_cast<double>( base );
+  double factor = invBase;
+  double result = 0.0;
+  while( i > 0 )
+  {
+    result += factor * static_cast<double>( i % base );
+    i /= base;
+    factor *= invBase;
+  }
+  return result;
+
+} // end RadicalInverse()
+
+
+/**
+ * ************************* Compute ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+void
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::Compute( void )
+{
+  /** Checks. */
+  if( this->m_Input1.IsNull() || this->m_Input2.IsNull() )
+  {
+    itkExceptionMacro( << "Both inputs should be set." );
+  }
+  if( ImageDimension != 3 )
+  {
+    itkExceptionMacro( << "Only 3D images are supported." );
+  }
+  const RegionType largest = this->m_Input1->GetLargestPossibleRegion();
+  if( this->m_Input2->GetLargestPossibleRegion() != largest )
+  {
+    itkExceptionMacro( << "The inputs should have the same size." );
+  }
+  if( this->m_ThetaSize < 2 || this->m_PhiSize < 2 )
+  {
+    itkExceptionMacro( << "The theta and phi sizes should be at least 2." );
+  }
+
+  const unsigned int numberOfProfiles = this->m_Labels.empty()
+    ? 1 : static_cast<unsigned int>( this->m_Labels.size() );
+  const unsigned int thetaSize = this->m_ThetaSize;
+  const unsigned int phiSize = this->m_PhiSize;
+  const double thetaSpacing = 2.0 * vnl_math::pi / thetaSize;
+  const double phiSpacing = vnl_math::pi / ( phiSize - 1 );
+
+  /** One pass over both inputs for the bounding boxes and centers of mass. */
+  std::vector<LabelStatistics> statistics( numberOfProfiles );
+  for( unsigned int p = 0; p < numberOfProfiles; ++p )
+  {
+    statistics[ p ].Lower.Fill( NumericTraits<IndexValueType>::max() );
+    statistics[ p ].Upper.Fill( NumericTraits<IndexValueType>::NonpositiveMin() );
+    std::fill( statistics[ p ].IndexSum, statistics[ p ].IndexSum + ImageDimension, 0.0 );
+    statistics[ p ].Count1 = 0;
+    statistics[ p ].Count2 = 0;
+  }
+
+  ImageRegionConstIteratorWithIndex<LabelImageType> it1( this->m_Input1, largest );
+  ImageRegionConstIterator<LabelImageType> it2( this->m_Input2, largest );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+  {
+    const int p1 = this->GetProfileIndex( it1.Value() );
+    const int p2 = this->GetProfileIndex( it2.Value() );
+    if( p1 < 0 && p2 < 0 ) continue;
+
+    const IndexType & index = it1.GetIndex();
+    if( p1 >= 0 )
+    {
+      LabelStatistics & s = statistics[ p1 ];
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        s.Lower[ d ] = std::min( s.Lower[ d ], index[ d ] );
+        s.Upper[ d ] = std::max( s.Upper[ d ], index[ d ] );
+        s.IndexSum[ d ] += static_cast<double>( index[ d ] );
+      }
+      ++s.Count1;
+    }
+    if( p2 >= 0 )
+    {
+      LabelStatistics & s = statistics[ p2 ];
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        s.Lower[ d ] = std::min( s.Lower[ d ], index[ d ] );
+        s.Upper[ d ] = std::max( s.Upper[ d ], index[ d ] );
+      }
+      ++s.Count2;
+    }
+  }
+
+  /** The sample offsets: the voxel center, followed by a Halton sequence. */
+  const unsigned int primes[ 3 ] = { 2, 3, 5 };
+  const unsigned int maximumNumberOfSamples
+    = std::max( this->m_MaximumNumberOfSamplesPerVoxel, 1u );
+  this->m_SampleOffsets.resize( maximumNumberOfSamples );
+  for( unsigned int s = 0; s < maximumNumberOfSamples; ++s )
+  {
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_SampleOffsets[ s ][ d ] = s == 0
+        ? 0.0 : RadicalInverse( s, primes[ d % 3 ] ) - 0.5;
+    }
+  }
+
+  /** The ratio of the volume of a (r, theta, phi) cell and a voxel, divided
+   * by r^2 sin(phi), as in CartesianToSphericalCoordinateImageFilter.
+   */
+  const typename LabelImageType::SpacingType spacing = this->m_Input1->GetSpacing();
+  double minSpacing = NumericTraits<double>::max();
+  double maxSpacing = 0.0;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    minSpacing = std::min( minSpacing, static_cast<double>( spacing[ d ] ) );
+    maxSpacing = std::max( maxSpacing, static_cast<double>( spacing[ d ] ) );
+  }
+  const double dVrtp = std::min( minSpacing, std::min( thetaSpacing, phiSpacing ) );
+  this->m_DeltaVolumeRatioFactor
+    = ( dVrtp / maxSpacing ) * ( dVrtp / maxSpacing ) * ( dVrtp / maxSpacing );
+
+  /** Compute the profiles one label at a time. */
+  this->m_Profiles.clear();
+  this->m_UsedCentersOfRotation.clear();
+  const unsigned int phiDimension = OutputImageType::ImageDimension - 1;
+  for( unsigned int p = 0; p < numberOfProfiles; ++p )
+  {
+    const LabelStatistics & s = statistics[ p ];
+
+    /** The output (theta, phi) image. */
+    typename OutputImageType::SizeType size;
+    typename OutputImageType::SpacingType outputSpacing;
+    size.Fill( 1 );
+    size[ 0 ] = thetaSize;
+    size[ phiDimension ] = phiSize;
+    outputSpacing.Fill( 1.0 );
+    outputSpacing[ 0 ] = thetaSpacing;
+    outputSpacing[ phiDimension ] = phiSpacing;
+    OutputImagePointer profile = OutputImageType::New();
+    profile->SetRegions( size );
+    profile->SetSpacing( outputSpacing );
+    profile->Allocate();
+    profile->FillBuffer( NumericTraits<OutputPixelType>::Zero );
+    this->m_Profiles.push_back( profile );
+
+    /** The center of rotation. */
+    PointType center;
+    center.Fill( 0.0 );
+    if( this->m_CenterOfRotation.size() == ImageDimension )
+    {
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        center[ d ] = this->m_CenterOfRotation[ d ];
+      }
+    }
+    else if( s.Count1 > 0 )
+    {
+      ContinuousIndexType centerIndex;
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        centerIndex[ d ] = s.IndexSum[ d ] / static_cast<double>( s.Count1 );
+      }
+      this->m_Input1->TransformContinuousIndexToPhysicalPoint( centerIndex, center );
+    }
+    this->m_UsedCentersOfRotation.push_back( center );
+
+    if( s.Count1 == 0 || s.Count2 == 0 )
+    {
+      itkWarningMacro( << "Profile " << p << " is empty in one of the inputs; "
+        << "its distance profile is set to zero." );
+      continue;
+    }
+
+    /** The bounding box, padded for the outer edge and the samples around it. */
+    RegionType box;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      box.SetIndex( d, s.Lower[ d ] - 2 );
+      box.SetSize( d, static_cast<SizeValueType>( s.Upper[ d ] - s.Lower[ d ] + 5 ) );
+    }
+
+    /** The signed distance maps of the label in Input1 and of its complement. */
+    typename BinaryImageType::Pointer binary1
+      = this->ExtractBinary( this->m_Input1, box, p, false );
+    this->m_CurrentDistance = this->ComputeDistance( binary1 );
+    binary1 = this->ExtractBinary( this->m_Input1, box, p, true );
+    this->m_CurrentComplementDistance = this->ComputeDistance( binary1 );
+    binary1 = 0;
+
+    /** The fused pass: edges of Input2, distances and angular binning. */
+    this->m_CurrentBinary2 = this->ExtractBinary( this->m_Input2, box, p, false );
+    this->m_CurrentEdgeRegion = box;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      this->m_CurrentEdgeRegion.SetIndex( d, box.GetIndex()[ d ] + 1 );
+      this->m_CurrentEdgeRegion.SetSize( d, box.GetSize()[ d ] - 2 );
+    }
+    this->m_CurrentCenter = center;
+    this->m_ThreadSums.assign( this->m_NumberOfThreads,
+      std::vector<double>( thetaSize * phiSize, 0.0 ) );
+    this->m_ThreadWeights.assign( this->m_NumberOfThreads,
+      std::vector<double>( thetaSize * phiSize, 0.0 ) );
+
+    MultiThreader::Pointer threader = MultiThreader::New();
+    threader->SetNumberOfThreads( this->m_NumberOfThreads );
+    threader->SetSingleMethod( this->AccumulateThreaderCallback, this );
+    threader->SingleMethodExecute();
+
+    /** Merge the threads and average. */
+    OutputPixelType * out = profile->GetBufferPointer();
+    for( unsigned int i = 0; i < thetaSize * phiSize; ++i )
+    {
+      double sum = 0.0;
+      double weight = 0.0;
+      for( unsigned int t = 0; t < this->m_ThreadSums.size(); ++t )
+      {
+        sum += this->m_ThreadSums[ t ][ i ];
+        weight += this->m_ThreadWeights[ t ][ i ];
+      }
+      if( weight > 1e-10 )
+      {
+        out[ i ] = static_cast<OutputPixelType>( sum / weight );
+      }
+    }
+
+    this->m_CurrentDistance = 0;
+    this->m_CurrentComplementDistance = 0;
+    this->m_CurrentBinary2 = 0;
+  }
+
+  this->m_ThreadSums.clear();
+  this->m_ThreadWeights.clear();
+
+} // end Compute()
+
+
+/**
+ * ************************* ExtractBinary ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+typename MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >::BinaryImageType::Pointer
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::ExtractBinary( const LabelImageType * image, const RegionType & region,
+  unsigned int profile, bool complement ) const
+{
+  typename BinaryImageType::Pointer binary = BinaryImageType::New();
+  binary->SetRegions( region );
+  binary->SetSpacing( image->GetSpacing() );
+  binary->SetOrigin( image->GetOrigin() );
+  binary->SetDirection( image->GetDirection() );
+  binary->Allocate();
+
+  /** Outside the image is background, as if the image was padded with zeros. */
+  binary->FillBuffer( complement ? 1 : 0 );
+
+  RegionType inside = region;
+  if( inside.Crop( image->GetLargestPossibleRegion() ) )
+  {
+    ImageRegionConstIterator<LabelImageType> it( image, inside );
+    ImageRegionIterator<BinaryImageType> bit( binary, inside );
+    for( ; !it.IsAtEnd(); ++it, ++bit )
+    {
+      const bool member = this->GetProfileIndex( it.Value() ) == static_cast<int>( profile );
+      bit.Set( member != complement ? 1 : 0 );
+    }
+  }
+
+  return binary;
+
+} // end ExtractBinary()
+
+
+/**
+ * ************************* ComputeDistance ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+typename MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >::DistanceImageType::Pointer
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::ComputeDistance( const BinaryImageType * binary ) const
+{
+  typedef SignedMaurerDistanceMapImageFilter<
+    BinaryImageType, DistanceImageType >            DistanceMapFilterType;
+
+  typename DistanceMapFilterType::Pointer distanceMapFilter = DistanceMapFilterType::New();
+  distanceMapFilter->SetInput( binary );
+  distanceMapFilter->SetUseImageSpacing( true );
+  distanceMapFilter->SetSquaredDistance( false );
+  distanceMapFilter->SetNumberOfThreads( this->m_NumberOfThreads );
+  distanceMapFilter->Update();
+
+  typename DistanceImageType::Pointer distance = distanceMapFilter->GetOutput();
+  distance->DisconnectPipeline();
+  return distance;
+
+} // end ComputeDistance()
+
+
+/**
+ * ************************* InterpolateDistance ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+double
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::InterpolateDistance( const DistanceImageType * distance,
+  const ContinuousIndexType & cindex )
+{
+  const RegionType & region = distance->GetBufferedRegion();
+  const OffsetValueType * offsetTable = distance->GetOffsetTable();
+  OffsetValueType lower[ ImageDimension ];
+  OffsetValueType upper[ ImageDimension ];
+  double fraction[ ImageDimension ];
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+  {
+    const double first = static_cast<double>( region.GetIndex()[ d ] );
+    const double last = first + static_cast<double>( region.GetSize()[ d ] ) - 1.0;
+    const double c = std::min( std::max( cindex[ d ], first ), last );
+    const double base = std::floor( c );
+    fraction[ d ] = c - base;
+    lower[ d ] = static_cast<OffsetValueType>( base - first );
+    upper[ d ] = std::min( lower[ d ] + 1,
+      static_cast<OffsetValueType>( region.GetSize()[ d ] ) - 1 );
+    lower[ d ] *= offsetTable[ d ];
+    upper[ d ] *= offsetTable[ d ];
+  }
+
+  const float * buffer = distance->GetBufferPointer();
+  double value = 0.0;
+  for( unsigned int corner = 0; corner < ( 1u << ImageDimension ); ++corner )
+  {
+    double weight = 1.0;
+    OffsetValueType offset = 0;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      if( corner & ( 1u << d ) )
+      {
+        weight *= fraction[ d ];
+        offset += upper[ d ];
+      }
+      else
+      {
+        weight *= 1.0 - fraction[ d ];
+        offset += lower[ d ];
+      }
+    }
+    value += weight * buffer[ offset ];
+  }
+  return value;
+
+} // end InterpolateDistance()
+
+
+/**
+ * ************************* AccumulateThreaderCallback ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::AccumulateThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  Self * self = static_cast<Self *>( info->UserData );
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const RegionType & region = self->m_CurrentEdgeRegion;
+  const unsigned int total = splitter->GetNumberOfSplits( region, threadCount );
+  if( threadId < total )
+  {
+    self->ThreadedAccumulate( splitter->GetSplit( threadId, total, region ), threadId );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end AccumulateThreaderCallback()
+
+
+/**
+ * ************************* ThreadedAccumulate ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+void
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::ThreadedAccumulate( const RegionType & region, ThreadIdType threadId )
+{
+  const BinaryImageType * binary = this->m_CurrentBinary2;
+  const OffsetValueType * offsetTable = binary->GetOffsetTable();
+  double * sums = &this->m_ThreadSums[ threadId ][ 0 ];
+  double * weights = &this->m_ThreadWeights[ threadId ][ 0 ];
+
+  const unsigned int thetaSize = this->m_ThetaSize;
+  const unsigned int phiSize = this->m_PhiSize;
+  const double twoPi = 2.0 * vnl_math::pi;
+  const double invThetaSpacing = thetaSize / twoPi;
+  const double invPhiSpacing = ( phiSize - 1 ) / vnl_math::pi;
+  const unsigned int maximumNumberOfSamples
+    = static_cast<unsigned int>( this->m_SampleOffsets.size() );
+  const double invMaximumNumberOfSamples = 1.0 / maximumNumberOfSamples;
+  const PointType & center = this->m_CurrentCenter;
+
+  ImageRegionConstIteratorWithIndex<BinaryImageType> it( binary, region );
+  PointType point;
+  ContinuousIndexType cindex;
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    /** An edge voxel has a face neighbour with the other value. */
+    const unsigned char * pixel = &it.Value();
+    const unsigned char inside = *pixel;
+    bool edge = false;
+    for( unsigned int d = 0; d < ImageDimension && !edge; ++d )
+    {
+      edge = pixel[ offsetTable[ d ] ] != inside || pixel[ -offsetTable[ d ] ] != inside;
+    }
+    if( !edge ) continue;
+
+    /** Inner edges see the label, outer edges the complement. */
+    const DistanceImageType * distance = inside
+      ? this->m_CurrentDistance.GetPointer()
+      : this->m_CurrentComplementDistance.GetPointer();
+    const double sign = inside ? 1.0 : -1.0;
+
+    /** Fewer samples where a voxel covers more than a direction bin. */
+    const IndexType & index = it.GetIndex();
+    binary->TransformIndexToPhysicalPoint( index, point );
+    const typename PointType::VectorType centered = point - center;
+    const double r2 = centered.GetSquaredNorm();
+    const double z = centered[ ImageDimension - 1 ];
+    const double sinphi = r2 > 0.0 ? std::sqrt( std::max( 1.0 - z * z / r2, 0.0 ) ) : 0.0;
+    const double deltaVolumeRatio = this->m_DeltaVolumeRatioFactor * r2 * sinphi;
+    unsigned int numberOfSamples = maximumNumberOfSamples;
+    if( deltaVolumeRatio > invMaximumNumberOfSamples )
+    {
+      numberOfSamples = static_cast<unsigned int>( std::ceil( 1.0 / deltaVolumeRatio ) );
+    }
+
+    for( unsigned int s = 0; s < numberOfSamples; ++s )
+    {
+      for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+        cindex[ d ] = index[ d ] + this->m_SampleOffsets[ s ][ d ];
+      }
+      binary->TransformContinuousIndexToPhysicalPoint( cindex, point );
+      const typename PointType::VectorType vec = point - center;
+      const double r = vec.GetNorm();
+      if( r <= 0.0 ) continue;
+      const double value = sign * InterpolateDistance( distance, cindex );
+
+      /** The two nearest theta bins wrap around, the phi bins do not. */
+      double theta = std::atan2( vec[ 1 ], vec[ 0 ] );
+      if( theta < 0.0 ) theta += twoPi;
+      const double phi = std::acos( std::min( std::max( vec[ ImageDimension - 1 ] / r, -1.0 ), 1.0 ) );
+      const double thetaIndex = theta * invThetaSpacing;
+      const double phiIndex = phi * invPhiSpacing;
+      const unsigned int theta0 = static_cast<unsigned int>( thetaIndex );
+      const unsigned int phi0 = static_cast<unsigned int>( phiIndex );
+      const double thetaWeight = thetaIndex - theta0;
+      const double phiWeight = phiIndex - phi0;
+      const unsigned int thetaBins[ 2 ] = { theta0 % thetaSize, ( theta0 + 1 ) % thetaSize };
+      const double thetaWeights[ 2 ] = { 1.0 - thetaWeight, thetaWeight };
+      const double phiWeights[ 2 ] = { 1.0 - phiWeight, phiWeight };
+      for( unsigned int j = 0; j < 2; ++j )
+      {
+        const unsigned int phiBin = phi0 + j;
+        if( phiBin >= phiSize ) continue;
+        for( unsigned int i = 0; i < 2; ++i )
+        {
+          const unsigned int bin = phiBin * thetaSize + thetaBins[ i ];
+          const double weight = phiWeights[ j ] * thetaWeights[ i ];
+          sums[ bin ] += weight * value;
+          weights[ bin ] += weight;
+        }
+      }
+    }
+  }
+
+} // end ThreadedAccumulate()
+
+
+/**
+ * ************************* PrintSelf ************************
+ */
+
+template< class TLabelImage, class TOutputImage >
+void
+MultiLabelSphericalDistanceCalculator< TLabelImage, TOutputImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfLabels: " << this->m_Labels.size() << std::endl;
+  os << indent << "ThetaSize: " << this->m_ThetaSize << std::endl;
+  os << indent << "PhiSize: " << this->m_PhiSize << std::endl;
+  os << indent << "MaximumNumberOfSamplesPerVoxel: "
+    << this->m_MaximumNumberOfSamplesPerVoxel << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace itk
+
+#endif // end #ifndef __itkMultiLabelSphericalDistanceCalculator_txx_
@@ -49,6 +49,13 @@ std::string GetHelpString( void )
     << "  [-p]     phi size; the size of the phi dimension. default: 90, which yields a spacing of 2 degrees.\n"
     << "  [-car]   skip the polar transform and return two output images (outputFileNameDIST and outputFileNameEDGE): true or false; default = false\n"
     << "           The EDGE output image is an edge mask for inputfile2. The DIST output image contains the distance at each edge pixel to the first inputFile.\n"
+    << "  [-fused] use the fused engine: edge extraction, distances and spherical binning\n"
+    << "           in one threaded pass, without full sized intermediate images.\n"
+    << "           Samples on different radii in a direction are averaged together.\n"
+    << "  [-labels] labels for which a profile is computed in one run, implies -fused.\n"
+    << "           Each label gets its own output <out>L<label>.mhd, and its own center\n"
+    << "           of rotation, the center of mass of the label in inputFilename1, unless -c is given.\n"
+    << "  [-threads] maximum number of threads, default all\n"
     << "Supported: 3D short for inputImage1, and everything convertable to short.\n"
     << "           3D short for inputImage2, and everything convertable to short.";
 
@@ -130,6 +137,20 @@ int main( int argc, char **argv )
     cartesianonly = true;
   }
 
+  bool useFusedEngine = parser->ArgumentExists( "-fused" );
+
+  std::vector<short> labels;
+  parser->GetCommandLineArgument( "-labels", labels );
+  if( !labels.empty() && cartesianonly )
+  {
+    std::cerr << "ERROR: -labels can not be combined with -car." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
   /** Determine image properties. */
   itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
@@ -173,6 +194,8 @@ int main( int argc, char **argv )
     filter->m_Thetasize = thetasize;
     filter->m_Phisize = phisize;
     filter->m_Cartesianonly = cartesianonly;
+    filter->m_UseFusedEngine = useFusedEngine;
+    filter->m_Labels = labels;
 
     filter->Run();
 
@@ -39,6 +39,8 @@
 #include "itkExtractImageFilter.h"
 #include "itkImageFileWriter.h"
 #include "itkLinearInterpolateImageFunction.h"
+#include "itkMultiLabelSphericalDistanceCalculator.h"
+#include <itksys/SystemTools.hxx>
 
 template< class InputImageType1, class InputImageType2, class ImageType >
 void SegmentationDistanceHelper(
@@ -74,6 +76,7 @@ public:
     this->m_Thetasize = 0;
     this->m_Phisize = 0;
     this->m_Cartesianonly = false;
+    this->m_UseFusedEngine = false;
   };
   /** Destructor. */
   ~ITKToolsSegmentationDistanceBase(){};
@@ -87,6 +90,8 @@ public:
   unsigned int m_Thetasize;
   unsigned int m_Phisize;
   bool m_Cartesianonly;
+  bool m_UseFusedEngine;
+  std::vector<short> m_Labels;
 
 }; // end class ITKToolsSegmentationDistanceBase
 
@@ -111,6 +116,13 @@ public:
   /** Run function. */
   void Run( void )
   {
+    /** The fused engine does not produce the cartesian images. */
+    if( !this->m_Cartesianonly && ( this->m_UseFusedEngine || !this->m_Labels.empty() ) )
+    {
+      this->RunFused();
+      return;
+    }
+
     /** constants */
     const unsigned int OutputDimension = VDimension-1;
     typedef itk::Image<TComponentType, VDimension>      ImageType;
@@ -340,6 +352,73 @@ public:
 
   } // end Run()
 
+  /*
+   * ******************* RunFused ****************
+   *
+   * Computes the spherical profiles of all labels with the fused engine.
+   */
+
+  void RunFused( void )
+  {
+    /** Typedef's. */
+    typedef itk::Image<short, VDimension>               LabelImageType;
+    typedef itk::Image<TComponentType, VDimension-1>    OutputImageType;
+    typedef itk::ImageFileReader<LabelImageType>        ReaderType;
+    typedef itk::ImageFileWriter<OutputImageType>       WriterType;
+    typedef itk::MultiLabelSphericalDistanceCalculator<
+      LabelImageType, OutputImageType >                 CalculatorType;
+
+    /** Read in the inputImages. */
+    typename ReaderType::Pointer reader1 = ReaderType::New();
+    typename ReaderType::Pointer reader2 = ReaderType::New();
+    reader1->SetFileName( this->m_InputFileName1.c_str() );
+    reader2->SetFileName( this->m_InputFileName2.c_str() );
+    reader1->Update();
+    reader2->Update();
+
+    /** Compute the profiles. */
+    typename CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetInput1( reader1->GetOutput() );
+    calculator->SetInput2( reader2->GetOutput() );
+    calculator->SetLabels( this->m_Labels );
+    calculator->SetCenterOfRotation( this->m_Mancor );
+    calculator->SetThetaSize( this->m_Thetasize );
+    calculator->SetPhiSize( this->m_Phisize );
+    calculator->SetMaximumNumberOfSamplesPerVoxel( this->m_Samples );
+    std::cout << "Computing the spherical distance profiles..." << std::endl;
+    calculator->Compute();
+    std::cout << "Profiles computed." << std::endl;
+
+    /** Write the output images; one per label if labels are given. */
+    const unsigned int numberOfProfiles = calculator->GetNumberOfProfiles();
+    const typename CalculatorType::LabelContainerType & labels = calculator->GetLabels();
+    std::string path = itksys::SystemTools::GetFilenamePath( this->m_OutputFileName );
+    if( !path.empty() ) path += "/";
+    const std::string part1 = path
+      + itksys::SystemTools::GetFilenameWithoutLastExtension( this->m_OutputFileName );
+    const std::string part2
+      = itksys::SystemTools::GetFilenameLastExtension( this->m_OutputFileName );
+    for( unsigned int i = 0; i < numberOfProfiles; ++i )
+    {
+      std::string outputFileName = this->m_OutputFileName;
+      std::ostringstream label;
+      if( !labels.empty() )
+      {
+        label << labels[ i ];
+        outputFileName = part1 + "L" + label.str() + part2;
+      }
+      std::cout << "Center of rotation"
+        << ( !labels.empty() ? " of label " + label.str() : std::string( "" ) )
+        << ": " << calculator->GetUsedCenterOfRotation( i ) << std::endl;
+
+      typename WriterType::Pointer writer = WriterType::New();
+      writer->SetInput( calculator->GetProfile( i ) );
+      writer->SetFileName( outputFileName.c_str() );
+      writer->Update();
+    }
+
+  } // end RunFused()
+
   /*
    * ******************* SegmentationDistanceHelper ****************
    *
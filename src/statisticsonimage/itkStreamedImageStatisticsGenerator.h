@@ -0,0 +1,208 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkStreamedImageStatisticsGenerator_h_
+#define __itkStreamedImageStatisticsGenerator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkHistogram.h"
+#include <vector>
+
+
+namespace itk {
+namespace Statistics {
+
+/** \class StreamedImageStatisticsGenerator
+ * \brief Computes arithmetic, geometric and histogram statistics of
+ * an image in a single streamed pass.
+ *
+ * The input (and optionally the mask) is requested piece by piece from
+ * the upstream pipeline, typically an ImageFileReader, so that only one
+ * piece of the image is in memory at a time. For each piece the minimum,
+ * maximum, sum, absolute sum and sum of squares are accumulated, as well
+ * as the sum and sum of squares of the logarithm of the pixel values if
+ * geometric statistics are requested. No masked copy of the image is made:
+ * pixels outside the mask are simply skipped.
+ *
+ * Since the intensity range of the image is only known after the pass,
+ * the histogram is accumulated in a fine internal histogram that adapts
+ * its range. It is initialized with the minimum and maximum of all pixels
+ * seen so far, as soon as these differ; until then the pixels, which all
+ * have the same value, are only counted. Whenever a piece falls outside
+ * the current range, the bin width is doubled by merging pairs of
+ * neighbouring bins. Afterwards
+ * GenerateHistogram() redistributes the internal bins over the requested
+ * output bins. The counts are exact up to the internal bin width, which
+ * is at most 2 * (max - min) / NumberOfInternalBins.
+ *
+ * If the upstream ImageIO can not stream, the reader will produce the
+ * whole image at the first piece and the remaining pieces are served
+ * from that buffer.
+ */
+
+template< class TImage, class TMaskImage >
+class StreamedImageStatisticsGenerator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef StreamedImageStatisticsGenerator  Self;
+  typedef Object                            Superclass;
+  typedef SmartPointer<Self>                Pointer;
+  typedef SmartPointer<const Self>          ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( StreamedImageStatisticsGenerator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Image typedefs. */
+  typedef TImage                                    ImageType;
+  typedef typename ImageType::Pointer               ImagePointer;
+  typedef typename ImageType::PixelType             PixelType;
+  typedef typename ImageType::RegionType            RegionType;
+  typedef TMaskImage                                MaskImageType;
+  typedef typename MaskImageType::Pointer           MaskImagePointer;
+  typedef typename NumericTraits<PixelType>::RealType RealType;
+
+  /** Histogram typedefs, the same as in ScalarImageToHistogramGenerator2. */
+  typedef itk::Statistics::Histogram< double >      HistogramType;
+  typedef typename HistogramType::Pointer           HistogramPointer;
+  typedef typename HistogramType::AbsoluteFrequencyType FrequencyType;
+  typedef std::vector<FrequencyType>                FrequencyContainerType;
+
+  /** Connect the input image. It is not const, since requested regions
+   * are set on it to drive the upstream pipeline.
+   */
+  void SetInput( ImageType * image );
+
+  /** Connect an optional mask. Only pixels for which the mask is nonzero
+   * are taken into account.
+   */
+  void SetMask( MaskImageType * mask );
+
+  /** Set the number of pieces in which the image is processed. */
+  itkSetMacro( NumberOfStreamDivisions, unsigned int );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
+  /** Set the number of bins of the internal histogram. Rounded up to an even number. */
+  itkSetMacro( NumberOfInternalBins, unsigned int );
+  itkGetConstMacro( NumberOfInternalBins, unsigned int );
+
+  /** Select whether the statistics on the log of the image are accumulated. */
+  itkSetMacro( ComputeGeometricStatistics, bool );
+  itkGetConstMacro( ComputeGeometricStatistics, bool );
+
+  /** Select whether the internal histogram is accumulated. */
+  itkSetMacro( ComputeHistogram, bool );
+  itkGetConstMacro( ComputeHistogram, bool );
+
+  /** Triggers the computation; this is the only pass over the image. */
+  void Compute( void );
+
+  /** Arithmetic statistics. Valid after Compute(). */
+  itkGetConstMacro( Minimum, RealType );
+  itkGetConstMacro( Maximum, RealType );
+  itkGetConstMacro( Mean, RealType );
+  itkGetConstMacro( Sigma, RealType );
+  itkGetConstMacro( Variance, RealType );
+  itkGetConstMacro( Sum, RealType );
+  itkGetConstMacro( AbsoluteMean, RealType );
+  itkGetConstMacro( Count, SizeValueType );
+
+  /** Mean and sigma of the log of the image. Valid after Compute(). */
+  itkGetConstMacro( LogMean, RealType );
+  itkGetConstMacro( LogSigma, RealType );
+
+  /** Redistribute the internal histogram over numberOfBins equally
+   * sized bins in [histogramMin, histogramMax). Valid after Compute().
+   */
+  const HistogramType * GenerateHistogram( unsigned int numberOfBins,
+    RealType histogramMin, RealType histogramMax );
+
+protected:
+  StreamedImageStatisticsGenerator();
+  virtual ~StreamedImageStatisticsGenerator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Accumulate the statistics of one piece of the image. */
+  void AccumulatePiece( const RegionType & piece );
+
+  /** Start the internal histogram with the range [lower, upper]. */
+  void InitializeInternalHistogram( RealType lower, RealType upper );
+
+  /** Merge bins of the internal histogram until it covers [lower, upper]. */
+  void ExpandInternalHistogram( RealType lower, RealType upper );
+
+private:
+  StreamedImageStatisticsGenerator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  ImagePointer      m_Input;
+  MaskImagePointer  m_Mask;
+
+  unsigned int      m_NumberOfStreamDivisions;
+  unsigned int      m_NumberOfInternalBins;
+  bool              m_ComputeGeometricStatistics;
+  bool              m_ComputeHistogram;
+
+  /** Accumulators. */
+  RealType          m_Minimum;
+  RealType          m_Maximum;
+  RealType          m_Sum;
+  RealType          m_AbsoluteSum;
+  RealType          m_SumOfSquares;
+  RealType          m_LogSum;
+  RealType          m_LogSumOfSquares;
+  SizeValueType     m_Count;
+
+  /** Results. */
+  RealType          m_Mean;
+  RealType          m_Sigma;
+  RealType          m_Variance;
+  RealType          m_AbsoluteMean;
+  RealType          m_LogMean;
+  RealType          m_LogSigma;
+
+  /** The adaptive internal histogram: bin i covers
+   * [origin + i * width, origin + (i+1) * width). A width of zero means
+   * that the histogram has not been initialized yet; the pixels seen until
+   * then all have the value m_PendingValue, and are counted in
+   * m_PendingFrequency. The finite range of the data is stored separately.
+   */
+  FrequencyContainerType  m_InternalFrequencies;
+  RealType                m_InternalOrigin;
+  RealType                m_InternalBinWidth;
+  RealType                m_PendingValue;
+  FrequencyType           m_PendingFrequency;
+  RealType                m_FiniteMinimum;
+  RealType                m_FiniteMaximum;
+
+  HistogramPointer        m_Histogram;
+
+}; // end class StreamedImageStatisticsGenerator
+
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkStreamedImageStatisticsGenerator.txx"
+#endif
+
+#endif // end #ifndef __itkStreamedImageStatisticsGenerator_h_
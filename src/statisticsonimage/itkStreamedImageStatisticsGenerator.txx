@@ -0,0 +1,466 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkStreamedImageStatisticsGenerator_txx_
+#define __itkStreamedImageStatisticsGenerator_txx_
+
+#include "itkStreamedImageStatisticsGenerator.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionSplitter.h"
+#include "vnl/vnl_math.h"
+#include <algorithm>
+
+
+namespace itk {
+namespace Statistics {
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template< class TImage, class TMaskImage >
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::StreamedImageStatisticsGenerator()
+{
+  this->m_NumberOfStreamDivisions = 16;
+  this->m_NumberOfInternalBins = 65536;
+  this->m_ComputeGeometricStatistics = true;
+  this->m_ComputeHistogram = true;
+
+  this->m_Minimum = NumericTraits<RealType>::max();
+  this->m_Maximum = NumericTraits<RealType>::NonpositiveMin();
+  this->m_Sum = this->m_AbsoluteSum = this->m_SumOfSquares = NumericTraits<RealType>::Zero;
+  this->m_LogSum = this->m_LogSumOfSquares = NumericTraits<RealType>::Zero;
+  this->m_Count = 0;
+
+  this->m_Mean = this->m_Sigma = this->m_Variance = NumericTraits<RealType>::Zero;
+  this->m_AbsoluteMean = NumericTraits<RealType>::Zero;
+  this->m_LogMean = this->m_LogSigma = NumericTraits<RealType>::Zero;
+
+  this->m_InternalOrigin = NumericTraits<RealType>::Zero;
+  this->m_InternalBinWidth = NumericTraits<RealType>::Zero;
+  this->m_PendingValue = NumericTraits<RealType>::Zero;
+  this->m_PendingFrequency = 0;
+  this->m_FiniteMinimum = NumericTraits<RealType>::max();
+  this->m_FiniteMaximum = NumericTraits<RealType>::NonpositiveMin();
+
+} // end Constructor
+
+
+/**
+ * ******************* SetInput *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::SetInput( ImageType * image )
+{
+  if( this->m_Input != image )
+  {
+    this->m_Input = image;
+    this->Modified();
+  }
+} // end SetInput()
+
+
+/**
+ * ******************* SetMask *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::SetMask( MaskImageType * mask )
+{
+  if( this->m_Mask != mask )
+  {
+    this->m_Mask = mask;
+    this->Modified();
+  }
+} // end SetMask()
+
+
+/**
+ * ******************* Compute *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::Compute( void )
+{
+  if( this->m_Input.IsNull() )
+  {
+    itkExceptionMacro( << "ERROR: no input image set." );
+  }
+
+  /** Reset the accumulators. */
+  this->m_Minimum = NumericTraits<RealType>::max();
+  this->m_Maximum = NumericTraits<RealType>::NonpositiveMin();
+  this->m_Sum = this->m_AbsoluteSum = this->m_SumOfSquares = NumericTraits<RealType>::Zero;
+  this->m_LogSum = this->m_LogSumOfSquares = NumericTraits<RealType>::Zero;
+  this->m_Count = 0;
+  this->m_FiniteMinimum = NumericTraits<RealType>::max();
+  this->m_FiniteMaximum = NumericTraits<RealType>::NonpositiveMin();
+  this->m_InternalOrigin = NumericTraits<RealType>::Zero;
+  this->m_InternalBinWidth = NumericTraits<RealType>::Zero;
+  this->m_PendingValue = NumericTraits<RealType>::Zero;
+  this->m_PendingFrequency = 0;
+
+  /** Merging pairs of bins requires an even number of bins. */
+  unsigned int numberOfInternalBins = vnl_math_max( 2u, this->m_NumberOfInternalBins );
+  numberOfInternalBins += numberOfInternalBins % 2;
+  this->m_InternalFrequencies.assign( numberOfInternalBins, 0 );
+
+  /** Only the meta data is read here. */
+  this->m_Input->UpdateOutputInformation();
+  const RegionType largestRegion = this->m_Input->GetLargestPossibleRegion();
+  if( this->m_Mask.IsNotNull() )
+  {
+    this->m_Mask->UpdateOutputInformation();
+    if( this->m_Mask->GetLargestPossibleRegion() != largestRegion )
+    {
+      itkExceptionMacro( << "ERROR: the mask does not have the same size as the input image." );
+    }
+  }
+
+  /** Split the image in pieces along the slowest varying dimension. */
+  typedef ImageRegionSplitter< ImageType::ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(
+    largestRegion, vnl_math_max( 1u, this->m_NumberOfStreamDivisions ) );
+
+  /** The single pass over the image. */
+  for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+  {
+    const RegionType pieceRegion = splitter->GetSplit( piece, numberOfPieces, largestRegion );
+
+    this->m_Input->SetRequestedRegion( pieceRegion );
+    this->m_Input->Update();
+    if( this->m_Mask.IsNotNull() )
+    {
+      this->m_Mask->SetRequestedRegion( pieceRegion );
+      this->m_Mask->Update();
+    }
+
+    this->AccumulatePiece( pieceRegion );
+  }
+
+  /** A constant image: start the histogram around the value. */
+  if( this->m_PendingFrequency > 0 )
+  {
+    this->InitializeInternalHistogram( this->m_FiniteMinimum, this->m_FiniteMaximum );
+  }
+
+  /** Compute the statistics, as in StatisticsImageFilter. */
+  const RealType count = static_cast<RealType>( this->m_Count );
+  this->m_Mean = this->m_Sum / count;
+  this->m_AbsoluteMean = this->m_AbsoluteSum / count;
+
+  // unbiased estimate
+  this->m_Variance = ( this->m_SumOfSquares - ( this->m_Sum * this->m_Sum / count ) )
+    / ( count - 1.0 );
+  // in case of numerical errors the variance might be <0.
+  this->m_Variance = vnl_math_max( 0.0, this->m_Variance );
+  this->m_Sigma = vcl_sqrt( this->m_Variance );
+
+  if( this->m_ComputeGeometricStatistics )
+  {
+    this->m_LogMean = this->m_LogSum / count;
+    RealType logVariance = ( this->m_LogSumOfSquares
+      - ( this->m_LogSum * this->m_LogSum / count ) ) / ( count - 1.0 );
+    logVariance = vnl_math_max( 0.0, logVariance );
+    this->m_LogSigma = vcl_sqrt( logVariance );
+  }
+
+} // end Compute()
+
+
+/**
+ * ******************* AccumulatePiece *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::AccumulatePiece( const RegionType & piece )
+{
+  typedef ImageRegionConstIterator<ImageType>       IteratorType;
+  typedef ImageRegionConstIterator<MaskImageType>   MaskIteratorType;
+
+  const bool useMask = this->m_Mask.IsNotNull();
+  IteratorType it( this->m_Input, piece );
+  MaskIteratorType itMask;
+  if( useMask ) itMask = MaskIteratorType( this->m_Mask, piece );
+
+  /** Accumulate the moments of this piece locally. */
+  RealType sum = NumericTraits<RealType>::Zero;
+  RealType absoluteSum = NumericTraits<RealType>::Zero;
+  RealType sumOfSquares = NumericTraits<RealType>::Zero;
+  RealType logSum = NumericTraits<RealType>::Zero;
+  RealType logSumOfSquares = NumericTraits<RealType>::Zero;
+  SizeValueType count = 0;
+  SizeValueType finiteCount = 0;
+  RealType finiteMin = NumericTraits<RealType>::max();
+  RealType finiteMax = NumericTraits<RealType>::NonpositiveMin();
+
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( useMask )
+    {
+      const bool inside = itMask.Value() != 0;
+      ++itMask;
+      if( !inside ) continue;
+    }
+
+    const RealType value = static_cast<RealType>( it.Get() );
+    if( value < this->m_Minimum ) this->m_Minimum = value;
+    if( value > this->m_Maximum ) this->m_Maximum = value;
+
+    sum += value;
+    absoluteSum += vnl_math_abs( value );
+    sumOfSquares += value * value;
+    ++count;
+
+    if( this->m_ComputeGeometricStatistics )
+    {
+      const RealType logValue = vcl_log( value );
+      logSum += logValue;
+      logSumOfSquares += logValue * logValue;
+    }
+
+    /** Infinite values can not be binned; NaN fails both tests. */
+    if( vnl_math_isfinite( value ) )
+    {
+      ++finiteCount;
+      if( value < finiteMin ) finiteMin = value;
+      if( value > finiteMax ) finiteMax = value;
+    }
+  }
+
+  this->m_Sum += sum;
+  this->m_AbsoluteSum += absoluteSum;
+  this->m_SumOfSquares += sumOfSquares;
+  this->m_LogSum += logSum;
+  this->m_LogSumOfSquares += logSumOfSquares;
+  this->m_Count += count;
+
+  if( !this->m_ComputeHistogram || finiteMin > finiteMax ) return;
+
+  this->m_FiniteMinimum = vnl_math_min( this->m_FiniteMinimum, finiteMin );
+  this->m_FiniteMaximum = vnl_math_max( this->m_FiniteMaximum, finiteMax );
+
+  /** As long as all pixels have the same value they are only counted,
+   * since a constant first piece says nothing about the range of the
+   * image. Then the histogram starts with the range of all pixels so far.
+   */
+  if( this->m_InternalBinWidth <= 0.0 )
+  {
+    if( this->m_FiniteMinimum == this->m_FiniteMaximum )
+    {
+      this->m_PendingValue = this->m_FiniteMinimum;
+      this->m_PendingFrequency += finiteCount;
+      return;
+    }
+    this->InitializeInternalHistogram( this->m_FiniteMinimum, this->m_FiniteMaximum );
+  }
+
+  /** Make sure the internal histogram covers this piece, and fill it.
+   * The piece is still in memory, so this second loop does not read
+   * from disk again.
+   */
+  this->ExpandInternalHistogram( finiteMin, finiteMax );
+
+  const long lastBin = static_cast<long>( this->m_InternalFrequencies.size() ) - 1;
+  const RealType origin = this->m_InternalOrigin;
+  const RealType invWidth = 1.0 / this->m_InternalBinWidth;
+  if( useMask ) itMask.GoToBegin();
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    if( useMask )
+    {
+      const bool inside = itMask.Value() != 0;
+      ++itMask;
+      if( !inside ) continue;
+    }
+
+    const RealType value = static_cast<RealType>( it.Get() );
+    if( !vnl_math_isfinite( value ) ) continue;
+
+    long bin = static_cast<long>( ( value - origin ) * invWidth );
+    bin = vnl_math_max( 0L, vnl_math_min( bin, lastBin ) );
+    ++this->m_InternalFrequencies[ bin ];
+  }
+
+} // end AccumulatePiece()
+
+
+/**
+ * ******************* InitializeInternalHistogram *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::InitializeInternalHistogram( RealType lower, RealType upper )
+{
+  const RealType binsAsReal = static_cast<RealType>( this->m_InternalFrequencies.size() );
+  this->m_InternalOrigin = lower;
+  this->m_InternalBinWidth = ( upper - lower ) / binsAsReal;
+  if( !( this->m_InternalBinWidth > 0.0 ) )
+  {
+    /** A constant image; use a narrow range around the value. */
+    this->m_InternalBinWidth = vnl_math_max( vnl_math_abs( lower ), 1.0 )
+      * NumericTraits<RealType>::epsilon() * 100.0;
+  }
+
+  /** The pixels counted so far all have the pending value, which need not
+   * be the minimum, since the current piece may contain smaller values.
+   */
+  if( this->m_PendingFrequency > 0 )
+  {
+    const long lastBin = static_cast<long>( this->m_InternalFrequencies.size() ) - 1;
+    long bin = static_cast<long>( ( this->m_PendingValue - this->m_InternalOrigin )
+      / this->m_InternalBinWidth );
+    bin = vnl_math_max( 0L, vnl_math_min( bin, lastBin ) );
+    this->m_InternalFrequencies[ bin ] += this->m_PendingFrequency;
+    this->m_PendingFrequency = 0;
+  }
+
+} // end InitializeInternalHistogram()
+
+
+/**
+ * ******************* ExpandInternalHistogram *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::ExpandInternalHistogram( RealType lower, RealType upper )
+{
+  const std::size_t numberOfBins = this->m_InternalFrequencies.size();
+  const RealType binsAsReal = static_cast<RealType>( numberOfBins );
+
+  /** Double the bin width until [lower, upper] is covered. The range is
+   * extended downwards, in which case the old bins end up in the upper
+   * half, or upwards, in which case they end up in the lower half.
+   */
+  FrequencyContainerType merged( numberOfBins );
+  const std::size_t half = numberOfBins / 2;
+  while( lower < this->m_InternalOrigin
+    || upper > this->m_InternalOrigin + binsAsReal * this->m_InternalBinWidth )
+  {
+    std::fill( merged.begin(), merged.end(), 0 );
+    const std::size_t offset = ( lower < this->m_InternalOrigin ) ? half : 0;
+    for( std::size_t i = 0; i < numberOfBins; ++i )
+    {
+      merged[ offset + i / 2 ] += this->m_InternalFrequencies[ i ];
+    }
+    if( offset > 0 )
+    {
+      this->m_InternalOrigin -= binsAsReal * this->m_InternalBinWidth;
+    }
+    this->m_InternalBinWidth *= 2.0;
+    this->m_InternalFrequencies.swap( merged );
+  }
+
+} // end ExpandInternalHistogram()
+
+
+/**
+ * ******************* GenerateHistogram *******************
+ */
+
+template< class TImage, class TMaskImage >
+const typename StreamedImageStatisticsGenerator< TImage, TMaskImage >::HistogramType *
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::GenerateHistogram( unsigned int numberOfBins,
+  RealType histogramMin, RealType histogramMax )
+{
+  typedef typename HistogramType::SizeType              SizeType;
+  typedef typename HistogramType::MeasurementVectorType MeasurementVectorType;
+  typedef typename HistogramType::IndexType             IndexType;
+
+  SizeType size;
+  size.SetSize( 1 );
+  size.Fill( numberOfBins );
+  MeasurementVectorType lowerBound( 1 );
+  MeasurementVectorType upperBound( 1 );
+  lowerBound[ 0 ] = histogramMin;
+  upperBound[ 0 ] = histogramMax;
+
+  this->m_Histogram = HistogramType::New();
+  this->m_Histogram->SetMeasurementVectorSize( 1 );
+  this->m_Histogram->Initialize( size, lowerBound, upperBound );
+
+  /** Each internal bin is assigned to the output bin that contains its
+   * center. The center is clamped to the range of the data, since the
+   * outer internal bins usually extend beyond it.
+   */
+  MeasurementVectorType measurement( 1 );
+  IndexType index( 1 );
+  for( std::size_t i = 0; i < this->m_InternalFrequencies.size(); ++i )
+  {
+    const FrequencyType frequency = this->m_InternalFrequencies[ i ];
+    if( frequency == 0 ) continue;
+
+    RealType center = this->m_InternalOrigin
+      + ( static_cast<RealType>( i ) + 0.5 ) * this->m_InternalBinWidth;
+    center = vnl_math_max( this->m_FiniteMinimum, vnl_math_min( center, this->m_FiniteMaximum ) );
+
+    measurement[ 0 ] = center;
+    if( this->m_Histogram->GetIndex( measurement, index ) )
+    {
+      this->m_Histogram->IncreaseFrequencyOfIndex( index, frequency );
+    }
+  }
+
+  return this->m_Histogram.GetPointer();
+
+} // end GenerateHistogram()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TImage, class TMaskImage >
+void
+StreamedImageStatisticsGenerator< TImage, TMaskImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "NumberOfStreamDivisions: " << this->m_NumberOfStreamDivisions << std::endl;
+  os << indent << "NumberOfInternalBins: " << this->m_NumberOfInternalBins << std::endl;
+  os << indent << "ComputeGeometricStatistics: " << this->m_ComputeGeometricStatistics << std::endl;
+  os << indent << "ComputeHistogram: " << this->m_ComputeHistogram << std::endl;
+  os << indent << "Count: " << this->m_Count << std::endl;
+  os << indent << "Minimum: " << this->m_Minimum << std::endl;
+  os << indent << "Maximum: " << this->m_Maximum << std::endl;
+  os << indent << "Mean: " << this->m_Mean << std::endl;
+  os << indent << "Sigma: " << this->m_Sigma << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#endif // end #ifndef __itkStreamedImageStatisticsGenerator_txx_
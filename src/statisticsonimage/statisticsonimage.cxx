@@ -54,6 +54,11 @@ std::string GetHelpString( void )
     << "           much larger (~100x) than the number of gray values.\n"
     << "           if equal 0, then the intensity range (max - min) is chosen.\n"
     << "  [-s]     select which to compute {arithmetic, geometric, histogram}, default all;\n"
+    << "  [-fused] compute all statistics in a single streamed pass over the image,\n"
+    << "           without keeping the whole image in memory. The histogram is then\n"
+    << "           derived from a fine adaptive histogram, so quantiles may differ\n"
+    << "           slightly from the default computation.\n"
+    << "  [-ns]    number of streams for -fused, default 16.\n"
     << "Supported: 2D, 3D, 4D, float, (unsigned) short, (unsigned) char, 1, 2 or 3 components per pixel.\n"
     << "For 4D, only 1 or 4 components per pixel are supported.";
 
@@ -102,6 +107,11 @@ int main( int argc, char ** argv )
   std::string select = "";
   bool rets = parser->GetCommandLineArgument( "-s", select );
 
+  const bool fused = parser->ArgumentExists( "-fused" );
+
+  unsigned int numberOfStreams = 16;
+  parser->GetCommandLineArgument( "-ns", numberOfStreams );
+
   /** Check selection. */
   if( rets && ( select != "arithmetic" && select != "geometric"
     && select != "histogram" ) )
@@ -158,6 +168,8 @@ int main( int argc, char ** argv )
     filter->m_HistogramOutputFileName = histogramOutputFileName;
     filter->m_NumberOfBins = numberOfBins;
     filter->m_Select = select;
+    filter->m_Fused = fused;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
@@ -23,6 +23,7 @@
 #include "itkImageToImageFilter.h"
 #include "itkStatisticsImageFilterWithMask.h"
 #include "itkScalarImageToHistogramGenerator2.h"
+#include "itkStreamedImageStatisticsGenerator.h"
 
 
 /** \class ITKToolsStatisticsOnImageBase
@@ -42,6 +43,8 @@ public:
     this->m_HistogramOutputFileName = "";
     this->m_NumberOfBins = 0;
     this->m_Select = "";
+    this->m_Fused = false;
+    this->m_NumberOfStreams = 16;
   };
   /** Destructor. */
   ~ITKToolsStatisticsOnImageBase(){};
@@ -52,6 +55,8 @@ public:
   std::string m_HistogramOutputFileName;
   unsigned int m_NumberOfBins;
   std::string m_Select;
+  bool m_Fused;
+  unsigned int m_NumberOfStreams;
 
 }; // end class StatisticsOnImageBase
 
@@ -91,6 +96,9 @@ public:
     InternalImageType >                               StatisticsFilterType;
   typedef itk::Statistics::ScalarImageToHistogramGenerator2<
     InternalImageType >                               HistogramGeneratorType;
+  typedef itk::Image<unsigned char, VDimension>       MaskImageType;
+  typedef itk::Statistics::StreamedImageStatisticsGenerator<
+    InternalImageType, MaskImageType >                StreamedGeneratorType;
 
   /** Run function. */
   void Run( void );
@@ -105,6 +113,14 @@ public:
     const std::string & histogramOutputFileName,
     const std::string & select );
 
+  /** Helper function. Computes all statistics in a single streamed pass. */
+  void ComputeStatisticsStreamed(
+    InternalImageType * inputImage,
+    MaskImageType * maskImage,
+    unsigned int numberOfBins,
+    const std::string & histogramOutputFileName,
+    const std::string & select );
+
   /** Helper function. */
   void DetermineHistogramMaximum(
     const InternalPixelType & maxPixelValue,
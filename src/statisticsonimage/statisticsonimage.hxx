@@ -39,11 +39,9 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
   /** Typedefs. */
   typedef TComponentType ScalarPixelType;
 
-  typedef unsigned char MaskPixelType;
   typedef itk::Vector<TComponentType, VNumberOfComponents>  VectorPixelType;
   typedef itk::Image<ScalarPixelType, VDimension>     ScalarImageType;
   typedef itk::Image<VectorPixelType, VDimension>     VectorImageType;
-  typedef itk::Image<MaskPixelType, VDimension>       MaskImageType;
 
   typedef itk::ImageFileReader< ScalarImageType >     ScalarReaderType;
   typedef itk::ImageFileReader< InternalImageType >   InternalScalarReaderType;
@@ -59,6 +57,54 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
   typedef typename
     HistogramGeneratorType::HistogramType             HistogramType;
 
+  /** The fused mode streams the input (and mask) through a single pass. */
+  if( this->m_Fused )
+  {
+    typename MaskReaderType::Pointer maskReader;
+    MaskImageType * maskImage = NULL;
+    if( this->m_MaskFileName != "" )
+    {
+      maskReader = MaskReaderType::New();
+      maskReader->SetFileName( this->m_MaskFileName.c_str() );
+      maskImage = maskReader->GetOutput();
+    }
+
+    if( VNumberOfComponents == 1 )
+    {
+      std::cout << "Statistics are computed on the gray values." << std::endl;
+
+      typename InternalScalarReaderType::Pointer reader
+        = InternalScalarReaderType::New();
+      reader->SetFileName( this->m_InputFileName.c_str() );
+
+      this->ComputeStatisticsStreamed(
+        reader->GetOutput(),
+        maskImage,
+        this->m_NumberOfBins,
+        this->m_HistogramOutputFileName,
+        this->m_Select );
+    }
+    else
+    {
+      std::cout << "Statistics are computed on the magnitude of the vectors." << std::endl;
+
+      typename VectorReaderType::Pointer reader = VectorReaderType::New();
+      reader->SetFileName( this->m_InputFileName.c_str() );
+
+      /** The magnitude is computed piece by piece as well. */
+      typename MagnitudeFilterType::Pointer magnitudeFilter = MagnitudeFilterType::New();
+      magnitudeFilter->SetInput( reader->GetOutput() );
+
+      this->ComputeStatisticsStreamed(
+        magnitudeFilter->GetOutput(),
+        maskImage,
+        this->m_NumberOfBins,
+        this->m_HistogramOutputFileName,
+        this->m_Select );
+    }
+    return;
+  } // end fused mode
+
   /** Create StatisticsFilter. */
   typename StatisticsFilterType::Pointer statistics
     = StatisticsFilterType::New();
@@ -252,6 +298,84 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
 } // end ComputeStatistics()
 
 
+/**
+ * ************************ ComputeStatisticsStreamed **************************
+ *
+ * Computes the same statistics as ComputeStatistics, but in a single
+ * streamed pass over the image, without a masked copy. The histogram is
+ * redistributed from a fine adaptive histogram, so the reported quantiles
+ * may differ from the multi-pass ones by a fraction of a bin.
+ */
+
+template< unsigned int VDimension, unsigned int VNumberOfComponents, class TComponentType >
+void
+ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
+::ComputeStatisticsStreamed(
+  InternalImageType * inputImage,
+  MaskImageType * maskImage,
+  unsigned int numberOfBins,
+  const std::string & histogramOutputFileName,
+  const std::string & select )
+{
+  typedef typename StreamedGeneratorType::HistogramType HistogramType;
+
+  const bool computeArithmetic = select == "arithmetic" || select == "";
+  const bool computeGeometric = select == "geometric" || select == "";
+  const bool computeHistogram = select == "histogram" || select == "";
+
+  typename StreamedGeneratorType::Pointer generator = StreamedGeneratorType::New();
+  generator->SetInput( inputImage );
+  if( maskImage ) generator->SetMask( maskImage );
+  generator->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+  generator->SetComputeGeometricStatistics( computeGeometric );
+  generator->SetComputeHistogram( computeHistogram );
+
+  /** Keep the internal bins well below the size of the output bins. */
+  if( numberOfBins > 0 )
+  {
+    generator->SetNumberOfInternalBins( vnl_math_max(
+      generator->GetNumberOfInternalBins(), 16 * numberOfBins ) );
+  }
+
+  std::cout << "Computing statistics in a single streamed pass ..." << std::endl;
+  generator->Compute();
+
+  if( computeArithmetic )
+  {
+    std::cout << "Arithmetic statistics:" << std::endl;
+    PrintStatistics<StreamedGeneratorType>( generator );
+  }
+
+  if( computeGeometric )
+  {
+    std::cout << "Geometric statistics:" << std::endl;
+    PrintGeometricStatistics( generator->GetLogMean(), generator->GetLogSigma() );
+  }
+
+  if( computeHistogram )
+  {
+    const InternalPixelType maxPixelValue = generator->GetMaximum();
+    const InternalPixelType minPixelValue = generator->GetMinimum();
+
+    /** If the user specified 0, the number of bins is equal to the intensity range. */
+    if( numberOfBins == 0 )
+    {
+      numberOfBins = static_cast<unsigned int>( maxPixelValue - minPixelValue );
+    }
+
+    /** Determine histogram maximum. */
+    InternalPixelType histogramMax;
+    this->DetermineHistogramMaximum( maxPixelValue, minPixelValue, numberOfBins, histogramMax );
+
+    std::cout << "Histogram statistics:" << std::endl;
+    const HistogramType * histogram = generator->GenerateHistogram(
+      numberOfBins, minPixelValue, histogramMax );
+    PrintHistogramStatistics<HistogramType>( histogram, histogramOutputFileName );
+  }
+
+} // end ComputeStatisticsStreamed()
+
+
 /**
  * ******************* DetermineHistogramMaximum *******************
  */
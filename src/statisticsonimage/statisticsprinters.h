@@ -22,7 +22,7 @@
 #include <fstream>
 #include <iomanip>
 
-/** this file defines three function that print statistics information */
+/** this file defines functions that print statistics information */
 
 /**
  * Print the results of an itk::StatisticsImageFilter
@@ -44,6 +44,23 @@ void PrintStatistics( const TStatisticsFilter * statistics )
 } // end PrintStatistics()
 
 
+/**
+ * Print the geometric mean and standard deviation, given the mean
+ * and standard deviation of the log of the actual image.
+ */
+
+inline void PrintGeometricStatistics( double logMean, double logSigma )
+{
+  /** Print to screen. */
+  std::cout << std::setprecision(10);
+  double geometricmean = vcl_exp( logMean );
+  double geometricstdev = vcl_exp( logSigma );
+  std::cout << "\tgeometric mean : " << geometricmean << std::endl;
+  std::cout << "\tgeometric stdev: " << geometricstdev << std::endl;
+
+} // end PrintGeometricStatistics()
+
+
 /**
  * Print the results of an itk::StatisticsImageFilter
  * Assume that statistics were calculated on the log
@@ -53,12 +70,7 @@ void PrintStatistics( const TStatisticsFilter * statistics )
 template<class TStatisticsFilter>
 void PrintGeometricStatistics( const TStatisticsFilter * statistics )
 {
-  /** Print to screen. */
-  std::cout << std::setprecision(10);
-  double geometricmean = vcl_exp( statistics->GetMean() );
-  double geometricstdev = vcl_exp( statistics->GetSigma() );
-  std::cout << "\tgeometric mean : " << geometricmean << std::endl;
-  std::cout << "\tgeometric stdev: " << geometricstdev << std::endl;
+  PrintGeometricStatistics( statistics->GetMean(), statistics->GetSigma() );
 
 } // end PrintGeometricStatistics()
 
@@ -36,6 +36,7 @@
 
 #include "itkHistogram.h"
 #include "itkMacro.h"
+#include <vector>
 
 namespace itk {
 namespace Statistics {
@@ -140,6 +141,9 @@ public:
   typedef typename HistogramType::MeasurementType         MeasurementType;
   typedef typename HistogramType::MeasurementVectorType   MeasurementVectorType;
   typedef typename HistogramType::IndexType               IndexType;
+  typedef typename HistogramType::InstanceIdentifier      InstanceIdentifier;
+  typedef typename HistogramType::SizeValueType           SizeValueType;
+  typedef ::itk::IndexValueType                           IndexValueType;
 
   typedef typename HistogramType::RelativeFrequencyType   RelativeFrequencyType;
   typedef typename HistogramType::AbsoluteFrequencyType   AbsoluteFrequencyType;
@@ -147,6 +151,17 @@ public:
   /** Triggers the computation of the histogram. */
   virtual void Compute( void );
 
+  /** Computes the features from the non-zero bins of a symmetric co-occurrence
+   * matrix with binsPerAxis bins along each axis. The bins are given as
+   * instance identifiers in ascending order, together with their frequencies.
+   * This gives exactly the same result as Compute() on the corresponding
+   * histogram, but does not require the histogram to exist.
+   */
+  virtual void Compute( SizeValueType binsPerAxis,
+    const std::vector< InstanceIdentifier > & bins,
+    const std::vector< AbsoluteFrequencyType > & frequencies,
+    double totalFrequency );
+
   /** Connects the GLCM histogram over which the features are going to be computed. */
   itkSetObjectMacro( Histogram, HistogramType );
   itkGetObjectMacro( Histogram, HistogramType );
@@ -188,6 +203,10 @@ private:
   /** The member variables: input histogram. */
   HistogramPointer  m_Histogram;
 
+  /** The non-zero bins of the input histogram. */
+  std::vector< InstanceIdentifier >     m_Bins;
+  std::vector< AbsoluteFrequencyType >  m_Frequencies;
+
   /** The member variables: output feature values. */
   double            m_Energy;
   double            m_Entropy;
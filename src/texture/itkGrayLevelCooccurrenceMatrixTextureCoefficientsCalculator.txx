@@ -86,13 +86,44 @@ void
 GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator< THistogram >
 ::Compute( void )
 {
-  /** Reset the feature values. */
-  this->ResetFeatureValues();
-
   /** Get the total histogram frequency and size. */
   double totalFrequency = this->m_Histogram->GetTotalFrequency();
   typename HistogramType::SizeValueType binsPerAxis = this->m_Histogram->GetSize( 0 );
 
+  /** Collect the non-zero bins, in the order of the histogram. */
+  this->m_Bins.clear();
+  this->m_Frequencies.clear();
+  HistogramConstIterator hit( this->m_Histogram );
+  for ( hit = this->m_Histogram->Begin(); hit != this->m_Histogram->End(); ++hit )
+  {
+    AbsoluteFrequencyType frequencyCount = hit.GetFrequency();
+    if( frequencyCount == 0 ) continue;
+
+    this->m_Bins.push_back( hit.GetInstanceIdentifier() );
+    this->m_Frequencies.push_back( frequencyCount );
+  }
+
+  /** Compute the features from these bins. */
+  this->Compute( binsPerAxis, this->m_Bins, this->m_Frequencies, totalFrequency );
+
+} // end Compute()
+
+
+/**
+ * ********************* Compute ****************************
+ */
+
+template< class THistogram >
+void
+GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator< THistogram >
+::Compute( SizeValueType binsPerAxis,
+  const std::vector< InstanceIdentifier > & bins,
+  const std::vector< AbsoluteFrequencyType > & frequencies,
+  double totalFrequency )
+{
+  /** Reset the feature values. */
+  this->ResetFeatureValues();
+
   /** Temporary variables. */
   double pixelSum_0, pixelSum_1, pixelSum_00, pixelSum_01, pixelSum_11,
     pixelSum_000, pixelSum_001, pixelSum_011, pixelSum_111,
@@ -104,20 +135,23 @@ GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator< THistogram >
     = pixelSum_0111 = pixelSum_1111 = 0.0;
   std::vector<double> marginalSums( binsPerAxis, 0.0 );
 
-  /** Walk over the histogram. Only once instead of 4! */
+  /** Walk over the non-zero histogram bins. Only once instead of 4! */
   double log2 = vcl_log(2.);
-  HistogramConstIterator hit( this->m_Histogram );
-  for ( hit = this->m_Histogram->Begin(); hit != this->m_Histogram->End(); ++hit )
+  IndexValueType index[ 2 ];
+  for( std::size_t i = 0; i < bins.size(); ++i )
   {
     /** Get the frequency of this histogram entry. */
-    AbsoluteFrequencyType frequencyCount = hit.GetFrequency();
+    AbsoluteFrequencyType frequencyCount = frequencies[ i ];
 
     /** No use doing these calculations if we're just multiplying by zero. */
     if( frequencyCount == 0 ) continue;
 
-    /** Normalize frequency and get the index of this histogram entry. */
+    /** Normalize frequency and get the index of this histogram entry.
+     * The instance identifier runs fastest over the first index.
+     */
     double frequency = static_cast<double>(frequencyCount) / totalFrequency;
-    IndexType index = this->m_Histogram->GetIndex( hit.GetInstanceIdentifier() );
+    index[ 0 ] = static_cast<IndexValueType>( bins[ i ] % binsPerAxis );
+    index[ 1 ] = static_cast<IndexValueType>( bins[ i ] / binsPerAxis );
 
     /** Compute values that are needed later for the feature computation. */
     pixelSum_0     += index[ 0 ] * frequency;
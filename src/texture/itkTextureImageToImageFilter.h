@@ -39,6 +39,15 @@ namespace itk
  *   the itk::GreyLevelCooccurrenceMatrixTextureCoefficientsCalculator class \n
  * - each feature value is copied to the corresponding output image.
  *
+ * By default the co-occurrence matrix is not rebuilt for every pixel. Instead,
+ * a sliding window is moved along each image line, and only the co-occurrence
+ * pairs of the slab that leaves and of the slab that enters the neighborhood
+ * are subtracted and added. Each thread keeps its own dense matrix, and the
+ * features are computed from its non-zero bins only. The result is identical
+ * to rebuilding the matrix for every pixel, which can still be selected with
+ * SetUseSlidingWindow( false ). When NormalizeHistogram is on, the full
+ * matrix is always rebuilt.
+ *
  * This last class is based on several papers from Haralick and Conners:
  *
  * Haralick, R.M., K. Shanmugam and I. Dinstein. 1973.  Textural Features for
@@ -86,6 +95,7 @@ public:
   typedef typename InputImageType::PixelType        InputImagePixelType;
   typedef typename InputImageType::RegionType       InputImageRegionType;
   typedef typename InputImageType::SizeType         InputImageSizeType;
+  typedef typename InputImageType::IndexType        InputImageIndexType;
   typedef TOutputImage                              OutputImageType;
   typedef typename OutputImageType::PixelType       OutputImagePixelType;
   typedef typename OutputImageType::Pointer         OutputImagePointer;
@@ -107,6 +117,10 @@ public:
 
   typedef Statistics::GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator<
     HistogramType >                                 TextureCalculatorType;
+  typedef typename TextureCalculatorType
+    ::InstanceIdentifier                            InstanceIdentifier;
+  typedef typename TextureCalculatorType
+    ::AbsoluteFrequencyType                         AbsoluteFrequencyType;
 
   /** Input Image dimension. */
   itkStaticConstMacro( InputImageDimension, unsigned int, TInputImage::ImageDimension );
@@ -122,6 +136,13 @@ public:
   /** Set the size of the neighborhood over which local texture is computed. */
   itkSetMacro( NeighborhoodRadius, unsigned int );
 
+  /** Update the co-occurrence matrix incrementally when moving from pixel to pixel,
+   * instead of rebuilding it for every pixel. The output is the same. Default true.
+   */
+  itkSetMacro( UseSlidingWindow, bool );
+  itkGetConstMacro( UseSlidingWindow, bool );
+  itkBooleanMacro( UseSlidingWindow );
+
   /** *****
    * Functions that influence the co-occurrence matrix generation.
    *  *****
@@ -175,6 +196,32 @@ protected:
   /** Starts the image modeling process. */
   void BeforeThreadedGenerateData( void );
   void ThreadedGenerateData( const OutputImageRegionType & region, ThreadIdType threadId );
+  void AfterThreadedGenerateData( void );
+
+  /** Typedef for the image containing the co-occurrence matrix bin of each pixel,
+   * or -1 for pixels outside the histogram range.
+   */
+  typedef Image< int, InputImageDimension >         BinIndexImageType;
+  typedef typename BinIndexImageType::Pointer       BinIndexImagePointer;
+
+  /** Per-thread co-occurrence matrix used by the sliding window. The frequencies
+   * are stored densely, ordered as the histogram instance identifiers. The
+   * occupied bins are flagged in a bit set, so that they can be visited in order.
+   */
+  struct SlidingWindowMatrixType
+  {
+    std::vector< AbsoluteFrequencyType >  m_Frequencies;
+    std::vector< unsigned int >           m_Occupied;
+    AbsoluteFrequencyType                 m_TotalFrequency;
+  };
+
+  /** Compute the texture features by rebuilding the co-occurrence matrix for each pixel. */
+  virtual void ThreadedGenerateDataFullWindow(
+    const OutputImageRegionType & region, ThreadIdType threadId );
+
+  /** Compute the texture features by sliding the window along the image lines. */
+  virtual void ThreadedGenerateDataSlidingWindow(
+    const OutputImageRegionType & region, ThreadIdType threadId );
 
 private:
 
@@ -188,9 +235,15 @@ private:
   virtual void ComputeDefaultOffsets( std::vector<unsigned int> scales );
   virtual void ComputeHistogramMinimumAndMaximum( void );
 
+  /** Private functions for the sliding window. */
+  virtual void ComputeBinIndexImage( void );
+  void UpdateSlidingWindowMatrix( const InputImageRegionType & slab,
+    const bool add, SlidingWindowMatrixType & matrix ) const;
+
   /** Private variables to store results. */
   unsigned int              m_NumberOfRequestedOutputs;
   unsigned int              m_NeighborhoodRadius;
+  bool                      m_UseSlidingWindow;
 
   /** Private variables for the offsets. */
   OffsetVectorPointer       m_Offsets;
@@ -205,6 +258,11 @@ private:
   bool                      m_HistogramMaximumSetManually;
   bool                      m_NormalizeHistogram;
 
+  /** Private variables for the sliding window. */
+  BinIndexImagePointer            m_BinIndexImage;
+  std::vector< OffsetType >       m_SlidingWindowOffsets;
+  std::vector< OffsetValueType >  m_SlidingWindowBufferOffsets;
+
 }; // end class TextureImageToImageFilter
 
 
@@ -23,7 +23,10 @@
 #include "../statisticsonimage/itkStatisticsImageFilterWithMask.h"
 #include "itkConstNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageLinearIteratorWithIndex.h"
 #include "itkProgressReporter.h"
+#include <algorithm>
 
 
 namespace itk
@@ -39,6 +42,7 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
 {
   this->m_NumberOfRequestedOutputs = 8;
   this->m_NeighborhoodRadius = 3;
+  this->m_UseSlidingWindow = true;
 
   this->m_OffsetsSetManually = false;
   this->m_OffsetScales.resize( 1, 1 );
@@ -207,6 +211,12 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
   /** Compute the offsets. */
   this->ComputeDefaultOffsets( this->m_OffsetScales );
 
+  /** The sliding window works on the histogram bin of each pixel. */
+  if( this->m_UseSlidingWindow && !this->m_NormalizeHistogram )
+  {
+    this->ComputeBinIndexImage();
+  }
+
 } // end BeforeThreadedGenerateData()
 
 
@@ -218,6 +228,45 @@ template< class TInputImage, class TOutputImage >
 void
 TextureImageToImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData( const OutputImageRegionType & regionForThread, ThreadIdType threadId )
+{
+  /** The sliding window is not used with a normalized histogram,
+   * since the normalization is not incremental.
+   */
+  if( this->m_UseSlidingWindow && !this->m_NormalizeHistogram )
+  {
+    this->ThreadedGenerateDataSlidingWindow( regionForThread, threadId );
+  }
+  else
+  {
+    this->ThreadedGenerateDataFullWindow( regionForThread, threadId );
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ********************* AfterThreadedGenerateData ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData( void )
+{
+  /** Release the memory of the bin index image. */
+  this->m_BinIndexImage = 0;
+
+} // end AfterThreadedGenerateData()
+
+
+/**
+ * ********************* ThreadedGenerateDataFullWindow ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateDataFullWindow( const OutputImageRegionType & regionForThread, ThreadIdType threadId )
 {
   /** Support for progress methods/callbacks. */
   ProgressReporter progress( this, threadId, regionForThread.GetNumberOfPixels() );
@@ -288,7 +337,279 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
 
   } // end while
 
-} // end ThreadedGenerateData()
+} // end ThreadedGenerateDataFullWindow()
+
+
+/**
+ * ********************* ThreadedGenerateDataSlidingWindow ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateDataSlidingWindow( const OutputImageRegionType & regionForThread, ThreadIdType threadId )
+{
+  /** Support for progress methods/callbacks. */
+  ProgressReporter progress( this, threadId, regionForThread.GetNumberOfPixels() );
+
+  /** Setup local texture feature calculator. */
+  typename TextureCalculatorType::Pointer cmCalculator
+    = TextureCalculatorType::New();
+
+  /** Setup the co-occurrence matrix of this thread. */
+  const unsigned int numberOfBins = this->m_NumberOfHistogramBins;
+  const InstanceIdentifier matrixSize
+    = static_cast<InstanceIdentifier>( numberOfBins ) * numberOfBins;
+  SlidingWindowMatrixType matrix;
+  matrix.m_Frequencies.resize( matrixSize );
+  matrix.m_Occupied.resize( ( matrixSize + 31 ) / 32 );
+  std::vector< InstanceIdentifier > bins;
+  std::vector< AbsoluteFrequencyType > frequencies;
+
+  /** Get the extent of the input image. */
+  const InputImageRegionType largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  const InputImageIndexType imageStart = largestRegion.GetIndex();
+  InputImageIndexType imageEnd;
+  for( unsigned int i = 0; i < InputImageDimension; ++i )
+  {
+    imageEnd[ i ] = imageStart[ i ] + static_cast<IndexValueType>( largestRegion.GetSize()[ i ] ) - 1;
+  }
+  const IndexValueType radius = static_cast<IndexValueType>( this->m_NeighborhoodRadius );
+
+  /** Setup line iterators over the output images. */
+  typedef ImageLinearIteratorWithIndex< OutputImageType >     OutputIteratorType;
+  const unsigned int noo = this->GetNumberOfOutputs();
+  std::vector< OutputIteratorType > outputIterators( noo );
+  for( unsigned int i = 0; i < noo; ++i )
+  {
+    outputIterators[ i ] = OutputIteratorType( this->GetOutput( i ), regionForThread );
+    outputIterators[ i ].SetDirection( 0 );
+    outputIterators[ i ].GoToBegin();
+  }
+
+  /** Loop over the lines of the output region. */
+  InputImageRegionType window, slab;
+  InputImageIndexType windowStart;
+  InputImageSizeType windowSize;
+  while( !outputIterators[ 0 ].IsAtEnd() )
+  {
+    /** Construct the neighborhood of the first pixel on this line,
+     * cropped with the largest possible region of the input image.
+     */
+    const InputImageIndexType lineStart = outputIterators[ 0 ].GetIndex();
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      const IndexValueType lower = std::max( lineStart[ i ] - radius, imageStart[ i ] );
+      const IndexValueType upper = std::min( lineStart[ i ] + radius, imageEnd[ i ] );
+      windowStart[ i ] = lower;
+      windowSize[ i ] = static_cast<SizeValueType>( upper - lower + 1 );
+    }
+    window.SetIndex( windowStart );
+    window.SetSize( windowSize );
+
+    /** Start this line with the full co-occurrence matrix of the first pixel. */
+    std::fill( matrix.m_Frequencies.begin(), matrix.m_Frequencies.end(), 0 );
+    std::fill( matrix.m_Occupied.begin(), matrix.m_Occupied.end(), 0 );
+    matrix.m_TotalFrequency = 0;
+    this->UpdateSlidingWindowMatrix( window, true, matrix );
+
+    /** The slabs leaving and entering the window have the same extent as the
+     * window, except along the line direction.
+     */
+    slab = window;
+    slab.SetSize( 0, 1 );
+
+    IndexValueType x = lineStart[ 0 ];
+    while( !outputIterators[ 0 ].IsAtEndOfLine() )
+    {
+      /** Move the window one pixel along the line. */
+      if( x != lineStart[ 0 ] )
+      {
+        const IndexValueType leaving = x - 1 - radius;
+        if( leaving >= imageStart[ 0 ] )
+        {
+          slab.SetIndex( 0, leaving );
+          this->UpdateSlidingWindowMatrix( slab, false, matrix );
+        }
+        const IndexValueType entering = x + radius;
+        if( entering <= imageEnd[ 0 ] )
+        {
+          slab.SetIndex( 0, entering );
+          this->UpdateSlidingWindowMatrix( slab, true, matrix );
+        }
+      }
+
+      /** Collect the non-zero bins in ascending order. */
+      bins.clear();
+      frequencies.clear();
+      for( std::size_t w = 0; w < matrix.m_Occupied.size(); ++w )
+      {
+        const unsigned int word = matrix.m_Occupied[ w ];
+        if( word == 0 ) continue;
+        for( unsigned int b = 0; b < 32; ++b )
+        {
+          if( ( word >> b ) & 1u )
+          {
+            const InstanceIdentifier id = w * 32 + b;
+            bins.push_back( id );
+            frequencies.push_back( matrix.m_Frequencies[ id ] );
+          }
+        }
+      }
+
+      /** Compute texture features from this co-occurrence matrix. */
+      cmCalculator->Compute( numberOfBins, bins, frequencies,
+        static_cast<double>( matrix.m_TotalFrequency ) );
+
+      /** Copy the requested texture features to the outputs and update iterators. */
+      for( unsigned int ii = 0; ii < noo; ++ii )
+      {
+        outputIterators[ ii ].Set( cmCalculator->GetFeature( ii ) );
+        ++outputIterators[ ii ];
+      }
+      ++x;
+
+      progress.CompletedPixel();
+    } // end while line
+
+    for( unsigned int ii = 0; ii < noo; ++ii )
+    {
+      outputIterators[ ii ].NextLine();
+    }
+  } // end while lines
+
+} // end ThreadedGenerateDataSlidingWindow()
+
+
+/**
+ * ********************* UpdateSlidingWindowMatrix ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::UpdateSlidingWindowMatrix( const InputImageRegionType & slab,
+  const bool add, SlidingWindowMatrixType & matrix ) const
+{
+  const InputImageRegionType largestRegion = this->m_BinIndexImage->GetLargestPossibleRegion();
+  const std::vector< OffsetType > & offsets = this->m_SlidingWindowOffsets;
+  const std::vector< OffsetValueType > & bufferOffsets = this->m_SlidingWindowBufferOffsets;
+  const unsigned int numberOfOffsets = offsets.size();
+
+  /** Loop over the slab and add or remove both co-occurrence combinations of
+   * each pair, exactly as ScalarImageToGrayLevelCooccurrenceMatrixGenerator
+   * adds them: the neighbor only needs to be inside the image, not inside the slab.
+   */
+  const InstanceIdentifier numberOfBins = this->m_NumberOfHistogramBins;
+  ImageRegionConstIteratorWithIndex< BinIndexImageType > it( this->m_BinIndexImage, slab );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    const int centerBin = it.Get();
+    if( centerBin < 0 ) continue;
+
+    const InputImageIndexType & centerIndex = it.GetIndex();
+    const int * centerPointer = &( it.Value() );
+    for( unsigned int k = 0; k < numberOfOffsets; ++k )
+    {
+      if( !largestRegion.IsInside( centerIndex + offsets[ k ] ) ) continue;
+
+      const int neighborBin = *( centerPointer + bufferOffsets[ k ] );
+      if( neighborBin < 0 ) continue;
+
+      const InstanceIdentifier ids[ 2 ] = {
+        centerBin + neighborBin * numberOfBins,
+        neighborBin + centerBin * numberOfBins };
+      for( unsigned int j = 0; j < 2; ++j )
+      {
+        const InstanceIdentifier id = ids[ j ];
+        const unsigned int mask = 1u << ( id % 32 );
+        if( add )
+        {
+          if( matrix.m_Frequencies[ id ]++ == 0 ) matrix.m_Occupied[ id / 32 ] |= mask;
+          ++matrix.m_TotalFrequency;
+        }
+        else
+        {
+          if( --matrix.m_Frequencies[ id ] == 0 ) matrix.m_Occupied[ id / 32 ] &= ~mask;
+          --matrix.m_TotalFrequency;
+        }
+      }
+    }
+  }
+
+} // end UpdateSlidingWindowMatrix()
+
+
+/**
+ * ********************* ComputeBinIndexImage ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::ComputeBinIndexImage( void )
+{
+  /** Setup a histogram with exactly the same bins as the co-occurrence
+   * matrix, see ScalarImageToGrayLevelCooccurrenceMatrixGenerator::SetPixelValueMinMax().
+   */
+  typename HistogramType::Pointer histogram = HistogramType::New();
+  histogram->SetMeasurementVectorSize( 2 );
+  typename HistogramType::SizeType size;
+  size.SetSize( 2 );
+  size.Fill( this->m_NumberOfHistogramBins );
+  typename HistogramType::MeasurementVectorType lowerBound, upperBound, measurement;
+  lowerBound.SetSize( 2 );
+  upperBound.SetSize( 2 );
+  measurement.SetSize( 2 );
+  lowerBound.Fill( this->m_HistogramMinimum );
+  upperBound.Fill( this->m_HistogramMaximum + 1 );
+  histogram->Initialize( size, lowerBound, upperBound );
+
+  /** Allocate the bin index image. */
+  const InputImageRegionType largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  this->m_BinIndexImage = BinIndexImageType::New();
+  this->m_BinIndexImage->SetRegions( largestRegion );
+  this->m_BinIndexImage->Allocate();
+
+  /** Look up the bin of each pixel. Pixels outside the histogram range
+   * never contribute to the co-occurrence matrix.
+   */
+  typedef ImageRegionConstIterator< InputImageType >  InputIteratorType;
+  typedef ImageRegionIterator< BinIndexImageType >    BinIndexIteratorType;
+  InputIteratorType it( this->GetInput(), largestRegion );
+  BinIndexIteratorType bit( this->m_BinIndexImage, largestRegion );
+  typename HistogramType::IndexType index( 2 );
+  for( it.GoToBegin(), bit.GoToBegin(); !it.IsAtEnd(); ++it, ++bit )
+  {
+    const InputImagePixelType value = it.Get();
+    int bin = -1;
+    if( !( value < this->m_HistogramMinimum || value > this->m_HistogramMaximum ) )
+    {
+      measurement.Fill( value );
+      if( histogram->GetIndex( measurement, index ) )
+      {
+        bin = static_cast<int>( index[ 0 ] );
+      }
+    }
+    bit.Set( bin );
+  }
+
+  /** Store the offsets, also as offsets in the buffer of the bin index image. */
+  const unsigned int numberOfOffsets = this->m_Offsets->Size();
+  const OffsetValueType * offsetTable = this->m_BinIndexImage->GetOffsetTable();
+  this->m_SlidingWindowOffsets.resize( numberOfOffsets );
+  this->m_SlidingWindowBufferOffsets.assign( numberOfOffsets, 0 );
+  for( unsigned int k = 0; k < numberOfOffsets; ++k )
+  {
+    this->m_SlidingWindowOffsets[ k ] = this->m_Offsets->GetElement( k );
+    for( unsigned int i = 0; i < InputImageDimension; ++i )
+    {
+      this->m_SlidingWindowBufferOffsets[ k ]
+        += this->m_SlidingWindowOffsets[ k ][ i ] * offsetTable[ i ];
+    }
+  }
+
+} // end ComputeBinIndexImage()
 
 
 /**
@@ -427,6 +748,8 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
     << this->m_NeighborhoodRadius << std::endl;
   os << indent << "NumberOfRequestedOutputs: "
     << this->m_NumberOfRequestedOutputs << std::endl;
+  os << indent << "UseSlidingWindow: "
+    << this->m_UseSlidingWindow << std::endl;
 
   os << indent << "OffsetsSetManually: "
     << this->m_OffsetsSetManually << std::endl;
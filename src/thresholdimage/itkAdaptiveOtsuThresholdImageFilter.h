@@ -50,21 +50,33 @@
 #endif
 
 #include "itkImageToImageFilter.h"
-#include "itkOtsuThresholdCalculator.h"
 #include "itkNumericTraits.h"
 
 #include "itkVector.h"
 #include "itkPointSet.h"
-#include "itkConstNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
-#include "itkImageRandomNonRepeatingConstIteratorWithIndex.h"
 #include "itkBSplineScatteredDataPointSetToImageFilter.h"
-#include "itkVectorIndexSelectionCastImageFilter.h"
-#include "itkRegionOfInterestImageFilter.h"
+#include "itkMultiThreader.h"
+#include <vector>
 
 namespace itk {
 
+/** \class AdaptiveOtsuThresholdImageFilter
+ * \brief Thresholds an image with a smoothly varying Otsu threshold.
+ *
+ * Otsu thresholds are computed in NumberOfSamples windows of size Radius
+ * at random positions. A B-spline surface is fitted through these local
+ * thresholds and every pixel brighter than the surface is set to the
+ * InsideValue.
+ *
+ * The local thresholds are computed in parallel, each thread reusing its
+ * own histogram. The surface is cached in the threshold image: when only
+ * the inside or outside value changed, the surface is not fitted again.
+ * Filling the threshold image and thresholding the input is done in one
+ * threaded pass.
+ */
+
 template < class TInputImage, class TOutputImage >
 class ITK_EXPORT AdaptiveOtsuThresholdImageFilter :
   public ImageToImageFilter< TInputImage, TOutputImage >
@@ -107,18 +119,7 @@ public:
   typedef typename OutputImageType::RegionType  OutputImageRegionType;
 
   typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-  typedef ImageRegionIteratorWithIndex< OutputImageType > OutputIteratorType;
-
-  typedef ImageRandomNonRepeatingConstIteratorWithIndex< InputImageType >
-    RandomIteratorType;
-
-  typedef RegionOfInterestImageFilter< InputImageType, InputImageType >
-    ROIFilterType;
-  typedef typename ROIFilterType::Pointer
-    ROIFilterPointer;
-
-  typedef OtsuThresholdCalculator< InputImageType >       OtsuThresholdType;
-  typedef typename OtsuThresholdType::Pointer             OtsuThresholdPointer;
+  typedef ImageRegionIterator< OutputImageType >          OutputIteratorType;
 
   typedef Vector< InputCoordType, 1 >         VectorType;
   typedef Image< VectorType, ImageDimension > VectorImageType;
@@ -137,29 +138,33 @@ public:
 
   typedef Image< InputCoordType, ImageDimension > CoordImageType;
   typedef typename CoordImageType::Pointer        CoordImagePointer;
-  typedef VectorIndexSelectionCastImageFilter< VectorImageType,
-    OutputImageType > IndexFilterType;
-  typedef typename IndexFilterType::Pointer IndexFilterPointer;
 
-  /** Set the radius of the neighborhood used to compute the median. */
-  itkSetMacro( Radius, InputSizeType );
+  typedef std::vector< double >                   HistogramContainerType;
+
+  /** Set the size of the windows in which the local Otsu thresholds are
+   * computed. Changing it invalidates the cached threshold surface.
+   */
+  void SetRadius( const InputSizeType & radius );
 
-  /** Get the radius of the neighborhood used to compute the median */
+  /** Get the size of the windows in which the local Otsu thresholds are computed. */
   itkGetConstReferenceMacro( Radius, InputSizeType );
 
-  itkSetMacro( NumberOfHistogramBins, unsigned int );
+  /** Setters of the parameters that determine the threshold surface. Changing
+   * any of them invalidates the cached threshold surface.
+   */
+  void SetNumberOfHistogramBins( unsigned int bins );
   itkGetConstMacro( NumberOfHistogramBins, unsigned int );
 
-  itkSetMacro( NumberOfControlPoints, unsigned int );
+  void SetNumberOfControlPoints( unsigned int controlPoints );
   itkGetConstMacro( NumberOfControlPoints, unsigned int );
 
-  itkSetMacro(NumberOfLevels, unsigned int);
+  void SetNumberOfLevels( unsigned int levels );
   itkGetConstMacro(NumberOfLevels, unsigned int);
 
-  itkSetMacro(NumberOfSamples, unsigned int);
+  void SetNumberOfSamples( unsigned int samples );
   itkGetConstMacro(NumberOfSamples, unsigned int);
 
-  itkSetMacro(SplineOrder, unsigned int);
+  void SetSplineOrder( unsigned int order );
   itkGetConstMacro(SplineOrder, unsigned int);
 
   itkSetMacro(OutsideValue, OutputPixelType);
@@ -168,14 +173,23 @@ public:
   itkSetMacro(InsideValue, OutputPixelType);
   itkGetConstReferenceMacro(InsideValue, OutputPixelType);
 
-  OutputImagePointer GetThresholdImage()
+  /** The threshold surface, in real values so that thresholds of
+   * floating point inputs are not rounded to the output pixel type.
+   */
+  CoordImagePointer GetThresholdImage()
     {
     return this->m_Threshold;
     }
 
+  /** Set the window positions. If not set, NumberOfSamples random
+   * positions are drawn.
+   */
   void SetPointSet( PointSetPointer pt )
     {
     this->m_PointSet = pt;
+    this->m_UserPointSet = pt.IsNotNull();
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
     }
 
 protected:
@@ -183,9 +197,41 @@ protected:
   AdaptiveOtsuThresholdImageFilter();
   ~AdaptiveOtsuThresholdImageFilter() {}
 
+  /** The whole input is needed and the whole output is produced. */
+  void GenerateInputRequestedRegion();
+  void EnlargeOutputRequestedRegion( DataObject * output );
+
   void ComputeRandomPointSet();
   void GenerateData();
 
+  /** Compute the local thresholds of the samples [begin, end) using the
+   * given histogram buffer.
+   */
+  void ComputeSampleThresholds( unsigned long begin, unsigned long end,
+    HistogramContainerType & frequency );
+
+  /** Otsu threshold of the input in the given window, computed the same
+   * way as OtsuThresholdWithMaskImageCalculator does.
+   */
+  InputCoordType ComputeWindowThreshold( const InputImageRegionType & window,
+    HistogramContainerType & frequency ) const;
+
+  /** Threshold the input in the given region. If a surface is given, the
+   * threshold image is filled from it in the same pass; otherwise the
+   * cached threshold image is used.
+   */
+  void ThreadedThreshold( const OutputImageRegionType & region,
+    const VectorImageType * surface );
+
+  /** Static thread callbacks for the sample loop and the threshold pass. */
+  struct AdaptiveOtsuThreadStruct
+    {
+    Self *                  Filter;
+    const VectorImageType * Surface;
+    };
+  static ITK_THREAD_RETURN_TYPE SampleThreaderCallback( void * arg );
+  static ITK_THREAD_RETURN_TYPE ThresholdThreaderCallback( void * arg );
+
   InputSizeType m_Radius;
   unsigned int m_NumberOfHistogramBins;
   unsigned int m_NumberOfControlPoints;
@@ -196,7 +242,17 @@ protected:
   OutputPixelType m_InsideValue;
 
   PointSetPointer m_PointSet;
-  OutputImagePointer m_Threshold;
+  bool m_UserPointSet;
+  CoordImagePointer m_Threshold;
+
+  /** Modified when a parameter of the threshold surface changes, and
+   * when the surface was last computed.
+   */
+  TimeStamp m_SurfaceParametersTime;
+  TimeStamp m_SurfaceTime;
+
+  /** One histogram per thread, reused for all its samples. */
+  std::vector< HistogramContainerType > m_ThreadHistograms;
 
 private:
 
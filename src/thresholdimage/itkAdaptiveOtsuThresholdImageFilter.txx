@@ -42,6 +42,10 @@
 #define __itkAdaptiveOtsuThresholdImageFilter_txx
 
 #include "itkAdaptiveOtsuThresholdImageFilter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "vnl/vnl_math.h"
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -60,12 +64,120 @@ AdaptiveOtsuThresholdImageFilter()
   this->m_InsideValue = 1;
 
   this->m_PointSet = NULL;
+  this->m_UserPointSet = false;
+  this->m_Threshold = NULL;
 
   this->Superclass::SetNumberOfRequiredInputs( 1 );
   this->Superclass::SetNumberOfRequiredOutputs( 1 );
   this->Superclass::SetNthOutput( 0, OutputImageType::New() );
 }
 
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetRadius( const InputSizeType & radius )
+{
+  if( radius != this->m_Radius )
+    {
+    this->m_Radius = radius;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetNumberOfHistogramBins( unsigned int bins )
+{
+  if( bins != this->m_NumberOfHistogramBins )
+    {
+    this->m_NumberOfHistogramBins = bins;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetNumberOfControlPoints( unsigned int controlPoints )
+{
+  if( controlPoints != this->m_NumberOfControlPoints )
+    {
+    this->m_NumberOfControlPoints = controlPoints;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetNumberOfLevels( unsigned int levels )
+{
+  if( levels != this->m_NumberOfLevels )
+    {
+    this->m_NumberOfLevels = levels;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetNumberOfSamples( unsigned int samples )
+{
+  if( samples != this->m_NumberOfSamples )
+    {
+    this->m_NumberOfSamples = samples;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SetSplineOrder( unsigned int order )
+{
+  if( order != this->m_SplineOrder )
+    {
+    this->m_SplineOrder = order;
+    this->m_SurfaceParametersTime.Modified();
+    this->Modified();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::GenerateInputRequestedRegion()
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  InputImagePointer input = const_cast< InputImageType * >( this->GetInput() );
+  if( input )
+    {
+    input->SetRequestedRegionToLargestPossibleRegion();
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::EnlargeOutputRequestedRegion( DataObject * output )
+{
+  Superclass::EnlargeOutputRequestedRegion( output );
+  output->SetRequestedRegionToLargestPossibleRegion();
+}
+
+/** Draws the window start indices directly, uniformly over the positions
+ * where a whole window fits. Unlike a non-repeating random iterator this
+ * does not need a permutation of all pixels, which is prohibitive for
+ * large images.
+ */
 template< class TInputImage, class TOutputImage >
 void
 AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
@@ -74,14 +186,23 @@ AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
   InputConstImagePointer input  = this->GetInput();
   InputImageRegionType inputRegion = input->GetLargestPossibleRegion();
   InputSizeType inputSize = inputRegion.GetSize();
+  InputIndexType inputIndex = inputRegion.GetIndex();
 
-  InputIndexType startIndex, endIndex;
+  InputIndexType startIndex;
   PointSetPointType point;
 
-  // Find a random number generator
-  RandomIteratorType rIt( input, inputRegion );
-  rIt.SetNumberOfSamples( this->m_NumberOfSamples );
-  rIt.GoToBegin();
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  typename GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 121212 );
+
+  /** The largest start index offset for which the window fits. */
+  InputSizeType maxOffset;
+  for( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    const SizeValueType windowSize = std::max< SizeValueType >( 1,
+      std::min( this->m_Radius[j], inputSize[j] ) );
+    maxOffset[j] = inputSize[j] - windowSize;
+    }
 
   this->m_PointSet = PointSetType::New();
   PointsContainerPointer
@@ -93,124 +214,347 @@ AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
   pointdatacontainer->Reserve( this->m_NumberOfSamples );
   this->m_PointSet->SetPointData( pointdatacontainer );
 
-  unsigned long i = 0;
+  for( unsigned long i = 0; i < this->m_NumberOfSamples; i++ )
+    {
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      startIndex[j] = inputIndex[j] + static_cast< InputIndexValueType >(
+        generator->GetIntegerVariate( maxOffset[j] ) );
+      }
+
+    input->TransformIndexToPhysicalPoint( startIndex, point );
+
+    pointscontainer->SetElement( i, point );
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+typename AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>::InputCoordType
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::ComputeWindowThreshold( const InputImageRegionType & window,
+  HistogramContainerType & frequency ) const
+{
+  const unsigned int numberOfBins = this->m_NumberOfHistogramBins;
+  InputIteratorType it( this->GetInput(), window );
 
-  while( !rIt.IsAtEnd() )
+  // compute the window max and min
+  InputPixelType windowMin = NumericTraits<InputPixelType>::max();
+  InputPixelType windowMax = NumericTraits<InputPixelType>::NonpositiveMin();
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
     {
-    startIndex = rIt.GetIndex();
+    const InputPixelType current = it.Value();
+    windowMin = windowMin > current ? current : windowMin;
+    windowMax = windowMax < current ? current : windowMax;
+    }
 
-    for( unsigned int j = 0; j < ImageDimension; j++ )
+  if( windowMin >= windowMax || numberOfBins == 0 )
+    {
+    return static_cast<InputCoordType>( windowMin );
+    }
+
+  // fill the reused histogram
+  std::fill( frequency.begin(), frequency.end(), 0.0 );
+  const double binMultiplier = static_cast<double>( numberOfBins )
+    / ( static_cast<double>( windowMax ) - static_cast<double>( windowMin ) );
+  double totalPixels = 0.0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const InputPixelType value = it.Value();
+    unsigned int binNumber = 0;
+    if( value != windowMin )
       {
-      endIndex[j] = startIndex[j] + this->m_Radius[j] - 1;
-      if( endIndex[j] >= static_cast< InputIndexValueType >( inputSize[j] ) )
+      binNumber = static_cast<unsigned int>( std::ceil(
+        ( static_cast<double>( value ) - static_cast<double>( windowMin ) )
+        * binMultiplier ) ) - 1;
+      if( binNumber >= numberOfBins ) // in case of rounding errors
         {
-          startIndex[j] = inputSize[j] - this->m_Radius[j];
+        binNumber = numberOfBins - 1;
         }
       }
+    frequency[ binNumber ] += 1.0;
+    totalPixels += 1.0;
+    }
 
-    input->TransformIndexToPhysicalPoint( startIndex, point );
+  // normalize the frequencies
+  double totalMean = 0.0;
+  for( unsigned int j = 0; j < numberOfBins; j++ )
+    {
+    frequency[j] /= totalPixels;
+    totalMean += ( j + 1 ) * frequency[j];
+    }
 
-    pointscontainer->SetElement( i, point );
+  // compute Otsu's threshold by maximizing the between-class variance
+  double freqLeft = frequency[0];
+  double meanLeft = 1.0;
+  double meanRight = ( totalMean - freqLeft ) / ( 1.0 - freqLeft );
+  double maxVarBetween = freqLeft * ( 1.0 - freqLeft )
+    * vnl_math_sqr( meanLeft - meanRight );
+  unsigned int maxBinNumber = 0;
+
+  double freqLeftOld = freqLeft;
+  double meanLeftOld = meanLeft;
+  for( unsigned int j = 1; j < numberOfBins; j++ )
+    {
+    freqLeft += frequency[j];
+    meanLeft = ( meanLeftOld * freqLeftOld + ( j + 1 ) * frequency[j] ) / freqLeft;
+    if( freqLeft == 1.0 )
+      {
+      meanRight = 0.0;
+      }
+    else
+      {
+      meanRight = ( totalMean - meanLeft * freqLeft ) / ( 1.0 - freqLeft );
+      }
+    const double varBetween = freqLeft * ( 1.0 - freqLeft )
+      * vnl_math_sqr( meanLeft - meanRight );
 
-    i++;
-    ++rIt;
+    if( varBetween > maxVarBetween )
+      {
+      maxVarBetween = varBetween;
+      maxBinNumber = j;
+      }
+
+    freqLeftOld = freqLeft;
+    meanLeftOld = meanLeft;
     }
+
+  return static_cast<InputCoordType>( static_cast<InputPixelType>(
+    static_cast<double>( windowMin ) + ( maxBinNumber + 1 ) / binMultiplier ) );
 }
 
 template< class TInputImage, class TOutputImage >
 void
 AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
-::GenerateData()
+::ComputeSampleThresholds( unsigned long begin, unsigned long end,
+  HistogramContainerType & frequency )
 {
-  // Allocate output
-  this->AllocateOutputs();
-  this->GetOutput()->FillBuffer( 0 );
-
-  OutputImagePointer output = this->GetOutput();
   InputConstImagePointer input  = this->GetInput();
-  InputImageRegionType inputRegion = input->GetLargestPossibleRegion();
-  InputSizeType inputSize = inputRegion.GetSize();
+  const InputImageRegionType inputRegion = input->GetLargestPossibleRegion();
+  const InputSizeType inputSize = inputRegion.GetSize();
+  const InputIndexType inputIndex = inputRegion.GetIndex();
 
-  InputIndexType startIndex;
-  InputImageRegionType region;
-  region.SetSize( this->m_Radius );
+  InputImageRegionType window;
+  InputSizeType windowSize;
+  for( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    windowSize[j] = std::max< SizeValueType >( 1,
+      std::min( this->m_Radius[j], inputSize[j] ) );
+    }
+  window.SetSize( windowSize );
 
-  PointSetPointType point;
+  PointsContainerPointer pointscontainer = this->m_PointSet->GetPoints();
+  typename PointDataContainer::STLContainerType & pointdata
+    = this->m_PointSet->GetPointData()->CastToSTLContainer();
+
+  InputIndexType startIndex;
   VectorPixelType V;
+  for( unsigned long i = begin; i < end; i++ )
+    {
+    input->TransformPhysicalPointToIndex( pointscontainer->GetElement( i ), startIndex );
+
+    /** Keep the window inside the image. */
+    for( unsigned int j = 0; j < ImageDimension; j++ )
+      {
+      const InputIndexValueType maxStart = inputIndex[j]
+        + static_cast< InputIndexValueType >( inputSize[j] - windowSize[j] );
+      startIndex[j] = std::max( inputIndex[j], std::min( maxStart, startIndex[j] ) );
+      }
+    window.SetIndex( startIndex );
+
+    V[0] = this->ComputeWindowThreshold( window, frequency );
+    pointdata[ i ] = V;
+    }
+}
 
-  if( !m_PointSet )
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::SampleThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  AdaptiveOtsuThreadStruct * str
+    = static_cast<AdaptiveOtsuThreadStruct *>( info->UserData );
+
+  /** Every thread takes a contiguous block of samples. */
+  const unsigned long numberOfSamples
+    = str->Filter->m_PointSet->GetNumberOfPoints();
+  const unsigned long begin = ( numberOfSamples * threadId ) / threadCount;
+  const unsigned long end = ( numberOfSamples * ( threadId + 1 ) ) / threadCount;
+  str->Filter->ComputeSampleThresholds( begin, end,
+    str->Filter->m_ThreadHistograms[ threadId ] );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::ThresholdThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+  AdaptiveOtsuThreadStruct * str
+    = static_cast<AdaptiveOtsuThreadStruct *>( info->UserData );
+
+  OutputImageRegionType splitRegion;
+  const ThreadIdType total = str->Filter->SplitRequestedRegion(
+    threadId, threadCount, splitRegion );
+  if( threadId < total )
     {
-    ComputeRandomPointSet();
+    str->Filter->ThreadedThreshold( splitRegion, str->Surface );
     }
 
-  PointsContainerPointer
-    pointscontainer = this->m_PointSet->GetPoints();
-  PointDataContainerPointer pointdatacontainer =  this->m_PointSet->GetPointData();
-  for( unsigned long i = 0; i < this->m_NumberOfSamples; i++ )
-  {
-    point = pointscontainer->GetElement( i );
-    input->TransformPhysicalPointToIndex( point, startIndex );
-    region.SetIndex( startIndex );
-
-    ROIFilterPointer roi = ROIFilterType::New();
-    roi->SetInput( input );
-    roi->SetRegionOfInterest( region );
-    roi->Update();
-
-    OtsuThresholdPointer otsu = OtsuThresholdType::New();
-    otsu->SetImage( roi->GetOutput() );
-    otsu->SetNumberOfHistogramBins( this->m_NumberOfHistogramBins);
-    otsu->Compute();
-
-    V[0] = static_cast<InputCoordType>( otsu->GetThreshold() );
-    pointdatacontainer->SetElement( i, V );
-  }
-
-  typename SDAFilterType::ArrayType ncps;
-  ncps.Fill( this->m_NumberOfControlPoints );
-
-  SDAFilterPointer filter = SDAFilterType::New();
-  filter->SetSplineOrder( this->m_SplineOrder );
-  filter->SetNumberOfControlPoints( ncps );
-  filter->SetNumberOfLevels( this->m_NumberOfLevels );
-
-  // Define the parametric domain.
-  filter->SetOrigin( input->GetOrigin() );
-  filter->SetSpacing( input->GetSpacing() );
-  filter->SetSize( inputRegion.GetSize() );
-  filter->SetInput( this->m_PointSet );
-  filter->Update();
-
-  IndexFilterPointer componentExtractor = IndexFilterType::New();
-  componentExtractor->SetInput( filter->GetOutput() );
-  componentExtractor->SetIndex( 0 );
-  componentExtractor->Update();
-  this->m_Threshold = componentExtractor->GetOutput();
-
-  OutputIteratorType Itt( this->m_Threshold, inputRegion );
-  Itt.GoToBegin();
-
-  OutputIteratorType oIt( output, inputRegion );
-  oIt.GoToBegin();
-
-  InputIteratorType iIt( input, inputRegion );
-  iIt.GoToBegin();
-
-  OutputPixelType p;
-  while( !Itt.IsAtEnd() )
-    {
-    p = Itt.Get();
-    if( p < iIt.Get() )
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::ThreadedThreshold( const OutputImageRegionType & region,
+  const VectorImageType * surface )
+{
+  InputIteratorType iIt( this->GetInput(), region );
+  OutputIteratorType oIt( this->GetOutput(), region );
+  ImageRegionIterator< CoordImageType > Itt( this->m_Threshold, region );
+
+  InputCoordType p;
+  if( surface )
+    {
+    /** The surface starts at index zero, at the start of the input. */
+    const InputIndexType inputIndex
+      = this->GetInput()->GetLargestPossibleRegion().GetIndex();
+    typename VectorImageType::RegionType surfaceRegion;
+    typename VectorImageType::IndexType surfaceIndex;
+    for( unsigned int j = 0; j < ImageDimension; j++ )
       {
-      oIt.Set( this->m_InsideValue  );
+      surfaceIndex[j] = region.GetIndex()[j] - inputIndex[j];
       }
-    else
+    surfaceRegion.SetIndex( surfaceIndex );
+    surfaceRegion.SetSize( region.GetSize() );
+
+    ImageRegionConstIterator< VectorImageType > sIt( surface, surfaceRegion );
+    while( !oIt.IsAtEnd() )
+      {
+      p = sIt.Value()[0];
+      Itt.Set( p );
+      oIt.Set( p < static_cast<InputCoordType>( iIt.Get() )
+        ? this->m_InsideValue : this->m_OutsideValue );
+      ++sIt;
+      ++Itt;
+      ++oIt;
+      ++iIt;
+      }
+    }
+  else
+    {
+    while( !oIt.IsAtEnd() )
       {
-      oIt.Set( this->m_OutsideValue );
+      p = Itt.Get();
+      oIt.Set( p < static_cast<InputCoordType>( iIt.Get() )
+        ? this->m_InsideValue : this->m_OutsideValue );
+      ++Itt;
+      ++oIt;
+      ++iIt;
       }
-    ++Itt;
-    ++oIt;
-    ++iIt;
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+AdaptiveOtsuThresholdImageFilter<TInputImage, TOutputImage>
+::GenerateData()
+{
+  // Allocate output
+  this->AllocateOutputs();
+
+  InputConstImagePointer input  = this->GetInput();
+  InputImageRegionType inputRegion = input->GetLargestPossibleRegion();
+
+  /** The cached surface is reused as long as the input and the surface
+   * parameters did not change; a new inside or outside value only needs
+   * the threshold pass.
+   */
+  const unsigned long surfaceTime = this->m_SurfaceTime.GetMTime();
+  const bool surfaceIsValid = this->m_Threshold.IsNotNull()
+    && this->m_Threshold->GetBufferedRegion() == inputRegion
+    && surfaceTime > this->m_SurfaceParametersTime.GetMTime()
+    && surfaceTime > input->GetMTime()
+    && surfaceTime > input->GetUpdateMTime()
+    && ( !this->m_UserPointSet || surfaceTime > this->m_PointSet->GetMTime() );
+
+  AdaptiveOtsuThreadStruct str;
+  str.Filter = this;
+  str.Surface = NULL;
+
+  SDAFilterPointer filter;
+  if( !surfaceIsValid )
+    {
+    if( !this->m_UserPointSet )
+      {
+      this->ComputeRandomPointSet();
+      }
+    const unsigned long numberOfSamples = this->m_PointSet->GetNumberOfPoints();
+    if( this->m_PointSet->GetPointData() == NULL
+      || this->m_PointSet->GetPointData()->Size() != numberOfSamples )
+      {
+      PointDataContainerPointer pointdatacontainer = PointDataContainer::New();
+      pointdatacontainer->Reserve( numberOfSamples );
+      this->m_PointSet->SetPointData( pointdatacontainer );
+      }
+
+    /** Compute the local Otsu thresholds in parallel. */
+    const ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+    this->m_ThreadHistograms.resize( numberOfThreads );
+    for( ThreadIdType t = 0; t < numberOfThreads; t++ )
+      {
+      this->m_ThreadHistograms[ t ].resize( this->m_NumberOfHistogramBins );
+      }
+    this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+    this->GetMultiThreader()->SetSingleMethod( this->SampleThreaderCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+
+    /** Fit the threshold surface. */
+    typename SDAFilterType::ArrayType ncps;
+    ncps.Fill( this->m_NumberOfControlPoints );
+
+    filter = SDAFilterType::New();
+    filter->SetSplineOrder( this->m_SplineOrder );
+    filter->SetNumberOfControlPoints( ncps );
+    filter->SetNumberOfLevels( this->m_NumberOfLevels );
+
+    // Define the parametric domain, which starts at the first pixel.
+    InputPointType domainOrigin;
+    input->TransformIndexToPhysicalPoint( inputRegion.GetIndex(), domainOrigin );
+    filter->SetOrigin( domainOrigin );
+    filter->SetSpacing( input->GetSpacing() );
+    filter->SetSize( inputRegion.GetSize() );
+    filter->SetInput( this->m_PointSet );
+    filter->Update();
+    str.Surface = filter->GetOutput();
+
+    this->m_Threshold = CoordImageType::New();
+    this->m_Threshold->SetRegions( inputRegion );
+    this->m_Threshold->SetOrigin( input->GetOrigin() );
+    this->m_Threshold->SetSpacing( input->GetSpacing() );
+    this->m_Threshold->SetDirection( input->GetDirection() );
+    this->m_Threshold->Allocate();
+    }
+
+  /** Fill the threshold image from the surface, if needed, and threshold
+   * the input in one threaded pass.
+   */
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod( this->ThresholdThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  if( !surfaceIsValid )
+    {
+    this->m_SurfaceTime.Modified();
     }
 }
 
@@ -230,9 +230,11 @@ int main( int argc, char **argv )
 
     /** Set the filter arguments. */
     filter->m_Bins = bins;
+    filter->m_ControlPoints = controlPoints;
     filter->m_InputFileName = inputFileName;
     filter->m_Inside = inside;
     filter->m_Iterations = iterations;
+    filter->m_Levels = levels;
     filter->m_MaskFileName = maskFileName;
     filter->m_MaskValue = maskValue;
     filter->m_Method = method;
@@ -241,7 +243,10 @@ int main( int argc, char **argv )
     filter->m_OutputFileName = outputFileName;
     filter->m_Outside = outside;
     filter->m_Pow = pow;
+    filter->m_Radius = radius;
+    filter->m_Samples = samples;
     filter->m_Sigma = sigma;
+    filter->m_SplineOrder = splineOrder;
     filter->m_Threshold1 = threshold1;
     filter->m_Threshold2 = threshold2;
     filter->m_UseCompression = useCompression;
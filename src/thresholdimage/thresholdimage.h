@@ -36,9 +36,11 @@ public:
   ITKToolsThresholdImageBase()
   {
     this->m_Bins = 0;
+    this->m_ControlPoints = 0;
     this->m_InputFileName = "";
     this->m_Inside = 0.0f;
     this->m_Iterations = 0;
+    this->m_Levels = 0;
     this->m_MaskFileName = "";
     this->m_MaskValue = 0;
     this->m_Method = "";
@@ -47,7 +49,10 @@ public:
     this->m_OutputFileName = "";
     this->m_Outside = 0.0f;
     this->m_Pow = 0.0f;
+    this->m_Radius = 0;
+    this->m_Samples = 0;
     this->m_Sigma = 0.0f;
+    this->m_SplineOrder = 0;
     this->m_Supported = false;
     this->m_Threshold1 = 0.0f;
     this->m_Threshold2 = 0.0f;
@@ -73,6 +78,11 @@ public:
   unsigned int  m_Iterations;
   unsigned int  m_MaskValue;
   unsigned int  m_MixtureType;
+  unsigned int  m_Radius;
+  unsigned int  m_ControlPoints;
+  unsigned int  m_Levels;
+  unsigned int  m_Samples;
+  unsigned int  m_SplineOrder;
 
   double        m_Pow;
   double        m_Sigma;
@@ -129,6 +139,16 @@ public:
         this->m_Bins, this->m_NumThresholds,
         this->m_UseCompression );
     }
+    else if( this->m_Method == "AdaptiveOtsuThreshold" )
+    {
+      this->AdaptiveOtsuThresholdImage(
+        this->m_InputFileName, this->m_OutputFileName,
+        this->m_Inside, this->m_Outside,
+        this->m_Radius, this->m_Bins,
+        this->m_ControlPoints, this->m_Levels,
+        this->m_Samples, this->m_SplineOrder,
+        this->m_UseCompression );
+    }
     else if( this->m_Method == "RobustAutomaticThreshold" )
     {
       this->RobustAutomaticThresholdImage(
@@ -184,11 +204,13 @@ public:
     const bool & useCompression );
 
   /** Function to perform Otsu thresholding with an adaptive threshold. */
-//   void AdaptiveOtsuThresholdImage(
-//     const std::string & inputFileName, const std::string & outputFileName,
-//     const unsigned int & radius, const unsigned int & bins,
-//     const unsigned int & controlPoints, const unsigned int & levels,
-//     const unsigned int & samples, const unsigned int & splineOrder );
+  void AdaptiveOtsuThresholdImage(
+    const std::string & inputFileName, const std::string & outputFileName,
+    const double & inside, const double & outside,
+    const unsigned int & radius, const unsigned int & bins,
+    const unsigned int & controlPoints, const unsigned int & levels,
+    const unsigned int & samples, const unsigned int & splineOrder,
+    const bool & useCompression );
 
   /** Function to perform thresholding using .. . */
   void RobustAutomaticThresholdImage(
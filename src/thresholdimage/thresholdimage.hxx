@@ -204,60 +204,61 @@ ITKToolsThresholdImage< VDimension, TComponentType >
 } // end OtsuMultipleThresholdImage()
 
 
-// /**
-//  * ******************* AdaptiveOtsuThresholdImage *******************
-//  */
-//
-// template< unsigned int VDimension, class TComponentType >
-// void
-// ITKToolsThresholdImage< VDimension, TComponentType >
-// ::AdaptiveOtsuThresholdImage(
-//   const std::string & inputFileName,
-//   const std::string & outputFileName,
-//   const unsigned int & radius,
-//   const unsigned int & bins,
-//   const unsigned int & controlPoints,
-//   const unsigned int & levels,
-//   const unsigned int & samples,
-//   const unsigned int & splineOrder )
-// {
-//   /** Typedef's. */
-//   const unsigned int ImageDimension = InputImageType::ImageDimension;
-//
-//   typedef unsigned char                                 OutputPixelType;
-//   typedef itk::Image< OutputPixelType, ImageDimension > OutputImageType;
-//   typedef itk::ImageFileReader< InputImageType >        ReaderType;
-//   typedef itk::AdaptiveOtsuThresholdImageFilter<
-//     InputImageType, OutputImageType>                    ThresholderType;
-//   typedef itk::ImageFileWriter< OutputImageType >       WriterType;
-//   typedef ThresholderType::InputSizeType                RadiusType;
-//
-//   /** Declarations. */
-//   typename ReaderType::Pointer reader = ReaderType::New();
-//   typename ThresholderType::Pointer thresholder = ThresholderType::New();
-//   typename WriterType::Pointer writer = WriterType::New();
-//   RadiusType Radius; Radius.Fill( radius );
-//
-//   /** Read in the inputImage. */
-//   reader->SetFileName( inputFileName.c_str() );
-//
-//   /** Apply the threshold. */
-//   thresholder->SetRadius( Radius );
-//   thresholder->SetNumberOfHistogramBins( bins );
-//   thresholder->SetNumberOfControlPoints( controlPoints );
-//   thresholder->SetNumberOfLevels( levels );
-//   thresholder->SetNumberOfSamples( samples );
-//   thresholder->SetSplineOrder( splineOrder );
-//   thresholder->SetInsideValue( 1 );
-//   thresholder->SetOutsideValue( 0 );
-//   thresholder->SetInput( reader->GetOutput() );
-//
-//   /** Write the output image. */
-//   writer->SetInput( thresholder->GetOutput() );
-//   writer->SetFileName( outputFileName.c_str() );
-//   writer->Update();
-//
-// } // end AdaptiveOtsuThresholdImage()
+/**
+ * ******************* AdaptiveOtsuThresholdImage *******************
+ */
+
+template< unsigned int VDimension, class TComponentType >
+void
+ITKToolsThresholdImage< VDimension, TComponentType >
+::AdaptiveOtsuThresholdImage(
+  const std::string & inputFileName,
+  const std::string & outputFileName,
+  const double & inside,
+  const double & outside,
+  const unsigned int & radius,
+  const unsigned int & bins,
+  const unsigned int & controlPoints,
+  const unsigned int & levels,
+  const unsigned int & samples,
+  const unsigned int & splineOrder,
+  const bool & useCompression )
+{
+  /** Typedef's. */
+  typedef itk::ImageFileReader< InputImageType >        ReaderType;
+  typedef itk::AdaptiveOtsuThresholdImageFilter<
+    InputImageType, InputImageType>                     ThresholderType;
+  typedef itk::ImageFileWriter< InputImageType >        WriterType;
+  typedef typename ThresholderType::InputSizeType       RadiusType;
+  typedef typename InputImageType::PixelType            InputPixelType;
+
+  /** Declarations. */
+  typename ReaderType::Pointer reader = ReaderType::New();
+  typename ThresholderType::Pointer thresholder = ThresholderType::New();
+  typename WriterType::Pointer writer = WriterType::New();
+  RadiusType Radius; Radius.Fill( radius );
+
+  /** Read in the inputImage. */
+  reader->SetFileName( inputFileName.c_str() );
+
+  /** Apply the threshold. */
+  thresholder->SetRadius( Radius );
+  thresholder->SetNumberOfHistogramBins( bins );
+  thresholder->SetNumberOfControlPoints( controlPoints );
+  thresholder->SetNumberOfLevels( levels );
+  thresholder->SetNumberOfSamples( samples );
+  thresholder->SetSplineOrder( splineOrder );
+  thresholder->SetInsideValue( static_cast<InputPixelType>( inside ) );
+  thresholder->SetOutsideValue( static_cast<InputPixelType>( outside ) );
+  thresholder->SetInput( reader->GetOutput() );
+
+  /** Write the output image. */
+  writer->SetInput( thresholder->GetOutput() );
+  writer->SetFileName( outputFileName.c_str() );
+  writer->SetUseCompression( useCompression );
+  writer->Update();
+
+} // end AdaptiveOtsuThresholdImage()
 
 
 /**
@@ -0,0 +1,220 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkVoxelwiseTTestCalculator_h_
+#define __itkVoxelwiseTTestCalculator_h_
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkMultiThreader.h"
+#include <vector>
+
+
+namespace itk {
+
+/** \class VoxelwiseTTestCalculator
+ * \brief Computes a voxelwise t-test between two groups of co-registered
+ * images, with optional permutation testing.
+ *
+ * The tests are those of pxttest:
+ * - Paired: the images of group 1 and group 2 are paired in order, and the
+ *   differences are tested, with n - 1 degrees of freedom.
+ * - EqualVariance: the two-sample test with pooled variance, n1 + n2 - 2
+ *   degrees of freedom.
+ * - UnequalVariance: Welch's test. The Welch-Satterthwaite degrees of
+ *   freedom are rounded down, since TDistribution takes an integer.
+ * The parametric p-value follows from TDistribution, one or two tailed;
+ * one tailed in the direction of the observed t, as pxttest does. Voxels
+ * without variance get t = 0.
+ *
+ * All subject images are requested piece by piece from the upstream
+ * pipeline. For every piece the values of all subjects are gathered in a
+ * block, voxel by voxel, shifted by the first subject to keep the sums of
+ * squares accurate. The sums and sums of squares of a voxel are the
+ * sufficient statistics of the test; a relabeling only changes the sums
+ * of group 1, or for the paired test the signs of the differences.
+ *
+ * If NumberOfPermutations is nonzero, that many random relabelings are
+ * drawn once, and applied to all voxels: random subsets of size n1 for the
+ * two-sample tests, and random sign flips for the paired test. They are
+ * drawn in order from a single MersenneTwister stream seeded with Seed,
+ * so the results do not depend on the number of threads; drawing is cheap
+ * compared to applying them. Two permutation p-values are computed, both
+ * counting the observed labeling as one of the relabelings:
+ * - uncorrected: the fraction of relabelings with a t at least as extreme
+ *   as the observed t in that voxel;
+ * - corrected for the family-wise error: the fraction of relabelings of
+ *   which the most extreme t over the whole image is at least as extreme.
+ * The voxels of a piece are split over the threads; each thread keeps the
+ * extreme t per relabeling, which are merged afterwards.
+ */
+
+template< class TInputImage, class TOutputImage >
+class VoxelwiseTTestCalculator : public Object
+{
+public:
+  /** Standard typedefs */
+  typedef VoxelwiseTTestCalculator    Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( VoxelwiseTTestCalculator, Object );
+
+  /** standard New() method support */
+  itkNewMacro( Self );
+
+  /** Dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                               InputImageType;
+  typedef typename InputImageType::Pointer          InputImagePointer;
+  typedef typename InputImageType::RegionType       RegionType;
+  typedef TOutputImage                              OutputImageType;
+  typedef typename OutputImageType::Pointer         OutputImagePointer;
+  typedef typename OutputImageType::PixelType       OutputPixelType;
+
+  /** The tests of pxttest. */
+  enum TestType { Paired = 1, EqualVariance = 2, UnequalVariance = 3 };
+
+  /** Add a subject image to group 1 or 2. The images are not const, since
+   * requested regions are set on them to drive the upstream pipeline.
+   */
+  void AddInput( InputImageType * image, unsigned int group );
+
+  /** Select the test. */
+  itkSetMacro( Test, unsigned int );
+  itkGetConstMacro( Test, unsigned int );
+
+  /** Select a one or two tailed test. */
+  itkSetMacro( NumberOfTails, unsigned int );
+  itkGetConstMacro( NumberOfTails, unsigned int );
+
+  /** Set the number of relabelings; 0 means no permutation test. */
+  itkSetMacro( NumberOfPermutations, unsigned int );
+  itkGetConstMacro( NumberOfPermutations, unsigned int );
+
+  /** Set the seed of the random relabelings. */
+  itkSetMacro( Seed, unsigned int );
+  itkGetConstMacro( Seed, unsigned int );
+
+  /** Set the number of pieces in which the images are processed. */
+  itkSetMacro( NumberOfStreamDivisions, unsigned int );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
+  /** Set the number of threads. */
+  itkSetMacro( NumberOfThreads, unsigned int );
+  itkGetConstMacro( NumberOfThreads, unsigned int );
+
+  /** Triggers the computation; this is the only pass over the images. */
+  void Compute( void );
+
+  /** The t-map and the parametric p-map. Valid after Compute(). */
+  OutputImageType * GetTImage( void )
+  { return this->m_TImage.GetPointer(); }
+  OutputImageType * GetPImage( void )
+  { return this->m_PImage.GetPointer(); }
+
+  /** The uncorrected and the corrected permutation p-maps. Only valid
+   * after Compute() with a nonzero NumberOfPermutations.
+   */
+  OutputImageType * GetPermutationPImage( void )
+  { return this->m_PermutationPImage.GetPointer(); }
+  OutputImageType * GetCorrectedPermutationPImage( void )
+  { return this->m_CorrectedPermutationPImage.GetPointer(); }
+
+  /** The t value of a test from the sums and sums of squares of both
+   * groups. For the paired test only group 1, the differences, is used.
+   * Returns 0 without variance.
+   */
+  static double ComputeTValue( unsigned int test,
+    double sum1, double sumOfSquares1, double n1,
+    double sum2, double sumOfSquares2, double n2,
+    double & degreesOfFreedom );
+
+protected:
+  VoxelwiseTTestCalculator();
+  virtual ~VoxelwiseTTestCalculator() {};
+  void PrintSelf( std::ostream& os, Indent indent ) const;
+
+  /** Draw the relabelings. */
+  void DrawRelabelings( void );
+
+  /** Test the voxels of a part of the current block. */
+  void ThreadedTestBlock( ThreadIdType threadId, ThreadIdType numberOfThreads );
+
+  /** Gather the values of all subjects in the piece in the block. */
+  void GatherBlock( const RegionType & piece );
+
+  /** Write the results of the block in the output images. */
+  void ScatterBlock( const RegionType & piece );
+
+private:
+  VoxelwiseTTestCalculator( const Self& ); //purposely not implemented
+  void operator=( const Self& ); //purposely not implemented
+
+  /** Callbacks for the multithreader. */
+  static ITK_THREAD_RETURN_TYPE TestBlockThreaderCallback( void * arg );
+
+  std::vector<InputImagePointer>  m_Group1;
+  std::vector<InputImagePointer>  m_Group2;
+  unsigned int                    m_Test;
+  unsigned int                    m_NumberOfTails;
+  unsigned int                    m_NumberOfPermutations;
+  unsigned int                    m_Seed;
+  unsigned int                    m_NumberOfStreamDivisions;
+  unsigned int                    m_NumberOfThreads;
+
+  /** The relabelings: per relabeling one weight per column of the block,
+   * 1 or 0 for membership of group 1, or +1 or -1 for the paired test.
+   */
+  std::vector<double>             m_Relabelings;
+
+  /** The current block: m_NumberOfColumns values per voxel, and the
+   * results per voxel.
+   */
+  unsigned int                    m_NumberOfColumns;
+  SizeValueType                   m_NumberOfBlockVoxels;
+  std::vector<double>             m_Block;
+  std::vector<double>             m_BlockT;
+  std::vector<double>             m_BlockDegreesOfFreedom;
+  std::vector<SizeValueType>      m_BlockExceedances;
+
+  /** Per thread, and merged: the largest and smallest t per relabeling. */
+  std::vector< std::vector<double> >  m_ThreadMaximumT;
+  std::vector< std::vector<double> >  m_ThreadMinimumT;
+  std::vector<double>                 m_MaximumT;
+  std::vector<double>                 m_MinimumT;
+
+  /** Results. */
+  OutputImagePointer              m_TImage;
+  OutputImagePointer              m_PImage;
+  OutputImagePointer              m_PermutationPImage;
+  OutputImagePointer              m_CorrectedPermutationPImage;
+
+}; // end class VoxelwiseTTestCalculator
+
+
+} // end of namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkVoxelwiseTTestCalculator.txx"
+#endif
+
+#endif // end #ifndef __itkVoxelwiseTTestCalculator_h_
@@ -0,0 +1,552 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkVoxelwiseTTestCalculator_txx_
+#define __itkVoxelwiseTTestCalculator_txx_
+
+#include "itkVoxelwiseTTestCalculator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTDistribution.h"
+#include "vnl/vnl_math.h"
+#include <algorithm>
+
+
+namespace itk {
+
+/**
+ * ************************* Constructor ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::VoxelwiseTTestCalculator()
+{
+  this->m_Test = Paired;
+  this->m_NumberOfTails = 2;
+  this->m_NumberOfPermutations = 0;
+  this->m_Seed = 0;
+  this->m_NumberOfStreamDivisions = 1;
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->m_NumberOfColumns = 0;
+  this->m_NumberOfBlockVoxels = 0;
+
+} // end Constructor()
+
+
+/**
+ * ************************* AddInput ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::AddInput( InputImageType * image, unsigned int group )
+{
+  if( group == 1 )
+  {
+    this->m_Group1.push_back( image );
+  }
+  else if( group == 2 )
+  {
+    this->m_Group2.push_back( image );
+  }
+  else
+  {
+    itkExceptionMacro( << "ERROR: the group should be 1 or 2." );
+  }
+  this->Modified();
+
+} // end AddInput()
+
+
+/**
+ * ************************* ComputeTValue ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+double
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::ComputeTValue( unsigned int test,
+  double sum1, double sumOfSquares1, double n1,
+  double sum2, double sumOfSquares2, double n2,
+  double & degreesOfFreedom )
+{
+  /** The paired test: t = mean( X ) * sqrt( N ) / std( X ). */
+  if( test == Paired )
+  {
+    degreesOfFreedom = n1 - 1.0;
+    const double variance = ( sumOfSquares1 - sum1 * sum1 / n1 ) / ( n1 - 1.0 );
+    if( variance <= 0.0 ) return 0.0;
+    return ( sum1 / n1 ) / vcl_sqrt( variance / n1 );
+  }
+
+  const double mean1 = sum1 / n1;
+  const double mean2 = sum2 / n2;
+  const double variance1 = vnl_math_max( 0.0, ( sumOfSquares1 - sum1 * mean1 ) / ( n1 - 1.0 ) );
+  const double variance2 = vnl_math_max( 0.0, ( sumOfSquares2 - sum2 * mean2 ) / ( n2 - 1.0 ) );
+
+  double squaredStandardError = 0.0;
+  degreesOfFreedom = n1 + n2 - 2.0;
+  if( test == EqualVariance )
+  {
+    const double pooledVariance
+      = ( ( n1 - 1.0 ) * variance1 + ( n2 - 1.0 ) * variance2 ) / degreesOfFreedom;
+    squaredStandardError = pooledVariance * ( 1.0 / n1 + 1.0 / n2 );
+  }
+  else
+  {
+    /** Welch, with the Welch-Satterthwaite degrees of freedom. */
+    const double a = variance1 / n1;
+    const double b = variance2 / n2;
+    squaredStandardError = a + b;
+    const double denominator = a * a / ( n1 - 1.0 ) + b * b / ( n2 - 1.0 );
+    if( denominator > 0.0 )
+    {
+      degreesOfFreedom = squaredStandardError * squaredStandardError / denominator;
+    }
+  }
+
+  if( squaredStandardError <= 0.0 ) return 0.0;
+  return ( mean1 - mean2 ) / vcl_sqrt( squaredStandardError );
+
+} // end ComputeTValue()
+
+
+/**
+ * ************************* Compute ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::Compute( void )
+{
+  /** Check the groups. */
+  const unsigned int n1 = this->m_Group1.size();
+  const unsigned int n2 = this->m_Group2.size();
+  if( this->m_Test == Paired )
+  {
+    if( n1 != n2 || n1 < 2 )
+    {
+      itkExceptionMacro( << "ERROR: the paired t-test requires two groups of equal size, "
+        << "with at least two images." );
+    }
+    this->m_NumberOfColumns = n1;
+  }
+  else if( this->m_Test == EqualVariance || this->m_Test == UnequalVariance )
+  {
+    if( n1 < 2 || n2 < 2 )
+    {
+      itkExceptionMacro( << "ERROR: the two-sample t-test requires at least two images per group." );
+    }
+    this->m_NumberOfColumns = n1 + n2;
+  }
+  else
+  {
+    itkExceptionMacro( << "ERROR: This type is not supported. Choose one of {1,2,3}." );
+  }
+
+  /** Only the meta data is read here. */
+  std::vector<InputImagePointer> inputs( this->m_Group1 );
+  inputs.insert( inputs.end(), this->m_Group2.begin(), this->m_Group2.end() );
+  for( unsigned int k = 0; k < inputs.size(); ++k )
+  {
+    inputs[ k ]->UpdateOutputInformation();
+  }
+  const RegionType largestRegion = inputs[ 0 ]->GetLargestPossibleRegion();
+  for( unsigned int k = 1; k < inputs.size(); ++k )
+  {
+    if( inputs[ k ]->GetLargestPossibleRegion() != largestRegion )
+    {
+      itkExceptionMacro( << "ERROR: all images should have the same size." );
+    }
+  }
+
+  /** Allocate the outputs. */
+  const unsigned int numberOfPermutations = this->m_NumberOfPermutations;
+  OutputImagePointer * outputs[ 4 ] = { &this->m_TImage, &this->m_PImage,
+    &this->m_PermutationPImage, &this->m_CorrectedPermutationPImage };
+  for( unsigned int i = 0; i < 4; ++i )
+  {
+    *outputs[ i ] = 0;
+    if( i >= 2 && numberOfPermutations == 0 ) continue;
+    *outputs[ i ] = OutputImageType::New();
+    ( *outputs[ i ] )->CopyInformation( inputs[ 0 ] );
+    ( *outputs[ i ] )->SetRegions( largestRegion );
+    ( *outputs[ i ] )->Allocate();
+  }
+
+  /** Draw the relabelings. */
+  this->DrawRelabelings();
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( this->m_NumberOfThreads );
+  this->m_ThreadMaximumT.assign( threader->GetNumberOfThreads(),
+    std::vector<double>( numberOfPermutations, NumericTraits<double>::NonpositiveMin() ) );
+  this->m_ThreadMinimumT.assign( threader->GetNumberOfThreads(),
+    std::vector<double>( numberOfPermutations, NumericTraits<double>::max() ) );
+
+  /** The single pass over the images. */
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const unsigned int numberOfPieces = splitter->GetNumberOfSplits(
+    largestRegion, vnl_math_max( 1u, this->m_NumberOfStreamDivisions ) );
+  for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+  {
+    const RegionType pieceRegion = splitter->GetSplit( piece, numberOfPieces, largestRegion );
+    for( unsigned int k = 0; k < inputs.size(); ++k )
+    {
+      inputs[ k ]->SetRequestedRegion( pieceRegion );
+      inputs[ k ]->Update();
+    }
+
+    this->GatherBlock( pieceRegion );
+    threader->SetSingleMethod( this->TestBlockThreaderCallback, this );
+    threader->SingleMethodExecute();
+    this->ScatterBlock( pieceRegion );
+  }
+  std::vector<double>().swap( this->m_Block );
+
+  if( numberOfPermutations == 0 ) return;
+
+  /** Merge the extreme t per relabeling of the threads. */
+  this->m_MaximumT = this->m_ThreadMaximumT[ 0 ];
+  this->m_MinimumT = this->m_ThreadMinimumT[ 0 ];
+  for( unsigned int t = 1; t < this->m_ThreadMaximumT.size(); ++t )
+  {
+    for( unsigned int p = 0; p < numberOfPermutations; ++p )
+    {
+      this->m_MaximumT[ p ] = vnl_math_max( this->m_MaximumT[ p ], this->m_ThreadMaximumT[ t ][ p ] );
+      this->m_MinimumT[ p ] = vnl_math_min( this->m_MinimumT[ p ], this->m_ThreadMinimumT[ t ][ p ] );
+    }
+  }
+
+  /** The null distributions of the most extreme t, sorted. */
+  std::vector<double> largestPositive( numberOfPermutations );
+  std::vector<double> largestNegative( numberOfPermutations );
+  std::vector<double> largestAbsolute( numberOfPermutations );
+  for( unsigned int p = 0; p < numberOfPermutations; ++p )
+  {
+    largestPositive[ p ] = this->m_MaximumT[ p ];
+    largestNegative[ p ] = -this->m_MinimumT[ p ];
+    largestAbsolute[ p ] = vnl_math_max( largestPositive[ p ], largestNegative[ p ] );
+  }
+  std::sort( largestPositive.begin(), largestPositive.end() );
+  std::sort( largestNegative.begin(), largestNegative.end() );
+  std::sort( largestAbsolute.begin(), largestAbsolute.end() );
+
+  /** The corrected p-value: the fraction of relabelings of which the most
+   * extreme t is at least as extreme as the observed t.
+   */
+  ImageRegionConstIterator<OutputImageType> tIt( this->m_TImage, largestRegion );
+  ImageRegionIterator<OutputImageType> cIt( this->m_CorrectedPermutationPImage, largestRegion );
+  for( ; !tIt.IsAtEnd(); ++tIt, ++cIt )
+  {
+    const double t = static_cast<double>( tIt.Get() );
+    const std::vector<double> & nullDistribution = this->m_NumberOfTails == 2
+      ? largestAbsolute : ( t >= 0.0 ? largestPositive : largestNegative );
+    const double extreme = vnl_math_abs( t ) * ( 1.0 - 1e-6 );
+    const SizeValueType count = nullDistribution.end()
+      - std::lower_bound( nullDistribution.begin(), nullDistribution.end(), extreme );
+    cIt.Set( static_cast<OutputPixelType>(
+      ( count + 1.0 ) / ( numberOfPermutations + 1.0 ) ) );
+  }
+
+} // end Compute()
+
+
+/**
+ * ************************* GatherBlock ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::GatherBlock( const RegionType & piece )
+{
+  typedef ImageRegionConstIterator<InputImageType> IteratorType;
+  const unsigned int columns = this->m_NumberOfColumns;
+  const unsigned int n1 = this->m_Group1.size();
+  this->m_NumberOfBlockVoxels = piece.GetNumberOfPixels();
+  this->m_Block.resize( this->m_NumberOfBlockVoxels * columns );
+  this->m_BlockT.resize( this->m_NumberOfBlockVoxels );
+  this->m_BlockDegreesOfFreedom.resize( this->m_NumberOfBlockVoxels );
+  this->m_BlockExceedances.resize( this->m_NumberOfBlockVoxels );
+
+  for( unsigned int k = 0; k < n1; ++k )
+  {
+    IteratorType it( this->m_Group1[ k ], piece );
+    for( SizeValueType v = 0; !it.IsAtEnd(); ++it, ++v )
+    {
+      this->m_Block[ v * columns + k ] = static_cast<double>( it.Get() );
+    }
+  }
+
+  /** The paired test works on the differences. */
+  for( unsigned int k = 0; k < this->m_Group2.size(); ++k )
+  {
+    IteratorType it( this->m_Group2[ k ], piece );
+    if( this->m_Test == Paired )
+    {
+      for( SizeValueType v = 0; !it.IsAtEnd(); ++it, ++v )
+      {
+        this->m_Block[ v * columns + k ] -= static_cast<double>( it.Get() );
+      }
+    }
+    else
+    {
+      for( SizeValueType v = 0; !it.IsAtEnd(); ++it, ++v )
+      {
+        this->m_Block[ v * columns + n1 + k ] = static_cast<double>( it.Get() );
+      }
+    }
+  }
+
+  /** The two-sample tests do not change with a shift; shift by the first subject. */
+  if( this->m_Test != Paired )
+  {
+    for( SizeValueType v = 0; v < this->m_NumberOfBlockVoxels; ++v )
+    {
+      double * x = &this->m_Block[ v * columns ];
+      const double shift = x[ 0 ];
+      for( unsigned int c = 0; c < columns; ++c ) x[ c ] -= shift;
+    }
+  }
+
+} // end GatherBlock()
+
+
+/**
+ * ************************* ThreadedTestBlock ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::ThreadedTestBlock( ThreadIdType threadId, ThreadIdType numberOfThreads )
+{
+  const unsigned int columns = this->m_NumberOfColumns;
+  const unsigned int numberOfPermutations = this->m_NumberOfPermutations;
+  const bool paired = this->m_Test == Paired;
+  const double n1 = static_cast<double>( this->m_Group1.size() );
+  const double n2 = paired ? 0.0 : static_cast<double>( this->m_Group2.size() );
+  std::vector<double> & maximumT = this->m_ThreadMaximumT[ threadId ];
+  std::vector<double> & minimumT = this->m_ThreadMinimumT[ threadId ];
+
+  /** The observed labeling. */
+  std::vector<double> observed( columns, 0.0 );
+  std::fill( observed.begin(), observed.begin() + this->m_Group1.size(), 1.0 );
+
+  const SizeValueType first = this->m_NumberOfBlockVoxels * threadId / numberOfThreads;
+  const SizeValueType last = this->m_NumberOfBlockVoxels * ( threadId + 1 ) / numberOfThreads;
+  std::vector<double> squares( columns );
+  double dof = 0.0;
+  for( SizeValueType v = first; v < last; ++v )
+  {
+    /** The sums over all subjects do not change with the labeling. */
+    const double * x = &this->m_Block[ v * columns ];
+    double sum = 0.0, sumOfSquares = 0.0;
+    for( unsigned int c = 0; c < columns; ++c )
+    {
+      squares[ c ] = x[ c ] * x[ c ];
+      sum += x[ c ];
+      sumOfSquares += squares[ c ];
+    }
+
+    /** Test a labeling: the sums of group 1, or the sum of the signed differences. */
+    const double * w = &observed[ 0 ];
+    double t = 0.0;
+    for( unsigned int p = 0; p <= numberOfPermutations; ++p )
+    {
+      double sum1 = 0.0, sumOfSquares1 = 0.0;
+      if( paired )
+      {
+        for( unsigned int c = 0; c < columns; ++c ) sum1 += w[ c ] * x[ c ];
+        t = Self::ComputeTValue( this->m_Test, sum1, sumOfSquares, n1, 0.0, 0.0, 0.0, dof );
+      }
+      else
+      {
+        for( unsigned int c = 0; c < columns; ++c )
+        {
+          sum1 += w[ c ] * x[ c ];
+          sumOfSquares1 += w[ c ] * squares[ c ];
+        }
+        t = Self::ComputeTValue( this->m_Test, sum1, sumOfSquares1, n1,
+          sum - sum1, sumOfSquares - sumOfSquares1, n2, dof );
+      }
+
+      if( p == 0 )
+      {
+        this->m_BlockT[ v ] = t;
+        this->m_BlockDegreesOfFreedom[ v ] = dof;
+        this->m_BlockExceedances[ v ] = 0;
+      }
+      else
+      {
+        /** At least as extreme as observed, as the parametric p-value. */
+        const double tObserved = this->m_BlockT[ v ];
+        const double extreme = vnl_math_abs( tObserved ) * ( 1.0 - 1e-9 );
+        bool exceeds = false;
+        if( this->m_NumberOfTails == 2 ) exceeds = vnl_math_abs( t ) >= extreme;
+        else if( tObserved >= 0.0 ) exceeds = t >= extreme;
+        else exceeds = -t >= extreme;
+        if( exceeds ) ++this->m_BlockExceedances[ v ];
+
+        maximumT[ p - 1 ] = vnl_math_max( maximumT[ p - 1 ], t );
+        minimumT[ p - 1 ] = vnl_math_min( minimumT[ p - 1 ], t );
+      }
+
+      if( p < numberOfPermutations ) w = &this->m_Relabelings[ p * columns ];
+    }
+  }
+
+} // end ThreadedTestBlock()
+
+
+/**
+ * ************************* ScatterBlock ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::ScatterBlock( const RegionType & piece )
+{
+  /** TDistribution is evaluated here, outside the threads. */
+  typedef Statistics::TDistribution   DistributionType;
+  typedef ImageRegionIterator<OutputImageType> IteratorType;
+  const double tails = this->m_NumberOfTails == 2 ? 2.0 : 1.0;
+  const double numberOfPermutations = static_cast<double>( this->m_NumberOfPermutations );
+
+  IteratorType tIt( this->m_TImage, piece );
+  IteratorType pIt( this->m_PImage, piece );
+  for( SizeValueType v = 0; !tIt.IsAtEnd(); ++tIt, ++pIt, ++v )
+  {
+    const double t = this->m_BlockT[ v ];
+    const SizeValueType dof = static_cast<SizeValueType>(
+      vcl_floor( this->m_BlockDegreesOfFreedom[ v ] ) );
+    tIt.Set( static_cast<OutputPixelType>( t ) );
+    pIt.Set( static_cast<OutputPixelType>(
+      tails * DistributionType::CDF( -vnl_math_abs( t ), dof ) ) );
+  }
+
+  if( this->m_NumberOfPermutations == 0 ) return;
+  IteratorType permIt( this->m_PermutationPImage, piece );
+  for( SizeValueType v = 0; !permIt.IsAtEnd(); ++permIt, ++v )
+  {
+    permIt.Set( static_cast<OutputPixelType>(
+      ( this->m_BlockExceedances[ v ] + 1.0 ) / ( numberOfPermutations + 1.0 ) ) );
+  }
+
+} // end ScatterBlock()
+
+
+/**
+ * ************************* DrawRelabelings ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::DrawRelabelings( void )
+{
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  typename GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( this->m_Seed );
+
+  const unsigned int columns = this->m_NumberOfColumns;
+  const unsigned int n1 = this->m_Group1.size();
+  const SizeValueType numberOfPermutations = this->m_NumberOfPermutations;
+  this->m_Relabelings.resize( numberOfPermutations * columns );
+  std::vector<unsigned int> order( columns );
+  for( SizeValueType p = 0; p < numberOfPermutations; ++p )
+  {
+    double * w = &this->m_Relabelings[ p * columns ];
+    if( this->m_Test == Paired )
+    {
+      /** Random sign flips of the differences. */
+      for( unsigned int c = 0; c < columns; ++c )
+      {
+        w[ c ] = generator->GetIntegerVariate( 1 ) == 0 ? 1.0 : -1.0;
+      }
+    }
+    else
+    {
+      /** A random subset of size n1, by a partial Fisher-Yates shuffle. */
+      for( unsigned int c = 0; c < columns; ++c ) order[ c ] = c;
+      for( unsigned int i = 0; i < n1; ++i )
+      {
+        const unsigned int j = i + generator->GetIntegerVariate( columns - 1 - i );
+        std::swap( order[ i ], order[ j ] );
+      }
+      for( unsigned int i = 0; i < columns; ++i )
+      {
+        w[ order[ i ] ] = i < n1 ? 1.0 : 0.0;
+      }
+    }
+  }
+
+} // end DrawRelabelings()
+
+
+/**
+ * ************************* TestBlockThreaderCallback ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::TestBlockThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info
+    = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  Self * self = static_cast<Self *>( info->UserData );
+  self->ThreadedTestBlock( info->ThreadID, info->NumberOfThreads );
+
+  return ITK_THREAD_RETURN_VALUE;
+
+} // end TestBlockThreaderCallback()
+
+
+/**
+ * ************************* PrintSelf ************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+VoxelwiseTTestCalculator< TInputImage, TOutputImage >
+::PrintSelf( std::ostream& os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Group1: " << this->m_Group1.size() << " images" << std::endl;
+  os << indent << "Group2: " << this->m_Group2.size() << " images" << std::endl;
+  os << indent << "Test: " << this->m_Test << std::endl;
+  os << indent << "NumberOfTails: " << this->m_NumberOfTails << std::endl;
+  os << indent << "NumberOfPermutations: " << this->m_NumberOfPermutations << std::endl;
+  os << indent << "Seed: " << this->m_Seed << std::endl;
+  os << indent << "NumberOfStreamDivisions: " << this->m_NumberOfStreamDivisions << std::endl;
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads << std::endl;
+
+} // end PrintSelf()
+
+
+} // end of namespace itk
+
+#endif // end #ifndef __itkVoxelwiseTTestCalculator_txx_
@@ -22,6 +22,7 @@
  */
 #include "itkCommandLineArgumentParser.h"
 #include "ITKToolsHelpers.h"
+#include "ttest.h"
 
 #include <vector>
 #include <fstream>
@@ -40,7 +41,8 @@ std::string GetHelpString( void )
   ss << "ITKTools v" << itktools::GetITKToolsVersion() << "\n"
     << "Usage:\n"
     << "pxttest\n"
-    << "  -in      inputFilename\n"
+    << "  -in      inputFilename, or\n"
+    << "  -g1      the images of group 1, for a voxelwise t-test\n"
     << "  [-out]   output, choose one of {p,all}, default p\n"
     << "             p: only print the p-value\n"
     << "             all: print all\n"
@@ -51,9 +53,23 @@ std::string GetHelpString( void )
     << "             2: two-sample equal variance\n"
     << "             3: two-sample unequal variance\n"
     << "  [-p]     the output precision, default = 8:\n"
+    << "  [-g2]    the images of group 2, for a voxelwise t-test\n"
+    << "  [-tmap]  output filename of the t-map\n"
+    << "  [-pmap]  output filename of the p-map\n"
+    << "  [-permpmap] output filename of the uncorrected permutation p-map\n"
+    << "  [-fwepmap]  output filename of the permutation p-map, corrected for\n"
+    << "             the family-wise error with the maximum t over the image\n"
+    << "  [-perm]  the number of random relabelings, default 0: no permutation test\n"
+    << "  [-seed]  the seed of the relabelings, default 0\n"
+    << "  [-s]     number of streams, default 8\n"
+    << "  [-threads] maximum number of threads, default all\n"
     << "The input file should be in a certain format. No text is allowed.\n"
     << "No headers are allowed. The data samples should be displayed in columns.\n"
-    << "Columns should be separated by a single space or tab.";
+    << "Columns should be separated by a single space or tab.\n"
+    << "With \"-g1\" and \"-g2\" a t-test is done in every voxel of two groups\n"
+    << "of co-registered images of the same size, instead of on the columns.\n"
+    << "For the paired test the images of both groups are paired in order.\n"
+    << "Supported: 2D, 3D, all scalar types; the images are read as float.";
 
   return ss.str();
 
@@ -69,6 +85,10 @@ bool ComputeTValue( const std::vector<double> & samples1,
     double & mean1, double & mean2, double & meandiff,
     double & std1, double & std2, double & stddiff );
 
+/* Declare VoxelwiseTTest. */
+int VoxelwiseTTest( itk::CommandLineArgumentParser * parser,
+  const unsigned int type, const unsigned int tail );
+
 /* Declare ComputeMeanAndStandardDeviation. */
 void ComputeMeanAndStandardDeviation(
   const std::vector<double> & samples1,
@@ -85,8 +105,11 @@ int main( int argc, char **argv )
   parser->SetCommandLineArguments( argc, argv );
   parser->SetProgramHelpText( GetHelpString() );
 
-  parser->MarkArgumentAsRequired( "-in", "The input filename." );
-  parser->MarkArgumentAsRequired( "-c", "Columns." );
+  std::vector<std::string> exactlyOneArguments;
+  exactlyOneArguments.push_back( "-in" );
+  exactlyOneArguments.push_back( "-g1" );
+
+  parser->MarkExactlyOneOfArgumentsAsRequired( exactlyOneArguments );
 
   itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
 
@@ -100,6 +123,18 @@ int main( int argc, char **argv )
   }
 
   /** Get arguments. */
+  unsigned int tail = 2;
+  parser->GetCommandLineArgument( "-tail", tail );
+
+  unsigned int type = 1;
+  parser->GetCommandLineArgument( "-type", type );
+
+  /** The voxelwise t-test on two groups of images. */
+  if( parser->ArgumentExists( "-g1" ) )
+  {
+    return VoxelwiseTTest( parser, type, tail );
+  }
+
   std::string inputFileName = "";
   parser->GetCommandLineArgument( "-in", inputFileName );
 
@@ -107,19 +142,13 @@ int main( int argc, char **argv )
   parser->GetCommandLineArgument( "-out", output );
 
   std::vector<unsigned int> columns( 2, 0 );
-  parser->GetCommandLineArgument( "-c", columns );
-
-  unsigned int tail = 2;
-  parser->GetCommandLineArgument( "-tail", tail );
-
-  unsigned int type = 1;
-  parser->GetCommandLineArgument( "-type", type );
+  bool retc = parser->GetCommandLineArgument( "-c", columns );
 
   unsigned int precision = 8;
   parser->GetCommandLineArgument( "-p", precision );
 
   /** Check command line arguments. */
-  if( columns.size() != 2 )
+  if( !retc || columns.size() != 2 )
   {
     std::cerr << "ERROR: You should specify two different columns with \"-c\"." << std::endl;
     return EXIT_FAILURE;
@@ -212,6 +241,130 @@ int main( int argc, char **argv )
 } // end main
 
 
+/*
+ * ******************* VoxelwiseTTest *******************
+ */
+
+int VoxelwiseTTest( itk::CommandLineArgumentParser * parser,
+  const unsigned int type, const unsigned int tail )
+{
+  /** Get arguments. */
+  std::vector<std::string> group1FileNames;
+  parser->GetCommandLineArgument( "-g1", group1FileNames );
+
+  std::vector<std::string> group2FileNames;
+  parser->GetCommandLineArgument( "-g2", group2FileNames );
+
+  std::string tMapFileName = "";
+  parser->GetCommandLineArgument( "-tmap", tMapFileName );
+
+  std::string pMapFileName = "";
+  parser->GetCommandLineArgument( "-pmap", pMapFileName );
+
+  std::string permutationPMapFileName = "";
+  parser->GetCommandLineArgument( "-permpmap", permutationPMapFileName );
+
+  std::string correctedPermutationPMapFileName = "";
+  parser->GetCommandLineArgument( "-fwepmap", correctedPermutationPMapFileName );
+
+  unsigned int numberOfPermutations = 0;
+  parser->GetCommandLineArgument( "-perm", numberOfPermutations );
+
+  unsigned int seed = 0;
+  parser->GetCommandLineArgument( "-seed", seed );
+
+  unsigned int numberOfStreams = 8;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  parser->GetCommandLineArgument( "-threads", maxThreads );
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( maxThreads );
+
+  /** Check command line arguments. */
+  if( group2FileNames.empty() )
+  {
+    std::cerr << "ERROR: You should specify the images of group 2 with \"-g2\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( tMapFileName == "" && pMapFileName == ""
+    && permutationPMapFileName == "" && correctedPermutationPMapFileName == "" )
+  {
+    std::cerr << "ERROR: You should specify at least one of \"-tmap\", \"-pmap\", "
+      << "\"-permpmap\" or \"-fwepmap\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( numberOfPermutations == 0
+    && ( permutationPMapFileName != "" || correctedPermutationPMapFileName != "" ) )
+  {
+    std::cerr << "ERROR: The permutation p-maps require \"-perm\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( tail != 1 && tail != 2 )
+  {
+    std::cerr << "ERROR: \"-tail\" should be 1 or 2." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Determine image properties. */
+  itk::ImageIOBase::IOPixelType pixelType = itk::ImageIOBase::UNKNOWNPIXELTYPE;
+  itk::ImageIOBase::IOComponentType componentType = itk::ImageIOBase::UNKNOWNCOMPONENTTYPE;
+  unsigned int dim = 0;
+  unsigned int numberOfComponents = 0;
+  bool retgip = itktools::GetImageProperties(
+    group1FileNames[ 0 ], pixelType, componentType, dim, numberOfComponents );
+  if( !retgip ) return EXIT_FAILURE;
+
+  /** Check for vector images. */
+  bool retNOCCheck = itktools::NumberOfComponentsCheck( numberOfComponents );
+  if( !retNOCCheck ) return EXIT_FAILURE;
+
+  /** Force images to sneaky be converted to float. */
+  componentType = itk::ImageIOBase::FLOAT;
+
+  /** Class that does the work. */
+  ITKToolsVoxelwiseTTestBase * filter = NULL;
+
+  try
+  {
+    // now call all possible template combinations.
+    if( !filter ) filter = ITKToolsVoxelwiseTTest< 2, float >::New( dim, componentType );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+    if( !filter ) filter = ITKToolsVoxelwiseTTest< 3, float >::New( dim, componentType );
+#endif
+    /** Check if filter was instantiated. */
+    bool supported = itktools::IsFilterSupportedCheck( filter, dim, componentType );
+    if( !supported ) return EXIT_FAILURE;
+
+    /** Set the filter arguments. */
+    filter->m_Group1FileNames = group1FileNames;
+    filter->m_Group2FileNames = group2FileNames;
+    filter->m_TMapFileName = tMapFileName;
+    filter->m_PMapFileName = pMapFileName;
+    filter->m_PermutationPMapFileName = permutationPMapFileName;
+    filter->m_CorrectedPermutationPMapFileName = correctedPermutationPMapFileName;
+    filter->m_Type = type;
+    filter->m_NumberOfTails = tail;
+    filter->m_NumberOfPermutations = numberOfPermutations;
+    filter->m_Seed = seed;
+    filter->m_NumberOfStreams = numberOfStreams;
+
+    filter->Run();
+
+    delete filter;
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    delete filter;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end VoxelwiseTTest()
+
+
 /*
  * ******************* ReadInputData *******************
  *
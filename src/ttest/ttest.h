@@ -0,0 +1,140 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __ttest_h_
+#define __ttest_h_
+
+#include "ITKToolsBase.h"
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkVoxelwiseTTestCalculator.h"
+
+
+/** \class ITKToolsVoxelwiseTTestBase
+ *
+ * Untemplated pure virtual base class that holds
+ * the Run() function and all required parameters.
+ */
+
+class ITKToolsVoxelwiseTTestBase : public itktools::ITKToolsBase
+{
+public:
+  /** Constructor. */
+  ITKToolsVoxelwiseTTestBase()
+  {
+    this->m_TMapFileName = "";
+    this->m_PMapFileName = "";
+    this->m_PermutationPMapFileName = "";
+    this->m_CorrectedPermutationPMapFileName = "";
+    this->m_Type = 1;
+    this->m_NumberOfTails = 2;
+    this->m_NumberOfPermutations = 0;
+    this->m_Seed = 0;
+    this->m_NumberOfStreams = 8;
+  };
+  /** Destructor. */
+  ~ITKToolsVoxelwiseTTestBase(){};
+
+  /** Input member parameters. */
+  std::vector<std::string> m_Group1FileNames;
+  std::vector<std::string> m_Group2FileNames;
+  std::string m_TMapFileName;
+  std::string m_PMapFileName;
+  std::string m_PermutationPMapFileName;
+  std::string m_CorrectedPermutationPMapFileName;
+  unsigned int m_Type;
+  unsigned int m_NumberOfTails;
+  unsigned int m_NumberOfPermutations;
+  unsigned int m_Seed;
+  unsigned int m_NumberOfStreams;
+
+}; // end class ITKToolsVoxelwiseTTestBase
+
+
+/** \class ITKToolsVoxelwiseTTest
+ *
+ * Templated class that implements the Run() function
+ * and the New() function for its creation.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+class ITKToolsVoxelwiseTTest : public ITKToolsVoxelwiseTTestBase
+{
+public:
+  /** Standard ITKTools stuff. */
+  typedef ITKToolsVoxelwiseTTest Self;
+  itktoolsOneTypeNewMacro( Self );
+
+  ITKToolsVoxelwiseTTest(){};
+  ~ITKToolsVoxelwiseTTest(){};
+
+  /** Run function. */
+  void Run( void )
+  {
+    /** Typedefs. */
+    typedef itk::Image< TComponentType, VDimension >      ImageType;
+    typedef itk::Image< float, VDimension >               OutputImageType;
+    typedef itk::ImageFileReader< ImageType >             ReaderType;
+    typedef itk::ImageFileWriter< OutputImageType >       WriterType;
+    typedef itk::VoxelwiseTTestCalculator<
+      ImageType, OutputImageType >                        CalculatorType;
+
+    /** Setup the readers; the pixels are read piece by piece by the calculator. */
+    typename CalculatorType::Pointer calculator = CalculatorType::New();
+    std::vector<typename ReaderType::Pointer> readers;
+    for( unsigned int group = 1; group <= 2; ++group )
+    {
+      const std::vector<std::string> & fileNames
+        = group == 1 ? this->m_Group1FileNames : this->m_Group2FileNames;
+      for( unsigned int i = 0; i < fileNames.size(); ++i )
+      {
+        typename ReaderType::Pointer reader = ReaderType::New();
+        reader->SetFileName( fileNames[ i ] );
+        calculator->AddInput( reader->GetOutput(), group );
+        readers.push_back( reader );
+      }
+    }
+
+    /** Test. */
+    calculator->SetTest( this->m_Type );
+    calculator->SetNumberOfTails( this->m_NumberOfTails );
+    calculator->SetNumberOfPermutations( this->m_NumberOfPermutations );
+    calculator->SetSeed( this->m_Seed );
+    calculator->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    calculator->Compute();
+
+    /** Write the requested maps. */
+    const std::string fileNames[ 4 ] = { this->m_TMapFileName, this->m_PMapFileName,
+      this->m_PermutationPMapFileName, this->m_CorrectedPermutationPMapFileName };
+    OutputImageType * maps[ 4 ] = { calculator->GetTImage(), calculator->GetPImage(),
+      calculator->GetPermutationPImage(), calculator->GetCorrectedPermutationPImage() };
+    for( unsigned int i = 0; i < 4; ++i )
+    {
+      if( fileNames[ i ] == "" || maps[ i ] == 0 ) continue;
+      typename WriterType::Pointer writer = WriterType::New();
+      writer->SetFileName( fileNames[ i ] );
+      writer->SetInput( maps[ i ] );
+      writer->Update();
+    }
+
+  } // end Run()
+
+}; // end class ITKToolsVoxelwiseTTest
+
+
+#endif // end #ifndef __ttest_h_